@@ -280,3 +280,36 @@ adminLogsEnabled = false
 displayPlayersLogging = true
 prefixChannelLogs = ""
 runFile = ""
+
+-- Performance
+-- batchedCreatureThinking lets all thinking creatures think together in one game tick
+-- instead of scheduling a separate task for each creature.
+batchedCreatureThinking = true
+-- dispatcherBatchSize is the maximum number of queued tasks which run before pending
+-- network messages are sent. 1 sends after every task, 0 runs all queued tasks at once.
+dispatcherBatchSize = 100
+-- rsaWorkerThreads is the number of threads which decrypt login packets, 0 uses one per CPU core.
+rsaWorkerThreads = 0
+-- asyncPlayerSaving writes player saves on a separate database thread in batches of at most
+-- playerSaveBatchSize players per transaction, instead of blocking the game while saving.
+asyncPlayerSaving = true
+playerSaveBatchSize = 50
+-- deltaPlayerSaving only writes the items and storage values which changed since the last save,
+-- false rewrites all of them on every save.
+deltaPlayerSaving = true
+-- pathfindingMaxNodes is the maximum number of tiles a single path search may visit.
+pathfindingMaxNodes = 512
+-- flowFieldPathing lets monsters which chase the same creature share one map of walking
+-- distances to it instead of each searching its own path.
+flowFieldPathing = true
+-- sharedMapTiles lets map tiles which only hold plain items share one description, creating
+-- each of them when it is first used instead of when the map is loaded.
+sharedMapTiles = true
+-- networkThreads is the number of threads which handle client connections, each of them with its
+-- own event loop. 0 uses one per CPU core.
+networkThreads = 0
+-- banRefreshInterval is the number of seconds after which the bans kept in memory are read
+-- again from the database, to pick up bans added by other tools. 0 only reads them at startup.
+-- Logins are only checked against the bans in memory, so bans written directly to the database
+-- only apply after the next read.
+banRefreshInterval = 60
@@ -0,0 +1,185 @@
+////////////////////////////////////////////////////////////////////////
+// OpenTibia - an opensource roleplaying game
+////////////////////////////////////////////////////////////////////////
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+////////////////////////////////////////////////////////////////////////
+
+#include "otpch.h"
+
+#include "adler.h"
+#include "const.h"
+
+
+namespace {
+
+const uint32_t adlerModulus = 65521;
+
+// largest number of bytes which can be summed up before the 32 bit sums have to be reduced
+const size_t adlerMaximumRun = 5552;
+
+typedef size_t (*AdlerKernel)(const uint8_t* data, size_t length, uint32_t& a, uint32_t& b);
+
+
+void adlerChecksumScalar(const uint8_t* data, size_t length, uint32_t& a, uint32_t& b) {
+	while (length > 0) {
+		size_t tmp = length > adlerMaximumRun ? adlerMaximumRun : length;
+		length -= tmp;
+
+		do {
+			a += *data++;
+			b += a;
+		} while (--tmp);
+
+		a %= adlerModulus;
+		b %= adlerModulus;
+	}
+}
+
+
+#ifdef SIMD_X86
+
+// The vector kernels sum up whole blocks at once: a grows by the sum of the bytes and b by the sum of the bytes
+// weighted by their distance to the end of the run, plus the block size times every previous value of a.
+// They return the number of bytes processed and leave the rest to the scalar kernel.
+
+__attribute__((target("avx2")))
+size_t adlerChecksumAvx2(const uint8_t* data, size_t length, uint32_t& a, uint32_t& b) {
+	const size_t blockSize = 32;
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i highWeights = _mm256_set_epi16(17, 18, 19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29, 30, 31, 32);
+	const __m256i lowWeights = _mm256_set_epi16(1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16);
+
+	size_t processed = 0;
+	while (length - processed >= blockSize) {
+		size_t blocks = std::min(length - processed, adlerMaximumRun) / blockSize;
+		__m256i sums = zero, weightedSums = zero, previousSums = zero;
+
+		for (size_t block = 0; block < blocks; ++block, data += blockSize) {
+			__m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data));
+
+			previousSums = _mm256_add_epi32(previousSums, sums);
+			sums = _mm256_add_epi32(sums, _mm256_sad_epu8(bytes, zero));
+
+			__m256i low = _mm256_cvtepu8_epi16(_mm256_castsi256_si128(bytes));
+			__m256i high = _mm256_cvtepu8_epi16(_mm256_extracti128_si256(bytes, 1));
+			weightedSums = _mm256_add_epi32(weightedSums, _mm256_madd_epi16(low, highWeights));
+			weightedSums = _mm256_add_epi32(weightedSums, _mm256_madd_epi16(high, lowWeights));
+		}
+
+		uint32_t lanes[3][8];
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes[0]), sums);
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes[1]), weightedSums);
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes[2]), previousSums);
+
+		uint64_t sum = 0, weightedSum = 0, previousSum = 0;
+		for (uint32_t lane = 0; lane < 8; ++lane) {
+			sum += lanes[0][lane];
+			weightedSum += lanes[1][lane];
+			previousSum += lanes[2][lane];
+		}
+
+		b = (b + uint64_t(a) * blocks * blockSize + previousSum * blockSize + weightedSum) % adlerModulus;
+		a = (a + sum) % adlerModulus;
+		processed += blocks * blockSize;
+	}
+
+	return processed;
+}
+
+
+__attribute__((target("sse2")))
+size_t adlerChecksumSse2(const uint8_t* data, size_t length, uint32_t& a, uint32_t& b) {
+	const size_t blockSize = 16;
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i highWeights = _mm_set_epi16(9, 10, 11, 12, 13, 14, 15, 16);
+	const __m128i lowWeights = _mm_set_epi16(1, 2, 3, 4, 5, 6, 7, 8);
+
+	size_t processed = 0;
+	while (length - processed >= blockSize) {
+		size_t blocks = std::min(length - processed, adlerMaximumRun) / blockSize;
+		__m128i sums = zero, weightedSums = zero, previousSums = zero;
+
+		for (size_t block = 0; block < blocks; ++block, data += blockSize) {
+			__m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+
+			previousSums = _mm_add_epi32(previousSums, sums);
+			sums = _mm_add_epi32(sums, _mm_sad_epu8(bytes, zero));
+
+			weightedSums = _mm_add_epi32(weightedSums, _mm_madd_epi16(_mm_unpacklo_epi8(bytes, zero), highWeights));
+			weightedSums = _mm_add_epi32(weightedSums, _mm_madd_epi16(_mm_unpackhi_epi8(bytes, zero), lowWeights));
+		}
+
+		uint32_t lanes[3][4];
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(lanes[0]), sums);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(lanes[1]), weightedSums);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(lanes[2]), previousSums);
+
+		uint64_t sum = 0, weightedSum = 0, previousSum = 0;
+		for (uint32_t lane = 0; lane < 4; ++lane) {
+			sum += lanes[0][lane];
+			weightedSum += lanes[1][lane];
+			previousSum += lanes[2][lane];
+		}
+
+		b = (b + uint64_t(a) * blocks * blockSize + previousSum * blockSize + weightedSum) % adlerModulus;
+		a = (a + sum) % adlerModulus;
+		processed += blocks * blockSize;
+	}
+
+	return processed;
+}
+
+#endif // SIMD_X86
+
+
+AdlerKernel getAdlerKernel(SimdKernel kernel) {
+	switch (kernel) {
+#ifdef SIMD_X86
+	case SimdKernel::AVX2:
+		return adlerChecksumAvx2;
+
+	case SimdKernel::SSE2:
+		return adlerChecksumSse2;
+#endif
+
+	default:
+		return nullptr;
+	}
+}
+
+} // namespace
+
+
+
+uint32_t adlerChecksum(uint8_t* data, size_t length) {
+	static const SimdKernel kernel = getFastestSimdKernel();
+	return adlerChecksum(data, length, kernel);
+}
+
+
+uint32_t adlerChecksum(uint8_t* data, size_t length, SimdKernel kernel) {
+	if (length > NETWORKMESSAGE_MAXSIZE) {
+		return 0;
+	}
+
+	uint32_t a = 1, b = 0;
+	if (AdlerKernel vectorKernel = getAdlerKernel(kernel)) {
+		size_t processed = vectorKernel(data, length, a, b);
+		data += processed;
+		length -= processed;
+	}
+
+	adlerChecksumScalar(data, length, a, b);
+	return (b << 16) | a;
+}
@@ -0,0 +1,29 @@
+////////////////////////////////////////////////////////////////////////
+// OpenTibia - an opensource roleplaying game
+////////////////////////////////////////////////////////////////////////
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+////////////////////////////////////////////////////////////////////////
+
+
+#ifndef _ADLER_H
+#define _ADLER_H
+
+#include "simd.h"
+
+// Computes the Adler-32 checksum of a network message, or 0 if it is larger than the maximum message size. The fastest
+// kernel supported by the CPU is picked on first use unless one is given; all of them produce the same checksum.
+uint32_t adlerChecksum(uint8_t* data, size_t length);
+uint32_t adlerChecksum(uint8_t* data, size_t length, SimdKernel kernel);
+
+#endif // _ADLER_H
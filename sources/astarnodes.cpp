@@ -0,0 +1,185 @@
+////////////////////////////////////////////////////////////////////////
+// OpenTibia - an opensource roleplaying game
+////////////////////////////////////////////////////////////////////////
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+////////////////////////////////////////////////////////////////////////
+
+
+#include "otpch.h"
+
+#include "astarnodes.h"
+#include "position.h"
+
+
+LOGGER_DEFINITION(AStarNodes);
+
+
+AStarNodes::AStarNodes(uint32_t capacity)
+	: capacity(std::max<uint32_t>(capacity, 1)),
+	  openNodeCount(0)
+{
+	// node pointers are handed out, so the nodes must never be reallocated
+	nodes.reserve(this->capacity);
+	openEntries.reserve(this->capacity);
+	openNodes.reserve(this->capacity);
+
+	uint32_t tableSize = 1;
+	while(tableSize < this->capacity * 2)
+		tableSize <<= 1;
+
+	table.assign(tableSize, -1);
+	tableMask = tableSize - 1;
+}
+
+AStarNode* AStarNodes::createNode(uint16_t x, uint16_t y)
+{
+	if(nodes.size() >= capacity)
+		return nullptr;
+
+	uint32_t slot = getTableSlot(x, y);
+	if(table[slot] >= 0)
+	{
+		assert(table[slot] < 0);
+		LOGe("AStarNodes. trying to create a node twice");
+		return &nodes[table[slot]];
+	}
+
+	table[slot] = nodes.size();
+	openNodes.push_back(false);
+
+	AStarNode node;
+	node.x = x;
+	node.y = y;
+	node.parent = nullptr;
+	node.f = node.g = node.h = 0;
+
+	nodes.push_back(node);
+	return &nodes.back();
+}
+
+AStarNode* AStarNodes::getBestNode()
+{
+	while(!openEntries.empty())
+	{
+		std::pop_heap(openEntries.begin(), openEntries.end());
+		OpenEntry entry = openEntries.back();
+		openEntries.pop_back();
+
+		// entries of closed nodes and of nodes which were opened again with a lower cost are outdated
+		if(openNodes[entry.index] && nodes[entry.index].f == entry.f)
+			return &nodes[entry.index];
+	}
+
+	return nullptr;
+}
+
+void AStarNodes::closeNode(AStarNode* node)
+{
+	uint32_t pos = node - nodes.data();
+	if(pos < nodes.size())
+	{
+		if(openNodes[pos])
+		{
+			openNodes[pos] = false;
+			--openNodeCount;
+		}
+
+		return;
+	}
+
+	assert(pos >= nodes.size());
+	LOGe("AStarNodes. trying to close node out of range");
+	return;
+}
+
+void AStarNodes::openNode(AStarNode* node)
+{
+	uint32_t pos = node - nodes.data();
+	if(pos < nodes.size())
+	{
+		if(!openNodes[pos])
+		{
+			openNodes[pos] = true;
+			++openNodeCount;
+		}
+
+		OpenEntry entry;
+		entry.f = node->f;
+		entry.index = pos;
+
+		openEntries.push_back(entry);
+		std::push_heap(openEntries.begin(), openEntries.end());
+		return;
+	}
+
+	assert(pos >= nodes.size());
+	LOGe("AStarNodes. trying to open node out of range");
+	return;
+}
+
+uint32_t AStarNodes::countClosedNodes()
+{
+	return nodes.size() - openNodeCount;
+}
+
+uint32_t AStarNodes::countOpenNodes()
+{
+	return openNodeCount;
+}
+
+bool AStarNodes::isInList(uint16_t x, uint16_t y)
+{
+	return getNodeInList(x, y) != nullptr;
+}
+
+AStarNode* AStarNodes::getNodeInList(uint16_t x, uint16_t y)
+{
+	int32_t index = table[getTableSlot(x, y)];
+	if(index < 0)
+		return nullptr;
+
+	return &nodes[index];
+}
+
+uint32_t AStarNodes::getTableSlot(uint16_t x, uint16_t y) const
+{
+	// linear probing, the table is at least twice as large as the number of nodes so there is always a free slot
+	uint32_t slot = ((uint32_t)x * 0x9E3779B1u ^ (uint32_t)y * 0x85EBCA77u) & tableMask;
+	while(table[slot] >= 0)
+	{
+		const AStarNode& node = nodes[table[slot]];
+		if(node.x == x && node.y == y)
+			break;
+
+		slot = (slot + 1) & tableMask;
+	}
+
+	return slot;
+}
+
+int32_t AStarNodes::getMapWalkCost(const Creature* creature, AStarNode* node,
+	const Tile* neighbourTile, const Position& neighbourPos)
+{
+	if(std::abs(node->x - neighbourPos.x) == std::abs(node->y - neighbourPos.y)) //diagonal movement extra cost
+		return MAP_DIAGONALWALKCOST;
+
+	return MAP_NORMALWALKCOST;
+}
+
+int32_t AStarNodes::getEstimatedDistance(uint16_t x, uint16_t y, uint16_t xGoal, uint16_t yGoal)
+{
+	int32_t diagonal = std::min(std::abs(x - xGoal), std::abs(y - yGoal));
+	return (MAP_DIAGONALWALKCOST * diagonal) + (MAP_NORMALWALKCOST * ((std::abs(
+		x - xGoal) + std::abs(y - yGoal)) - (2 * diagonal)));
+}
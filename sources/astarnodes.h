@@ -0,0 +1,91 @@
+////////////////////////////////////////////////////////////////////////
+// OpenTibia - an opensource roleplaying game
+////////////////////////////////////////////////////////////////////////
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+////////////////////////////////////////////////////////////////////////
+
+
+#ifndef _ASTARNODES_H
+#define _ASTARNODES_H
+
+#define MAP_NORMALWALKCOST 10
+#define MAP_DIAGONALWALKCOST 25
+
+class Creature;
+class Position;
+class Tile;
+
+
+struct AStarNode {
+	uint16_t x, y;
+	AStarNode* parent;
+	int32_t f, g, h;
+};
+
+
+
+// The nodes of one path search. The open node with the lowest cost is kept on top of a binary heap and nodes are
+// found by their position through a hash table, so that neither has to scan all nodes.
+class AStarNodes {
+
+public:
+
+	AStarNodes(uint32_t capacity);
+
+	void openNode(AStarNode* node);
+	void closeNode(AStarNode* node);
+
+	uint32_t countOpenNodes();
+	uint32_t countClosedNodes();
+
+	AStarNode* getBestNode();
+	AStarNode* createNode(uint16_t x, uint16_t y);
+	AStarNode* getNodeInList(uint16_t x, uint16_t y);
+
+	bool isInList(uint16_t x, uint16_t y);
+	int32_t getEstimatedDistance(uint16_t x, uint16_t y, uint16_t xGoal, uint16_t yGoal);
+
+	int32_t getMapWalkCost(const Creature* creature, AStarNode* node,
+		const Tile* neighbourTile, const Position& neighbourPos);
+	static int32_t getTileWalkCost(const Creature* creature, const Tile* tile);
+
+private:
+
+	struct OpenEntry {
+		int32_t  f;
+		uint32_t index;
+
+		// the heap is a max-heap, so the entry with the lowest cost and among them the oldest node is the greatest
+		bool operator < (const OpenEntry& other) const {
+			return f > other.f || (f == other.f && index > other.index);
+		}
+	};
+
+
+	uint32_t getTableSlot(uint16_t x, uint16_t y) const;
+
+
+	LOGGER_DECLARATION;
+
+	uint32_t               capacity;
+	std::vector<AStarNode> nodes;
+	std::vector<OpenEntry> openEntries;
+	std::vector<bool>      openNodes;
+	uint32_t               openNodeCount;
+	std::vector<int32_t>   table;
+	uint32_t               tableMask;
+
+};
+
+#endif // _ASTARNODES_H
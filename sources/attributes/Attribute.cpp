@@ -21,14 +21,19 @@
 using namespace attributes;
 
 
-Attribute::Attribute(const std::string& name, Type type)
+Attribute::Attribute(const Name& name, Type type)
 	: _name(name),
 	  _type(type)
 {}
 
 
+Name::Index Attribute::getIndex() const {
+	return _name.getIndex();
+}
+
+
 const std::string& Attribute::getName() const {
-	return _name;
+	return _name.getName();
 }
 
 
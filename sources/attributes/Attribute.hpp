@@ -18,6 +18,8 @@
 #ifndef _ATTRIBUTES_ATTRIBUTE_HPP
 #define _ATTRIBUTES_ATTRIBUTE_HPP
 
+#include "attributes/Name.hpp"
+
 namespace attributes {
 
 	enum class Type : uint8_t {
@@ -35,10 +37,11 @@ namespace attributes {
 
 		static const std::string& getTypeName(Type type);
 
-		Attribute(const std::string& name, Type type);
+		Attribute(const Name& name, Type type);
 
-		const std::string& getName () const;
-		Type               getType () const;
+		Name::Index        getIndex () const;
+		const std::string& getName  () const;
+		Type               getType  () const;
 
 
 	private:
@@ -47,8 +50,8 @@ namespace attributes {
 		Attribute(Attribute&&) = delete;
 
 
-		const std::string _name;
-		const Type        _type;
+		const Name _name;
+		const Type _type;
 
 	};
 
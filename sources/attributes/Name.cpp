@@ -0,0 +1,53 @@
+////////////////////////////////////////////////////////////////////////
+// OpenTibia - an opensource roleplaying game
+////////////////////////////////////////////////////////////////////////
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+////////////////////////////////////////////////////////////////////////
+
+#include "otpch.h"
+#include "attributes/Name.hpp"
+
+using namespace attributes;
+
+
+Name::Name(const std::string& name)
+	: _index(indexesByName().emplace(name, static_cast<Index>(names().size())).first->second)
+{
+	if (_index == names().size()) {
+		names().push_back(name);
+	}
+}
+
+
+Name::Index Name::getIndex() const {
+	return _index;
+}
+
+
+const std::string& Name::getName() const {
+	return names()[_index];
+}
+
+
+Name::IndexesByName& Name::indexesByName() {
+	// names are declared during static initialization, so the registry must not depend on the initialization order
+	static IndexesByName indexesByName;
+	return indexesByName;
+}
+
+
+Name::Names& Name::names() {
+	static Names names;
+	return names;
+}
@@ -0,0 +1,55 @@
+////////////////////////////////////////////////////////////////////////
+// OpenTibia - an opensource roleplaying game
+////////////////////////////////////////////////////////////////////////
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+////////////////////////////////////////////////////////////////////////
+
+#ifndef _ATTRIBUTES_NAME_HPP
+#define _ATTRIBUTES_NAME_HPP
+
+namespace attributes {
+
+	// An attribute name which is resolved once to a small index. The index is the same in every scheme, so values can be
+	// found by it without hashing the name on every access. Names are meant to be declared statically, e.g. by item
+	// classes for the attributes they use.
+	class Name {
+
+	public:
+
+		typedef uint16_t  Index;
+
+
+		explicit Name(const std::string& name);
+
+		Index              getIndex () const;
+		const std::string& getName  () const;
+
+
+	private:
+
+		typedef std::deque<std::string>                Names;
+		typedef std::unordered_map<std::string,Index>  IndexesByName;
+
+
+		static IndexesByName& indexesByName ();
+		static Names&         names         ();
+
+
+		const Index _index;
+
+	};
+
+} // namespace attributes
+
+#endif // _ATTRIBUTES_NAME_HPP
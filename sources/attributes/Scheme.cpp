@@ -19,12 +19,14 @@
 #include "attributes/Scheme.hpp"
 
 #include "attributes/Attribute.hpp"
+#include "attributes/Name.hpp"
 
 using namespace attributes;
 
 
 Scheme::Scheme(AttributesP attributes)
 	: _attributes(std::move(attributes)),
+	  _attributesByIndex(mapAttributesByIndex(*_attributes)),
 	  _attributesByName(mapAttributesByName(*_attributes))
 {}
 
@@ -33,6 +35,20 @@ Scheme::~Scheme() {
 }
 
 
+Scheme::AttributesByIndex Scheme::mapAttributesByIndex(const Attributes& attributes) {
+	AttributesByIndex attributesByIndex;
+	for (const auto& attribute : attributes) {
+		if (attribute.getIndex() >= attributesByIndex.size()) {
+			attributesByIndex.resize(attribute.getIndex() + 1, nullptr);
+		}
+
+		attributesByIndex[attribute.getIndex()] = &attribute;
+	}
+
+	return attributesByIndex;
+}
+
+
 Scheme::AttributesByName Scheme::mapAttributesByName(const Attributes& attributes) {
 	AttributesByName attributesByName(attributes.size());
 	for (const auto& attribute : attributes) {
@@ -43,6 +59,15 @@ Scheme::AttributesByName Scheme::mapAttributesByName(const Attributes& attribute
 }
 
 
+const Attribute* Scheme::getAttribute(const Name& name) const {
+	if (name.getIndex() >= _attributesByIndex.size()) {
+		return nullptr;
+	}
+
+	return _attributesByIndex[name.getIndex()];
+}
+
+
 const Attribute* Scheme::getAttributeByName(const std::string& name) const {
 	auto it = _attributesByName.find(name);
 	if (it == _attributesByName.cend()) {
@@ -21,6 +21,7 @@
 namespace attributes {
 
 	class Attribute;
+	class Name;
 	class Scheme;
 
 	typedef std::shared_ptr<Scheme>  SchemeP;
@@ -37,23 +38,27 @@ namespace attributes {
 		Scheme(AttributesP attributes);
 		~Scheme();
 
+		const Attribute* getAttribute       (const Name& name) const;
 		const Attribute* getAttributeByName (const std::string& name) const;
 
 
 	private:
 
+		typedef std::vector<const Attribute*>                                                   AttributesByIndex;
 		typedef std::unordered_map<std::reference_wrapper<const std::string>,const Attribute*>  AttributesByName;
 
 
-		static AttributesByName mapAttributesByName (const Attributes& attributes);
+		static AttributesByIndex mapAttributesByIndex (const Attributes& attributes);
+		static AttributesByName  mapAttributesByName  (const Attributes& attributes);
 
 
 		Scheme(const Scheme&) = delete;
 		Scheme(Scheme&&) = delete;
 
 
-		const AttributesP      _attributes;
-		const AttributesByName _attributesByName;
+		const AttributesP       _attributes;
+		const AttributesByIndex _attributesByIndex;
+		const AttributesByName  _attributesByName;
 
 	};
 
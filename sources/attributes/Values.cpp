@@ -19,6 +19,7 @@
 #include "attributes/Values.hpp"
 
 #include "attributes/Attribute.hpp"
+#include "attributes/Name.hpp"
 #include "attributes/Scheme.hpp"
 
 
@@ -28,6 +29,135 @@ using namespace attributes;
 
 
 
+Values::Entry::Entry()
+	: _attribute(nullptr),
+	  _string(nullptr)
+{}
+
+
+Values::Entry::Entry(const Entry& entry)
+	: _attribute(nullptr),
+	  _string(nullptr)
+{
+	*this = entry;
+}
+
+
+Values::Entry::Entry(Entry&& entry)
+	: _attribute(nullptr),
+	  _string(nullptr)
+{
+	*this = std::move(entry);
+}
+
+
+Values::Entry::~Entry() {
+	release();
+}
+
+
+const Attribute& Values::Entry::getAttribute() const {
+	return *_attribute;
+}
+
+
+bool Values::Entry::getBoolean() const {
+	assert(_attribute->getType() == Type::BOOLEAN);
+	return _boolean;
+}
+
+
+float Values::Entry::getFloat() const {
+	assert(_attribute->getType() == Type::FLOAT);
+	return _float;
+}
+
+
+int32_t Values::Entry::getInteger() const {
+	assert(_attribute->getType() == Type::INTEGER);
+	return _integer;
+}
+
+
+const std::string& Values::Entry::getString() const {
+	assert(_attribute->getType() == Type::STRING);
+	return *_string;
+}
+
+
+Values::Entry& Values::Entry::operator =(const Entry& entry) {
+	if (&entry == this) {
+		return *this;
+	}
+
+	release();
+
+	_attribute = entry._attribute;
+	if (_attribute != nullptr && _attribute->getType() == Type::STRING) {
+		_string = new std::string(*entry._string);
+	}
+	else {
+		_string = entry._string;
+	}
+
+	return *this;
+}
+
+
+Values::Entry& Values::Entry::operator =(Entry&& entry) {
+	if (&entry == this) {
+		return *this;
+	}
+
+	release();
+
+	// the union is copied as a whole, which also takes over the string
+	_attribute = entry._attribute;
+	_string = entry._string;
+
+	entry._attribute = nullptr;
+	entry._string = nullptr;
+
+	return *this;
+}
+
+
+void Values::Entry::release() {
+	if (_attribute != nullptr && _attribute->getType() == Type::STRING) {
+		delete _string;
+	}
+
+	_attribute = nullptr;
+	_string = nullptr;
+}
+
+
+void Values::Entry::set(bool value) {
+	_boolean = value;
+}
+
+
+void Values::Entry::set(float value) {
+	_float = value;
+}
+
+
+void Values::Entry::set(int32_t value) {
+	_integer = value;
+}
+
+
+void Values::Entry::set(const std::string& value) {
+	if (_string == nullptr) {
+		_string = new std::string(value);
+	}
+	else {
+		*_string = value;
+	}
+}
+
+
+
 Values::Values(const SchemeP& scheme)
 	: _scheme(scheme)
 {
@@ -35,76 +165,177 @@ Values::Values(const SchemeP& scheme)
 }
 
 
+const Values::Entry* Values::begin() const {
+	return _entries.get();
+}
+
+
+bool Values::contains(const Name& name) const {
+	auto attribute = resolve(name, "access");
+	return (attribute != nullptr && find(attribute) != nullptr);
+}
+
+
 bool Values::contains(const std::string& name) const {
-	auto attribute = _scheme->getAttributeByName(name);
-	if (attribute == nullptr) {
-		LOGe("Cannot access non-existent attribute '" << name << "'.");
+	auto attribute = resolve(name, "access");
+	return (attribute != nullptr && find(attribute) != nullptr);
+}
+
+
+const Values::Entry* Values::end() const {
+	return (_entries != nullptr ? _entries.get() + size() : nullptr);
+}
+
+
+const Values::Entry* Values::find(const Attribute* attribute) const {
+	if (_entries == nullptr) {
 		return nullptr;
 	}
 
-	return (_entries != nullptr && _entries->find(attribute) != _entries->cend());
+	for (auto entry = _entries.get(); entry->_attribute != nullptr; ++entry) {
+		if (entry->_attribute == attribute) {
+			return entry;
+		}
+	}
+
+	return nullptr;
+}
+
+
+template <>
+const bool* Values::_getValue<bool>(const Entry& entry) {
+	return &entry._boolean;
+}
+
+
+template <>
+const float* Values::_getValue<float>(const Entry& entry) {
+	return &entry._float;
+}
+
+
+template <>
+const int32_t* Values::_getValue<int32_t>(const Entry& entry) {
+	return &entry._integer;
+}
+
+
+template <>
+const std::string* Values::_getValue<std::string>(const Entry& entry) {
+	return entry._string;
 }
 
 
 template <typename T>
-const T* Values::_get(const std::string& name, Type type) const {
-	auto entry = getEntry(name);
-	if (entry == nullptr) {
+const T* Values::_get(const Attribute* attribute, Type type) const {
+	if (attribute == nullptr) {
 		return nullptr;
 	}
 
-	auto& attribute = *entry->first;
-	if (attribute.getType() != type) {
-		LOGe("Cannot access " << Attribute::getTypeName(attribute.getType()) << " attribute '" << attribute.getName() << "' as " << Attribute::getTypeName(type) << ".");
+	if (attribute->getType() != type) {
+		LOGe("Cannot access " << Attribute::getTypeName(attribute->getType()) << " attribute '" << attribute->getName() << "' as " << Attribute::getTypeName(type) << ".");
 		return nullptr;
 	}
 
-	return boost::any_cast<T>(&entry->second);
+	auto entry = find(attribute);
+	if (entry == nullptr) {
+		return nullptr;
+	}
+
+	return _getValue<T>(*entry);
+}
+
+
+const bool* Values::getBoolean(const Name& name) const {
+	return _get<bool>(resolve(name, "access"), Type::BOOLEAN);
 }
 
 
 const bool* Values::getBoolean(const std::string& name) const {
-	return _get<bool>(name, Type::BOOLEAN);
+	return _get<bool>(resolve(name, "access"), Type::BOOLEAN);
 }
 
 
-const Values::Entries* Values::getEntries() const {
-	return _entries.get();
+const Values::Entry* Values::getEntry(const Name& name) const {
+	auto attribute = resolve(name, "access");
+	if (attribute == nullptr) {
+		return nullptr;
+	}
+
+	return find(attribute);
 }
 
 
 const Values::Entry* Values::getEntry(const std::string& name) const {
-	auto attribute = _scheme->getAttributeByName(name);
+	auto attribute = resolve(name, "access");
 	if (attribute == nullptr) {
-		LOGe("Cannot access non-existent attribute '" << name << "'.");
 		return nullptr;
 	}
 
+	return find(attribute);
+}
+
+
+const float* Values::getFloat(const Name& name) const {
+	return _get<float>(resolve(name, "access"), Type::FLOAT);
+}
+
+
+const float* Values::getFloat(const std::string& name) const {
+	return _get<float>(resolve(name, "access"), Type::FLOAT);
+}
+
+
+// The bytes allocated for the entries and their strings, not counting the allocator's own overhead.
+size_t Values::getHeapSize() const {
 	if (_entries == nullptr) {
-		return nullptr;
+		return 0;
 	}
 
-	auto it = _entries->find(attribute);
-	if (it == _entries->cend()) {
-		return nullptr;
+	size_t count = size();
+	size_t heapSize = (count + 1) * sizeof(Entry);
+
+	for (auto entry = _entries.get(); entry->_attribute != nullptr; ++entry) {
+		if (entry->_attribute->getType() != Type::STRING) {
+			continue;
+		}
+
+		heapSize += sizeof(std::string);
+
+		// short strings are kept within the string object itself
+		auto object = reinterpret_cast<const char*>(entry->_string);
+		auto data = entry->_string->data();
+		if (data < object || data >= object + sizeof(std::string)) {
+			heapSize += entry->_string->capacity() + 1;
+		}
 	}
 
-	return &(*it);
+	return heapSize;
 }
 
 
-const float* Values::getFloat(const std::string& name) const {
-	return _get<float>(name, Type::FLOAT);
+const int32_t* Values::getInteger(const Name& name) const {
+	return _get<int32_t>(resolve(name, "access"), Type::INTEGER);
 }
 
 
 const int32_t* Values::getInteger(const std::string& name) const {
-	return _get<int32_t>(name, Type::INTEGER);
+	return _get<int32_t>(resolve(name, "access"), Type::INTEGER);
+}
+
+
+const std::string* Values::getString(const Name& name) const {
+	return _get<std::string>(resolve(name, "access"), Type::STRING);
 }
 
 
 const std::string* Values::getString(const std::string& name) const {
-	return _get<std::string>(name, Type::STRING);
+	return _get<std::string>(resolve(name, "access"), Type::STRING);
+}
+
+
+bool Values::isEmpty() const {
+	return (_entries == nullptr);
 }
 
 
@@ -119,7 +350,10 @@ Values& Values::operator =(const Values& values) {
 	}
 
 	if (values._entries != nullptr) {
-		_entries = EntriesP(new Entries(*values._entries));
+		auto count = values.size();
+
+		_entries = Entries(new Entry[count + 1]);
+		std::copy(values._entries.get(), values._entries.get() + count, _entries.get());
 	}
 	else {
 		_entries = nullptr;
@@ -141,34 +375,73 @@ Values& Values::operator =(Values&& values) {
 }
 
 
-bool Values::isEmpty() const {
-	return (_entries == nullptr || _entries->empty());
+void Values::remove(const Attribute* attribute) {
+	if (find(attribute) == nullptr) {
+		return;
+	}
+
+	auto count = size();
+	if (count == 1) {
+		_entries = nullptr;
+		return;
+	}
+
+	Entries entries(new Entry[count]);
+
+	auto target = entries.get();
+	for (auto entry = _entries.get(); entry->_attribute != nullptr; ++entry) {
+		if (entry->_attribute != attribute) {
+			*target++ = std::move(*entry);
+		}
+	}
+
+	_entries = std::move(entries);
 }
 
 
-void Values::remove(const std::string& name) {
-	auto attribute = _scheme->getAttributeByName(name);
+void Values::remove(const Name& name) {
+	auto attribute = resolve(name, "remove");
 	if (attribute == nullptr) {
-		LOGe("Cannot remove non-existent attribute '" << name << "'.");
 		return;
 	}
 
-	if (_entries == nullptr) {
+	remove(attribute);
+}
+
+
+void Values::remove(const std::string& name) {
+	auto attribute = resolve(name, "remove");
+	if (attribute == nullptr) {
 		return;
 	}
 
-	_entries->erase(attribute);
-	if (_entries->empty()) {
-		_entries = nullptr;
+	remove(attribute);
+}
+
+
+const Attribute* Values::resolve(const Name& name, const char* action) const {
+	auto attribute = _scheme->getAttribute(name);
+	if (attribute == nullptr) {
+		LOGe("Cannot " << action << " non-existent attribute '" << name.getName() << "'.");
 	}
+
+	return attribute;
 }
 
 
-template <typename T>
-void Values::_set(const std::string& name, Type type, const T& value) {
+const Attribute* Values::resolve(const std::string& name, const char* action) const {
 	auto attribute = _scheme->getAttributeByName(name);
 	if (attribute == nullptr) {
-		LOGe("Cannot set non-existent attribute '" << name << "'.");
+		LOGe("Cannot " << action << " non-existent attribute '" << name << "'.");
+	}
+
+	return attribute;
+}
+
+
+template <typename T>
+void Values::_set(const Attribute* attribute, Type type, const T& value) {
+	if (attribute == nullptr) {
 		return;
 	}
 
@@ -177,29 +450,73 @@ void Values::_set(const std::string& name, Type type, const T& value) {
 		return;
 	}
 
-	if (_entries == nullptr) {
-		_entries = EntriesP(new Entries);
+	auto entry = const_cast<Entry*>(find(attribute));
+	if (entry == nullptr) {
+		// values are rarely added, so the array grows by exactly one entry
+		auto count = size();
+
+		Entries entries(new Entry[count + 2]);
+		std::move(_entries.get(), _entries.get() + count, entries.get());
+
+		_entries = std::move(entries);
+
+		entry = &_entries[count];
+		entry->_attribute = attribute;
 	}
 
-	(*_entries)[attribute] = value;
+	entry->set(value);
+}
+
+
+void Values::set(const Name& name, bool value) {
+	_set<bool>(resolve(name, "set"), Type::BOOLEAN, value);
+}
+
+
+void Values::set(const Name& name, float value) {
+	_set<float>(resolve(name, "set"), Type::FLOAT, value);
+}
+
+
+void Values::set(const Name& name, int32_t value) {
+	_set<int32_t>(resolve(name, "set"), Type::INTEGER, value);
+}
+
+
+void Values::set(const Name& name, const std::string& value) {
+	_set<std::string>(resolve(name, "set"), Type::STRING, value);
 }
 
 
 void Values::set(const std::string& name, bool value) {
-	_set<bool>(name, Type::BOOLEAN, value);
+	_set<bool>(resolve(name, "set"), Type::BOOLEAN, value);
 }
 
 
 void Values::set(const std::string& name, float value) {
-	_set<float>(name, Type::FLOAT, value);
+	_set<float>(resolve(name, "set"), Type::FLOAT, value);
 }
 
 
 void Values::set(const std::string& name, int32_t value) {
-	_set<int32_t>(name, Type::INTEGER, value);
+	_set<int32_t>(resolve(name, "set"), Type::INTEGER, value);
 }
 
 
 void Values::set(const std::string& name, const std::string& value) {
-	_set<std::string>(name, Type::STRING, value);
+	_set<std::string>(resolve(name, "set"), Type::STRING, value);
+}
+
+
+size_t Values::size() const {
+	if (_entries == nullptr) {
+		return 0;
+	}
+
+	size_t count = 0;
+	while (_entries[count]._attribute != nullptr) {
+		++count;
+	}
+
+	return count;
 }
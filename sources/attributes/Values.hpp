@@ -21,35 +21,92 @@
 namespace attributes {
 
 	class      Attribute;
+	class      Name;
 	class      Scheme;
 	enum class Type : uint8_t;
 
 	typedef std::shared_ptr<Scheme>  SchemeP;
 
 
+	// The attribute values of one object. They are stored in a single array which is only allocated once a value is set,
+	// so objects without attributes don't allocate anything. Objects rarely have more than a few values, so a linear
+	// search over the array is faster than hashing.
 	class Values {
 
 	public:
 
-		typedef std::unordered_map<const Attribute*,boost::any>  Entries;
-		typedef Entries::value_type                              Entry;
+		class Entry {
+
+		public:
+
+			Entry();
+			Entry(const Entry& entry);
+			Entry(Entry&& entry);
+			~Entry();
+
+			const Attribute&   getAttribute () const;
+			bool               getBoolean   () const;
+			float              getFloat     () const;
+			int32_t            getInteger   () const;
+			const std::string& getString    () const;
+
+			Entry& operator = (const Entry& entry);
+			Entry& operator = (Entry&& entry);
+
+
+		private:
+
+			void release ();
+			void set     (bool value);
+			void set     (float value);
+			void set     (int32_t value);
+			void set     (const std::string& value);
+
+
+			const Attribute* _attribute;
+
+			union {
+				bool         _boolean;
+				float        _float;
+				int32_t      _integer;
+				std::string* _string;
+			};
+
+
+			friend class Values;
+
+		};
 
 
 		Values(const SchemeP& scheme);
 
-		bool               contains   (const std::string& name) const;
-		const bool*        getBoolean (const std::string& name) const;
-		const Entries*     getEntries () const;
-		const Entry*       getEntry   (const std::string& name) const;
-		const float*       getFloat   (const std::string& name) const;
-		const int32_t*     getInteger (const std::string& name) const;
-		const std::string* getString  (const std::string& name) const;
-		bool               isEmpty    () const;
-		void               remove     (const std::string& name);
-		void               set        (const std::string& name, bool value);
-		void               set        (const std::string& name, float value);
-		void               set        (const std::string& name, int32_t value);
-		void               set        (const std::string& name, const std::string& value);
+		const Entry*       begin       () const;
+		bool               contains    (const Name& name) const;
+		bool               contains    (const std::string& name) const;
+		const Entry*       end         () const;
+		const bool*        getBoolean  (const Name& name) const;
+		const bool*        getBoolean  (const std::string& name) const;
+		const Entry*       getEntry    (const Name& name) const;
+		const Entry*       getEntry    (const std::string& name) const;
+		const float*       getFloat    (const Name& name) const;
+		const float*       getFloat    (const std::string& name) const;
+		size_t             getHeapSize () const;
+		const int32_t*     getInteger  (const Name& name) const;
+		const int32_t*     getInteger  (const std::string& name) const;
+		const std::string* getString   (const Name& name) const;
+		const std::string* getString   (const std::string& name) const;
+		bool               isEmpty     () const;
+		void               remove      (const Name& name);
+		void               remove      (const std::string& name);
+		void               set         (const Name& name, bool value);
+		void               set         (const Name& name, float value);
+		void               set         (const Name& name, int32_t value);
+		void               set         (const Name& name, const std::string& value);
+		void               set         (const std::string& name, bool value);
+		void               set         (const std::string& name, float value);
+		void               set         (const std::string& name, int32_t value);
+		void               set         (const std::string& name, const std::string& value);
+		size_t             size        () const;
 
 		Values& operator = (const Values& values);
 		Values& operator = (Values&& values);
@@ -57,24 +114,33 @@ namespace attributes {
 
 	private:
 
-		typedef std::unique_ptr<Entries> EntriesP;
+		typedef std::unique_ptr<Entry[]> Entries;
 
 
 		Values(const Values&) = delete;
 		Values(Values&&) = delete;
 
 
+		const Entry*     find    (const Attribute* attribute) const;
+		void             remove  (const Attribute* attribute);
+		const Attribute* resolve (const Name& name, const char* action) const;
+		const Attribute* resolve (const std::string& name, const char* action) const;
+
+		template <typename T>
+		const T* _get(const Attribute* attribute, Type type) const;
+
 		template <typename T>
-		const T* _get(const std::string& name, Type type) const;
+		static const T* _getValue(const Entry& entry);
 
 		template <typename T>
-		void _set(const std::string& name, Type type, const T& value);
+		void _set(const Attribute* attribute, Type type, const T& value);
 
 
 		LOGGER_DECLARATION;
 
 
-		EntriesP      _entries;
+		// terminated by an entry without attribute
+		Entries       _entries;
 		const SchemeP _scheme;
 
 	};
@@ -34,7 +34,7 @@
 
 
 
-const std::string BedItem::ATTRIBUTE_SLEEPSTART("sleepstart");
+const attributes::Name BedItem::ATTRIBUTE_SLEEPSTART("sleepstart");
 
 
 
@@ -28,7 +28,7 @@ class BedItem : public Item
 {
 	public:
 
-		static const std::string ATTRIBUTE_SLEEPSTART;
+		static const attributes::Name ATTRIBUTE_SLEEPSTART;
 
 
 		static ClassAttributesP   getClassAttributes();
@@ -18,6 +18,7 @@
 #include "chat.h"
 
 #include "player.h"
+#include "protocolgame.h"
 #include "ioguild.h"
 #include "iologindata.h"
 
@@ -171,8 +172,9 @@ bool ChatChannel::talk(Player* player, SpeakClasses type, const std::string& tex
 			player->addCondition(condition);
 	}
 
+	NetworkFragment_ptr fragment = ProtocolGame::createCreatureSpeak(player, type, text, m_id, _time);
 	for(it = m_users.begin(); it != m_users.end(); ++it)
-		it->second->sendToChannel(player, type, text, m_id, _time);
+		it->second->sendToChannel(player, type, text, m_id, _time, fragment);
 
 	if(hasFlag(CHANNELFLAG_LOGGED) && m_file->is_open())
 		*m_file << "[" << formatDate() << "] " << player->getName() << ": " << text << std::endl;
@@ -290,6 +290,17 @@ bool ConfigManager::load()
 	m_confDouble[RATE_MONSTER_MANA] = getGlobalDouble("rateMonsterMana", 1);
 	m_confDouble[RATE_MONSTER_ATTACK] = getGlobalDouble("rateMonsterAttack", 1);
 	m_confDouble[RATE_MONSTER_DEFENSE] = getGlobalDouble("rateMonsterDefense", 1);
+	m_confBool[BATCHED_CREATURE_THINKING] = getGlobalBool("batchedCreatureThinking", true);
+	m_confNumber[DISPATCHER_BATCH_SIZE] = getGlobalNumber("dispatcherBatchSize", 100);
+	m_confNumber[RSA_WORKER_THREADS] = getGlobalNumber("rsaWorkerThreads", 0);
+	m_confBool[ASYNC_PLAYER_SAVING] = getGlobalBool("asyncPlayerSaving", true);
+	m_confNumber[PLAYER_SAVE_BATCH_SIZE] = getGlobalNumber("playerSaveBatchSize", 50);
+	m_confBool[DELTA_PLAYER_SAVING] = getGlobalBool("deltaPlayerSaving", true);
+	m_confNumber[PATHFINDING_MAX_NODES] = getGlobalNumber("pathfindingMaxNodes", 512);
+	m_confBool[FLOW_FIELD_PATHING] = getGlobalBool("flowFieldPathing", true);
+	m_confBool[SHARED_MAP_TILES] = getGlobalBool("sharedMapTiles", true);
+	m_confNumber[NETWORK_THREADS] = getGlobalNumber("networkThreads", 0);
+	m_confNumber[BAN_REFRESH_INTERVAL] = getGlobalNumber("banRefreshInterval", 60);
 
 	m_loaded = true;
 	return true;
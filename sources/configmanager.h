@@ -159,6 +159,12 @@ class ConfigManager
 			LOOT_MESSAGE_TYPE,
 			NAME_REPORT_TYPE,
 			HOUSE_CLEAN_OLD,
+			DISPATCHER_BATCH_SIZE,
+			RSA_WORKER_THREADS,
+			PLAYER_SAVE_BATCH_SIZE,
+			PATHFINDING_MAX_NODES,
+			NETWORK_THREADS,
+			BAN_REFRESH_INTERVAL,
 			LAST_NUMBER_CONFIG /* this must be the last one */
 		};
 
@@ -249,6 +255,11 @@ class ConfigManager
 			ALLOW_FIGHTBACK,
 			VIPLIST_PER_PLAYER,
 			USE_FRAG_HANDLER,
+			BATCHED_CREATURE_THINKING,
+			ASYNC_PLAYER_SAVING,
+			DELTA_PLAYER_SAVING,
+			FLOW_FIELD_PATHING,
+			SHARED_MAP_TILES,
 			LAST_BOOL_CONFIG /* this must be the last one */
 		};
 
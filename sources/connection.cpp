@@ -18,6 +18,8 @@
 #include "otpch.h"
 #include "connection.h"
 
+#include "adler.h"
+
 #include "protocol.h"
 #include "protocolgame.h"
 #include "protocolold.h"
@@ -223,6 +225,10 @@ void Connection::closeSocket() {
 
 	boost::recursive_mutex::scoped_lock lock(m_connectionLock);
 
+	// queued messages keep a reference to this connection
+	m_sendQueue.clear();
+	m_sendQueueBytes = 0;
+
 	if(m_socket->is_open())
 	{
 		m_pendingRead = m_pendingWrite = 0;
@@ -432,6 +438,9 @@ void Connection::parsePacket(const boost::system::error_code& error)
 	else
 		m_protocol->onRecvMessage(m_msg); // Send the packet to the current protocol
 
+	if(m_readingPaused)
+		return;
+
 	try
 	{
 		++m_pendingRead;
@@ -455,6 +464,30 @@ void Connection::parsePacket(const boost::system::error_code& error)
 	}
 }
 
+void Connection::pauseReading()
+{
+	LOGt("Connection::pauseReading()");
+
+	boost::recursive_mutex::scoped_lock lock(m_connectionLock);
+	m_readingPaused = true;
+}
+
+void Connection::resumeReading()
+{
+	LOGt("Connection::resumeReading()");
+
+	boost::recursive_mutex::scoped_lock lock(m_connectionLock);
+	if(!m_readingPaused)
+		return;
+
+	m_readingPaused = false;
+	if(m_connectionState != CONNECTION_STATE_OPEN || m_readError)
+		return;
+
+	// Wait to the next packet
+	accept();
+}
+
 bool Connection::send(OutputMessage_ptr msg) {
 	LOGt("Connection::send()");
 
@@ -466,29 +499,55 @@ bool Connection::send(OutputMessage_ptr msg) {
 	}
 
 	TRACK_MESSAGE(msg);
-	if(!m_pendingWrite)
-	{
-		if(msg->getProtocol())
-			msg->getProtocol()->onSendMessage(msg);
-
-		internalSend(msg);
-	}
-	else if(m_pendingWrite > 100 && server.configManager().getBool(ConfigManager::FORCE_CLOSE_SLOW_CONNECTION))
+	if(m_sendQueue.size() >= slowConnectionQueueSize && server.configManager().getBool(ConfigManager::FORCE_CLOSE_SLOW_CONNECTION))
 	{
 		LOGd("Forcing slow connection to disconnect!");
 		close();
+
+		return true;
 	}
-	else
-	{	
-		OutputMessagePool::getInstance()->autoSend(msg);
+
+	if(msg->getProtocol())
+		msg->getProtocol()->onSendMessage(msg);
+
+	m_sendQueue.push_back(msg);
+	m_sendQueueBytes += msg->getMessageLength();
+
+	m_sendQueuePeakBytes = std::max(m_sendQueuePeakBytes, m_sendQueueBytes);
+	m_sendQueuePeakSize = std::max(m_sendQueuePeakSize, m_sendQueue.size());
+
+	if(m_sendQueue.size() >= m_sendQueueWarningSize)
+	{
+		LOGw("Send queue of connection " << convertIPAddress(getIP()) << " grew to " << m_sendQueue.size() << " messages (" << m_sendQueueBytes << " bytes).");
+		m_sendQueueWarningSize *= 2;
 	}
 
+	if(!m_pendingWrite)
+		internalSend();
+
 	return true;
 }
 
-void Connection::internalSend(OutputMessage_ptr msg)
+void Connection::internalSend()
 {
-	TRACK_MESSAGE(msg);
+	// all queued messages are written with one gathered write, no matter how many were added since the last write
+	std::vector<boost::asio::const_buffer> buffers;
+	buffers.reserve(std::min<size_t>(m_sendQueue.size(), maxGatheredMessages));
+
+	while(!m_sendQueue.empty() && buffers.size() < maxGatheredMessages)
+	{
+		OutputMessage_ptr msg = std::move(m_sendQueue.front());
+		m_sendQueue.pop_front();
+
+		TRACK_MESSAGE(msg);
+		buffers.push_back(boost::asio::const_buffer(msg->getOutputBuffer(), msg->getMessageLength()));
+		m_sendQueueBytes -= msg->getMessageLength();
+		m_writingMessages.push_back(std::move(msg));
+	}
+
+	if(m_sendQueue.empty())
+		m_sendQueueWarningSize = sendQueueWarningSize;
+
 	try
 	{
 		++m_pendingWrite;
@@ -496,9 +555,8 @@ void Connection::internalSend(OutputMessage_ptr msg)
 		m_writeTimer.async_wait(boost::bind(&Connection::handleWriteTimeout,
 			std::weak_ptr<Connection>(shared_from_this()), boost::asio::placeholders::error));
 
-		boost::asio::async_write(getHandle(),
-			boost::asio::buffer(msg->getOutputBuffer(), msg->getMessageLength()),
-			std::bind(&Connection::onWrite, shared_from_this(), msg, std::placeholders::_1));
+		boost::asio::async_write(getHandle(), buffers,
+			std::bind(&Connection::onWrite, shared_from_this(), std::placeholders::_1));
 	}
 	catch(boost::system::system_error& e)
 	{
@@ -532,15 +590,14 @@ uint32_t Connection::getIP() const
 	return 0;
 }
 
-void Connection::onWrite(OutputMessage_ptr msg, const boost::system::error_code& error) {
+void Connection::onWrite(const boost::system::error_code& error) {
 	LOGt("Connection::onWrite()");
 
 	boost::recursive_mutex::scoped_lock lock(m_connectionLock);
 
 	m_writeTimer.cancel();
 
-	TRACK_MESSAGE(msg);
-	msg.reset();
+	m_writingMessages.clear();
 	if(error)
 		handleWriteError(error);
 
@@ -553,6 +610,8 @@ void Connection::onWrite(OutputMessage_ptr msg, const boost::system::error_code&
 	}
 
 	--m_pendingWrite;
+	if(!m_pendingWrite && !m_sendQueue.empty())
+		internalSend();
 }
 
 void Connection::handleReadError(const boost::system::error_code& error)
@@ -86,6 +86,9 @@ class Connection : public std::enable_shared_from_this<Connection>, boost::nonco
 	public:
 		enum {writeTimeout = 30};
 		enum {readTimeout = 30};
+		enum {maxGatheredMessages = 64};
+		enum {sendQueueWarningSize = 64};
+		enum {slowConnectionQueueSize = 100};
 
 		enum ConnectionState_t
 		{
@@ -102,8 +105,10 @@ class Connection : public std::enable_shared_from_this<Connection>, boost::nonco
 			m_socket(socket), m_readTimer(io_service), m_writeTimer(io_service), m_service(io_service), m_servicePort(servicePort)
 		{
 			m_refCount = m_pendingWrite = m_pendingRead = 0;
+			m_sendQueueBytes = m_sendQueuePeakBytes = m_sendQueuePeakSize = 0;
+			m_sendQueueWarningSize = sendQueueWarningSize;
 			m_connectionState = CONNECTION_STATE_OPEN;
-			m_receivedFirst = m_writeError = m_readError = false;
+			m_receivedFirst = m_writeError = m_readError = m_readingPaused = false;
 			m_protocol = nullptr;
 
 #ifdef __ENABLE_SERVER_DIAGNOSTIC__
@@ -119,6 +124,7 @@ class Connection : public std::enable_shared_from_this<Connection>, boost::nonco
 		}
 
 		boost::asio::ip::tcp::socket& getHandle() {return *m_socket;}
+		boost::asio::io_service& getService() {return m_service;}
 		uint32_t getLocalIP() const;
 		uint32_t getIP() const;
 
@@ -128,14 +134,24 @@ class Connection : public std::enable_shared_from_this<Connection>, boost::nonco
 		bool send(OutputMessage_ptr msg);
 		void close();
 
+		// the next packet is only read once reading is resumed, e.g. while its decryption key is still unknown
+		void pauseReading();
+		void resumeReading();
+
 		int32_t addRef() {return ++m_refCount;}
 		int32_t unRef() {return --m_refCount;}
 
+		// back-pressure counters of messages which were encrypted but not yet handed to the socket
+		size_t getSendQueueBytes() const {return m_sendQueueBytes;}
+		size_t getSendQueuePeakBytes() const {return m_sendQueuePeakBytes;}
+		size_t getSendQueuePeakSize() const {return m_sendQueuePeakSize;}
+		size_t getSendQueueSize() const {return m_sendQueue.size();}
+
 	private:
 		void parseHeader(const boost::system::error_code& error);
 		void parsePacket(const boost::system::error_code& error);
 
-		void onWrite(OutputMessage_ptr msg, const boost::system::error_code& error);
+		void onWrite(const boost::system::error_code& error);
 		void onStop();
 
 		void handleReadError(const boost::system::error_code& error);
@@ -151,7 +167,7 @@ class Connection : public std::enable_shared_from_this<Connection>, boost::nonco
 		void onReadTimeout();
 		void onWriteTimeout();
 
-		void internalSend(OutputMessage_ptr msg);
+		void internalSend();
 		void closeSocket();
 
 		LOGGER_DECLARATION;
@@ -164,11 +180,16 @@ class Connection : public std::enable_shared_from_this<Connection>, boost::nonco
 
 		boost::asio::io_service& m_service;
 		ServicePort_ptr m_servicePort;
-		bool m_receivedFirst, m_writeError, m_readError;
+		bool m_receivedFirst, m_writeError, m_readError, m_readingPaused;
 
 		int32_t m_pendingWrite, m_pendingRead;
+
+		typedef std::deque<OutputMessage_ptr> OutputMessageQueue;
+		OutputMessageQueue m_sendQueue;
+		std::vector<OutputMessage_ptr> m_writingMessages;
+		size_t m_sendQueueBytes, m_sendQueuePeakBytes, m_sendQueuePeakSize, m_sendQueueWarningSize;
 		ConnectionState_t m_connectionState;
-		uint32_t m_refCount;
+		std::atomic<int32_t> m_refCount;
 
 		static bool m_logError;
 		boost::recursive_mutex m_connectionLock;
@@ -39,6 +39,12 @@
 
 const Duration Creature::THINK_DURATION = Seconds(1);
 const Duration Creature::THINK_INTERVAL = Milliseconds(100);
+const Duration Creature::THINK_TICK_REPORT_INTERVAL = Minutes(1);
+
+Creature::ThinkingCreatures Creature::_thinkingCreatures[Creature::THINKING_GROUPS];
+uint32_t                    Creature::_thinkTickCount = 0;
+Time                        Creature::_thinkTickReportTime;
+Scheduler::TaskId           Creature::_thinkTickTaskId = 0;
 
 LOGGER_DEFINITION(Creature);
 
@@ -378,6 +384,18 @@ auto Creature::getRoute() const -> const Route& {
 }
 
 
+size_t Creature::getThinkingGroup() const {
+	if (getPlayer() != nullptr) {
+		return 0;
+	}
+	if (getMonster() != nullptr) {
+		return 1;
+	}
+
+	return 2;
+}
+
+
 Direction Creature::getWanderingDirection() const {
 	return getRandomStepDirection();
 }
@@ -655,6 +673,11 @@ Direction Creature::route() {
 }
 
 
+void Creature::scheduleThinkTick(Time time) {
+	_thinkTickTaskId = server.scheduler().addTask(SchedulerTask::create(time, &Creature::thinkTick));
+}
+
+
 void Creature::setDefaultOutfit(Outfit_t defaultOutfit) {
 	this->defaultOutfit = defaultOutfit;
 }
@@ -759,7 +782,19 @@ bool Creature::startThinking(bool forced) {
 	_previousThinkTime = Clock::now();
 	_thinkDuration = THINK_DURATION;
 
-	server.dispatcher().addTask(Task::create(std::bind(&Creature::think, CreatureP(this))));
+	if (server.configManager().getBool(ConfigManager::BATCHED_CREATURE_THINKING)) {
+		auto& creatures = _thinkingCreatures[getThinkingGroup()];
+
+		_thinkingIndex = creatures.size();
+		creatures.push_back(this);
+
+		if (_thinkTickTaskId == 0) {
+			scheduleThinkTick(_previousThinkTime + THINK_INTERVAL);
+		}
+	}
+	else {
+		server.dispatcher().addTask(Task::create(std::bind(&Creature::think, CreatureP(this))));
+	}
 
 	onThinkingStarted();
 	return true;
@@ -818,6 +853,29 @@ void Creature::stopRouting() {
 }
 
 
+void Creature::stopAllThinking() {
+	if (_thinkTickTaskId != 0) {
+		server.scheduler().cancelTask(_thinkTickTaskId);
+		_thinkTickTaskId = 0;
+	}
+
+	// the groups hold strong references which would otherwise keep the creatures alive past the shutdown
+	for (auto& creatures : _thinkingCreatures) {
+		ThinkingCreatures stoppingCreatures;
+		stoppingCreatures.swap(creatures);
+
+		for (size_t index = 0; index < stoppingCreatures.size(); ++index) {
+			if (stoppingCreatures[index]->_thinkingIndex == index) {
+				stoppingCreatures[index]->stopThinking();
+			}
+		}
+	}
+
+	_thinkTickCount = 0;
+	_thinkTickReportTime = Time();
+}
+
+
 void Creature::stopThinking() {
 	if (!isThinking()) {
 		return;
@@ -828,6 +886,9 @@ void Creature::stopThinking() {
 		_thinkTaskId = 0;
 	}
 
+	// the slot is cleaned up by the next think tick
+	_thinkingIndex = NOT_THINKING;
+
 	_thinkDuration = Duration::zero();
 	onThinkingStopped();
 }
@@ -891,12 +952,71 @@ void Creature::think() {
 		return;
 	}
 
-	if (_thinkTaskId == 0) {
+	if (_thinkTaskId == 0 && _thinkingIndex == NOT_THINKING) {
 		_thinkTaskId = server.scheduler().addTask(SchedulerTask::create(THINK_INTERVAL, std::bind(&Creature::think, CreatureP(this))));
 	}
 }
 
 
+void Creature::thinkTick() {
+	_thinkTickTaskId = 0;
+
+	auto startTime = Clock::now();
+	size_t thinkingCount = 0;
+
+	for (auto& creatures : _thinkingCreatures) {
+		// Creatures which stopped thinking leave a stale slot behind which we drop here while compacting the list.
+		// Creatures which start thinking during the tick are appended and still think in this tick.
+		size_t nextIndex = 0;
+		for (size_t index = 0; index < creatures.size(); ++index) {
+			if (creatures[index]->_thinkingIndex != index) {
+				continue;
+			}
+
+			if (index != nextIndex) {
+				creatures[nextIndex] = std::move(creatures[index]);
+				creatures[nextIndex]->_thinkingIndex = nextIndex;
+			}
+
+			CreatureP creature = creatures[nextIndex];
+			++nextIndex;
+
+			creature->think();
+		}
+
+		creatures.resize(nextIndex);
+		thinkingCount += nextIndex;
+	}
+
+	auto endTime = Clock::now();
+	if (endTime - startTime > THINK_INTERVAL) {
+		LOGw("Think tick for " << thinkingCount << " creatures took " << std::chrono::duration_cast<Milliseconds>(endTime - startTime).count() << " ms.");
+	}
+
+	++_thinkTickCount;
+	if (_thinkTickReportTime == Time()) {
+		_thinkTickReportTime = startTime;
+		_thinkTickCount = 0;
+	}
+	else if (endTime - _thinkTickReportTime >= THINK_TICK_REPORT_INTERVAL) {
+		auto reportDuration = std::chrono::duration_cast<Milliseconds>(endTime - _thinkTickReportTime);
+		LOGi("Thinking at " << (_thinkTickCount * 1000.0 / reportDuration.count()) << " ticks per second for " << thinkingCount << " creatures.");
+
+		_thinkTickCount = 0;
+		_thinkTickReportTime = endTime;
+	}
+
+	// creatures which started thinking during the tick may already have scheduled the next one
+	if (thinkingCount > 0 && _thinkTickTaskId == 0) {
+		scheduleThinkTick(std::max(startTime + THINK_INTERVAL, endTime));
+	}
+	else if (_thinkTickTaskId == 0) {
+		// idle time would drag down the next report
+		_thinkTickReportTime = Time();
+	}
+}
+
+
 void Creature::updateFollowing() {
 	if (!_needsNewRouteToFollowedCreature) {
 		return;
@@ -921,7 +1041,7 @@ void Creature::updateFollowing() {
 	getPathSearchParams(_followedCreature.get(), parameters);
 
 	DirectionRoute route;
-	if (server.game().getPathToEx(this, _followedCreature->getPosition(), route, parameters)) {
+	if (server.game().getPathToCreature(this, *_followedCreature, route, parameters)) {
 		startRouting(route);
 	}
 	else {
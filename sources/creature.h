@@ -120,6 +120,10 @@ public:
 	typedef uint32_t                Id;
 	typedef std::deque<Position>    Route;
 
+
+	static void stopAllThinking ();
+
+
 	virtual bool         canAttack               (const Creature& creature) const = 0;
 	virtual bool         canFollow               (const CreatureP& target) const;
 	        bool         canMoveTo               (Direction direction) const;
@@ -204,18 +208,33 @@ protected:
 
 private:
 
-	static Id findNextFreeId();
+	typedef std::vector<CreatureP>  ThinkingCreatures;
+
+	static const size_t THINKING_GROUPS = 3;
+	static const size_t NOT_THINKING = std::numeric_limits<size_t>::max();
 
-	void stopFollowing   (bool preliminary);
-	void think           ();
-	void updateFollowing ();
-	void updateMovement  (Time now);
+
+	static Id   findNextFreeId    ();
+	static void scheduleThinkTick (Time time);
+	static void thinkTick         ();
+
+	size_t getThinkingGroup () const;
+	void   stopFollowing    (bool preliminary);
+	void   think            ();
+	void   updateFollowing  ();
+	void   updateMovement   (Time now);
 
 
 	LOGGER_DECLARATION;
 
 	static const Duration THINK_DURATION;
 	static const Duration THINK_INTERVAL;
+	static const Duration THINK_TICK_REPORT_INTERVAL;
+
+	static ThinkingCreatures _thinkingCreatures[THINKING_GROUPS];
+	static uint32_t          _thinkTickCount;
+	static Time              _thinkTickReportTime;
+	static Scheduler::TaskId _thinkTickTaskId;
 
 	CreatureP         _followedCreature;
 	Id                _id = 0;
@@ -226,6 +245,7 @@ private:
 	Time              _previousThinkTime;
 	Route             _route;
 	Duration          _thinkDuration = Duration::zero();
+	size_t            _thinkingIndex = NOT_THINKING;
 	Scheduler::TaskId _thinkTaskId = 0;
 	Tile*             _tile = nullptr;
 	bool              _wandering = false;
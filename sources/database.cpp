@@ -30,6 +30,48 @@ DBResultP Database::verifyResult(DBResultP result) {
 	return result;
 }
 
+bool DBResult::isNull(const std::string& field)
+{
+	int32_t column = getColumn(field);
+	return column >= 0 && isNull(column);
+}
+
+uint32_t DBResult::getUnsigned32(const std::string& field)
+{
+	int32_t column = getColumn(field);
+	return column >= 0 ? getUnsigned32(column) : 0;
+}
+
+int32_t DBResult::getDataInt(const std::string &s)
+{
+	int32_t column = getColumn(s);
+	return column >= 0 ? getDataInt(column) : 0;
+}
+
+int64_t DBResult::getDataLong(const std::string &s)
+{
+	int32_t column = getColumn(s);
+	return column >= 0 ? getDataLong(column) : 0;
+}
+
+std::string DBResult::getDataString(const std::string &s)
+{
+	int32_t column = getColumn(s);
+	return column >= 0 ? getDataString(column) : "";
+}
+
+const char* DBResult::getDataStream(const std::string &s, uint64_t &size)
+{
+	int32_t column = getColumn(s);
+	if(column < 0)
+	{
+		size = 0;
+		return nullptr;
+	}
+
+	return getDataStream(column, size);
+}
+
 DBInsert::DBInsert(Database& db)
 	: m_db(db), m_multiLine(db.getParam(DBPARAM_MULTIINSERT)), m_rows(0)
 {}
@@ -38,13 +80,19 @@ void DBInsert::setQuery(const std::string& query)
 {
 	m_query = query;
 	m_buf = "";
+	m_suffix = "";
 	m_rows = 0;
 }
 
+void DBInsert::setSuffix(const std::string& suffix)
+{
+	m_suffix = suffix;
+}
+
 bool DBInsert::addRow(const std::string& row)
 {
 	if(!m_multiLine) // executes INSERT for current row
-		return m_db.executeQuery(m_query + "(" + row + ")");
+		return m_db.executeQuery(m_query + "(" + row + ")" + m_suffix);
 
 	m_rows++;
 	int32_t size = m_buf.length();
@@ -81,7 +129,7 @@ bool DBInsert::execute()
 
 	m_rows = 0;
 	// executes buffer
-	bool res = m_db.executeQuery(m_query + m_buf);
+	bool res = m_db.executeQuery(m_query + m_buf + m_suffix);
 	m_buf = "";
 	return res;
 }
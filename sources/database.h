@@ -20,6 +20,7 @@
 
 class DBQuery;
 class DBResult;
+class DBStatement;
 
 typedef std::unique_ptr<DBResult>  DBResultP;
 
@@ -28,32 +29,45 @@ class DBResult
 {
 	public:
 
-		virtual bool isNull(const std::string& field) = 0;
-		virtual uint32_t getUnsigned32(const std::string& field) = 0;
+		/** Get the index of a field in database, which is faster to access than its name when reading many rows
+		*\returns The index of the field or -1 if there is no such field
+		*\param s The name of the field
+		*/
+		virtual int32_t getColumn(const std::string &s) {return -1;}
+
+		virtual bool isNull(uint32_t column) {return true;}
+		virtual uint32_t getUnsigned32(uint32_t column) {return 0;}
 
 		/** Get the Integer value of a field in database
 		*\returns The Integer value of the selected field and row
-		*\param s The name of the field
+		*\param column The index of the field
 		*/
-		virtual int32_t getDataInt(const std::string &s) {return 0;}
+		virtual int32_t getDataInt(uint32_t column) {return 0;}
 
 		/** Get the Long value of a field in database
 		*\returns The Long value of the selected field and row
-		*\param s The name of the field
+		*\param column The index of the field
 		*/
-		virtual int64_t getDataLong(const std::string &s) {return 0;}
+		virtual int64_t getDataLong(uint32_t column) {return 0;}
 
 		/** Get the String of a field in database
 		*\returns The String of the selected field and row
-		*\param s The name of the field
+		*\param column The index of the field
 		*/
-		virtual std::string getDataString(const std::string &s) {return "''";}
+		virtual std::string getDataString(uint32_t column) {return "";}
 
 		/** Get the blob of a field in database
-		*\returns a PropStream that is initiated with the blob data field, if not exist it returns nullptr.
-		*\param s The name of the field
+		*\returns a pointer to the blob data of the field, nullptr if it is null.
+		*\param column The index of the field
 		*/
-		virtual const char* getDataStream(const std::string &s, uint64_t &size) {return 0;}
+		virtual const char* getDataStream(uint32_t column, uint64_t &size) {size = 0; return nullptr;}
+
+		bool isNull(const std::string& field);
+		uint32_t getUnsigned32(const std::string& field);
+		int32_t getDataInt(const std::string &s);
+		int64_t getDataLong(const std::string &s);
+		std::string getDataString(const std::string &s);
+		const char* getDataStream(const std::string &s, uint64_t &size);
 
 		/** Moves to next result in set
 		*\returns true if moved, false if there are no more results.
@@ -69,6 +83,45 @@ class DBResult
 };
 
 
+class DBStatement
+{
+	public:
+		virtual ~DBStatement() {}
+
+		/**
+		* Binds value to a parameter.
+		*
+		* Values stay bound until they are replaced, so a statement may be executed again with only some of them changed.
+		*
+		* @param uint32_t position of the ? in the query, starting at 0
+		* @param value
+		*/
+		virtual void bind(uint32_t index, int32_t value) = 0;
+		virtual void bind(uint32_t index, uint32_t value) = 0;
+		virtual void bind(uint32_t index, int64_t value) = 0;
+		virtual void bind(uint32_t index, uint64_t value) = 0;
+		virtual void bind(uint32_t index, const std::string& value) = 0;
+		virtual void bindBlob(uint32_t index, const char* data, uint32_t length) = 0;
+
+		/**
+		* Executes statement which doesn't generate results (eg. INSERT, UPDATE, DELETE...).
+		*
+		* @return true on success, false on error
+		*/
+		virtual bool execute() = 0;
+
+		/**
+		* Executes statement which generates results (mostly SELECT).
+		*
+		* @return results object (null on error or if there are no rows)
+		*/
+		virtual DBResultP query() = 0;
+
+	protected:
+		DBStatement() {}
+};
+
+
 enum DBParam_t
 {
 	DBPARAM_MULTIINSERT = 1
@@ -142,6 +195,17 @@ class Database
 		*/
 		virtual DBResultP storeQuery(const std::string &query) {return 0;}
 
+		/**
+		* Prepares statement.
+		*
+		* Parameters are marked with ? in the query. Statements are prepared once per query and connection and are
+		* owned by the database, so they may be kept. They are used under the same lock as queries.
+		*
+		* @param std::string query
+		* @return statement
+		*/
+		virtual DBStatement* prepare(const std::string &query) = 0;
+
 		/**
 		* Escapes string for query.
 		*
@@ -230,6 +294,13 @@ class DBInsert
 		*/
 		void setQuery(const std::string& query);
 
+		/**
+		* Sets clause which is appended to the INSERT statement after the rows, e.g. ON DUPLICATE KEY UPDATE.
+		*
+		* @param std::string& clause
+		*/
+		void setSuffix(const std::string& suffix);
+
 		/**
 		* Adds new row to INSERT statement.
 		*
@@ -253,7 +324,7 @@ class DBInsert
 		bool m_multiLine;
 
 		uint32_t m_rows;
-		std::string m_query, m_buf;
+		std::string m_query, m_buf, m_suffix;
 };
 
 
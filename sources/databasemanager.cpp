@@ -39,6 +39,14 @@ DatabaseManager::DatabaseManager()
 DatabaseManager::~DatabaseManager() {}
 
 
+std::unique_ptr<Database> DatabaseManager::createDatabase() const {
+	std::unique_ptr<Database> database(new DatabaseMySQL(false));
+	database->use();
+
+	return database;
+}
+
+
 Database& DatabaseManager::getDatabase() const {
 	return *_database;
 }
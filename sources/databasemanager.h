@@ -30,6 +30,9 @@ class DatabaseManager
 
 		bool optimizeTables();
 
+		// opens an additional connection for use by another thread
+		std::unique_ptr<Database> createDatabase() const;
+
 		bool tableExists(std::string table);
 		bool triggerExists(std::string trigger);
 
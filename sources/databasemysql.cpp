@@ -34,20 +34,28 @@
 LOGGER_DEFINITION(DatabaseMySQL);
 
 
-DatabaseMySQL::DatabaseMySQL()
-	: m_attempts(0)
+DatabaseMySQL::DatabaseMySQL(bool primary /*= true*/)
+	: m_attempts(0),
+	  m_connections(0),
+	  m_primary(primary)
 {
 }
 
 
 DatabaseMySQL::~DatabaseMySQL() {
+	m_statements.clear();
 	mysql_close(&m_handle);
-	mysql_library_end();
+
+	if(m_primary)
+		mysql_library_end();
+	else
+		mysql_thread_end();
 }
 
 
 void DatabaseMySQL::start() {
-	mysql_library_init(0, nullptr, nullptr);
+	if(m_primary)
+		mysql_library_init(0, nullptr, nullptr);
 
 	m_connected = false;
 	if(!mysql_init(&m_handle))
@@ -72,7 +80,7 @@ void DatabaseMySQL::start() {
 		LOGw("Outdated MySQL server detected, consider upgrading to a newer version.");
 	}
 
-	if(server.configManager().getBool(ConfigManager::HOUSE_STORAGE))
+	if(m_primary && server.configManager().getBool(ConfigManager::HOUSE_STORAGE))
 	{
 		//we cannot lock mutex here :)
 		if(DBResultP result = storeQuery("SHOW variables LIKE 'max_allowed_packet';"))
@@ -86,7 +94,7 @@ void DatabaseMySQL::start() {
 	}
 
 	int32_t keepAlive = server.configManager().getNumber(ConfigManager::SQL_KEEPALIVE);
-	if(keepAlive)
+	if(m_primary && keepAlive)
 		server.scheduler().addTask(SchedulerTask::create(Milliseconds(keepAlive * 1000), std::bind(&DatabaseMySQL::keepAlive, this)));
 }
 
@@ -187,6 +195,15 @@ DBResultP DatabaseMySQL::storeQuery(const std::string &query)
 	return nullptr;
 }
 
+DBStatement* DatabaseMySQL::prepare(const std::string &query)
+{
+	Unique<MySQLStatement>& statement = m_statements[query];
+	if(!statement)
+		statement.reset(new MySQLStatement(*this, query));
+
+	return statement.get();
+}
+
 std::string DatabaseMySQL::escapeBlob(const char* s, uint32_t length)
 {
 	if(!s)
@@ -233,6 +250,7 @@ bool DatabaseMySQL::connect()
 
 	m_connected = true;
 	m_attempts = 0;
+	++m_connections;
 	return true;
 }
 
@@ -255,116 +273,81 @@ bool DatabaseMySQL::reconnect()
 LOGGER_DEFINITION(MySQLResult);
 
 
-bool MySQLResult::isNull(const std::string& field) {
-	listNames_t::iterator it = m_listNames.find(field);
-	if(it != m_listNames.end()) {
-		return (m_row[it->second] == nullptr);
-	}
-
-	if(refetch())
-		return isNull(field);
-
-	LOGe("Error during isNull(" << field << ").");
-	return 0; // Failed
-}
-
-
-uint32_t MySQLResult::getUnsigned32(const std::string& field) {
-	listNames_t::iterator it = m_listNames.find(field);
+int32_t MySQLResult::getColumn(const std::string &s)
+{
+	listNames_t::const_iterator it = m_listNames.find(s);
 	if(it != m_listNames.end())
-	{
-		if(!m_row[it->second])
-			return 0;
-
-		return static_cast<uint32_t>(atoll(m_row[it->second]));
-	}
+		return it->second;
 
 	if(refetch())
-		return getUnsigned32(field);
+		return getColumn(s);
 
-	LOGe("Error during getDataInt(" << field << ").");
-	return 0; // Failed
+	LOGe("Error during getColumn(" << s << ").");
+	return -1; // Failed
 }
 
+bool MySQLResult::isNull(uint32_t column)
+{
+	return (getValue(column) == nullptr);
+}
 
-int32_t MySQLResult::getDataInt(const std::string &s)
+uint32_t MySQLResult::getUnsigned32(uint32_t column)
 {
-	listNames_t::iterator it = m_listNames.find(s);
-	if(it != m_listNames.end())
-	{
-		if(!m_row[it->second])
-			return 0;
+	const char* value = getValue(column);
+	if(!value)
+		return 0;
 
-		return atoi(m_row[it->second]);
-	}
+	return static_cast<uint32_t>(atoll(value));
+}
 
-	if(refetch())
-		return getDataInt(s);
+int32_t MySQLResult::getDataInt(uint32_t column)
+{
+	const char* value = getValue(column);
+	if(!value)
+		return 0;
 
-	LOGe("Error during getDataInt(" << s << ").");
-	return 0; // Failed
+	return atoi(value);
 }
 
-int64_t MySQLResult::getDataLong(const std::string &s)
+int64_t MySQLResult::getDataLong(uint32_t column)
 {
-	listNames_t::iterator it = m_listNames.find(s);
-	if(it != m_listNames.end())
-	{
-		if(!m_row[it->second])
-			return 0;
+	const char* value = getValue(column);
+	if(!value)
+		return 0;
 
-		return atoll(m_row[it->second]);
-	}
+	return atoll(value);
+}
 
-	if(refetch())
-		return getDataLong(s);
+std::string MySQLResult::getDataString(uint32_t column)
+{
+	const char* value = getValue(column);
+	if(!value)
+		return "";
 
-	LOGe("Error during getDataLong(" << s << ").");
-	return 0; // Failed
+	return std::string(value);
 }
 
-std::string MySQLResult::getDataString(const std::string &s)
+const char* MySQLResult::getDataStream(uint32_t column, uint64_t &size)
 {
-	listNames_t::iterator it = m_listNames.find(s);
-	if(it != m_listNames.end())
+	const char* value = getValue(column);
+	if(!value)
 	{
-		if(!m_row[it->second])
-			return "";
-
-		return std::string(m_row[it->second]);
+		size = 0;
+		return nullptr;
 	}
 
-	if(refetch())
-		return getDataString(s);
-
-	LOGe("Error during getDataString(" << s << ").");
-	return ""; // Failed
+	size = mysql_fetch_lengths(m_handle)[column];
+	return value;
 }
 
-const char* MySQLResult::getDataStream(const std::string &s, uint64_t &size)
+const char* MySQLResult::getValue(uint32_t column) const
 {
-	listNames_t::iterator it = m_listNames.find(s);
-	if(it != m_listNames.end())
-	{
-		if(!m_row[it->second])
-		{
-			size = 0;
-			return nullptr;
-		}
-
-		size = mysql_fetch_lengths(m_handle)[it->second];
-		return m_row[it->second];
-	}
-
-	if(refetch())
-		return getDataStream(s, size);
+	if(column >= mysql_num_fields(m_handle))
+		return nullptr;
 
-	LOGe("Error during getDataStream(" << s << ").");
-	size = 0;
-	return nullptr; // Failed
+	return m_row[column];
 }
 
-
 bool MySQLResult::next()
 {
 	m_row = mysql_fetch_row(m_handle);
@@ -409,3 +392,372 @@ MySQLResult::~MySQLResult() {
 		mysql_free_result(m_handle);
 	}
 }
+
+
+
+
+LOGGER_DEFINITION(MySQLStatement);
+
+
+MySQLStatement::MySQLStatement(DatabaseMySQL& database, const std::string& query)
+	: m_database(database),
+	  m_handle(nullptr),
+	  m_connection(0),
+	  m_query(query)
+{
+}
+
+
+MySQLStatement::~MySQLStatement() {
+	if (m_handle != nullptr) {
+		mysql_stmt_close(m_handle);
+	}
+}
+
+
+void MySQLStatement::bind(uint32_t index, int32_t value) {
+	bind(index, static_cast<int64_t>(value));
+}
+
+
+void MySQLStatement::bind(uint32_t index, uint32_t value) {
+	bind(index, static_cast<int64_t>(value));
+}
+
+
+void MySQLStatement::bind(uint32_t index, int64_t value) {
+	Parameter& parameter = getParameter(index);
+	parameter.type = MYSQL_TYPE_LONGLONG;
+	parameter.isUnsigned = false;
+	parameter.number = value;
+}
+
+
+void MySQLStatement::bind(uint32_t index, uint64_t value) {
+	Parameter& parameter = getParameter(index);
+	parameter.type = MYSQL_TYPE_LONGLONG;
+	parameter.isUnsigned = true;
+	parameter.number = static_cast<int64_t>(value);
+}
+
+
+void MySQLStatement::bind(uint32_t index, const std::string& value) {
+	Parameter& parameter = getParameter(index);
+	parameter.type = MYSQL_TYPE_STRING;
+	parameter.isUnsigned = false;
+	parameter.data = value;
+}
+
+
+void MySQLStatement::bindBlob(uint32_t index, const char* data, uint32_t length) {
+	Parameter& parameter = getParameter(index);
+	parameter.type = MYSQL_TYPE_BLOB;
+	parameter.isUnsigned = false;
+	parameter.data.assign(data, length);
+}
+
+
+bool MySQLStatement::execute() {
+	if (!run()) {
+		return false;
+	}
+
+	mysql_stmt_free_result(m_handle);
+	return true;
+}
+
+
+MySQLStatement::Parameter& MySQLStatement::getParameter(uint32_t index) {
+	if (index >= m_parameters.size()) {
+		Parameter parameter;
+		parameter.type = MYSQL_TYPE_NULL;
+		parameter.isUnsigned = false;
+		parameter.number = 0;
+		parameter.length = 0;
+
+		m_parameters.resize(index + 1, parameter);
+	}
+
+	return m_parameters[index];
+}
+
+
+bool MySQLStatement::prepare() {
+	if (m_handle != nullptr) {
+		mysql_stmt_close(m_handle);
+	}
+
+	m_handle = mysql_stmt_init(&m_database.m_handle);
+	if (m_handle == nullptr) {
+		LOGe("mysql_stmt_init(): " << m_query << " - MYSQL ERROR: " << mysql_error(&m_database.m_handle) << " (" << mysql_errno(&m_database.m_handle) << ")");
+		return false;
+	}
+
+	if (mysql_stmt_prepare(m_handle, m_query.c_str(), m_query.length()) != 0) {
+		uint32_t error = mysql_stmt_errno(m_handle);
+		if ((error == CR_UNKNOWN_ERROR || error == CR_SERVER_LOST || error == CR_SERVER_GONE_ERROR) && m_database.reconnect()) {
+			return prepare();
+		}
+
+		LOGe("mysql_stmt_prepare(): " << m_query << " - MYSQL ERROR: " << mysql_stmt_error(m_handle) << " (" << error << ")");
+
+		mysql_stmt_close(m_handle);
+		m_handle = nullptr;
+		return false;
+	}
+
+	m_connection = m_database.m_connections;
+	return true;
+}
+
+
+DBResultP MySQLStatement::query() {
+	if (!run()) {
+		return nullptr;
+	}
+
+	if (mysql_stmt_store_result(m_handle) != 0) {
+		LOGe("mysql_stmt_store_result(): " << m_query << " - MYSQL ERROR: " << mysql_stmt_error(m_handle) << " (" << mysql_stmt_errno(m_handle) << ")");
+
+		mysql_stmt_free_result(m_handle);
+		return nullptr;
+	}
+
+	MYSQL_RES* metadata = mysql_stmt_result_metadata(m_handle);
+	if (metadata == nullptr) {
+		LOGe("Statement " << m_query << " doesn't return any results.");
+
+		mysql_stmt_free_result(m_handle);
+		return nullptr;
+	}
+
+	DBResultP result(new MySQLStatementResult(m_handle, metadata));
+
+	mysql_free_result(metadata);
+	mysql_stmt_free_result(m_handle);
+
+	return m_database.verifyResult(std::move(result));
+}
+
+
+bool MySQLStatement::run() {
+	if (!m_database.m_connected) {
+		return false;
+	}
+
+	if (m_handle == nullptr || m_connection != m_database.m_connections) {
+		if (!prepare()) {
+			return false;
+		}
+	}
+
+	if (m_parameters.size() != mysql_stmt_param_count(m_handle)) {
+		LOGe("Statement " << m_query << " has " << mysql_stmt_param_count(m_handle) << " parameters but " << m_parameters.size() << " were bound.");
+		return false;
+	}
+
+	if (!m_parameters.empty()) {
+		std::vector<MYSQL_BIND> binds(m_parameters.size());
+		for (size_t index = 0; index < m_parameters.size(); ++index) {
+			Parameter& parameter = m_parameters[index];
+			MYSQL_BIND& bind = binds[index];
+
+			bind.buffer_type = parameter.type;
+			bind.is_unsigned = parameter.isUnsigned;
+
+			if (parameter.type == MYSQL_TYPE_LONGLONG) {
+				bind.buffer = &parameter.number;
+			}
+			else if (parameter.type != MYSQL_TYPE_NULL) {
+				parameter.length = parameter.data.length();
+
+				bind.buffer = const_cast<char*>(parameter.data.data());
+				bind.buffer_length = parameter.length;
+				bind.length = &parameter.length;
+			}
+		}
+
+		if (mysql_stmt_bind_param(m_handle, binds.data())) {
+			LOGe("mysql_stmt_bind_param(): " << m_query << " - MYSQL ERROR: " << mysql_stmt_error(m_handle) << " (" << mysql_stmt_errno(m_handle) << ")");
+			return false;
+		}
+	}
+
+	m_database.use();
+
+	if (mysql_stmt_execute(m_handle) != 0) {
+		uint32_t error = mysql_stmt_errno(m_handle);
+		if ((error == CR_UNKNOWN_ERROR || error == CR_SERVER_LOST || error == CR_SERVER_GONE_ERROR) && m_database.reconnect()) {
+			return run();
+		}
+
+		LOGe("mysql_stmt_execute(): " << m_query << " - MYSQL ERROR: " << mysql_stmt_error(m_handle) << " (" << error << ")");
+		return false;
+	}
+
+	return true;
+}
+
+
+
+
+LOGGER_DEFINITION(MySQLStatementResult);
+
+
+MySQLStatementResult::MySQLStatementResult(MYSQL_STMT* statement, MYSQL_RES* metadata)
+	: m_columnCount(mysql_num_fields(metadata)),
+	  m_nextRow(0),
+	  m_row(0)
+{
+	typedef std::remove_pointer<decltype(MYSQL_BIND::is_null)>::type Flag;
+
+	MYSQL_FIELD* fields = mysql_fetch_fields(metadata);
+	for (uint32_t column = 0; column < m_columnCount; ++column) {
+		m_listNames[fields[column].name] = column;
+	}
+
+	// values are fetched as strings like results of queries and buffers grow when a value doesn't fit
+	std::vector<MYSQL_BIND> binds(m_columnCount);
+	std::vector<std::vector<char>> buffers(m_columnCount, std::vector<char>(64));
+	std::vector<unsigned long> lengths(m_columnCount);
+	std::unique_ptr<Flag[]> nulls(new Flag[m_columnCount]());
+
+	for (uint32_t column = 0; column < m_columnCount; ++column) {
+		MYSQL_BIND& bind = binds[column];
+		bind.buffer_type = MYSQL_TYPE_STRING;
+		bind.buffer = buffers[column].data();
+		bind.buffer_length = buffers[column].size();
+		bind.is_null = &nulls[column];
+		bind.length = &lengths[column];
+	}
+
+	if (mysql_stmt_bind_result(statement, binds.data())) {
+		LOGe("mysql_stmt_bind_result() - MYSQL ERROR: " << mysql_stmt_error(statement) << " (" << mysql_stmt_errno(statement) << ")");
+		return;
+	}
+
+	while (true) {
+		int status = mysql_stmt_fetch(statement);
+		if (status == MYSQL_NO_DATA) {
+			break;
+		}
+
+		if (status == 1) {
+			LOGe("mysql_stmt_fetch() - MYSQL ERROR: " << mysql_stmt_error(statement) << " (" << mysql_stmt_errno(statement) << ")");
+			break;
+		}
+
+		bool grown = false;
+		for (uint32_t column = 0; column < m_columnCount; ++column) {
+			Value value;
+			value.null = nulls[column];
+
+			if (!value.null) {
+				if (lengths[column] > buffers[column].size()) {
+					buffers[column].resize(lengths[column]);
+					binds[column].buffer = buffers[column].data();
+					binds[column].buffer_length = buffers[column].size();
+					grown = true;
+
+					mysql_stmt_fetch_column(statement, &binds[column], column, 0);
+				}
+
+				value.data.assign(buffers[column].data(), lengths[column]);
+			}
+
+			m_values.push_back(std::move(value));
+		}
+
+		if (grown) {
+			mysql_stmt_bind_result(statement, binds.data());
+		}
+	}
+}
+
+
+int32_t MySQLStatementResult::getColumn(const std::string &s) {
+	listNames_t::const_iterator it = m_listNames.find(s);
+	if (it == m_listNames.end()) {
+		LOGe("Error during getColumn(" << s << ").");
+		return -1;
+	}
+
+	return it->second;
+}
+
+
+int32_t MySQLStatementResult::getDataInt(uint32_t column) {
+	const Value* value = getValue(column);
+	if (value == nullptr || value->null) {
+		return 0;
+	}
+
+	return atoi(value->data.c_str());
+}
+
+
+int64_t MySQLStatementResult::getDataLong(uint32_t column) {
+	const Value* value = getValue(column);
+	if (value == nullptr || value->null) {
+		return 0;
+	}
+
+	return atoll(value->data.c_str());
+}
+
+
+const char* MySQLStatementResult::getDataStream(uint32_t column, uint64_t &size) {
+	const Value* value = getValue(column);
+	if (value == nullptr || value->null) {
+		size = 0;
+		return nullptr;
+	}
+
+	size = value->data.size();
+	return value->data.data();
+}
+
+
+std::string MySQLStatementResult::getDataString(uint32_t column) {
+	const Value* value = getValue(column);
+	if (value == nullptr || value->null) {
+		return "";
+	}
+
+	return value->data;
+}
+
+
+uint32_t MySQLStatementResult::getUnsigned32(uint32_t column) {
+	const Value* value = getValue(column);
+	if (value == nullptr || value->null) {
+		return 0;
+	}
+
+	return static_cast<uint32_t>(atoll(value->data.c_str()));
+}
+
+
+const MySQLStatementResult::Value* MySQLStatementResult::getValue(uint32_t column) const {
+	if (column >= m_columnCount || m_nextRow == 0) {
+		return nullptr;
+	}
+
+	return &m_values[m_row * m_columnCount + column];
+}
+
+
+bool MySQLStatementResult::isNull(uint32_t column) {
+	const Value* value = getValue(column);
+	return (value == nullptr || value->null);
+}
+
+
+bool MySQLStatementResult::next() {
+	if (m_columnCount == 0 || m_nextRow >= m_values.size() / m_columnCount) {
+		return false;
+	}
+
+	m_row = m_nextRow++;
+	return true;
+}
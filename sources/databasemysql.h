@@ -24,10 +24,16 @@
 #define MAX_REFETCH_ATTEMPTS 3
 
 
+class MySQLStatement;
+
+
 class DatabaseMySQL : public Database
 {
+	friend class MySQLStatement;
+
 	public:
-		DatabaseMySQL();
+		// only the primary connection initializes the client library and keeps the connection alive
+		explicit DatabaseMySQL(bool primary = true);
 		~DatabaseMySQL();
 
 		bool getParam(DBParam_t param);
@@ -38,6 +44,7 @@ class DatabaseMySQL : public Database
 
 		bool executeQuery(const std::string &query);
 		DBResultP storeQuery(const std::string &query);
+		DBStatement* prepare(const std::string &query);
 
 		std::string escapeString(const std::string &s) {return escapeBlob(s.c_str(), s.length());}
 		std::string escapeBlob(const char* s, uint32_t length);
@@ -47,6 +54,8 @@ class DatabaseMySQL : public Database
 		void start();
 
 	private:
+		typedef std::unordered_map<std::string, Unique<MySQLStatement>> StatementMap;
+
 		void keepAlive();
 
 		bool connect();
@@ -56,6 +65,9 @@ class DatabaseMySQL : public Database
 
 		MYSQL m_handle;
 		uint32_t m_attempts;
+		uint32_t m_connections; // statements prepared on an earlier connection are prepared again
+		bool m_primary;
+		StatementMap m_statements;
 };
 
 class MySQLResult : public DBResult
@@ -63,13 +75,14 @@ class MySQLResult : public DBResult
 	friend class DatabaseMySQL;
 
 	public:
-		virtual bool isNull(const std::string& field);
-		virtual uint32_t getUnsigned32(const std::string& field);
+		int32_t getColumn(const std::string &s);
 
-		int32_t getDataInt(const std::string &s);
-		int64_t getDataLong(const std::string &s);
-		std::string getDataString(const std::string &s);
-		const char* getDataStream(const std::string &s, uint64_t &size);
+		bool isNull(uint32_t column);
+		uint32_t getUnsigned32(uint32_t column);
+		int32_t getDataInt(uint32_t column);
+		int64_t getDataLong(uint32_t column);
+		std::string getDataString(uint32_t column);
+		const char* getDataStream(uint32_t column, uint64_t &size);
 
 		void free();
 		bool next();
@@ -79,11 +92,12 @@ class MySQLResult : public DBResult
 		virtual ~MySQLResult();
 
 		void fetch();
+		const char* getValue(uint32_t column) const;
 		bool refetch();
 
 		LOGGER_DECLARATION;
 
-		typedef std::map<const std::string, uint32_t> listNames_t;
+		typedef std::unordered_map<std::string, uint32_t> listNames_t;
 		listNames_t m_listNames;
 
 		MYSQL_RES* m_handle;
@@ -91,4 +105,85 @@ class MySQLResult : public DBResult
 		uint32_t m_attempts;
 };
 
+class MySQLStatement : public DBStatement
+{
+	friend class DatabaseMySQL;
+
+	public:
+		virtual ~MySQLStatement();
+
+		void bind(uint32_t index, int32_t value);
+		void bind(uint32_t index, uint32_t value);
+		void bind(uint32_t index, int64_t value);
+		void bind(uint32_t index, uint64_t value);
+		void bind(uint32_t index, const std::string& value);
+		void bindBlob(uint32_t index, const char* data, uint32_t length);
+
+		bool execute();
+		DBResultP query();
+
+	private:
+		struct Parameter
+		{
+			enum_field_types type;
+			bool isUnsigned;
+			int64_t number;
+			std::string data;
+			unsigned long length;
+		};
+
+		MySQLStatement(DatabaseMySQL& database, const std::string& query);
+
+		Parameter& getParameter(uint32_t index);
+		bool prepare();
+		bool run();
+
+		LOGGER_DECLARATION;
+
+		DatabaseMySQL& m_database;
+		MYSQL_STMT* m_handle;
+		uint32_t m_connection;
+		std::vector<Parameter> m_parameters;
+		std::string m_query;
+};
+
+// Rows of a statement are copied when it is executed, so that the statement may be executed again while they are read.
+class MySQLStatementResult : public DBResult
+{
+	friend class MySQLStatement;
+
+	public:
+		int32_t getColumn(const std::string &s);
+
+		bool isNull(uint32_t column);
+		uint32_t getUnsigned32(uint32_t column);
+		int32_t getDataInt(uint32_t column);
+		int64_t getDataLong(uint32_t column);
+		std::string getDataString(uint32_t column);
+		const char* getDataStream(uint32_t column, uint64_t &size);
+
+		bool next();
+
+	private:
+		struct Value
+		{
+			bool null;
+			std::string data;
+		};
+
+		MySQLStatementResult(MYSQL_STMT* statement, MYSQL_RES* metadata);
+
+		const Value* getValue(uint32_t column) const;
+
+		LOGGER_DECLARATION;
+
+		typedef std::unordered_map<std::string, uint32_t> listNames_t;
+		listNames_t m_listNames;
+
+		uint32_t m_columnCount;
+		size_t m_nextRow;
+		size_t m_row;
+		std::vector<Value> m_values;
+};
+
 #endif // _DATABASEMYSQL_H
@@ -21,7 +21,7 @@
 #include "tools.h"
 
 
-const std::string Depot::ATTRIBUTE_DEPOTID("depotid");
+const attributes::Name Depot::ATTRIBUTE_DEPOTID("depotid");
 
 
 Depot::Depot(const ItemKindPC& kind):
@@ -25,7 +25,7 @@ class Depot : public Container {
 
 	public:
 
-		static const std::string ATTRIBUTE_DEPOTID;
+		static const attributes::Name ATTRIBUTE_DEPOTID;
 
 
 		static ClassAttributesP   getClassAttributes();
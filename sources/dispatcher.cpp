@@ -19,6 +19,7 @@
 
 #include "dispatcher.h"
 
+#include "configmanager.h"
 #include "game.h"
 #include "outputmessage.h"
 #include "server.h"
@@ -27,10 +28,17 @@
 
 LOGGER_DEFINITION(Dispatcher);
 
+const Duration Dispatcher::STATISTICS_INTERVAL = std::chrono::minutes(1);
+
 
 
 Dispatcher::Dispatcher()
-	: _state(State::STOPPED)
+	: _state(State::STOPPED),
+	  _statisticsBatchCount(0),
+	  _statisticsBatchDuration(Duration::zero()),
+	  _statisticsMaximumBatchDuration(Duration::zero()),
+	  _statisticsStartTime(Clock::now()),
+	  _statisticsTaskCount(0)
 {
 }
 
@@ -102,33 +110,60 @@ Dispatcher::State Dispatcher::getState() {
 }
 
 
-void Dispatcher::runTask(const Task& task, Game& game, OutputMessagePool* messagePool) const {
-	if (task.getExpiration() < Clock::now()) {
+void Dispatcher::recordBatch(size_t taskCount, Duration duration) {
+	++_statisticsBatchCount;
+	_statisticsBatchDuration += duration;
+	_statisticsTaskCount += taskCount;
+
+	if (duration > _statisticsMaximumBatchDuration) {
+		_statisticsMaximumBatchDuration = duration;
+	}
+
+	auto now = Clock::now();
+	if (now - _statisticsStartTime < STATISTICS_INTERVAL) {
 		return;
 	}
 
+	LOGd("Ran " << _statisticsTaskCount << " tasks in " << _statisticsBatchCount << " batches, "
+		<< "average batch latency " << std::chrono::duration_cast<Milliseconds>(_statisticsBatchDuration / _statisticsBatchCount).count() << " ms, "
+		<< "maximum batch latency " << std::chrono::duration_cast<Milliseconds>(_statisticsMaximumBatchDuration).count() << " ms.");
+
+	_statisticsBatchCount = 0;
+	_statisticsBatchDuration = Duration::zero();
+	_statisticsMaximumBatchDuration = Duration::zero();
+	_statisticsStartTime = now;
+	_statisticsTaskCount = 0;
+}
+
+
+void Dispatcher::runTasks(const TaskDeque& tasks) {
+	if (tasks.empty()) {
+		return;
+	}
+
+	auto startTime = Clock::now();
+	auto messagePool = OutputMessagePool::getInstance();
+
+	// all tasks of a batch share one execution frame so that messages of each connection are sent together
 	if (messagePool != nullptr) {
 		messagePool->startExecutionFrame();
 	}
 
-	task();
+	for (const auto& task : tasks) {
+		if (task->getExpiration() < Clock::now()) {
+			continue;
+		}
+
+		(*task)();
+	}
 
-	// TODO run all(most?) outstanding tasks before sending all messages
 	if (messagePool != nullptr) {
 		messagePool->sendAll();
 	}
 
-	game.clearSpectatorCache();
-}
-
-
-void Dispatcher::runTasks(const TaskDeque& tasks) const {
-	auto& game = server.game();
-	auto messagePool = OutputMessagePool::getInstance();
+	server.game().trimSpectatorCache();
 
-	for (const auto& task : tasks) {
-		runTask(*task, game, messagePool);
-	}
+	recordBatch(tasks.size(), Clock::now() - startTime);
 }
 
 
@@ -165,6 +200,7 @@ void Dispatcher::stop() {
 
 void Dispatcher::thread() {
 	std::unique_lock<std::mutex> uniqueLock(_mutex, std::defer_lock);
+	TaskDeque tasks;
 
 	while (_state == State::STARTED) {
 		uniqueLock.lock();
@@ -178,19 +214,25 @@ void Dispatcher::thread() {
 			continue;
 		}
 
-		auto task = std::move(_tasks.front());
-		_tasks.pop_front();
+		auto batchSize = static_cast<size_t>(std::max<int32_t>(server.configManager().getNumber(ConfigManager::DISPATCHER_BATCH_SIZE), 0));
+		if (batchSize == 0 || _tasks.size() <= batchSize) {
+			tasks.swap(_tasks);
+		}
+		else {
+			auto batchEnd = _tasks.begin() + batchSize;
 
-		uniqueLock.unlock();
+			tasks.assign(std::make_move_iterator(_tasks.begin()), std::make_move_iterator(batchEnd));
+			_tasks.erase(_tasks.begin(), batchEnd);
+		}
 
-		auto& game = server.game();
-		auto messagePool = OutputMessagePool::getInstance();
+		uniqueLock.unlock();
 
-		runTask(*task, game, messagePool);
+		runTasks(tasks);
+		tasks.clear();
 	}
 
 	_mutex.lock();
-	auto tasks = std::move(_tasks);
+	tasks = std::move(_tasks);
 	_mutex.unlock();
 
 	runTasks(tasks);
@@ -18,8 +18,6 @@
 #ifndef _DISPATCHER_H
 #define _DISPATCHER_H
 
-class Game;
-class OutputMessagePool;
 class Task;
 
 
@@ -51,19 +49,27 @@ private:
 	typedef std::deque<TaskP>  TaskDeque;
 
 
-	void runTask (const Task& task, Game& game, OutputMessagePool* messagePool) const;
-	void runTasks(const TaskDeque& tasks) const;
-	void thread  ();
+	void recordBatch (size_t taskCount, Duration duration);
+	void runTasks    (const TaskDeque& tasks);
+	void thread      ();
 
 
 	LOGGER_DECLARATION;
 
+	static const Duration STATISTICS_INTERVAL;
+
 	std::mutex              _mutex;
 	std::condition_variable _signal;
 	volatile State          _state;
 	TaskDeque               _tasks;
 	std::thread             _thread;
 
+	uint64_t                _statisticsBatchCount;
+	Duration                _statisticsBatchDuration;
+	Duration                _statisticsMaximumBatchDuration;
+	Time                    _statisticsStartTime;
+	uint64_t                _statisticsTaskCount;
+
 };
 
 #endif // _DISPATCHER_H
@@ -17,6 +17,10 @@
 #include "otpch.h"
 #include "fileloader.h"
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
 FileLoader::FileLoader()
 {
 	m_file = nullptr;
@@ -31,6 +35,10 @@ FileLoader::FileLoader()
 	m_cache_index = NO_VALID_CACHE;
 	m_cache_offset = NO_VALID_CACHE;
 	memset(m_cached_data, 0, sizeof(m_cached_data));
+
+	//mapping
+	m_data = nullptr;
+	m_data_size = 0;
 }
 
 FileLoader::~FileLoader()
@@ -41,7 +49,11 @@ FileLoader::~FileLoader()
 		m_file = nullptr;
 	}
 
-	NodeStruct::clearNet(m_root);
+	if(m_data)
+		munmap(const_cast<uint8_t*>(m_data), m_data_size);
+	else
+		NodeStruct::clearNet(m_root);
+
 	delete[] m_buffer;
 	for(int32_t i = 0; i < CACHE_BLOCKS; i++)
 	{
@@ -111,6 +123,167 @@ bool FileLoader::openFile(const char* filename, bool write, bool caching /*= fal
 	return false;
 }
 
+bool FileLoader::mapFile(const char* filename)
+{
+	int32_t fd = open(filename, O_RDONLY);
+	if(fd == -1)
+	{
+		m_lastError = ERROR_CAN_NOT_OPEN;
+		return false;
+	}
+
+	struct stat fileStat;
+	if(fstat(fd, &fileStat) == -1 || fileStat.st_size < 6)
+	{
+		close(fd);
+		m_lastError = ERROR_EOF;
+		return false;
+	}
+
+	//the whole file is read front to back once while parsing, so it is faulted in up front where supported
+	int32_t flags = MAP_PRIVATE;
+#ifdef MAP_POPULATE
+	flags |= MAP_POPULATE;
+#endif
+
+	void* data = mmap(nullptr, fileStat.st_size, PROT_READ, flags, fd, 0);
+	close(fd);
+
+	if(data == MAP_FAILED)
+	{
+		m_lastError = ERROR_CAN_NOT_OPEN;
+		return false;
+	}
+
+	madvise(data, fileStat.st_size, MADV_SEQUENTIAL);
+
+	m_data = static_cast<const uint8_t*>(data);
+	m_data_size = fileStat.st_size;
+
+	uint32_t version;
+	memcpy(&version, m_data, sizeof(version));
+	if(version > 0)
+	{
+		m_lastError = ERROR_INVALID_FILE_VERSION;
+		return false;
+	}
+
+	if(m_data[4] != NODE_START)
+	{
+		m_lastError = ERROR_INVALID_FORMAT;
+		return false;
+	}
+
+	return parseMappedNodes();
+}
+
+bool FileLoader::parseMappedNodes()
+{
+	m_nodes.clear();
+
+	std::vector<NODE> parents;
+	NODE currentNode = nullptr;
+	NODE previousNode = nullptr;
+
+	size_t pos = 4;
+	while(pos < m_data_size)
+	{
+		switch(m_data[pos])
+		{
+			case NODE_START:
+			{
+				if(pos + 1 >= m_data_size)
+				{
+					m_lastError = ERROR_EOF;
+					return false;
+				}
+
+				m_nodes.push_back(NodeStruct());
+				NODE node = &m_nodes.back();
+				node->start = pos;
+				node->type = m_data[pos + 1];
+
+				if(previousNode)
+					previousNode->next = node;
+				else if(currentNode)
+				{
+					currentNode->propsSize = pos - currentNode->start - 2;
+					currentNode->child = node;
+				}
+				else
+					m_root = node;
+
+				parents.push_back(currentNode);
+				currentNode = node;
+				previousNode = nullptr;
+
+				pos += 2;
+				break;
+			}
+
+			case NODE_END:
+			{
+				if(!currentNode)
+				{
+					m_lastError = ERROR_INVALID_FORMAT;
+					return false;
+				}
+
+				if(!currentNode->child)
+					currentNode->propsSize = pos - currentNode->start - 2;
+
+				previousNode = currentNode;
+				currentNode = parents.back();
+				parents.pop_back();
+
+				++pos;
+				if(!currentNode)
+					return true;
+
+				break;
+			}
+
+			case ESCAPE_CHAR:
+			{
+				//escaped bytes are only removed when the properties of the node are read
+				if(!currentNode->child)
+					currentNode->escaped = true;
+
+				pos += 2;
+				break;
+			}
+
+			default:
+				pos = findSpecialByte(pos + 1);
+				break;
+		}
+	}
+
+	m_lastError = ERROR_EOF;
+	return false;
+}
+
+size_t FileLoader::findSpecialByte(size_t pos) const
+{
+	//most bytes are plain properties, so they are skipped eight at a time. A byte is special if it is 0xFD or above,
+	//that is if its high bit is set and adding 3 to its low seven bits carries into the high bit.
+	const uint64_t lowBits = UINT64_C(0x7F7F7F7F7F7F7F7F), highBits = UINT64_C(0x8080808080808080), three = UINT64_C(0x0303030303030303);
+	while(pos + sizeof(uint64_t) <= m_data_size)
+	{
+		uint64_t bytes;
+		memcpy(&bytes, m_data + pos, sizeof(bytes));
+		if(((bytes & lowBits) + three) & bytes & highBits)
+			break;
+
+		pos += sizeof(uint64_t);
+	}
+
+	while(pos < m_data_size && m_data[pos] < ESCAPE_CHAR)
+		++pos;
+
+	return pos;
+}
+
 bool FileLoader::parseNode(NODE node)
 {
 	int32_t byte, pos;
@@ -221,6 +394,35 @@ bool FileLoader::parseNode(NODE node)
 
 const uint8_t* FileLoader::getProps(const NodeStruct* node, uint32_t &size)
 {
+	if(node && m_data)
+	{
+		const uint8_t* props = m_data + node->start + 2;
+		if(!node->escaped)
+		{
+			size = node->propsSize;
+			return props;
+		}
+
+		if(node->propsSize > m_buffer_size)
+		{
+			delete[] m_buffer;
+			m_buffer = new uint8_t[node->propsSize];
+			m_buffer_size = node->propsSize;
+		}
+
+		uint32_t j = 0;
+		for(uint32_t i = 0; i < node->propsSize; ++i, ++j)
+		{
+			if(props[i] == ESCAPE_CHAR)
+				++i;
+
+			m_buffer[j] = props[i];
+		}
+
+		size = j;
+		return m_buffer;
+	}
+
 	if(node)
 	{
 		if(node->propsSize >= m_buffer_size)
@@ -274,6 +476,35 @@ bool FileLoader::getProps(const NodeStruct* node, PropStream &props)
 	return false;
 }
 
+bool FileLoader::getProps(const NodeStruct* node, PropStream& props, std::vector<uint8_t>& buffer) const
+{
+	//only mapped files can be read by several threads at once, each of them bringing its own buffer
+	if(!node || !m_data)
+	{
+		props.init(nullptr, 0);
+		return false;
+	}
+
+	const uint8_t* data = m_data + node->start + 2;
+	if(!node->escaped)
+	{
+		props.init((const char*)data, node->propsSize);
+		return true;
+	}
+
+	buffer.clear();
+	for(uint32_t i = 0; i < node->propsSize; ++i)
+	{
+		if(data[i] == ESCAPE_CHAR)
+			++i;
+
+		buffer.push_back(data[i]);
+	}
+
+	props.init((const char*)buffer.data(), buffer.size());
+	return true;
+}
+
 int32_t FileLoader::setProps(void* data, uint16_t size)
 {
 	//data
@@ -296,7 +527,7 @@ void FileLoader::endNode()
 	writeData(&nodeEnd, sizeof(nodeEnd), false);
 }
 
-const NodeStruct* FileLoader::getChildNode(const NodeStruct* parent, uint32_t &type)
+const NodeStruct* FileLoader::getChildNode(const NodeStruct* parent, uint32_t &type) const
 {
 	if(parent)
 	{
@@ -311,7 +542,7 @@ const NodeStruct* FileLoader::getChildNode(const NodeStruct* parent, uint32_t &t
 	return m_root;
 }
 
-const NodeStruct* FileLoader::getNextNode(const NodeStruct* prev, uint32_t &type)
+const NodeStruct* FileLoader::getNextNode(const NodeStruct* prev, uint32_t &type) const
 {
 	if(prev)
 	{
@@ -27,11 +27,13 @@ struct NodeStruct
 	{
 		start = propsSize = type = 0;
 		next = child = 0;
+		escaped = false;
 	}
 
 	uint32_t start, propsSize, type;
 	NodeStruct* next;
 	NodeStruct* child;
+	bool escaped; //only known for mapped files
 
 	static void clearNet(NodeStruct* root) {if(root) clearChild(root); }
 	private:
@@ -87,10 +89,12 @@ class FileLoader
 		~FileLoader();
 
 		bool openFile(const char* filename, bool write, bool caching = false);
+		bool mapFile(const char* filename);
 		const uint8_t* getProps(const NodeStruct*, uint32_t &size);
 		bool getProps(const NodeStruct*, PropStream& props);
-		const NodeStruct* getChildNode(const NodeStruct* parent, uint32_t &type);
-		const NodeStruct* getNextNode(const NodeStruct* prev, uint32_t &type);
+		bool getProps(const NodeStruct*, PropStream& props, std::vector<uint8_t>& buffer) const;
+		const NodeStruct* getChildNode(const NodeStruct* parent, uint32_t &type) const;
+		const NodeStruct* getNextNode(const NodeStruct* prev, uint32_t &type) const;
 
 		void startNode(uint8_t type);
 		void endNode();
@@ -107,6 +111,8 @@ class FileLoader
 			ESCAPE_CHAR = 0xFD,
 		};
 		bool parseNode(NODE node);
+		bool parseMappedNodes();
+		size_t findSpecialByte(size_t pos) const;
 
 		inline bool readByte(int32_t &value);
 		inline bool readBytes(unsigned char* buffer, int32_t size, int32_t pos);
@@ -164,6 +170,11 @@ class FileLoader
 		uint32_t m_cache_index, m_cache_offset;
 		inline uint32_t getCacheBlock(uint32_t pos);
 		int32_t loadCacheBlock(uint32_t pos);
+
+		//mapped files are parsed in place, their nodes point at each other and must never move
+		const uint8_t* m_data;
+		size_t m_data_size;
+		std::deque<NodeStruct> m_nodes;
 };
 
 class PropStream
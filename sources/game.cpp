@@ -60,6 +60,7 @@
 #include "creatureevent.h"
 #include "group.h"
 #include "player.h"
+#include "protocolgame.h"
 #include "scheduler.h"
 #include "schedulertask.h"
 #include "server.h"
@@ -220,6 +221,7 @@ void Game::setGameState(GameState_t newState)
 				server.globalEvents().startup();
 
 				IOBan::getInstance()->clearTemporials();
+				IOBan::getInstance()->scheduleRefresh();
 				break;
 			}
 
@@ -557,13 +559,7 @@ PlayerP Game::getPlayerByName(const std::string& name) {
 		return nullptr;
 	}
 
-	for (auto& player : server.world().getPlayers()) {
-		if (boost::iequals(player->getName(), name)) {
-			return player;
-		}
-	}
-
-	return nullptr;
+	return server.world().getPlayerByName(name);
 }
 
 PlayerP Game::getPlayerByNameEx(const std::string& name)
@@ -598,13 +594,7 @@ PlayerP Game::getPlayerByGuid(uint32_t guid) {
 		return nullptr;
 	}
 
-	for (auto& player : server.world().getPlayers()) {
-		if (player->getGUID() == guid) {
-			return player;
-		}
-	}
-
-	return nullptr;
+	return server.world().getPlayerByGuid(guid);
 }
 
 PlayerP Game::getPlayerByGuidEx(uint32_t guid)
@@ -654,43 +644,33 @@ ReturnValue Game::getPlayerByNameWildcard(std::string s, Player*& player)
 		return RET_NOERROR;
 	}
 
-	Player* last = nullptr;
 	s = s.substr(0, s.length() - 1);
 
-	for (auto& player : server.world().getPlayers()) {
-		if (!boost::iequals(player->getName().substr(0, s.length()), s)) {
-			continue;
-		}
-
-		if(last)
-			return RET_NAMEISTOOAMBIGUOUS;
-
-		last = player.get();
-	}
-
-	if(!last)
+	// a second match is enough to know that the name is ambiguous
+	auto players = server.world().getPlayersByNamePrefix(s, 2);
+	if(players.empty())
 		return RET_PLAYERWITHTHISNAMEISNOTONLINE;
 
-	player = last;
+	if(players.size() > 1)
+		return RET_NAMEISTOOAMBIGUOUS;
+
+	player = players.front().get();
 	return RET_NOERROR;
 }
 
 Player* Game::getPlayerByAccount(uint32_t accountId) {
-	for (auto& player : server.world().getPlayers()) {
-		if (player->getAccount() != nullptr && player->getAccount()->getId() == accountId) {
-			return player.get();
-		}
+	auto& players = server.world().getPlayersByAccount(accountId);
+	if (players.empty()) {
+		return nullptr;
 	}
 
-	return nullptr;
+	return players.front().get();
 }
 
 PlayerVector Game::getPlayersByName(const std::string& name) {
 	PlayerVector players;
-	for (auto& player : server.world().getPlayers()) {
-		if (boost::iequals(player->getName(), name)) {
-			players.push_back(player.get());
-		}
+	for (auto& player : server.world().getPlayersByName(name)) {
+		players.push_back(player.get());
 	}
 
 	return players;
@@ -698,19 +678,25 @@ PlayerVector Game::getPlayersByName(const std::string& name) {
 
 PlayerVector Game::getPlayersByAccount(uint32_t accountId) {
 	PlayerVector players;
-	for (auto& player : server.world().getPlayers()) {
-		if (player->getAccount() != nullptr && player->getAccount()->getId() == accountId) {
-			players.push_back(player.get());
-		}
+	for (auto& player : server.world().getPlayersByAccount(accountId)) {
+		players.push_back(player.get());
 	}
 
 	return players;
 }
 
 PlayerVector Game::getPlayersByIP(uint32_t ip, uint32_t mask) {
-	ip &= mask;
-
 	PlayerVector players;
+	if (mask == 0xFFFFFFFF) {
+		for (auto& player : server.world().getPlayersByIp(ip)) {
+			players.push_back(player.get());
+		}
+
+		return players;
+	}
+
+	// masked lookups cover address ranges, which the index by address cannot answer
+	ip &= mask;
 	for (auto& player : server.world().getPlayers()) {
 		if ((player->getIP() & mask) == ip) {
 			players.push_back(player.get());
@@ -3680,14 +3666,20 @@ bool Game::internalCreatureSay(Creature* creature, SpeakClasses type, const std:
 		list = (*spectators);
 
 	//send to client
+	NetworkFragment_ptr fragment;
 	Player* tmpPlayer = nullptr;
 	for(it = list.begin(); it != list.end(); ++it)
 	{
 		if(!(tmpPlayer = (*it)->getPlayer()))
 			continue;
 
-		if(!ghostMode || tmpPlayer->canSeeCreature(*creature))
-			tmpPlayer->sendCreatureSay(creature, type, text, &destPos);
+		if(ghostMode && !tmpPlayer->canSeeCreature(*creature))
+			continue;
+
+		if(!fragment)
+			fragment = ProtocolGame::createCreatureSpeak(creature, type, text, 0, 0, &destPos);
+
+		tmpPlayer->sendCreatureSay(creature, type, text, &destPos, fragment);
 	}
 
 	//event method
@@ -3708,6 +3700,12 @@ bool Game::getPathToEx(const Creature* creature, const Position& targetPos,
 	return map->getPathMatching(creature, route, FrozenPathingConditionCall(targetPos), fpp);
 }
 
+bool Game::getPathToCreature(const Creature* creature, const Creature& target,
+	std::deque<Direction>& route, const FindPathParams& fpp)
+{
+	return map->getPathToCreature(creature, target, route, fpp);
+}
+
 bool Game::getPathToEx(const Creature* creature, const Position& targetPos, std::deque<Direction>& route,
 	uint32_t minTargetDist, uint32_t maxTargetDist, bool fullPathSearch /*= true*/,
 	bool clearSight /*= true*/, int32_t maxSearchDist /*= -1*/)
@@ -4212,11 +4210,13 @@ void Game::addAnimatedText(const Position& pos, uint8_t textColor,
 void Game::addAnimatedText(const SpectatorList& list, const Position& pos, uint8_t textColor,
 	const std::string& text)
 {
+	NetworkFragment_ptr fragment = ProtocolGame::createAnimatedText(pos, textColor, text);
+
 	Player* player = nullptr;
 	for(SpectatorList::const_iterator it = list.begin(); it != list.end(); ++it)
 	{
 		if((player = (*it)->getPlayer()))
-			player->sendAnimatedText(pos, textColor, text);
+			player->sendAnimatedText(pos, textColor, text, fragment);
 	}
 }
 
@@ -4234,11 +4234,13 @@ void Game::addMagicEffect(const SpectatorList& list, const Position& pos, uint8_
 	if(ghostMode)
 		return;
 
+	NetworkFragment_ptr fragment = ProtocolGame::createMagicEffect(pos, effect);
+
 	Player* player = nullptr;
 	for(SpectatorList::const_iterator it = list.begin(); it != list.end(); ++it)
 	{
 		if((player = (*it)->getPlayer()))
-			player->sendMagicEffect(pos, effect);
+			player->sendMagicEffect(pos, effect, fragment);
 	}
 }
 
@@ -4252,11 +4254,13 @@ void Game::addDistanceEffect(const Position& fromPos, const Position& toPos, uin
 
 void Game::addDistanceEffect(const SpectatorList& list, const Position& fromPos, const Position& toPos, uint8_t effect)
 {
+	NetworkFragment_ptr fragment = ProtocolGame::createDistanceShoot(fromPos, toPos, effect);
+
 	Player* player = nullptr;
 	for(SpectatorList::const_iterator it = list.begin(); it != list.end(); ++it)
 	{
 		if((player = (*it)->getPlayer()))
-			player->sendDistanceShoot(fromPos, toPos, effect);
+			player->sendDistanceShoot(fromPos, toPos, effect, fragment);
 	}
 }
 
@@ -5821,6 +5825,7 @@ void Game::shutdown()
 	LOGi("Preparing to shutdown the server...");
 	server.scheduler().waitUntilStopped();
 	server.dispatcher().waitUntilStopped();
+	Creature::stopAllThinking();
 	Spawns::getInstance()->clear();
 	Raids::getInstance()->clear();
 	clear();
@@ -203,6 +203,12 @@ private:
 		Tile* getTile(int32_t x, int32_t y, int32_t z) const {return map->getTile(x, y, z);}
 		Tile* getTile(const Position& pos) const {return map->getTile(pos);}
 
+		/**
+		  * Get a single tile of the map for reading, without creating it from its template.
+		  * \returns A pointer to the tile or to the shared tile of its template, which must not be changed
+		  */
+		const Tile* getTileForReading(const Position& pos) const {return map->getTileForReading(pos);}
+
 
 		/**
 		  * Returns a creature based on a string name identifier
@@ -299,7 +305,7 @@ private:
 			int32_t minRangeY = 0, int32_t maxRangeY = 0)
 			{map->getSpectators(list, centerPos, checkforduplicate, multifloor, minRangeX, maxRangeX, minRangeY, maxRangeY);}
 		const SpectatorList& getSpectators(const Position& centerPos) {return map->getSpectators(centerPos);}
-		void clearSpectatorCache() {if(map) map->clearSpectatorCache();}
+		void trimSpectatorCache() {if(map) map->trimSpectatorCache();}
 
 		ReturnValue internalMoveCreature(Creature* creature, Direction direction, uint32_t flags = 0);
 
@@ -488,6 +494,9 @@ private:
 		bool getPathToEx(const Creature* creature, const Position& targetPos, std::deque<Direction>& route,
 			const FindPathParams& fpp);
 
+		bool getPathToCreature(const Creature* creature, const Creature& target, std::deque<Direction>& route,
+			const FindPathParams& fpp);
+
 		bool getPathToEx(const Creature* creature, const Position& targetPos, std::deque<Direction>& route,
 			uint32_t minTargetDist, uint32_t maxTargetDist, bool fullPathSearch = true,
 			bool clearSight = true, int32_t maxSearchDist = -1);
@@ -37,7 +37,7 @@
 #include "server.h"
 
 
-const std::string Door::ATTRIBUTE_DOORID("doorid");
+const attributes::Name Door::ATTRIBUTE_DOORID("doorid");
 
 
 House::House(uint32_t houseId) :
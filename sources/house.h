@@ -85,7 +85,7 @@ class Door : public Item
 {
 	public:
 
-		static const std::string ATTRIBUTE_DOORID;
+		static const attributes::Name ATTRIBUTE_DOORID;
 
 
 		static ClassAttributesP   getClassAttributes();
@@ -18,8 +18,11 @@
 #include "ioban.h"
 
 #include "tools.h"
+#include "configmanager.h"
 #include "database.h"
 #include "iologindata.h"
+#include "scheduler.h"
+#include "schedulertask.h"
 #include "server.h"
 
 bool IOBan::isIpBanished(uint32_t ip, uint32_t mask/* = 0xFFFFFFFF*/) const
@@ -27,42 +30,57 @@ bool IOBan::isIpBanished(uint32_t ip, uint32_t mask/* = 0xFFFFFFFF*/) const
 	if(!ip)
 		return false;
 
-	Database& db = server.database();
-	DBResultP result;
-
-	DBQuery query;
-	query << "SELECT `id`, `value`, `param`, `expires` FROM `bans` WHERE `type` = " << BAN_IP << " AND `active` = 1";
-	if(!(result = db.storeQuery(query.str())))
-		return false;
-
 	bool ret = false;
-	do
+	std::vector<std::pair<uint32_t, uint32_t>> expiredBans;
 	{
-		uint32_t value = result->getDataInt("value"), param = result->getDataInt("param");
-		if((ip & mask & param) == (value & param & mask))
+		std::lock_guard<std::mutex> lock(m_indexLock);
+		for(IpBanIndex::const_iterator it = m_ipBans.begin(); it != m_ipBans.end(); ++it)
 		{
-			int32_t expires = result->getDataLong("expires");
-			if(expires > 0 && expires <= (int32_t)time(nullptr))
-				removeIpBanishment(value, param);
-			else if(!ret)
-				ret = true;
+			uint32_t param = it->first;
+			if(mask == 0xFFFFFFFF)
+			{
+				auto bans = it->second.find(ip & param);
+				if(bans == it->second.end())
+					continue;
+
+				for(const IndexedBan& ban : bans->second)
+				{
+					if(isExpired(ban.expires))
+						expiredBans.push_back(std::make_pair(ban.value, param));
+					else
+						ret = true;
+				}
+			}
+			else
+			{
+				// partial masks are only used by scripts, so these compare against all bans of the group
+				for(const auto& bans : it->second)
+				{
+					for(const IndexedBan& ban : bans.second)
+					{
+						if((ip & mask & param) != (ban.value & param & mask))
+							continue;
+
+						if(isExpired(ban.expires))
+							expiredBans.push_back(std::make_pair(ban.value, param));
+						else
+							ret = true;
+					}
+				}
+			}
 		}
 	}
-	while(result->next());
+
+	for(const auto& ban : expiredBans)
+		removeIpBanishment(ban.first, ban.second);
+
 	return ret;
 }
 
 bool IOBan::isPlayerBanished(uint32_t playerId, PlayerBan_t type) const
 {
-	Database& db = server.database();
-	DBResultP result;
-
-	DBQuery query;
-	query << "SELECT `id` FROM `bans` WHERE `type` = " << BAN_PLAYER << " AND `value` = " << playerId << " AND `param` = " << type << " AND `active` = 1 LIMIT 1";
-	if(!(result = db.storeQuery(query.str())))
-		return false;
-
-	return true;
+	std::lock_guard<std::mutex> lock(m_indexLock);
+	return m_playerBans.count(playerBanKey(playerId, type)) != 0;
 }
 
 bool IOBan::isPlayerBanished(std::string name, PlayerBan_t type) const
@@ -74,23 +92,29 @@ bool IOBan::isPlayerBanished(std::string name, PlayerBan_t type) const
 
 bool IOBan::isAccountBanished(uint32_t account, uint32_t playerId/* = 0*/) const
 {
-	Database& db = server.database();
-	DBResultP result;
+	bool found = false;
+	{
+		std::lock_guard<std::mutex> lock(m_indexLock);
 
-	DBQuery query;
-	query << "SELECT `expires` FROM `bans` WHERE `type` = " << BAN_ACCOUNT << " AND `value` = " << account;
-	if(playerId > 0)
-		query << " AND `param` = " << playerId;
+		AccountBanIndex::const_iterator it = m_accountBans.find(account);
+		if(it == m_accountBans.end())
+			return false;
 
-	query << " AND `active` = 1 LIMIT 1";
-	if(!(result = db.storeQuery(query.str())))
-		return false;
+		for(const IndexedBan& ban : it->second)
+		{
+			if(playerId > 0 && ban.value != playerId)
+				continue;
 
-	const int32_t expires = result->getDataInt("expires");
-	if(expires <= 0 || expires > (int32_t)time(nullptr))
-		return true;
+			if(!isExpired(ban.expires))
+				return true;
+
+			found = true;
+		}
+	}
+
+	if(found)
+		removeAccountBanishment(account);
 
-	removeAccountBanishment(account);
 	return false;
 }
 
@@ -106,7 +130,12 @@ bool IOBan::addIpBanishment(uint32_t ip, int64_t banTime, uint32_t reasonId,
 	query << "INSERT INTO `bans` (`id`, `type`, `value`, `param`, `expires`, `added`, `admin_id`, `comment`, `reason`, `statement`) ";
 	query << "VALUES (NULL, " << BAN_IP << ", " << ip << ", " << mask << ", " << banTime << ", " << time(nullptr) << ", " << gamemaster;
 	query << ", " << db.escapeString(comment.c_str()) << ", " << reasonId << ", " << db.escapeString(statement.c_str()) << ")";
-	return db.executeQuery(query.str());
+	if(!db.executeQuery(query.str()))
+		return false;
+
+	std::lock_guard<std::mutex> lock(m_indexLock);
+	m_ipBans[mask][ip & mask].push_back(IndexedBan(ip, (int32_t)banTime));
+	return true;
 }
 
 bool IOBan::addPlayerBanishment(uint32_t playerId, int64_t banTime, uint32_t reasonId, ViolationAction_t actionId,
@@ -121,7 +150,12 @@ bool IOBan::addPlayerBanishment(uint32_t playerId, int64_t banTime, uint32_t rea
 	query << "INSERT INTO `bans` (`id`, `type`, `value`, `param`, `expires`, `added`, `admin_id`, `comment`, `reason`, `action`, `statement`) ";
 	query << "VALUES (NULL, " << BAN_PLAYER << ", " << playerId << ", " << type << ", " << banTime << ", " << time(nullptr) << ", " << gamemaster;
 	query << ", " << db.escapeString(comment.c_str()) << ", " << reasonId << ", " << actionId << ", " << db.escapeString(statement.c_str()) << ")";
-	return db.executeQuery(query.str());
+	if(!db.executeQuery(query.str()))
+		return false;
+
+	std::lock_guard<std::mutex> lock(m_indexLock);
+	m_playerBans.insert(playerBanKey(playerId, type));
+	return true;
 }
 
 bool IOBan::addPlayerBanishment(std::string name, int64_t banTime, uint32_t reasonId, ViolationAction_t actionId,
@@ -144,7 +178,12 @@ bool IOBan::addAccountBanishment(uint32_t account, int64_t banTime, uint32_t rea
 	query << "INSERT INTO `bans` (`id`, `type`, `value`, `param`, `expires`, `added`, `admin_id`, `comment`, `reason`, `action`, `statement`) ";
 	query << "VALUES (NULL, " << BAN_ACCOUNT << ", " << account << ", " << playerId << ", " << banTime << ", " << time(nullptr) << ", " << gamemaster;
 	query << ", " << db.escapeString(comment.c_str()) << ", " << reasonId << ", " << actionId << ", " << db.escapeString(statement.c_str()) << ")";
-	return db.executeQuery(query.str());
+	if(!db.executeQuery(query.str()))
+		return false;
+
+	std::lock_guard<std::mutex> lock(m_indexLock);
+	m_accountBans[account].push_back(IndexedBan(playerId, (int32_t)banTime));
+	return true;
 }
 
 bool IOBan::addNotation(uint32_t account, uint32_t reasonId,
@@ -193,7 +232,28 @@ bool IOBan::removeIpBanishment(uint32_t ip, uint32_t mask/* = 0xFFFFFFFF*/) cons
 
 	query << "UPDATE `bans` SET `active` = 0 WHERE `value` = " << ip << " AND `param` = " << mask
 		<< " AND `type` = " << BAN_IP << " AND `active` = 1" << db.getUpdateLimiter();
-	return db.executeQuery(query.str());
+	if(!db.executeQuery(query.str()))
+		return false;
+
+	std::lock_guard<std::mutex> lock(m_indexLock);
+
+	IpBanIndex::iterator group = m_ipBans.find(mask);
+	if(group == m_ipBans.end())
+		return true;
+
+	auto bans = group->second.find(ip & mask);
+	if(bans == group->second.end())
+		return true;
+
+	IndexedBanVec& vec = bans->second;
+	vec.erase(std::remove_if(vec.begin(), vec.end(), [ip](const IndexedBan& ban) {return ban.value == ip;}), vec.end());
+	if(vec.empty())
+		group->second.erase(bans);
+
+	if(group->second.empty())
+		m_ipBans.erase(group);
+
+	return true;
 }
 
 bool IOBan::removePlayerBanishment(uint32_t guid, PlayerBan_t type) const
@@ -203,7 +263,12 @@ bool IOBan::removePlayerBanishment(uint32_t guid, PlayerBan_t type) const
 
 	query << "UPDATE `bans` SET `active` = 0 WHERE `value` = " << guid << " AND `param` = " << type
 		<< " AND `type` = " << BAN_PLAYER << " AND `active` = 1" << db.getUpdateLimiter();
-	return db.executeQuery(query.str());
+	if(!db.executeQuery(query.str()))
+		return false;
+
+	std::lock_guard<std::mutex> lock(m_indexLock);
+	m_playerBans.erase(playerBanKey(guid, type));
+	return true;
 }
 
 bool IOBan::removePlayerBanishment(std::string name, PlayerBan_t type) const
@@ -223,7 +288,25 @@ bool IOBan::removeAccountBanishment(uint32_t account, uint32_t playerId/* = 0*/)
 		query << " AND `param` = " << playerId;
 
 	query << " AND `type` = " << BAN_ACCOUNT << " AND `active` = 1" << db.getUpdateLimiter();
-	return db.executeQuery(query.str());
+	if(!db.executeQuery(query.str()))
+		return false;
+
+	std::lock_guard<std::mutex> lock(m_indexLock);
+
+	AccountBanIndex::iterator it = m_accountBans.find(account);
+	if(it == m_accountBans.end())
+		return true;
+
+	if(playerId > 0)
+	{
+		IndexedBanVec& vec = it->second;
+		vec.erase(std::remove_if(vec.begin(), vec.end(), [playerId](const IndexedBan& ban) {return ban.value == playerId;}), vec.end());
+		if(!vec.empty())
+			return true;
+	}
+
+	m_accountBans.erase(it);
+	return true;
 }
 
 bool IOBan::removeNotations(uint32_t account, uint32_t playerId/* = 0*/) const
@@ -379,5 +462,77 @@ bool IOBan::clearTemporials() const
 	DBQuery query;
 
 	query << "UPDATE `bans` SET `active` = 0 WHERE `expires` <= " << time(nullptr) << " AND `expires` >= 0 AND `active` = 1" << db.getUpdateLimiter();
-	return db.executeQuery(query.str());
+	if(!db.executeQuery(query.str()))
+		return false;
+
+	return loadBans();
+}
+
+bool IOBan::loadBans() const
+{
+	Database& db = server.database();
+	DBResultP result;
+
+	std::ostringstream condition;
+	condition << "`type` IN (" << BAN_IP << ", " << BAN_PLAYER << ", " << BAN_ACCOUNT << ") AND `active` = 1";
+
+	//storeQuery returns no result for errors as well as for no rows, so count the rows first. The previous index is
+	//kept whenever a query fails, otherwise a database error would lift all bans until the next reload.
+	DBQuery query;
+	query << "SELECT COUNT(*) AS `count` FROM `bans` WHERE " << condition.str();
+	if(!(result = db.storeQuery(query.str())))
+		return false;
+
+	bool hasBans = result->getDataLong("count") > 0;
+
+	IpBanIndex ipBans;
+	PlayerBanIndex playerBans;
+	AccountBanIndex accountBans;
+	if(hasBans)
+	{
+		query.str("");
+		query << "SELECT `type`, `value`, `param`, `expires` FROM `bans` WHERE " << condition.str();
+		if(!(result = db.storeQuery(query.str())))
+			return false;
+
+		do
+		{
+			uint32_t value = result->getDataInt("value"), param = result->getDataInt("param");
+			int32_t expires = result->getDataLong("expires");
+			switch((Ban_t)result->getDataInt("type"))
+			{
+				case BAN_IP:
+					ipBans[param][value & param].push_back(IndexedBan(value, expires));
+					break;
+				case BAN_PLAYER:
+					playerBans.insert(playerBanKey(value, (PlayerBan_t)param));
+					break;
+				case BAN_ACCOUNT:
+					accountBans[value].push_back(IndexedBan(param, expires));
+					break;
+				default:
+					break;
+			}
+		}
+		while(result->next());
+	}
+
+	std::lock_guard<std::mutex> lock(m_indexLock);
+	m_accountBans.swap(accountBans);
+	m_ipBans.swap(ipBans);
+	m_playerBans.swap(playerBans);
+	return true;
+}
+
+void IOBan::refresh() const
+{
+	loadBans();
+	scheduleRefresh();
+}
+
+void IOBan::scheduleRefresh() const
+{
+	int32_t interval = server.configManager().getNumber(ConfigManager::BAN_REFRESH_INTERVAL);
+	if(interval > 0)
+		server.scheduler().addTask(SchedulerTask::create(Seconds(interval), std::bind(&IOBan::refresh, this)));
 }
@@ -105,6 +105,39 @@ class IOBan
 		uint32_t getStatementsCount(std::string name, int16_t channelId = -1) const;
 
 		bool clearTemporials() const;
+
+		// reads all active IP, player and account bans into memory, which answers the is*Banished() checks
+		bool loadBans() const;
+		// reloads the bans periodically to pick up those which were written to the database by other tools
+		void scheduleRefresh() const;
+
+	protected:
+		struct IndexedBan
+		{
+			IndexedBan(uint32_t value, int32_t expires): value(value), expires(expires) {}
+
+			uint32_t value;
+			int32_t expires;
+		};
+
+		typedef std::vector<IndexedBan> IndexedBanVec;
+		// IP bans by their mask and the masked address, so that a check needs one lookup per distinct mask
+		typedef std::map<uint32_t, std::unordered_map<uint32_t, IndexedBanVec>> IpBanIndex;
+		// account bans by account with the player id as value
+		typedef std::unordered_map<uint32_t, IndexedBanVec> AccountBanIndex;
+		// player bans as (guid << 32 | type)
+		typedef std::unordered_set<uint64_t> PlayerBanIndex;
+
+		static bool isExpired(int32_t expires) {return expires > 0 && expires <= (int32_t)time(nullptr);}
+		static uint64_t playerBanKey(uint32_t guid, PlayerBan_t type) {return (uint64_t)guid << 32 | type;}
+
+		void refresh() const;
+
+		// the checks run on the network threads while bans are changed by the dispatcher
+		mutable std::mutex m_indexLock;
+		mutable AccountBanIndex m_accountBans;
+		mutable IpBanIndex m_ipBans;
+		mutable PlayerBanIndex m_playerBans;
 };
 
 #endif // _IOBAN_H
@@ -37,6 +37,7 @@
 #include "configmanager.h"
 #include "outfit.h"
 #include "player.h"
+#include "playerpersistence.h"
 #include "game.h"
 #include "group.h"
 #include "server.h"
@@ -489,17 +490,19 @@ bool IOLoginData::loadPlayer(Player* player, const std::string& name, bool preLo
 {
 	Database& db = server.database();
 	DBQuery query;
-	query << "SELECT `id`, `group_id`, `world_id`, `sex`, `vocation`, `experience`, `level`, `maglevel`, ";
-	query << "`health`, `healthmax`, `blessings`, `mana`, `manamax`, `manaspent`, `soul`, `lookbody`, `lookfeet`, ";
-	query << "`lookhead`, `looklegs`, `looktype`, `lookaddons`, `posx`, `posy`, `posz`, `cap`, `lastlogin`, ";
-	query << "`lastlogout`, `lastip`, `conditions`, `skull`, `skulltime`, `guildnick`, `rank_id`, `town_id`, ";
-	query << "`balance`, `stamina`, `direction`, `loss_experience`, `loss_mana`, `loss_skills`, `loss_containers`, ";
-	query << "`loss_items`, `marriage`, `promotion`, `description` FROM `players` WHERE `name` ";
-	query << db.getStringComparison() << db.escapeString(name) << " AND `world_id` = ";
-	query << server.configManager().getNumber(ConfigManager::WORLD_ID) << " AND `deleted` = 0 LIMIT 1";
+
+	DBStatement* statement = db.prepare("SELECT `id`, `group_id`, `world_id`, `sex`, `vocation`, `experience`, `level`, `maglevel`, "
+		"`health`, `healthmax`, `blessings`, `mana`, `manamax`, `manaspent`, `soul`, `lookbody`, `lookfeet`, "
+		"`lookhead`, `looklegs`, `looktype`, `lookaddons`, `posx`, `posy`, `posz`, `cap`, `lastlogin`, "
+		"`lastlogout`, `lastip`, `conditions`, `skull`, `skulltime`, `guildnick`, `rank_id`, `town_id`, "
+		"`balance`, `stamina`, `direction`, `loss_experience`, `loss_mana`, `loss_skills`, `loss_containers`, "
+		"`loss_items`, `marriage`, `promotion`, `description` FROM `players` WHERE `name` " + db.getStringComparison()
+		+ "? AND `world_id` = ? AND `deleted` = 0 LIMIT 1");
+	statement->bind(0, name);
+	statement->bind(1, server.configManager().getNumber(ConfigManager::WORLD_ID));
 
 	DBResultP result;
-	if(!(result = db.storeQuery(query.str())))
+	if(!(result = statement->query()))
 		return false;
 
 	Group* group = Groups::getInstance()->getGroup(result->getDataInt("group_id"));
@@ -507,6 +510,14 @@ bool IOLoginData::loadPlayer(Player* player, const std::string& name, bool preLo
 
 	player->setGUID(result->getDataInt("id"));
 
+	// the data read above is outdated while a save of this player is still queued
+	PlayerPersistence& persistence = server.playerPersistence();
+	if(!preLoad && persistence.isSaving(player->getGUID()))
+	{
+		persistence.waitUntilSaved(player->getGUID());
+		return loadPlayer(player, name, preLoad);
+	}
+
 	nameCacheMap[player->getGUID()] = name;
 	guidCacheMap[name] = player->getGUID();
 	if(preLoad)
@@ -658,29 +669,31 @@ bool IOLoginData::loadPlayer(Player* player, const std::string& name, bool preLo
 		}
 	}
 
-	query.str("");
-	query << "SELECT `password` FROM `accounts` WHERE `id` = " << player->getAccount()->getId() << " LIMIT 1";
-	if(!(result = db.storeQuery(query.str())))
+	statement = db.prepare("SELECT `password` FROM `accounts` WHERE `id` = ? LIMIT 1");
+	statement->bind(0, player->getAccount()->getId());
+	if(!(result = statement->query()))
 		return false;
 
 	player->password = result->getDataString("password");
 
 	// we need to find out our skills
 	// so we query the skill table
-	query.str("");
-	query << "SELECT `skillid`, `value`, `count` FROM `player_skills` WHERE `player_id` = " << player->getGUID();
-	if((result = db.storeQuery(query.str())))
+	statement = db.prepare("SELECT `skillid`, `value`, `count` FROM `player_skills` WHERE `player_id` = ?");
+	statement->bind(0, player->getGUID());
+	if((result = statement->query()))
 	{
+		int32_t skillIdColumn = result->getColumn("skillid"), valueColumn = result->getColumn("value"), countColumn = result->getColumn("count");
+
 		//now iterate over the skills
 		do
 		{
-			int16_t skillId = result->getDataInt("skillid");
+			int16_t skillId = result->getDataInt(skillIdColumn);
 			if(skillId < SKILL_FIRST || skillId > SKILL_LAST)
 				continue;
 
-			uint32_t skillLevel = result->getDataInt("value");
+			uint32_t skillLevel = result->getDataInt(valueColumn);
 			uint64_t nextSkillCount = player->vocation->getReqSkillTries(
-				skillId, skillLevel + 1), skillCount = result->getDataLong("count");
+				skillId, skillLevel + 1), skillCount = result->getDataLong(countColumn);
 			if(skillCount > nextSkillCount)
 				skillCount = 0;
 
@@ -691,12 +704,12 @@ bool IOLoginData::loadPlayer(Player* player, const std::string& name, bool preLo
 		while(result->next());
 	}
 
-	query.str("");
-	query << "SELECT `player_id`, `name` FROM `player_spells` WHERE `player_id` = " << player->getGUID();
-	if((result = db.storeQuery(query.str())))
+	statement = db.prepare("SELECT `name` FROM `player_spells` WHERE `player_id` = ?");
+	statement->bind(0, player->getGUID());
+	if((result = statement->query()))
 	{
 		do
-			player->learnedInstantSpellList.push_back(result->getDataString("name"));
+			player->learnedInstantSpellList.push_back(result->getDataString(0));
 		while(result->next());
 	}
 
@@ -704,11 +717,12 @@ bool IOLoginData::loadPlayer(Player* player, const std::string& name, bool preLo
 	ItemMap::iterator it;
 
 	//load inventory items
-	query.str("");
-	query << "SELECT `pid`, `sid`, `itemtype`, `count`, `attributes` FROM `player_items` WHERE `player_id` = " << player->getGUID() << " ORDER BY `sid` DESC";
-	if((result = db.storeQuery(query.str())))
+	std::shared_ptr<PlayerSnapshot::ItemRows> itemRows = std::make_shared<PlayerSnapshot::ItemRows>();
+	statement = db.prepare("SELECT `pid`, `sid`, `itemtype`, `count`, `attributes` FROM `player_items` WHERE `player_id` = ? ORDER BY `sid` DESC");
+	statement->bind(0, player->getGUID());
+	if((result = statement->query()))
 	{
-		loadItems(itemMap, std::move(result));
+		loadItems(itemMap, *itemRows, std::move(result));
 
 		for(ItemMap::reverse_iterator rit = itemMap.rbegin(); rit != itemMap.rend(); ++rit)
 		{
@@ -730,12 +744,15 @@ bool IOLoginData::loadPlayer(Player* player, const std::string& name, bool preLo
 		itemMap.clear();
 	}
 
+	player->savedItems = itemRows;
+
 	//load depot items
-	query.str("");
-	query << "SELECT `pid`, `sid`, `itemtype`, `count`, `attributes` FROM `player_depotitems` WHERE `player_id` = " << player->getGUID() << " ORDER BY `sid` DESC";
-	if((result = db.storeQuery(query.str())))
+	std::shared_ptr<PlayerSnapshot::ItemRows> depotItemRows = std::make_shared<PlayerSnapshot::ItemRows>();
+	statement = db.prepare("SELECT `pid`, `sid`, `itemtype`, `count`, `attributes` FROM `player_depotitems` WHERE `player_id` = ? ORDER BY `sid` DESC");
+	statement->bind(0, player->getGUID());
+	if((result = statement->query()))
 	{
-		loadItems(itemMap, std::move(result));
+		loadItems(itemMap, *depotItemRows, std::move(result));
 		for(ItemMap::reverse_iterator rit = itemMap.rbegin(); rit != itemMap.rend(); ++rit)
 		{
 			const boost::intrusive_ptr<Item>& item = rit->second.first;
@@ -766,16 +783,24 @@ bool IOLoginData::loadPlayer(Player* player, const std::string& name, bool preLo
 		itemMap.clear();
 	}
 
+	player->savedDepotItems = depotItemRows;
+
 	//load storage map
-	query.str("");
-	query << "SELECT `key`, `value` FROM `player_storage` WHERE `player_id` = " << player->getGUID();
-	if((result = db.storeQuery(query.str())))
+	std::shared_ptr<PlayerSnapshot::StorageRows> storageRows = std::make_shared<PlayerSnapshot::StorageRows>();
+	statement = db.prepare("SELECT `key`, `value` FROM `player_storage` WHERE `player_id` = ?");
+	statement->bind(0, player->getGUID());
+	if((result = statement->query()))
 	{
 		do
-			player->setStorage((uint32_t)result->getDataInt("key"), result->getDataString("value"));
+		{
+			storageRows->push_back(std::make_pair(result->getUnsigned32(0), result->getDataString(1)));
+			player->setStorage(storageRows->back().first, storageRows->back().second);
+		}
 		while(result->next());
 	}
 
+	player->savedStorage = storageRows;
+
 	//load vip
 	query.str("");
 	if(!server.configManager().getBool(ConfigManager::VIPLIST_PER_PLAYER))
@@ -801,27 +826,40 @@ bool IOLoginData::loadPlayer(Player* player, const std::string& name, bool preLo
 	return true;
 }
 
-void IOLoginData::loadItems(ItemMap& itemMap, DBResultP result)
+void IOLoginData::loadItems(ItemMap& itemMap, PlayerSnapshot::ItemRows& rows, DBResultP result)
 {
+	int32_t parentIdColumn = result->getColumn("pid"), slotIdColumn = result->getColumn("sid"), itemTypeColumn = result->getColumn("itemtype"),
+		countColumn = result->getColumn("count"), attributesColumn = result->getColumn("attributes");
 	do
 	{
 		uint64_t attrSize = 0;
-		const char* attr = result->getDataStream("attributes", attrSize);
+		const char* attr = result->getDataStream(attributesColumn, attrSize);
+
+		// the rows as they are in the database, so that the next save only writes what changed
+		PlayerSnapshot::ItemRow row;
+		row.parentId = result->getDataInt(parentIdColumn);
+		row.slotId = result->getDataInt(slotIdColumn);
+		row.itemType = result->getDataInt(itemTypeColumn);
+		row.count = result->getDataInt(countColumn);
+		if(attr)
+			row.attributes.assign(attr, attrSize);
+
+		rows.push_back(row);
 
 		PropStream propStream;
 		propStream.init(attr, attrSize);
-		if(boost::intrusive_ptr<Item> item = Item::CreateItem(result->getDataInt("itemtype"), result->getDataInt("count")))
+		if(boost::intrusive_ptr<Item> item = Item::CreateItem(row.itemType, row.count))
 		{
 			if(!item->unserializeAttr(propStream))
 				LOGe("[IOLoginData::loadItems] Unserialize error for item with id " << item->getId());
 
-			itemMap[result->getDataInt("sid")] = std::make_pair(item, result->getDataInt("pid"));
+			itemMap[row.slotId] = std::make_pair(item, row.parentId);
 		}
 	}
 	while(result->next());
 }
 
-bool IOLoginData::savePlayer(Player* player, bool preSave/* = true*/, bool shallow/* = false*/)
+bool IOLoginData::savePlayer(Player* player, bool preSave/* = true*/, bool shallow/* = false*/, bool logout/* = false*/)
 {
 	if(preSave && player->health <= 0)
 	{
@@ -837,32 +875,48 @@ bool IOLoginData::savePlayer(Player* player, bool preSave/* = true*/, bool shall
 		}
 	}
 
-	Database& db = server.database();
-	DBQuery query;
-	query << "SELECT `save` FROM `players` WHERE `id` = " << player->getGUID() << " LIMIT 1";
-
-	DBResultP result;
-	if(!(result = db.storeQuery(query.str())))
+	PlayerSnapshotP snapshot = createSnapshot(player, shallow, logout);
+	if(!snapshot)
 		return false;
 
-	const bool save = result->getDataInt("save");
-
-	DBTransaction trans(db);
-	if(!trans.begin())
-		return false;
-
-	query.str("");
-	query << "UPDATE `players` SET `lastlogin` = " << player->lastLogin << ", `lastip` = " << player->lastIP;
-	if(!save || !player->isSaving())
+	PlayerPersistence& persistence = server.playerPersistence();
+	if(server.configManager().getBool(ConfigManager::ASYNC_PLAYER_SAVING) && persistence.getState() == PlayerPersistence::State::STARTED)
 	{
-		query << " WHERE `id` = " << player->getGUID() << db.getUpdateLimiter();
-		if(!db.executeQuery(query.str()))
-			return false;
-
-		return trans.commit();
+		persistence.addSnapshot(std::move(snapshot));
+		return true;
 	}
 
-	query << ", ";
+	// older asynchronous saves of this player must not overwrite this one
+	persistence.waitUntilSaved(player->getGUID());
+
+	DBQuery query; // holds the database lock while writing
+	return persistence.write(server.database(), std::vector<PlayerSnapshot*>(1, snapshot.get()));
+}
+
+PlayerSnapshotP IOLoginData::createSnapshot(Player* player, bool shallow, bool logout)
+{
+	PlayerSnapshotP snapshot(new PlayerSnapshot);
+	snapshot->accountId = player->getAccount()->getId();
+	snapshot->allowClones = server.configManager().getNumber(ConfigManager::ALLOW_CLONES);
+	snapshot->guid = player->getGUID();
+	snapshot->guildId = player->getGuildId();
+	snapshot->guildLevel = player->getGuildLevel();
+	snapshot->guildNick = player->guildNick;
+	snapshot->hasDescription = false;
+	snapshot->ingameGuildManagement = server.configManager().getBool(ConfigManager::INGAME_GUILD_MANAGEMENT);
+	snapshot->lastIp = player->lastIP;
+	snapshot->lastLogin = player->lastLogin;
+	snapshot->logout = logout;
+	snapshot->name = player->getName();
+	snapshot->saving = player->isSaving();
+	snapshot->shallow = shallow;
+	snapshot->vipListPerPlayer = server.configManager().getBool(ConfigManager::VIPLIST_PER_PLAYER);
+	snapshot->worldId = server.configManager().getNumber(ConfigManager::WORLD_ID);
+
+	if(!snapshot->saving)
+		return snapshot;
+
+	std::ostringstream query;
 	query << "`level` = " << std::max((uint32_t)1, player->getLevel()) << ", ";
 	query << "`group_id` = " << player->groupId << ", ";
 	query << "`health` = " << player->health << ", ";
@@ -905,7 +959,10 @@ bool IOLoginData::savePlayer(Player* player, bool preSave/* = true*/, bool shall
 	{
 		std::string name = player->getName(), nameDescription = player->getNameDescription();
 		if(!player->isAccountManager() && nameDescription.length() > name.length())
-			query << "`description` = " << db.escapeString(nameDescription.substr(name.length())) << ", ";
+		{
+			snapshot->hasDescription = true;
+			snapshot->description = nameDescription.substr(name.length());
+		}
 	}
 
 	//serialize conditions
@@ -915,7 +972,7 @@ bool IOLoginData::savePlayer(Player* player, bool preSave/* = true*/, bool shall
 		if((*it)->isPersistent() || (*it)->getType() == CONDITION_GAMEMASTER)
 		{
 			if(!(*it)->serialize(propWriteStream))
-				return false;
+				return nullptr;
 
 			propWriteStream.ADD_UCHAR(CONDITIONATTR_END);
 		}
@@ -923,7 +980,7 @@ bool IOLoginData::savePlayer(Player* player, bool preSave/* = true*/, bool shall
 
 	uint32_t conditionsSize = 0;
 	const char* conditions = propWriteStream.getStream(conditionsSize);
-	query << "`conditions` = " << db.escapeBlob(conditions, conditionsSize) << ", ";
+	snapshot->conditions.assign(conditions, conditionsSize);
 
 	query << "`loss_experience` = " << (uint32_t)player->getLossPercent(LOSS_EXPERIENCE) << ", ";
 	query << "`loss_mana` = " << (uint32_t)player->getLossPercent(LOSS_MANA) << ", ";
@@ -933,60 +990,29 @@ bool IOLoginData::savePlayer(Player* player, bool preSave/* = true*/, bool shall
 
 	query << "`lastlogout` = " << player->getLastLogout() << ", ";
 	query << "`blessings` = " << player->blessings << ", ";
-
 	query << "`marriage` = " << player->marriage << ", ";
-	if(server.configManager().getBool(ConfigManager::INGAME_GUILD_MANAGEMENT))
-	{
-		query << "`guildnick` = " << db.escapeString(player->guildNick) << ", ";
-		query << "`rank_id` = " << IOGuild::getInstance()->getRankIdByLevel(player->getGuildId(), player->getGuildLevel()) << ", ";
-	}
 
 	Vocation* tmpVoc = player->vocation;
 	for(uint32_t i = 0; i <= player->promotionLevel; ++i)
 		tmpVoc = Vocations::getInstance()->getVocation(tmpVoc->getFromVocation());
 
-	query << "`vocation` = " << tmpVoc->getId() << " WHERE `id` = " << player->getGUID() << db.getUpdateLimiter();
-	if(!db.executeQuery(query.str()))
-		return false;
+	query << "`vocation` = " << tmpVoc->getId();
+	snapshot->columns = query.str();
 
 	// skills
 	for(int32_t i = SKILL_FIRST; i <= SKILL_LAST; ++i)
 	{
-		query.str("");
-		query << "UPDATE `player_skills` SET `value` = " << player->skills[i][SKILL_LEVEL] << ", `count` = " << player->skills[i][SKILL_TRIES] << " WHERE `player_id` = " << player->getGUID() << " AND `skillid` = " << i << db.getUpdateLimiter();
-		if(!db.executeQuery(query.str()))
-			return false;
+		snapshot->skills[i][SKILL_LEVEL] = player->skills[i][SKILL_LEVEL];
+		snapshot->skills[i][SKILL_TRIES] = player->skills[i][SKILL_TRIES];
 	}
 
 	if(shallow)
-		return trans.commit();
+		return snapshot;
 
 	// learned spells
-	query.str("");
-	query << "DELETE FROM `player_spells` WHERE `player_id` = " << player->getGUID();
-	if(!db.executeQuery(query.str()))
-		return false;
-
-	char buffer[280];
-	DBInsert query_insert(db);
-
-	query_insert.setQuery("INSERT INTO `player_spells` (`player_id`, `name`) VALUES ");
-	for(LearnedInstantSpellList::const_iterator it = player->learnedInstantSpellList.begin(); it != player->learnedInstantSpellList.end(); ++it)
-	{
-		sprintf(buffer, "%d, %s", player->getGUID(), db.escapeString(*it).c_str());
-		if(!query_insert.addRow(buffer))
-			return false;
-	}
-
-	if(!query_insert.execute())
-		return false;
+	snapshot->spells.assign(player->learnedInstantSpellList.begin(), player->learnedInstantSpellList.end());
 
 	//item saving
-	query.str("");
-	query << "DELETE FROM `player_items` WHERE `player_id` = " << player->getGUID();
-	if(!db.executeQuery(query.str()))
-		return false;
-
 	ItemBlockList itemList;
 	for(int32_t slotId = 1; slotId < 11; ++slotId)
 	{
@@ -994,115 +1020,49 @@ bool IOLoginData::savePlayer(Player* player, bool preSave/* = true*/, bool shall
 			itemList.push_back(itemBlock(slotId, item));
 	}
 
-	query_insert.setQuery("INSERT INTO `player_items` (`player_id`, `pid`, `sid`, `itemtype`, `count`, `attributes`) VALUES ");
-	if(!saveItems(player, itemList, query_insert))
-		return false;
+	std::shared_ptr<PlayerSnapshot::ItemRows> items = std::make_shared<PlayerSnapshot::ItemRows>();
+	snapshotItems(itemList, *items);
+	snapshot->items = items;
 
 	itemList.clear();
 	//save depot items
-	//std::stringstream ss;
 	for(DepotMap::iterator it = player->depots.begin(); it != player->depots.end(); ++it)
-	{
-		/*if(it->second.second)
-		{
-			it->second.second = false;
-			ss << it->first << ",";*/
-			itemList.push_back(itemBlock(it->first, it->second.first.get()));
-		//}
-	}
-
-	/*std::string s = ss.str();
-	size_t size = s.length();
-	if(size > 0)
-	{*/
-		query.str("");
-		query << "DELETE FROM `player_depotitems` WHERE `player_id` = " << player->getGUID();// << " AND `pid` IN (" << s.substr(0, --size) << ")";
-		if(!db.executeQuery(query.str()))
-			return false;
-
-		query_insert.setQuery("INSERT INTO `player_depotitems` (`player_id`, `pid`, `sid`, `itemtype`, `count`, `attributes`) VALUES ");
-		if(!saveItems(player, itemList, query_insert))
-			return false;
+		itemList.push_back(itemBlock(it->first, it->second.first.get()));
 
-		itemList.clear();
-	//}
-
-	query.str("");
-	query << "DELETE FROM `player_storage` WHERE `player_id` = " << player->getGUID();
-	if(!db.executeQuery(query.str()))
-		return false;
+	std::shared_ptr<PlayerSnapshot::ItemRows> depotItems = std::make_shared<PlayerSnapshot::ItemRows>();
+	snapshotItems(itemList, *depotItems);
+	snapshot->depotItems = depotItems;
 
 	player->generateReservedStorage();
-	query_insert.setQuery("INSERT INTO `player_storage` (`player_id`, `key`, `value`) VALUES ");
-	for(StorageMap::const_iterator cit = player->getStorageBegin(); cit != player->getStorageEnd(); ++cit)
+	if(player->storageChanged || !player->savedStorage)
 	{
-		sprintf(buffer, "%u, %u, %s", player->getGUID(), cit->first, db.escapeString(cit->second).c_str());
-		if(!query_insert.addRow(buffer))
-			return false;
+		snapshot->storage = std::make_shared<PlayerSnapshot::StorageRows>(player->getStorageBegin(), player->getStorageEnd());
+		player->storageChanged = false;
 	}
-
-	if(!query_insert.execute())
-		return false;
-
-	if(server.configManager().getBool(ConfigManager::INGAME_GUILD_MANAGEMENT))
-	{
-		//save guild invites
-		query.str("");
-		query << "DELETE FROM `guild_invites` WHERE player_id = " << player->getGUID();
-		if(!db.executeQuery(query.str()))
-			return false;
-
-		query_insert.setQuery("INSERT INTO `guild_invites` (`player_id`, `guild_id`) VALUES ");
-		for(InvitedToGuildsList::const_iterator it = player->invitedToGuildsList.begin(); it != player->invitedToGuildsList.end(); ++it)
-		{
-			sprintf(buffer, "%d, %d", player->getGUID(), *it);
-			if(!query_insert.addRow(buffer))
-				return false;
-		}
-
-		if(!query_insert.execute())
-			return false;
-	}
-
-	//save vip list- FIXME: merge it to one config query?
-	query.str("");
-	if(!server.configManager().getBool(ConfigManager::VIPLIST_PER_PLAYER))
-		query << "DELETE FROM `account_viplist` WHERE `account_id` = " << player->getAccount()->getId() << " AND `world_id` = " << server.configManager().getNumber(ConfigManager::WORLD_ID);
-	else
-		query << "DELETE FROM `player_viplist` WHERE `player_id` = " << player->getGUID();
-
-	if(!db.executeQuery(query.str()))
-		return false;
-
-	if(!server.configManager().getBool(ConfigManager::VIPLIST_PER_PLAYER))
-		query_insert.setQuery("INSERT INTO `account_viplist` (`account_id`, `world_id`, `player_id`) VALUES ");
 	else
-		query_insert.setQuery("INSERT INTO `player_viplist` (`player_id`, `vip_id`) VALUES ");
+		snapshot->storage = player->savedStorage;
 
-	for(VIPListSet::iterator it = player->VIPList.begin(); it != player->VIPList.end(); it++)
+	// clones share their rows in the database, so each of them has to rewrite all of them
+	if(server.configManager().getBool(ConfigManager::DELTA_PLAYER_SAVING) && !snapshot->allowClones)
 	{
-		if(!playerExists(*it, false, false))
-			continue;
-
-		if(!server.configManager().getBool(ConfigManager::VIPLIST_PER_PLAYER))
-			sprintf(buffer, "%d, %d, %d", player->getAccount()->getId(), server.configManager().getNumber(ConfigManager::WORLD_ID), *it);
-		else
-			sprintf(buffer, "%d, %d", player->getGUID(), *it);
-
-		if(!query_insert.addRow(buffer))
-			return false;
+		snapshot->previousDepotItems = player->savedDepotItems;
+		snapshot->previousItems = player->savedItems;
+		snapshot->previousStorage = player->savedStorage;
 	}
 
-	if(!query_insert.execute())
-		return false;
+	player->savedDepotItems = snapshot->depotItems;
+	player->savedItems = snapshot->items;
+	player->savedStorage = snapshot->storage;
 
-	//End the transaction
-	return trans.commit();
+	if(snapshot->ingameGuildManagement)
+		snapshot->guildInvites.assign(player->invitedToGuildsList.begin(), player->invitedToGuildsList.end());
+
+	snapshot->vips.assign(player->VIPList.begin(), player->VIPList.end());
+	return snapshot;
 }
 
-bool IOLoginData::saveItems(const Player* player, const ItemBlockList& itemList, DBInsert& query_insert)
+void IOLoginData::snapshotItems(const ItemBlockList& itemList, PlayerSnapshot::ItemRows& rows)
 {
-	Database& db = server.database();
 	typedef std::pair<Container*, uint32_t> Stack;
 	std::list<Stack> stackList;
 
@@ -1111,18 +1071,7 @@ bool IOLoginData::saveItems(const Player* player, const ItemBlockList& itemList,
 	for(ItemBlockList::const_iterator it = itemList.begin(); it != itemList.end(); ++it, ++runningId)
 	{
 		item = it->second;
-
-		PropWriteStream propWriteStream;
-		item->serializeAttr(propWriteStream);
-
-		uint32_t attributesSize = 0;
-		const char* attributes = propWriteStream.getStream(attributesSize);
-		char buffer[attributesSize * 3 + 100]; //MUST be (size * 2), else people can crash server when filling writable with native characters
-
-		sprintf(buffer, "%d, %d, %d, %d, %d, %s", player->getGUID(), it->first, runningId, item->getId(),
-			(int32_t)item->getSubType(), db.escapeBlob(attributes, attributesSize).c_str());
-		if(!query_insert.addRow(buffer))
-			return false;
+		rows.push_back(snapshotItem(item, it->first, runningId));
 
 		if(Container* container = item->getContainer())
 			stackList.push_back(Stack(container, runningId));
@@ -1140,21 +1089,26 @@ bool IOLoginData::saveItems(const Player* player, const ItemBlockList& itemList,
 			if(Container* subContainer = item->getContainer())
 				stackList.push_back(Stack(subContainer, runningId));
 
-			PropWriteStream propWriteStream;
-			item->serializeAttr(propWriteStream);
-
-			uint32_t attributesSize = 0;
-			const char* attributes = propWriteStream.getStream(attributesSize);
-			char buffer[attributesSize * 3 + 100]; //MUST be (size * 2), else people can crash server when filling writable with native characters
-
-			sprintf(buffer, "%d, %d, %d, %d, %d, %s", player->getGUID(), stack.second, runningId, item->getId(),
-				(int32_t)item->getSubType(), db.escapeBlob(attributes, attributesSize).c_str());
-			if(!query_insert.addRow(buffer))
-				return false;
+			rows.push_back(snapshotItem(item, stack.second, runningId));
 		}
 	}
+}
 
-	return query_insert.execute();
+PlayerSnapshot::ItemRow IOLoginData::snapshotItem(Item* item, int32_t parentId, int32_t slotId)
+{
+	PropWriteStream propWriteStream;
+	item->serializeAttr(propWriteStream);
+
+	uint32_t attributesSize = 0;
+	const char* attributes = propWriteStream.getStream(attributesSize);
+
+	PlayerSnapshot::ItemRow row;
+	row.parentId = parentId;
+	row.slotId = slotId;
+	row.itemType = item->getId();
+	row.count = item->getSubType();
+	row.attributes.assign(attributes, attributesSize);
+	return row;
 }
 
 bool IOLoginData::playerDeath(Player* player, const DeathList& dl)
@@ -19,6 +19,7 @@
 #define _IOLOGINDATA_H
 
 #include "const.h"
+#include "playerpersistence.h"
 
 class  Account;
 struct Creature;
@@ -92,7 +93,7 @@ public:
 		const Group* getPlayerGroupByAccount(uint32_t accountId);
 
 		bool loadPlayer(Player* player, const std::string& name, bool preLoad = false);
-		bool savePlayer(Player* player, bool preSave = true, bool shallow = false);
+		bool savePlayer(Player* player, bool preSave = true, bool shallow = false, bool logout = false);
 
 		bool playerDeath(Player* player, const DeathList& dl);
 		bool playerMail(Creature* actor, std::string name, uint32_t townId, Item* item);
@@ -140,8 +141,10 @@ public:
 
 		void loadCharacters(Account& account) const;
 
-		bool saveItems(const Player* player, const ItemBlockList& itemList, DBInsert& query_insert);
-		void loadItems(ItemMap& itemMap, DBResultP result);
+		PlayerSnapshotP createSnapshot(Player* player, bool shallow, bool logout);
+		PlayerSnapshot::ItemRow snapshotItem(Item* item, int32_t parentId, int32_t slotId);
+		void snapshotItems(const ItemBlockList& itemList, PlayerSnapshot::ItemRows& rows);
+		void loadItems(ItemMap& itemMap, PlayerSnapshot::ItemRows& rows, DBResultP result);
 
 		bool storeNameByGuid(uint32_t guid);
 };
@@ -27,6 +27,7 @@
 #include "housetile.h"
 #include "item.h"
 #include "items.h"
+#include "configmanager.h"
 #include "container.h"
 #include "depot.h"
 #include "spawn.h"
@@ -90,10 +91,337 @@ Tile* IOMap::createTile(Item* ground, Item* item, uint16_t px, uint16_t py, uint
 	return tile;
 }
 
+bool IOMap::isSharable(const std::vector<uint16_t>& itemIds)
+{
+	for(uint16_t itemId : itemIds)
+	{
+		ItemKindPC kind = server.items()[itemId];
+		if(!kind || kind->group == ITEM_GROUP_DEPRECATED)
+			return false;
+
+		//items with a class of their own are registered elsewhere or act on the tile
+		if(kind->isContainer() || kind->isDepot() || kind->isDoor() || kind->isMagicField() || kind->isTeleporter()
+			|| kind->isTrashHolder() || kind->isMailbox() || kind->isBed())
+			return false;
+
+		//decaying items have to start decaying as soon as the map is loaded
+		if(kind->decayTo >= 0 && kind->decayTime)
+			return false;
+	}
+
+	return true;
+}
+
+void IOMap::decodeTileArea(const FileLoader& f, const NodeStruct* nodeArea, TileArea& area, bool shareTiles)
+{
+	//runs on several threads at once, so it must not touch anything but the area
+	std::vector<uint8_t> buffer;
+
+	PropStream propStream;
+	if(!f.getProps(nodeArea, propStream, buffer))
+	{
+		area.error = "Invalid map node.";
+		return;
+	}
+
+	OTBM_Destination_coords* area_coord;
+	if(!propStream.GET_STRUCT(area_coord))
+	{
+		area.error = "Invalid map node.";
+		return;
+	}
+
+	int32_t base_x = area_coord->_x, base_y = area_coord->_y, base_z = area_coord->_z;
+
+	uint32_t type = 0;
+	const NodeStruct* nodeTile = f.getChildNode(nodeArea, type);
+	while(nodeTile != NO_NODE)
+	{
+		if(type != OTBM_TILE && type != OTBM_HOUSETILE)
+		{
+			area.error = "Unknown tile node.";
+			return;
+		}
+
+		if(!f.getProps(nodeTile, propStream, buffer))
+		{
+			area.error = "Could not read node data.";
+			return;
+		}
+
+		OTBM_Tile_coords* tileCoord;
+		if(!propStream.GET_STRUCT(tileCoord))
+		{
+			area.error = "Could not read tile position.";
+			return;
+		}
+
+		uint16_t px = base_x + tileCoord->_x, py = base_y + tileCoord->_y, pz = base_z;
+		if (!Position::isValid(px, py, pz)) {
+			LOGe("Map contains tile at invalid position " << px << "/" << py << "/" << pz << ".");
+			nodeTile = f.getNextNode(nodeTile, type);
+			continue;
+		}
+
+		TileRecord record;
+		record.x = px;
+		record.y = py;
+		record.z = pz;
+		record.houseId = 0;
+		record.flags = 0;
+		record.node = nodeTile;
+		record.sharable = false;
+
+		if(type == OTBM_HOUSETILE && !propStream.GET_ULONG(record.houseId))
+		{
+			std::stringstream ss;
+			ss << "[x:" << px << ", y:" << py << ", z:" << pz << "] Could not read house id.";
+
+			area.error = ss.str();
+			return;
+		}
+
+		//read tile attributes
+		uint8_t attribute;
+		while(propStream.GET_UCHAR(attribute))
+		{
+			switch(attribute)
+			{
+				case OTBM_ATTR_TILE_FLAGS:
+				{
+					uint32_t flags;
+					if(!propStream.GET_ULONG(flags))
+					{
+						std::stringstream ss;
+						ss << "[x:" << px << ", y:" << py << ", z:" << pz << "] Failed to read tile flags.";
+
+						area.error = ss.str();
+						return;
+					}
+
+					if((flags & TILESTATE_PROTECTIONZONE) == TILESTATE_PROTECTIONZONE)
+						record.flags |= TILESTATE_PROTECTIONZONE;
+					else if((flags & TILESTATE_NOPVPZONE) == TILESTATE_NOPVPZONE)
+						record.flags |= TILESTATE_NOPVPZONE;
+					else if((flags & TILESTATE_PVPZONE) == TILESTATE_PVPZONE)
+						record.flags |= TILESTATE_PVPZONE;
+
+					if((flags & TILESTATE_NOLOGOUT) == TILESTATE_NOLOGOUT)
+						record.flags |= TILESTATE_NOLOGOUT;
+
+					if((flags & TILESTATE_REFRESH) == TILESTATE_REFRESH)
+					{
+						if(record.houseId)
+							LOGw("[x:" << px << ", y:" << py << ", z:" << pz << "] House tile flagged as refreshing!");
+
+						record.flags |= TILESTATE_REFRESH;
+					}
+
+					break;
+				}
+
+				case OTBM_ATTR_ITEM:
+				{
+					//created once all attributes are known, unless the tile can be shared
+					uint16_t itemId;
+					if(!propStream.GET_USHORT(itemId))
+					{
+						std::stringstream ss;
+						ss << "[x:" << px << ", y:" << py << ", z:" << pz << "] Failed to create item.";
+
+						area.error = ss.str();
+						return;
+					}
+
+					record.inlineItemIds.push_back(server.items().getRandomizedKindId(itemId));
+					break;
+				}
+
+				default:
+				{
+					std::stringstream ss;
+					ss << "[x:" << px << ", y:" << py << ", z:" << pz << "] Unknown tile attribute.";
+
+					area.error = ss.str();
+					return;
+				}
+			}
+		}
+
+		uint32_t childType;
+		record.sharable = (shareTiles && !record.houseId && !f.getChildNode(nodeTile, childType)
+			&& !(record.flags & TILESTATE_REFRESH) && isSharable(record.inlineItemIds));
+
+		area.tiles.push_back(std::move(record));
+		nodeTile = f.getNextNode(nodeTile, type);
+	}
+}
+
+bool IOMap::loadTile(Map* map, FileLoader& f, const TileRecord& record, uint32_t& totalDecayingItems, std::map<uint16_t,uint32_t>& decayingItems)
+{
+	uint16_t px = record.x, py = record.y, pz = record.z;
+
+	Tile* tile = nullptr;
+	boost::intrusive_ptr<Item> ground;
+
+	House* house = nullptr;
+	if(record.houseId)
+	{
+		house = Houses::getInstance()->getHouse(record.houseId, true);
+		if(!house)
+		{
+			std::stringstream ss;
+			ss << "[x:" << px << ", y:" << py << ", z:" << pz << "] Could not create house id: " << record.houseId;
+
+			setLastErrorString(ss.str());
+			return false;
+		}
+
+		tile = new HouseTile(px, py, pz, house);
+		house->addTile(static_cast<HouseTile*>(tile));
+	}
+
+	for(uint16_t itemId : record.inlineItemIds)
+	{
+		boost::intrusive_ptr<Item> item = Item::CreateItem(itemId, 0);
+		if(!item)
+		{
+			std::stringstream ss;
+			ss << "[x:" << px << ", y:" << py << ", z:" << pz << "] Failed to create item.";
+
+			setLastErrorString(ss.str());
+			return false;
+		}
+
+		item->setLoadedFromMap(true);
+
+		if (item->canDecay(true)) {
+			++totalDecayingItems;
+			++decayingItems[item->getId()];
+		}
+
+		if(house && item->isMoveable())
+		{
+			LOGw("[IOMap::loadMap] Movable item in house: " << house->getId() << ", item type: " << item->getId() << ", at position " << px << "/" << py << "/" << pz);
+
+			item = nullptr;
+		}
+		else if(tile)
+		{
+			tile->__internalAddThing(item.get());
+			if (item->getParent() == nullptr) {
+				std::stringstream ss;
+				ss << "[x:" << px << ", y:" << py << ", z:" << pz << "] Cannot add item " << item->getId() << " to tile.";
+				setLastErrorString(ss.str());
+
+				return false;
+			}
+
+			item->__startDecaying();
+		}
+		else if(item->isGroundTile())
+		{
+			ground = item;
+		}
+		else
+		{
+			tile = createTile(ground.get(), item.get(), px, py, pz);
+			tile->__internalAddThing(item.get());
+
+			item->__startDecaying();
+
+			ground = nullptr;
+		}
+	}
+
+	uint32_t type = 0;
+	const NodeStruct* nodeItem = f.getChildNode(record.node, type);
+	while(nodeItem)
+	{
+		if(type == OTBM_ITEM)
+		{
+			PropStream propStream;
+			f.getProps(nodeItem, propStream);
+
+			boost::intrusive_ptr<Item> item = Item::CreateItem(propStream);
+			if(!item)
+			{
+				std::stringstream ss;
+				ss << "[x:" << px << ", y:" << py << ", z:" << pz << "] Failed to create item.";
+
+				setLastErrorString(ss.str());
+				return false;
+			}
+
+			item->setLoadedFromMap(true);
+
+			if (item->canDecay(true)) {
+				++totalDecayingItems;
+				++decayingItems[item->getId()];
+			}
+
+			if(item->unserializeItemNode(f, nodeItem, propStream))
+			{
+				if(house && item->isMoveable())
+				{
+					LOGw("[IOMap::loadMap] Movable item in house: " << house->getId() << ", item type: " << item->getId() << ", pos " << px << "/" << py << "/" << pz);
+
+					item = nullptr;
+				}
+				else if(tile)
+				{
+					tile->__internalAddThing(item.get());
+					item->__startDecaying();
+				}
+				else if(item->isGroundTile())
+				{
+					ground = item;
+				}
+				else
+				{
+					tile = createTile(ground.get(), item.get(), px, py, pz);
+					tile->__internalAddThing(item.get());
+					item->__startDecaying();
+
+					ground = nullptr;
+				}
+			}
+			else
+			{
+				std::stringstream ss;
+				ss << "[x:" << px << ", y:" << py << ", z:" << pz << "] Failed to load item " << item->getId() << ".";
+				setLastErrorString(ss.str());
+
+				return false;
+			}
+		}
+		else
+		{
+			std::stringstream ss;
+			ss << "[x:" << px << ", y:" << py << ", z:" << pz << "] Unknown node type.";
+			setLastErrorString(ss.str());
+		}
+
+		nodeItem = f.getNextNode(nodeItem, type);
+	}
+
+	if(!tile) {
+		tile = createTile(ground.get(), nullptr, px, py, pz);
+		ground = nullptr;
+	}
+
+	tile->setFlag((tileflags_t)record.flags);
+	if (!map->setTile(px, py, pz, tile)) {
+		delete tile;
+	}
+
+	return true;
+}
+
 bool IOMap::loadMap(Map* map, const std::string& identifier)
 {
 	FileLoader f;
-	if(!f.openFile(identifier.c_str(), false, true))
+	if(!f.mapFile(identifier.c_str()))
 	{
 		std::stringstream ss;
 		ss << "Could not open the file " << identifier << ".";
@@ -219,8 +547,7 @@ bool IOMap::loadMap(Map* map, const std::string& identifier)
 		}
 	}
 
-	uint32_t totalDecayingItems = 0;
-	std::map<uint16_t,uint32_t> decayingItems;
+	std::vector<const NodeStruct*> areaNodes;
 
 	const NodeStruct* nodeMapData = f.getChildNode(nodeMap, type);
 	while(nodeMapData != NO_NODE)
@@ -232,277 +559,7 @@ bool IOMap::loadMap(Map* map, const std::string& identifier)
 		}
 
 		if(type == OTBM_TILE_AREA)
-		{
-			if(!f.getProps(nodeMapData, propStream))
-			{
-				setLastErrorString("Invalid map node.");
-				return false;
-			}
-
-			OTBM_Destination_coords* area_coord;
-			if(!propStream.GET_STRUCT(area_coord))
-			{
-				setLastErrorString("Invalid map node.");
-				return false;
-			}
-
-			int32_t base_x = area_coord->_x, base_y = area_coord->_y, base_z = area_coord->_z;
-			const NodeStruct* nodeTile = f.getChildNode(nodeMapData, type);
-			while(nodeTile != NO_NODE)
-			{
-				if(f.getError() != ERROR_NONE)
-				{
-					setLastErrorString("Could not read node data.");
-					return false;
-				}
-
-				if(type == OTBM_TILE || type == OTBM_HOUSETILE)
-				{
-					if(!f.getProps(nodeTile, propStream))
-					{
-						setLastErrorString("Could not read node data.");
-						return false;
-					}
-
-					OTBM_Tile_coords* tileCoord;
-					if(!propStream.GET_STRUCT(tileCoord))
-					{
-						setLastErrorString("Could not read tile position.");
-						return false;
-					}
-
-					Tile* tile = nullptr;
-					boost::intrusive_ptr<Item> ground;
-					uint32_t tileflags = 0;
-
-					uint16_t px = base_x + tileCoord->_x, py = base_y + tileCoord->_y, pz = base_z;
-					if (!Position::isValid(px, py, pz)) {
-						LOGe("Map contains tile at invalid position " << px << "/" << py << "/" << pz << ".");
-						nodeTile = f.getNextNode(nodeTile, type);
-						continue;
-					}
-
-					House* house = nullptr;
-					if(type == OTBM_HOUSETILE)
-					{
-						uint32_t _houseid;
-						if(!propStream.GET_ULONG(_houseid))
-						{
-							std::stringstream ss;
-							ss << "[x:" << px << ", y:" << py << ", z:" << pz << "] Could not read house id.";
-
-							setLastErrorString(ss.str());
-							return false;
-						}
-
-						house = Houses::getInstance()->getHouse(_houseid, true);
-						if(!house)
-						{
-							std::stringstream ss;
-							ss << "[x:" << px << ", y:" << py << ", z:" << pz << "] Could not create house id: " << _houseid;
-
-							setLastErrorString(ss.str());
-							return false;
-						}
-
-						tile = new HouseTile(px, py, pz, house);
-						house->addTile(static_cast<HouseTile*>(tile));
-					}
-
-					//read tile attributes
-					uint8_t attribute;
-					while(propStream.GET_UCHAR(attribute))
-					{
-						switch(attribute)
-						{
-							case OTBM_ATTR_TILE_FLAGS:
-							{
-								uint32_t flags;
-								if(!propStream.GET_ULONG(flags))
-								{
-									std::stringstream ss;
-									ss << "[x:" << px << ", y:" << py << ", z:" << pz << "] Failed to read tile flags.";
-
-									setLastErrorString(ss.str());
-									return false;
-								}
-
-								if((flags & TILESTATE_PROTECTIONZONE) == TILESTATE_PROTECTIONZONE)
-									tileflags |= TILESTATE_PROTECTIONZONE;
-								else if((flags & TILESTATE_NOPVPZONE) == TILESTATE_NOPVPZONE)
-									tileflags |= TILESTATE_NOPVPZONE;
-								else if((flags & TILESTATE_PVPZONE) == TILESTATE_PVPZONE)
-									tileflags |= TILESTATE_PVPZONE;
-
-								if((flags & TILESTATE_NOLOGOUT) == TILESTATE_NOLOGOUT)
-									tileflags |= TILESTATE_NOLOGOUT;
-
-								if((flags & TILESTATE_REFRESH) == TILESTATE_REFRESH)
-								{
-									if(house)
-										LOGw("[x:" << px << ", y:" << py << ", z:" << pz << "] House tile flagged as refreshing!");
-
-									tileflags |= TILESTATE_REFRESH;
-								}
-
-								break;
-							}
-
-							case OTBM_ATTR_ITEM:
-							{
-								boost::intrusive_ptr<Item> item = Item::CreateItem(propStream);
-								if(!item)
-								{
-									std::stringstream ss;
-									ss << "[x:" << px << ", y:" << py << ", z:" << pz << "] Failed to create item.";
-
-									setLastErrorString(ss.str());
-									return false;
-								}
-
-								item->setLoadedFromMap(true);
-
-								if (item->canDecay(true)) {
-									++totalDecayingItems;
-									++decayingItems[item->getId()];
-								}
-
-								if(house && item->isMoveable())
-								{
-									LOGw("[IOMap::loadMap] Movable item in house: " << house->getId() << ", item type: " << item->getId() << ", at position " << px << "/" << py << "/" << pz);
-
-									item = nullptr;
-								}
-								else if(tile)
-								{
-									tile->__internalAddThing(item.get());
-									if (item->getParent() == nullptr) {
-										std::stringstream ss;
-										ss << "[x:" << px << ", y:" << py << ", z:" << pz << "] Cannot add item " << item->getId() << " to tile.";
-										setLastErrorString(ss.str());
-
-										return false;
-									}
-
-									item->__startDecaying();
-								}
-								else if(item->isGroundTile())
-								{
-									ground = item;
-								}
-								else
-								{
-									tile = createTile(ground.get(), item.get(), px, py, pz);
-									tile->__internalAddThing(item.get());
-
-									item->__startDecaying();
-
-									ground = nullptr;
-								}
-
-								break;
-							}
-
-							default:
-							{
-								std::stringstream ss;
-								ss << "[x:" << px << ", y:" << py << ", z:" << pz << "] Unknown tile attribute.";
-
-								setLastErrorString(ss.str());
-								return false;
-							}
-						}
-					}
-
-					const NodeStruct* nodeItem = f.getChildNode(nodeTile, type);
-					while(nodeItem)
-					{
-						if(type == OTBM_ITEM)
-						{
-							PropStream propStream;
-							f.getProps(nodeItem, propStream);
-
-							boost::intrusive_ptr<Item> item = Item::CreateItem(propStream);
-							if(!item)
-							{
-								std::stringstream ss;
-								ss << "[x:" << px << ", y:" << py << ", z:" << pz << "] Failed to create item.";
-
-								setLastErrorString(ss.str());
-								return false;
-							}
-
-							item->setLoadedFromMap(true);
-
-							if (item->canDecay(true)) {
-								++totalDecayingItems;
-								++decayingItems[item->getId()];
-							}
-
-							if(item->unserializeItemNode(f, nodeItem, propStream))
-							{
-								if(house && item->isMoveable())
-								{
-									LOGw("[IOMap::loadMap] Movable item in house: " << house->getId() << ", item type: " << item->getId() << ", pos " << px << "/" << py << "/" << pz);
-
-									item = nullptr;
-								}
-								else if(tile)
-								{
-									tile->__internalAddThing(item.get());
-									item->__startDecaying();
-								}
-								else if(item->isGroundTile())
-								{
-									ground = item;
-								}
-								else
-								{
-									tile = createTile(ground.get(), item.get(), px, py, pz);
-									tile->__internalAddThing(item.get());
-									item->__startDecaying();
-
-									ground = nullptr;
-								}
-							}
-							else
-							{
-								std::stringstream ss;
-								ss << "[x:" << px << ", y:" << py << ", z:" << pz << "] Failed to load item " << item->getId() << ".";
-								setLastErrorString(ss.str());
-
-								return false;
-							}
-						}
-						else
-						{
-							std::stringstream ss;
-							ss << "[x:" << px << ", y:" << py << ", z:" << pz << "] Unknown node type.";
-							setLastErrorString(ss.str());
-						}
-
-						nodeItem = f.getNextNode(nodeItem, type);
-					}
-
-					if(!tile) {
-						tile = createTile(ground.get(), nullptr, px, py, pz);
-						ground = nullptr;
-					}
-
-					tile->setFlag((tileflags_t)tileflags);
-					if (!map->setTile(px, py, pz, tile)) {
-						delete tile;
-					}
-				}
-				else
-				{
-					setLastErrorString("Unknown tile node.");
-					return false;
-				}
-
-				nodeTile = f.getNextNode(nodeTile, type);
-			}
-		}
+			areaNodes.push_back(nodeMapData);
 		else if(type == OTBM_TOWNS)
 		{
 			const NodeStruct* nodeTown = f.getChildNode(nodeMapData, type);
@@ -602,6 +659,55 @@ bool IOMap::loadMap(Map* map, const std::string& identifier)
 		nodeMapData = f.getNextNode(nodeMapData, type);
 	}
 
+	bool shareTiles = server.configManager().getBool(ConfigManager::SHARED_MAP_TILES);
+	uint32_t totalDecayingItems = 0;
+	std::map<uint16_t,uint32_t> decayingItems;
+
+	//tile areas are decoded in parallel, a few at a time so that decoded tiles never pile up for the whole map
+	uint32_t threadCount = std::max(1u, std::thread::hardware_concurrency());
+	size_t waveSize = threadCount * 8;
+
+	std::vector<TileArea> areas;
+	for(size_t waveStart = 0; waveStart < areaNodes.size(); waveStart += waveSize)
+	{
+		size_t waveEnd = std::min(waveStart + waveSize, areaNodes.size());
+
+		areas.clear();
+		areas.resize(waveEnd - waveStart);
+
+		std::atomic<size_t> nextArea(waveStart);
+		auto decodeAreas = [&]() {
+			for(size_t index = nextArea++; index < waveEnd; index = nextArea++)
+				decodeTileArea(f, areaNodes[index], areas[index - waveStart], shareTiles);
+		};
+
+		std::vector<std::thread> threads;
+		for(uint32_t i = 1; i < std::min<size_t>(threadCount, areas.size()); ++i)
+			threads.emplace_back(decodeAreas);
+
+		decodeAreas();
+		for(auto& thread : threads)
+			thread.join();
+
+		//creating items and tiles registers unique ids, houses, beds and decaying items, so it happens in map order
+		for(const TileArea& area : areas)
+		{
+			if(!area.error.empty())
+			{
+				setLastErrorString(area.error);
+				return false;
+			}
+
+			for(const TileRecord& record : area.tiles)
+			{
+				if(record.sharable)
+					map->setTileTemplate(record.x, record.y, record.z, map->getTileTemplate(record.flags, record.inlineItemIds));
+				else if(!loadTile(map, f, record, totalDecayingItems, decayingItems))
+					return false;
+			}
+		}
+	}
+
 	if (totalDecayingItems > 0) {
 		if (totalDecayingItems <= 100) {
 			LOGi("Your map contains " << totalDecayingItems << " items with limited duration. This may affect the server's performance!");
@@ -18,9 +18,11 @@
 #ifndef _IOMAP_H
 #define _IOMAP_H
 
+class FileLoader;
 class Map;
 class Item;
 class Tile;
+struct NodeStruct;
 
 
 enum OTBM_AttrTypes_t
@@ -99,8 +101,30 @@ struct OTBM_HouseTile_coords
 
 class IOMap
 {
-	static Tile* createTile(Item* ground, Item* item, uint16_t px, uint16_t py, uint16_t pz);
+	//a tile as read from the map file, before any of its items are created
+	struct TileRecord
+	{
+		uint16_t x, y, z;
+		uint32_t houseId, flags;
+		std::vector<uint16_t> inlineItemIds;
+		const NodeStruct* node;
+		bool sharable;
+	};
+
+	//the tiles of one tile area, which is decoded independently of all other areas
+	struct TileArea
+	{
+		std::vector<TileRecord> tiles;
+		std::string error;
+	};
+
+	static void decodeTileArea(const FileLoader& f, const NodeStruct* nodeArea, TileArea& area, bool shareTiles);
+	static bool isSharable(const std::vector<uint16_t>& itemIds);
+	bool loadTile(Map* map, FileLoader& f, const TileRecord& record, uint32_t& totalDecayingItems, std::map<uint16_t,uint32_t>& decayingItems);
+
 	public:
+		static Tile* createTile(Item* ground, Item* item, uint16_t px, uint16_t py, uint16_t pz);
+
 		bool loadMap(Map* map, const std::string& identifier);
 
 		/* Load the spawns
@@ -264,23 +264,31 @@ bool IOMapSerialize::loadMapRelational(Map* map)
 	Database& db = server.database();
 	DBQuery query; //lock mutex!
 
+	int32_t worldId = server.configManager().getNumber(ConfigManager::WORLD_ID);
+
+	DBStatement* tilesStatement = db.prepare("SELECT `id`, `x`, `y`, `z` FROM `tiles` WHERE `house_id` = ? AND `world_id` = ?");
+	tilesStatement->bind(1, worldId);
+
+	DBStatement* tileStatement = db.prepare("SELECT `id` FROM `tiles` WHERE `x` = ? AND `y` = ? AND `z` = ? AND `world_id` = ? LIMIT 1");
+	tileStatement->bind(3, worldId);
+
+	DBStatement* itemsStatement = db.prepare("SELECT `pid`, `sid`, `itemtype`, `count`, `attributes` FROM `tile_items` WHERE `tile_id` = ? AND `world_id` = ? ORDER BY `sid` DESC");
+	itemsStatement->bind(1, worldId);
+
 	House* house = nullptr;
 	for(HouseMap::iterator it = Houses::getInstance()->getHouseBegin(); it != Houses::getInstance()->getHouseEnd(); ++it)
 	{
 		if(!(house = it->second))
 			continue;
 
-		query.str("");
-		query << "SELECT * FROM `tiles` WHERE `house_id` = " << house->getId() <<
-			" AND `world_id` = " << server.configManager().getNumber(ConfigManager::WORLD_ID);
-		if(DBResultP result = db.storeQuery(query.str()))
+		tilesStatement->bind(0, house->getId());
+		if(DBResultP result = tilesStatement->query())
 		{
+			int32_t idColumn = result->getColumn("id"), xColumn = result->getColumn("x"), yColumn = result->getColumn("y"), zColumn = result->getColumn("z");
 			do
 			{
-				query.str("");
-				query << "SELECT * FROM `tile_items` WHERE `tile_id` = " << result->getDataInt("id") << " AND `world_id` = "
-					<< server.configManager().getNumber(ConfigManager::WORLD_ID) << " ORDER BY `sid` DESC";
-				if(DBResultP itemsResult = db.storeQuery(query.str()))
+				itemsStatement->bind(0, result->getDataInt(idColumn));
+				if(DBResultP itemsResult = itemsStatement->query())
 				{
 					if(house->hasPendingTransfer())
 					{
@@ -296,7 +304,7 @@ bool IOMapSerialize::loadMapRelational(Map* map)
 					}
 					else
 					{
-						Position pos(result->getDataInt("x"), result->getDataInt("y"), result->getDataInt("z"));
+						Position pos(result->getDataInt(xColumn), result->getDataInt(yColumn), result->getDataInt(zColumn));
 						if(Tile* tile = map->getTile(pos))
 							loadItems(db, std::move(itemsResult), tile, false);
 						else
@@ -310,16 +318,13 @@ bool IOMapSerialize::loadMapRelational(Map* map)
 		{
 			for(HouseTileList::iterator it = house->getHouseTileBegin(); it != house->getHouseTileEnd(); ++it)
 			{
-				query.str("");
-				query << "SELECT `id` FROM `tiles` WHERE `x` = " << (*it)->getPosition().x << " AND `y` = "
-					<< (*it)->getPosition().y << " AND `z` = " << (*it)->getPosition().z << " AND `world_id` = "
-					<< server.configManager().getNumber(ConfigManager::WORLD_ID) << " LIMIT 1";
-				if(DBResultP result = db.storeQuery(query.str()))
+				tileStatement->bind(0, (*it)->getPosition().x);
+				tileStatement->bind(1, (*it)->getPosition().y);
+				tileStatement->bind(2, (*it)->getPosition().z);
+				if(DBResultP result = tileStatement->query())
 				{
-					query.str("");
-					query << "SELECT * FROM `tile_items` WHERE `tile_id` = " << result->getDataInt("id") << " AND `world_id` = "
-						<< server.configManager().getNumber(ConfigManager::WORLD_ID) << " ORDER BY `sid` DESC";
-					if(DBResultP itemsResult = db.storeQuery(query.str()))
+					itemsStatement->bind(0, result->getDataInt("id"));
+					if(DBResultP itemsResult = itemsStatement->query())
 					{
 						if(house->hasPendingTransfer())
 						{
@@ -490,18 +495,21 @@ bool IOMapSerialize::loadItems(Database& db, DBResultP result, Cylinder* parent,
 		tile = parent->getTile();
 
 
+	int32_t sidColumn = result->getColumn("sid"), pidColumn = result->getColumn("pid"), idColumn = result->getColumn("itemtype"),
+		countColumn = result->getColumn("count"), attributesColumn = result->getColumn("attributes");
+
 	int32_t sid, pid, id, count;
 	do
 	{
 		boost::intrusive_ptr<Item> item;
 
-		sid = result->getDataInt("sid");
-		pid = result->getDataInt("pid");
-		id = result->getDataInt("itemtype");
-		count = result->getDataInt("count");
+		sid = result->getDataInt(sidColumn);
+		pid = result->getDataInt(pidColumn);
+		id = result->getDataInt(idColumn);
+		count = result->getDataInt(countColumn);
 
 		uint64_t attrSize = 0;
-		const char* attr = result->getDataStream("attributes", attrSize);
+		const char* attr = result->getDataStream(attributesColumn, attrSize);
 
 		PropStream propStream;
 		propStream.init(attr, attrSize);
@@ -47,30 +47,30 @@
 #include "server.h"
 
 
-const std::string Item::ATTRIBUTE_AID("aid");
-const std::string Item::ATTRIBUTE_ARMOR("armor");
-const std::string Item::ATTRIBUTE_ARTICLE("article");
-const std::string Item::ATTRIBUTE_ATTACK("attack");
-const std::string Item::ATTRIBUTE_ATTACKSPEED("attackspeed");
-const std::string Item::ATTRIBUTE_CHARGES("charges");
-const std::string Item::ATTRIBUTE_CORPSEOWNER("corpseowner");
-const std::string Item::ATTRIBUTE_DATE("date");
-const std::string Item::ATTRIBUTE_DECAYING("decaying");
-const std::string Item::ATTRIBUTE_DEFENSE("defense");
-const std::string Item::ATTRIBUTE_DESCRIPTION("description");
-const std::string Item::ATTRIBUTE_DURATION("duration");
-const std::string Item::ATTRIBUTE_EXTRAATTACK("extraattack");
-const std::string Item::ATTRIBUTE_EXTRADEFENSE("extradefense");
-const std::string Item::ATTRIBUTE_FLUIDTYPE("fluidtype");
-const std::string Item::ATTRIBUTE_HITCHANCE("hitchance");
-const std::string Item::ATTRIBUTE_NAME("name");
-const std::string Item::ATTRIBUTE_OWNER("owner");
-const std::string Item::ATTRIBUTE_PLURALNAME("pluralname");
-const std::string Item::ATTRIBUTE_SCRIPTPROTECTED("scriptprotected");
-const std::string Item::ATTRIBUTE_SHOOTRANGE("shootrange");
-const std::string Item::ATTRIBUTE_TEXT("text");
-const std::string Item::ATTRIBUTE_UID("uid");
-const std::string Item::ATTRIBUTE_WRITER("writer");
+const attributes::Name Item::ATTRIBUTE_AID("aid");
+const attributes::Name Item::ATTRIBUTE_ARMOR("armor");
+const attributes::Name Item::ATTRIBUTE_ARTICLE("article");
+const attributes::Name Item::ATTRIBUTE_ATTACK("attack");
+const attributes::Name Item::ATTRIBUTE_ATTACKSPEED("attackspeed");
+const attributes::Name Item::ATTRIBUTE_CHARGES("charges");
+const attributes::Name Item::ATTRIBUTE_CORPSEOWNER("corpseowner");
+const attributes::Name Item::ATTRIBUTE_DATE("date");
+const attributes::Name Item::ATTRIBUTE_DECAYING("decaying");
+const attributes::Name Item::ATTRIBUTE_DEFENSE("defense");
+const attributes::Name Item::ATTRIBUTE_DESCRIPTION("description");
+const attributes::Name Item::ATTRIBUTE_DURATION("duration");
+const attributes::Name Item::ATTRIBUTE_EXTRAATTACK("extraattack");
+const attributes::Name Item::ATTRIBUTE_EXTRADEFENSE("extradefense");
+const attributes::Name Item::ATTRIBUTE_FLUIDTYPE("fluidtype");
+const attributes::Name Item::ATTRIBUTE_HITCHANCE("hitchance");
+const attributes::Name Item::ATTRIBUTE_NAME("name");
+const attributes::Name Item::ATTRIBUTE_OWNER("owner");
+const attributes::Name Item::ATTRIBUTE_PLURALNAME("pluralname");
+const attributes::Name Item::ATTRIBUTE_SCRIPTPROTECTED("scriptprotected");
+const attributes::Name Item::ATTRIBUTE_SHOOTRANGE("shootrange");
+const attributes::Name Item::ATTRIBUTE_TEXT("text");
+const attributes::Name Item::ATTRIBUTE_UID("uid");
+const attributes::Name Item::ATTRIBUTE_WRITER("writer");
 
 LOGGER_DEFINITION(Item);
 
@@ -2133,35 +2133,34 @@ void Item::serializeAttr(PropWriteStream& stream) const
 		stream.ADD_UCHAR((uint8_t)getSubType());
 	}
 
-	auto entries = _attributes.getEntries();
-	if (entries != nullptr && !entries->empty()) {
+	if (!_attributes.isEmpty()) {
 		stream.ADD_UCHAR(ATTR_ATTRIBUTE_MAP);
-		stream.ADD_USHORT((uint16_t)std::min((size_t)0xFFFF, entries->size()));
+		stream.ADD_USHORT((uint16_t)std::min((size_t)0xFFFF, _attributes.size()));
 
-		for (auto& it : *entries) {
-			auto& attribute = *it.first;
+		for (auto& entry : _attributes) {
+			auto& attribute = entry.getAttribute();
 
 			stream.ADD_STRING(attribute.getName());
 
 			switch (attribute.getType()) {
 			case attributes::Type::BOOLEAN:
 				stream.ADD_UCHAR((uint8_t)SerializedTypeBool);
-				stream.ADD_UCHAR(boost::any_cast<bool>(it.second) ? 1 : 0);
+				stream.ADD_UCHAR(entry.getBoolean() ? 1 : 0);
 				break;
 
 			case attributes::Type::FLOAT:
 				stream.ADD_UCHAR((uint8_t)SerializedTypeFloat);
-				stream.ADD_VALUE(boost::any_cast<float>(it.second));
+				stream.ADD_VALUE(entry.getFloat());
 				break;
 
 			case attributes::Type::INTEGER:
 				stream.ADD_UCHAR((uint8_t)SerializedTypeInt);
-				stream.ADD_VALUE(boost::any_cast<int32_t>(it.second));
+				stream.ADD_VALUE(entry.getInteger());
 				break;
 
 			case attributes::Type::STRING:
 				stream.ADD_UCHAR((uint8_t)SerializedTypeString);
-				stream.ADD_LSTRING(boost::any_cast<const std::string&>(it.second));
+				stream.ADD_LSTRING(entry.getString());
 				break;
 
 			default:
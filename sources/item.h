@@ -19,6 +19,7 @@
 #define _ITEM_H
 
 #include "attributes/Attribute.hpp"
+#include "attributes/Name.hpp"
 #include "attributes/Scheme.hpp"
 #include "attributes/Values.hpp"
 #include "const.h"
@@ -193,30 +194,30 @@ private:
 		typedef attributes::Scheme::AttributesP  ClassAttributesP;
 
 
-		static const std::string ATTRIBUTE_AID;
-		static const std::string ATTRIBUTE_ARMOR;
-		static const std::string ATTRIBUTE_ARTICLE;
-		static const std::string ATTRIBUTE_ATTACK;
-		static const std::string ATTRIBUTE_ATTACKSPEED;
-		static const std::string ATTRIBUTE_CHARGES;
-		static const std::string ATTRIBUTE_CORPSEOWNER;
-		static const std::string ATTRIBUTE_DATE;
-		static const std::string ATTRIBUTE_DEFENSE;
-		static const std::string ATTRIBUTE_DESCRIPTION;
-		static const std::string ATTRIBUTE_DECAYING;
-		static const std::string ATTRIBUTE_DURATION;
-		static const std::string ATTRIBUTE_EXTRAATTACK;
-		static const std::string ATTRIBUTE_EXTRADEFENSE;
-		static const std::string ATTRIBUTE_FLUIDTYPE;
-		static const std::string ATTRIBUTE_HITCHANCE;
-		static const std::string ATTRIBUTE_NAME;
-		static const std::string ATTRIBUTE_OWNER;
-		static const std::string ATTRIBUTE_PLURALNAME;
-		static const std::string ATTRIBUTE_SCRIPTPROTECTED;
-		static const std::string ATTRIBUTE_SHOOTRANGE;
-		static const std::string ATTRIBUTE_TEXT;
-		static const std::string ATTRIBUTE_UID;
-		static const std::string ATTRIBUTE_WRITER;
+		static const attributes::Name ATTRIBUTE_AID;
+		static const attributes::Name ATTRIBUTE_ARMOR;
+		static const attributes::Name ATTRIBUTE_ARTICLE;
+		static const attributes::Name ATTRIBUTE_ATTACK;
+		static const attributes::Name ATTRIBUTE_ATTACKSPEED;
+		static const attributes::Name ATTRIBUTE_CHARGES;
+		static const attributes::Name ATTRIBUTE_CORPSEOWNER;
+		static const attributes::Name ATTRIBUTE_DATE;
+		static const attributes::Name ATTRIBUTE_DEFENSE;
+		static const attributes::Name ATTRIBUTE_DESCRIPTION;
+		static const attributes::Name ATTRIBUTE_DECAYING;
+		static const attributes::Name ATTRIBUTE_DURATION;
+		static const attributes::Name ATTRIBUTE_EXTRAATTACK;
+		static const attributes::Name ATTRIBUTE_EXTRADEFENSE;
+		static const attributes::Name ATTRIBUTE_FLUIDTYPE;
+		static const attributes::Name ATTRIBUTE_HITCHANCE;
+		static const attributes::Name ATTRIBUTE_NAME;
+		static const attributes::Name ATTRIBUTE_OWNER;
+		static const attributes::Name ATTRIBUTE_PLURALNAME;
+		static const attributes::Name ATTRIBUTE_SCRIPTPROTECTED;
+		static const attributes::Name ATTRIBUTE_SHOOTRANGE;
+		static const attributes::Name ATTRIBUTE_TEXT;
+		static const attributes::Name ATTRIBUTE_UID;
+		static const attributes::Name ATTRIBUTE_WRITER;
 
 
 		static ClassAttributesP   getClassAttributes();
@@ -133,6 +133,109 @@ ItemKind::~ItemKind() {
 
 
 
+namespace {
+
+	// Every plain field of ItemKind which is stored in the item kind cache. The cache version has to be increased whenever
+	// this list or the layout of the stored data changes.
+	#define ITEM_KIND_CACHE_FIELDS(FIELD) \
+		FIELD(stopTime) FIELD(showCount) FIELD(clientCharges) FIELD(stackable) FIELD(showDuration) FIELD(showCharges) \
+		FIELD(showAttributes) FIELD(allowDistRead) FIELD(canReadText) FIELD(canWriteText) FIELD(forceSerialize) \
+		FIELD(isVertical) FIELD(isHorizontal) FIELD(isHangable) FIELD(useable) FIELD(moveable) FIELD(pickupable) \
+		FIELD(rotable) FIELD(replaceable) FIELD(lookThrough) FIELD(hasHeight) FIELD(blockSolid) FIELD(blockPickupable) \
+		FIELD(blockProjectile) FIELD(blockPathFind) FIELD(allowPickupable) FIELD(alwaysOnTop) FIELD(floorChange0) \
+		FIELD(floorChange1) FIELD(floorChange2) FIELD(floorChange3) FIELD(floorChange4) FIELD(floorChange5) \
+		FIELD(floorChange6) FIELD(floorChange7) FIELD(floorChange8) FIELD(floorChange9) FIELD(magicEffect) \
+		FIELD(fluidSource) FIELD(weaponType) FIELD(bedPartnerDir) FIELD(ammoAction) FIELD(combatType) FIELD(corpseType) \
+		FIELD(shootType) FIELD(ammoType) FIELD(group) FIELD(slotPosition) FIELD(wieldPosition) FIELD(type) \
+		FIELD(charges) FIELD(transformUseTo[0]) FIELD(transformUseTo[1]) FIELD(transformToFree) \
+		FIELD(transformEquipTo) FIELD(transformDeEquipTo) FIELD(id) FIELD(clientId) FIELD(maxItems) FIELD(speed) \
+		FIELD(maxTextLen) FIELD(writeOnceItemId) FIELD(attack) FIELD(extraAttack) FIELD(defense) FIELD(extraDefense) \
+		FIELD(armor) FIELD(breakChance) FIELD(hitChance) FIELD(maxHitChance) FIELD(runeLevel) FIELD(runeMagLevel) \
+		FIELD(lightLevel) FIELD(lightColor) FIELD(decayTo) FIELD(rotateTo) FIELD(alwaysOnTopOrder) FIELD(shootRange) \
+		FIELD(decayTime) FIELD(attackSpeed) FIELD(wieldInfo) FIELD(minReqLevel) FIELD(minReqMagicLevel) FIELD(worth) \
+		FIELD(levelDoor)
+
+	const uint32_t itemKindCacheVersion = 1;
+
+	enum ItemKindCacheNode : uint8_t {
+		ITEM_KIND_CACHE_ROOT,
+		ITEM_KIND_CACHE_KIND,
+	};
+
+
+	bool readItemKind(PropStream& stream, ItemKind& kind) {
+		#define READ_FIELD(field) { \
+			int32_t value; \
+			if (!stream.GET_VALUE(value)) { \
+				return false; \
+			} \
+			kind.field = static_cast<std::remove_reference<decltype(kind.field)>::type>(value); \
+		}
+
+		ITEM_KIND_CACHE_FIELDS(READ_FIELD)
+		#undef READ_FIELD
+
+		int64_t expirationDelay;
+		uint8_t hasCondition;
+		if (!stream.GET_VALUE(expirationDelay) || !stream.GET_VALUE(kind.weight) || !stream.GET_VALUE(kind.abilities)
+			|| !stream.GET_STRING(kind.name) || !stream.GET_STRING(kind.pluralName) || !stream.GET_STRING(kind.article)
+			|| !stream.GET_STRING(kind.description) || !stream.GET_STRING(kind.runeSpellName)
+			|| !stream.GET_STRING(kind.vocationString) || !stream.GET_UCHAR(hasCondition)) {
+			return false;
+		}
+
+		kind.expirationDelay = Duration(expirationDelay);
+
+		if (hasCondition) {
+			kind.condition = Condition::createCondition(stream);
+			if (kind.condition == nullptr || !kind.condition->unserialize(stream)) {
+				return false;
+			}
+
+			// only field damage is stored in item kinds and its force update flag is derived from the damage
+			if (auto conditionDamage = dynamic_cast<ConditionDamage*>(kind.condition)) {
+				if (conditionDamage->getTotalDamage() > 0) {
+					conditionDamage->setParam(CONDITIONPARAM_FORCEUPDATE, true);
+				}
+			}
+		}
+
+		return true;
+	}
+
+
+	void writeItemKind(PropWriteStream& stream, const ItemKind& kind) {
+		#define WRITE_FIELD(field) stream.ADD_VALUE(static_cast<int32_t>(kind.field));
+
+		ITEM_KIND_CACHE_FIELDS(WRITE_FIELD)
+		#undef WRITE_FIELD
+
+		stream.ADD_VALUE(static_cast<int64_t>(kind.expirationDelay.count()));
+		stream.ADD_VALUE(kind.weight);
+		stream.ADD_VALUE(kind.abilities);
+		stream.ADD_STRING(kind.name);
+		stream.ADD_STRING(kind.pluralName);
+		stream.ADD_STRING(kind.article);
+		stream.ADD_STRING(kind.description);
+		stream.ADD_STRING(kind.runeSpellName);
+		stream.ADD_STRING(kind.vocationString);
+
+		if (kind.condition != nullptr) {
+			stream.ADD_UCHAR(1);
+			kind.condition->serialize(stream);
+			stream.ADD_UCHAR(CONDITIONATTR_END);
+		}
+		else {
+			stream.ADD_UCHAR(0);
+		}
+	}
+
+	#undef ITEM_KIND_CACHE_FIELDS
+
+}
+
+
+
 LOGGER_DEFINITION(Items);
 
 
@@ -278,6 +381,12 @@ uint16_t Items::getRandomizedKindId(uint16_t kindId) const {
 }
 
 
+// The files the item kinds are loaded from, which also decide whether caches built from item kinds are still valid.
+StringVector Items::getSourceFilePaths() {
+	return {getFilePath(FileType::OTHER, "items/items.otb"), getFilePath(FileType::OTHER, "items/items.xml")};
+}
+
+
 uint32_t Items::getVersionBuild() const {
 	return _versionBuild;
 }
@@ -1570,11 +1679,79 @@ void Items::loadKindFromXmlNode(xmlNodePtr root, uint16_t kindId, const std::str
 }
 
 
+bool Items::loadKindsFromCache(const std::string& sourceHash) {
+	std::string filePath = getFilePath(FileType::OTHER, "items/items.cache");
+
+	FileLoader loader;
+	if (!loader.mapFile(filePath.c_str())) {
+		return false;
+	}
+
+	uint32_t nodeType;
+	const NodeStruct* node = loader.getChildNode(NO_NODE, nodeType);
+
+	PropStream properties;
+	if (nodeType != ITEM_KIND_CACHE_ROOT || !loader.getProps(node, properties)) {
+		return false;
+	}
+
+	uint32_t version, kindSize, abilitiesSize;
+	std::string hash;
+	if (!properties.GET_ULONG(version) || !properties.GET_ULONG(kindSize) || !properties.GET_ULONG(abilitiesSize)
+		|| !properties.GET_STRING(hash)) {
+		return false;
+	}
+
+	if (version != itemKindCacheVersion || kindSize != sizeof(ItemKind) || abilitiesSize != sizeof(Abilities) || hash != sourceHash) {
+		LOGi("Item kind cache " << filePath << " is outdated.");
+		return false;
+	}
+
+	uint32_t worthCount;
+	if (!properties.GET_ULONG(_versionBuild) || !properties.GET_ULONG(_versionMajor) || !properties.GET_ULONG(_versionMinor)
+		|| !properties.GET_ULONG(worthCount)) {
+		return false;
+	}
+
+	for (uint32_t i = 0; i < worthCount; ++i) {
+		int32_t worth;
+		uint16_t kindId;
+		if (!properties.GET_VALUE(worth) || !properties.GET_USHORT(kindId)) {
+			return false;
+		}
+
+		_worth[worth] = kindId;
+	}
+
+	for (node = loader.getChildNode(node, nodeType); node != NO_NODE; node = loader.getNextNode(node, nodeType)) {
+		ItemKindP kind = std::make_shared<ItemKind>();
+		if (nodeType != ITEM_KIND_CACHE_KIND || !loader.getProps(node, properties) || !readItemKind(properties, *kind)) {
+			LOGe("Item kind cache " << filePath << " is corrupt.");
+			return false;
+		}
+
+		auto clazzIt = _classes.find(kind->type);
+		if (clazzIt == _classes.cend()) {
+			LOGe("Cannot add item kind of unsupported type " << static_cast<uint32_t>(kind->type));
+			return false;
+		}
+
+		kind->_class = clazzIt->second;
+
+		addKind(kind, filePath);
+	}
+
+	_kinds.shrink_to_fit();
+
+	return true;
+}
+
+
 bool Items::loadKindsFromOtb() {
 	std::string filePath = getFilePath(FileType::OTHER, "items/items.otb");
 
 	FileLoader loader;
-	if (!loader.openFile(filePath.c_str(), false, true)) {
+	if (!loader.mapFile(filePath.c_str())) {
 		return loader.getError();
 	}
 
@@ -1994,11 +2171,22 @@ bool Items::reload() {
 
 	setupClasses();
 
-	if (!loadKindsFromOtb()) {
-		return false;
-	}
-	if (!loadKindsFromXml()) {
-		return false;
+	// the cache holds the item kinds as loaded from items.otb and items.xml, which are only read again once they change
+	std::string sourceHash = hashFiles(getSourceFilePaths());
+	if (sourceHash.empty() || !loadKindsFromCache(sourceHash)) {
+		clear();
+		setupClasses();
+
+		if (!loadKindsFromOtb()) {
+			return false;
+		}
+		if (!loadKindsFromXml()) {
+			return false;
+		}
+
+		if (!sourceHash.empty()) {
+			saveKindsToCache(sourceHash);
+		}
 	}
 	if (!loadRandomizationFromXml()) {
 		return false;
@@ -2008,6 +2196,67 @@ bool Items::reload() {
 }
 
 
+void Items::saveKindsToCache(const std::string& sourceHash) const {
+	std::string filePath = getFilePath(FileType::OTHER, "items/items.cache");
+	std::string temporaryFilePath = filePath + ".tmp";
+
+	{
+		FileLoader writer;
+		if (!writer.openFile(temporaryFilePath.c_str(), true)) {
+			LOGw("Cannot write item kind cache " << temporaryFilePath << ".");
+			return;
+		}
+
+		PropWriteStream header;
+		header.ADD_ULONG(itemKindCacheVersion);
+		header.ADD_ULONG(sizeof(ItemKind));
+		header.ADD_ULONG(sizeof(Abilities));
+		header.ADD_STRING(sourceHash);
+		header.ADD_ULONG(_versionBuild);
+		header.ADD_ULONG(_versionMajor);
+		header.ADD_ULONG(_versionMinor);
+		header.ADD_ULONG(_worth.size());
+		for (auto& entry : _worth) {
+			header.ADD_VALUE(entry.first);
+			header.ADD_USHORT(entry.second);
+		}
+
+		uint32_t size;
+		const char* data = header.getStream(size);
+
+		writer.startNode(ITEM_KIND_CACHE_ROOT);
+		writer.setProps(const_cast<char*>(data), size);
+
+		for (const ItemKindP& kind : _kinds) {
+			if (!kind) {
+				continue;
+			}
+
+			PropWriteStream stream;
+			writeItemKind(stream, *kind);
+
+			data = stream.getStream(size);
+
+			writer.startNode(ITEM_KIND_CACHE_KIND);
+			writer.setProps(const_cast<char*>(data), size);
+			writer.endNode();
+		}
+
+		writer.endNode();
+
+		if (writer.getError() != ERROR_NONE) {
+			LOGw("Cannot write item kind cache " << temporaryFilePath << ".");
+			return;
+		}
+	}
+
+	// replaced at once so that an interrupted write never leaves a broken cache behind
+	if (rename(temporaryFilePath.c_str(), filePath.c_str()) != 0) {
+		LOGw("Cannot replace item kind cache " << filePath << ".");
+	}
+}
+
+
 void Items::setupClasses() {
 	_classes[ItemType::BED] = makeClass<BedItem>();
 	_classes[ItemType::CONTAINER] = makeClass<Container>();
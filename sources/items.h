@@ -349,6 +349,8 @@ public:
 
 	ItemKindPC operator[](uint16_t kindId) const;
 
+	static StringVector getSourceFilePaths ();
+
 
 private:
 
@@ -358,9 +360,11 @@ private:
 	void addKind                  (ItemKindP kind, const std::string& fileName);
 	void addRandomization         (uint16_t kindId, int32_t fromId, int32_t toId, int32_t chance, const std::string& fileName);
 	void clear                    ();
+	bool loadKindsFromCache       (const std::string& sourceHash);
 	bool loadKindsFromOtb         ();
 	bool loadKindsFromXml         ();
 	bool loadRandomizationFromXml ();
+	void saveKindsToCache         (const std::string& sourceHash) const;
 	void setupClasses             ();
 
 
@@ -9715,21 +9715,21 @@ int32_t LuaScriptInterface::luaGetItemAttribute(lua_State* L)
 		lua_pushnil(L);
 	}
 	else {
-		switch (entry->first->getType()) {
+		switch (entry->getAttribute().getType()) {
 		case attributes::Type::BOOLEAN:
-			lua_pushboolean(L, boost::any_cast<bool>(entry->second));
+			lua_pushboolean(L, entry->getBoolean());
 			break;
 
 		case attributes::Type::FLOAT:
-			lua_pushnumber(L, boost::any_cast<float>(entry->second));
+			lua_pushnumber(L, entry->getFloat());
 			break;
 
 		case attributes::Type::INTEGER:
-			lua_pushnumber(L, boost::any_cast<int32_t>(entry->second));
+			lua_pushnumber(L, entry->getInteger());
 			break;
 
 		case attributes::Type::STRING:
-			lua_pushstring(L, boost::any_cast<const std::string&>(entry->second).c_str());
+			lua_pushstring(L, entry->getString().c_str());
 			break;
 
 		default:
@@ -9834,7 +9834,7 @@ int32_t LuaScriptInterface::luaDoItemSetAttribute(lua_State* L) {
 		if (type == Type::INTEGER) {
 			typeMatches = true;
 
-			if (name == Item::ATTRIBUTE_UID) {
+			if (name == Item::ATTRIBUTE_UID.getName()) {
 				if (integerValue < 1000 || integerValue > 0xFFFF) {
 					errorEx("Value for protected key \"uid\" must be in range of 1000 to 65535");
 					lua_pushboolean(L, false);
@@ -9843,7 +9843,7 @@ int32_t LuaScriptInterface::luaDoItemSetAttribute(lua_State* L) {
 
 				item->setUniqueId(integerValue);
 			}
-			else if (name == Item::ATTRIBUTE_AID) {
+			else if (name == Item::ATTRIBUTE_AID.getName()) {
 				item->setActionId(integerValue);
 			}
 			else {
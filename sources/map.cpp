@@ -19,186 +19,123 @@
 #include "map.h"
 
 #include "combat.h"
+#include "configmanager.h"
+#include "container.h"
 #include "creature.h"
 #include "game.h"
 #include "iomap.h"
 #include "iomapserialize.h"
 #include "item.h"
+#include "monster.h"
 #include "position.h"
 #include "server.h"
 #include "tile.h"
 
 
-LOGGER_DEFINITION(AStarNodes);
-
-
-AStarNodes::AStarNodes()
-{
-	curNode = 0;
-	openNodes.reset();
-}
-
-AStarNode* AStarNodes::createOpenNode()
-{
-	if(curNode >= MAX_NODES)
-		return nullptr;
-
-	uint32_t retNode = curNode;
-	curNode++;
-
-	openNodes[retNode] = 1;
-	return &nodes[retNode];
-}
-
-AStarNode* AStarNodes::getBestNode()
+int32_t AStarNodes::getTileWalkCost(const Creature* creature, const Tile* tile)
 {
-	if(!curNode)
-		return nullptr;
-
-	int32_t bestNodeF = 100000;
-	uint32_t bestNode = 0;
+	int32_t cost = 0;
+	if(tile->getTopVisibleCreature(creature)) //destroy creature cost
+		cost += MAP_NORMALWALKCOST * 3;
 
-	bool found = false;
-	for(uint32_t i = 0; i < curNode; i++)
+	if(const MagicField* field = tile->getFieldItem())
 	{
-		if(nodes[i].f < bestNodeF && openNodes[i] == 1)
-		{
-			found = true;
-			bestNodeF = nodes[i].f;
-			bestNode = i;
-		}
+		if(!creature->isImmune(field->getCombatType()))
+			cost += MAP_NORMALWALKCOST * 3;
 	}
 
-	if(found)
-		return &nodes[bestNode];
-
-	return nullptr;
+	return cost;
 }
 
-void AStarNodes::closeNode(AStarNode* node)
-{
-	uint32_t pos = GET_NODE_INDEX(node);
-	if(pos < MAX_NODES)
-	{
-		openNodes[pos] = 0;
-		return;
-	}
 
-	assert(pos >= MAX_NODES);
-	LOGe("AStarNodes. trying to close node out of range");
-	return;
-}
 
-void AStarNodes::openNode(AStarNode* node)
-{
-	uint32_t pos = GET_NODE_INDEX(node);
-	if(pos < MAX_NODES)
-	{
-		openNodes[pos] = 1;
-		return;
-	}
+namespace {
 
-	assert(pos >= MAX_NODES);
-	LOGe("AStarNodes. trying to open node out of range");
-	return;
-}
+	struct FlowFieldStep {
+		int32_t   x;
+		int32_t   y;
+		Direction direction;
+	};
 
-uint32_t AStarNodes::countClosedNodes()
-{
-	uint32_t counter = 0;
-	for(uint32_t i = 0; i < curNode; i++)
-	{
-		if(!openNodes[i])
-			counter++;
-	}
+	const FlowFieldStep flowFieldSteps[] = {
+		{ -1,  0, Direction::WEST },
+		{  0,  1, Direction::SOUTH },
+		{  1,  0, Direction::EAST },
+		{  0, -1, Direction::NORTH },
+
+		// diagonal
+		{ -1, -1, Direction::NORTH_WEST },
+		{  1, -1, Direction::NORTH_EAST },
+		{  1,  1, Direction::SOUTH_EAST },
+		{ -1,  1, Direction::SOUTH_WEST },
+	};
 
-	return counter;
-}
+	// the tile flags mirrored by the bitmaps of a layer, in the order of MapLayer::TileState
+	const tileflags_t tileStateFlags[] = {
+		TILESTATE_BLOCKPROJECTILE,
+		TILESTATE_BLOCKSOLID,
+		TILESTATE_BLOCKPATH,
+		TILESTATE_PROTECTIONZONE,
+	};
 
-uint32_t AStarNodes::countOpenNodes()
-{
-	uint32_t counter = 0;
-	for(uint32_t i = 0; i < curNode; i++)
-	{
-		if(openNodes[i] == 1)
-			counter++;
-	}
 
-	return counter;
-}
+	void addItemAttributesSize(const Item& item, size_t& itemCount, size_t& attributedItemCount, size_t& size) {
+		++itemCount;
 
-bool AStarNodes::isInList(uint16_t x, uint16_t y)
-{
-	for(uint32_t i = 0; i < curNode; i++)
-	{
-		if(nodes[i].x == x && nodes[i].y == y)
-			return true;
+		size_t itemSize = item.getAttributes().getHeapSize();
+		if (itemSize != 0) {
+			++attributedItemCount;
+			size += itemSize;
+		}
+
+		if (const Container* container = item.getContainer()) {
+			for (auto it = container->getItems(); it != container->getEnd(); ++it) {
+				addItemAttributesSize(**it, itemCount, attributedItemCount, size);
+			}
+		}
 	}
 
-	return false;
 }
 
-AStarNode* AStarNodes::getNodeInList(uint16_t x, uint16_t y)
-{
-	for(uint32_t i = 0; i < curNode; i++)
-	{
-		if(nodes[i].x == x && nodes[i].y == y)
-			return &nodes[i];
-	}
 
-	return nullptr;
-}
 
-int32_t AStarNodes::getMapWalkCost(const Creature* creature, AStarNode* node,
-	const Tile* neighbourTile, const Position& neighbourPos)
-{
-	if(std::abs(node->x - neighbourPos.x) == std::abs(node->y - neighbourPos.y)) //diagonal movement extra cost
-		return MAP_DIAGONALWALKCOST;
+const uint16_t FlowField::radius;
+const uint16_t FlowField::size;
+const uint16_t FlowField::blockedCost;
+const uint16_t FlowField::unreachedCost;
+const uint32_t FlowField::maxAge;
 
-	return MAP_NORMALWALKCOST;
-}
 
-int32_t AStarNodes::getTileWalkCost(const Creature* creature, const Tile* tile)
-{
-	int32_t cost = 0;
-	if(tile->getTopVisibleCreature(creature)) //destroy creature cost
-		cost += MAP_NORMALWALKCOST * 3;
+FlowField::FlowField()
+	: stale(true)
+{}
 
-	if(const MagicField* field = tile->getFieldItem())
-	{
-		if(!creature->isImmune(field->getCombatType()))
-			cost += MAP_NORMALWALKCOST * 3;
-	}
 
-	return cost;
-}
+int32_t FlowField::indexForPosition(int32_t x, int32_t y) const {
+	int32_t offsetX = x - origin.x + FlowField::radius;
+	int32_t offsetY = y - origin.y + FlowField::radius;
+	if (offsetX < 0 || offsetY < 0 || offsetX >= FlowField::size || offsetY >= FlowField::size) {
+		return -1;
+	}
 
-int32_t AStarNodes::getEstimatedDistance(uint16_t x, uint16_t y, uint16_t xGoal, uint16_t yGoal)
-{
-	int32_t diagonal = std::min(std::abs(x - xGoal), std::abs(y - yGoal));
-	return (MAP_DIAGONALWALKCOST * diagonal) + (MAP_NORMALWALKCOST * ((std::abs(
-		x - xGoal) + std::abs(y - yGoal)) - (2 * diagonal)));
+	return (offsetY * FlowField::size + offsetX);
 }
 
 
 
 LOGGER_DEFINITION(Map);
 
+const Duration Map::spectatorCacheReportInterval = Minutes(1);
+
 
 Map::Map()
-	: _creatureBlockCountX(0),
-	  _creatureBlockCountY(0),
-	  _creatureBlockCountZ(0),
-	  _height(0),
+	: _height(0),
 	  _width(0),
-	  _creatures(nullptr),
 	  _layers { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15 }
 {}
 
 
-Map::~Map() {
-	delete[] _creatures;
-}
+Map::~Map() {}
 
 
 void Map::addDescription(const std::string& description) {
@@ -229,13 +166,32 @@ bool Map::canThrowObjectTo(const Position& origin, const Position& destination,
 }
 
 
-bool Map::canWalkTo(const Creature* creature, const Position& destination) const {
-	Tile* tile = getTile(destination);
-	if (creature->getTile() != tile && (tile == nullptr || tile->testAddCreature(*creature, FLAG_PATHFINDING|FLAG_IGNOREFIELDDAMAGE) != RET_NOERROR)) {
+bool Map::canWalkTo(const Creature* creature, const Position& destination, bool ignoreCreatures /*= false*/) const {
+	const Tile* tile = getTileForReading(destination);
+	if (creature->getTile() == tile) {
+		return true;
+	}
+
+	// solid items block every creature while searching a path, so most blocked tiles don't have to be asked
+	if (tile == nullptr || hasTileState(destination.x, destination.y, destination.z, MapLayer::TileState::BLOCK_SOLID)) {
 		return false;
 	}
 
-	return true;
+	// hostile monsters don't enter protection zones unless they are already in one
+	auto monster = creature->getMonster();
+	if (monster != nullptr && monster->isHostile() && hasTileState(destination.x, destination.y, destination.z, MapLayer::TileState::PROTECTION_ZONE)) {
+		auto currentTile = creature->getTile();
+		if (currentTile == nullptr || !currentTile->hasFlag(TILESTATE_PROTECTIONZONE)) {
+			return false;
+		}
+	}
+
+	uint32_t flags = FLAG_PATHFINDING|FLAG_IGNOREFIELDDAMAGE;
+	if (ignoreCreatures) {
+		flags |= FLAG_IGNOREBLOCKCREATURE;
+	}
+
+	return (tile->testAddCreature(*creature, flags) == RET_NOERROR);
 }
 
 
@@ -326,7 +282,7 @@ bool Map::checkSightLine(const Position& origin, const Position& destination) co
 		}
 
 		if (lastrz != rz || ((destination.x != rx || destination.y != ry || destination.z != rz) && (origin.x != rx || origin.y != ry || origin.z != rz))) {
-			if (lastrz != rz && this->getTile(lastrx, lastry, std::min(lastrz, rz)) != nullptr) {
+			if (lastrz != rz && getTileForReading(lastrx, lastry, std::min(lastrz, rz)) != nullptr) {
 				return false;
 			}
 
@@ -334,8 +290,7 @@ bool Map::checkSightLine(const Position& origin, const Position& destination) co
 			lastry = ry;
 			lastrz = rz;
 
-			const Tile* tile = this->getTile(rx, ry, rz);
-			if (tile != nullptr && tile->hasProperty(BLOCKPROJECTILE)) {
+			if (hasTileState(rx, ry, rz, MapLayer::TileState::BLOCK_PROJECTILE)) {
 				return false;
 			}
 		}
@@ -358,20 +313,32 @@ bool Map::checkSightLine(const Position& origin, const Position& destination) co
 }
 
 
-void Map::clearSpectatorCache() {
-	_spectatorCache.clear();
-}
+FlowField& Map::getFlowField(const Creature& target) {
+	Position origin = target.getPosition();
+	Time now = Clock::now();
 
+	if (now - _flowFieldsSweepTime > Milliseconds(FlowField::maxAge)) {
+		_flowFieldsSweepTime = now;
 
-uint32_t Map::creaturesIndexForPosition(const Position& position) const {
-	uint32_t yBlocks = _creatureBlockCountY;
-	uint32_t zBlocks = _creatureBlockCountZ;
+		for (auto it = _flowFields.begin(); it != _flowFields.end();) {
+			if (now - it->second.useTime > Milliseconds(FlowField::maxAge)) {
+				it = _flowFields.erase(it);
+			}
+			else {
+				++it;
+			}
+		}
+	}
 
-	uint32_t xIndex = zBlocks * yBlocks * (position.x / Map::creaturesBlockSize);
-	uint32_t yIndex = zBlocks * (position.y / Map::creaturesBlockSize);
-	uint32_t zIndex = position.z;
+	// the field is only updated when it is needed again after the target moved or tiles changed
+	FlowField& field = _flowFields[target.getId()];
+	if (field.stale || field.origin != origin || now - field.updateTime > Milliseconds(FlowField::maxAge)) {
+		updateFlowField(field, origin);
+		field.updateTime = now;
+	}
 
-	return (xIndex + yIndex + zIndex);
+	field.useTime = now;
+	return field;
 }
 
 
@@ -380,21 +347,85 @@ uint16_t Map::getHeight() const {
 }
 
 
+bool Map::getPathFromFlowField(const Creature* creature, const Creature& target, Route& route, const FindPathParams& findParameters) {
+	route.clear();
+
+	Position startPos = creature->getPosition();
+	Position targetPos = target.getPosition();
+	if (startPos.z != targetPos.z) {
+		return false;
+	}
+
+	const FlowField& field = getFlowField(target);
+
+	int32_t index = field.indexForPosition(startPos.x, startPos.y);
+	if (index < 0 || field.costs[index] >= FlowField::unreachedCost) {
+		return false;
+	}
+
+	FrozenPathingConditionCall pathCondition(targetPos);
+	int32_t bestMatch = 0;
+
+	Position pos = startPos;
+	while (!pathCondition(startPos, pos, findParameters, bestMatch)) {
+		const FlowFieldStep* nextStep = nullptr;
+		int32_t nextIndex = -1;
+		uint16_t nextCost = field.costs[index];
+
+		for (const auto& step : flowFieldSteps) {
+			int32_t x = pos.x + step.x;
+			int32_t y = pos.y + step.y;
+
+			if (findParameters.maxSearchDist != -1 && (std::abs(startPos.x - x) > findParameters.maxSearchDist || std::abs(startPos.y - y) > findParameters.maxSearchDist)) {
+				continue;
+			}
+
+			int32_t stepIndex = field.indexForPosition(x, y);
+			if (stepIndex < 0 || field.costs[stepIndex] >= nextCost) {
+				continue;
+			}
+
+			// other creatures will have moved on by the time a later step is taken, so they only block the first one
+			if (!canWalkTo(creature, Position(x, y, pos.z), !route.empty())) {
+				continue;
+			}
+
+			nextStep = &step;
+			nextIndex = stepIndex;
+			nextCost = field.costs[stepIndex];
+		}
+
+		if (nextStep == nullptr) {
+			// the shortest way is blocked for this creature
+			route.clear();
+			return false;
+		}
+
+		route.push_back(nextStep->direction);
+
+		pos.x += nextStep->x;
+		pos.y += nextStep->y;
+		index = nextIndex;
+	}
+
+	return true;
+}
+
+
 bool Map::getPathMatching(const Creature* creature, Route& route, const FrozenPathingConditionCall& pathCondition, const FindPathParams& findParameters) const {
 	route.clear();
 
 	Position startPos = creature->getPosition();
 	Position endPos;
 
-	AStarNodes nodes;
-	AStarNode* startNode = nodes.createOpenNode();
-
-	startNode->x = startPos.x;
-	startNode->y = startPos.y;
+	AStarNodes nodes(server.configManager().getNumber(ConfigManager::PATHFINDING_MAX_NODES));
+	AStarNode* startNode = nodes.createNode(startPos.x, startPos.y);
 
 	startNode->f = 0;
 	startNode->parent = nullptr;
 
+	nodes.openNode(startNode);
+
 	int32_t bestMatch = 0;
 
 	Position pos;
@@ -462,7 +493,7 @@ bool Map::getPathMatching(const Creature* creature, Route& route, const FrozenPa
 			}
 
 			if (canWalkTo(creature, pos)) {
-				const Tile* tile = getTile(pos);
+				const Tile* tile = getTileForReading(pos);
 
 				//The cost (g) for this neighbour
 				int32_t cost = nodes.getMapWalkCost(creature, n, tile, pos);
@@ -476,12 +507,10 @@ bool Map::getPathMatching(const Creature* creature, Route& route, const FrozenPa
 					if (neighbourNode->f <= newf) { //The node on the closed/open list is cheaper than this one
 						continue;
 					}
-
-					nodes.openNode(neighbourNode);
 				}
 				else {
 					// Does not exist in the open/closed list, create a new node
-					neighbourNode = nodes.createOpenNode();
+					neighbourNode = nodes.createNode(pos.x, pos.y);
 					if (neighbourNode == nullptr) {
 						if (found) {
 							// not quite what we want, but we found something
@@ -495,11 +524,10 @@ bool Map::getPathMatching(const Creature* creature, Route& route, const FrozenPa
 				}
 
 				//This node is the best node so far with this state
-				neighbourNode->x = pos.x;
-				neighbourNode->y = pos.y;
-
 				neighbourNode->parent = n;
 				neighbourNode->f = newf;
+
+				nodes.openNode(neighbourNode);
 			}
 		}
 
@@ -570,11 +598,8 @@ bool Map::getPathTo(const Creature* creature, const Position& destination, Route
 		return false;
 	}
 
-	AStarNodes nodes;
-	AStarNode* startNode = nodes.createOpenNode();
-
-	startNode->x = startPos.x;
-	startNode->y = startPos.y;
+	AStarNodes nodes(server.configManager().getNumber(ConfigManager::PATHFINDING_MAX_NODES));
+	AStarNode* startNode = nodes.createNode(startPos.x, startPos.y);
 
 	startNode->g = 0;
 	startNode->h = nodes.getEstimatedDistance(startPos.x, startPos.y, endPos.x, endPos.y);
@@ -582,6 +607,8 @@ bool Map::getPathTo(const Creature* creature, const Position& destination, Route
 	startNode->f = startNode->g + startNode->h;
 	startNode->parent = nullptr;
 
+	nodes.openNode(startNode);
+
 	Position pos;
 	pos.z = startPos.z;
 
@@ -633,7 +660,7 @@ bool Map::getPathTo(const Creature* creature, const Position& destination, Route
 			}
 
 			if (canWalkTo(creature, pos)) {
-				const Tile* tile = getTile(pos);
+				const Tile* tile = getTileForReading(pos);
 
 				//The cost (g) for this neighbour
 				int32_t cost = nodes.getMapWalkCost(creature, n, tile, pos);
@@ -647,12 +674,10 @@ bool Map::getPathTo(const Creature* creature, const Position& destination, Route
 					if (neighbourNode->g <= newg) { //The node on the closed/open list is cheaper than this one
 						continue;
 					}
-
-					nodes.openNode(neighbourNode);
 				}
 				else {
 					// Does not exist in the open/closed list, create a new node
-					neighbourNode = nodes.createOpenNode();
+					neighbourNode = nodes.createNode(pos.x, pos.y);
 					if (neighbourNode == nullptr) {
 						// seems we ran out of nodes
 						route.clear();
@@ -661,14 +686,13 @@ bool Map::getPathTo(const Creature* creature, const Position& destination, Route
 				}
 
 				//This node is the best node so far with this state
-				neighbourNode->x = pos.x;
-				neighbourNode->y = pos.y;
-
 				neighbourNode->g = newg;
 				neighbourNode->h = nodes.getEstimatedDistance(neighbourNode->x, neighbourNode->y, endPos.x, endPos.y);
 
 				neighbourNode->f = neighbourNode->g + neighbourNode->h;
 				neighbourNode->parent = n;
+
+				nodes.openNode(neighbourNode);
 			}
 		}
 
@@ -720,6 +744,23 @@ bool Map::getPathTo(const Creature* creature, const Position& destination, Route
 }
 
 
+bool Map::getPathToCreature(const Creature* creature, const Creature& target, Route& route, const FindPathParams& findParameters) {
+	// the field only knows the way right next to the target, so it cannot help creatures keeping their distance, and it
+	// treats protection zones as blocked, which only holds for hostile monsters
+	auto monster = creature->getMonster();
+	bool canUseFlowField = (monster != nullptr && monster->isHostile() && findParameters.minTargetDist <= 1 && findParameters.maxTargetDist == 1
+		&& findParameters.allowDiagonal && !findParameters.keepDistance);
+
+	if (canUseFlowField && server.configManager().getBool(ConfigManager::FLOW_FIELD_PATHING)) {
+		if (getPathFromFlowField(creature, target, route, findParameters)) {
+			return true;
+		}
+	}
+
+	return getPathMatching(creature, route, FrozenPathingConditionCall(target.getPosition()), findParameters);
+}
+
+
 const std::string& Map::getHousesFileName() const {
 	return _housesFileName;
 }
@@ -730,137 +771,73 @@ const std::string& Map::getSpawnsFileName() const {
 }
 
 
-void Map::getSpectators(SpectatorList& spectators, const Position& center, bool checkForDuplicates, int32_t minOffsetX, int32_t maxOffsetX, int32_t minOffsetY, int32_t maxOffsetY, uint16_t minZ, uint16_t maxZ) const {
-	if (_creatures == nullptr) {
-		return;
-	}
-
-	uint32_t yBlocks = _creatureBlockCountY;
-	uint32_t zBlocks = _creatureBlockCountZ;
-
-	auto indexStepX = zBlocks * yBlocks;
-	auto indexStepY = zBlocks;
-
-	auto basicMinX = static_cast<int32_t>(center.x) + minOffsetX;
-	auto basicMaxX = static_cast<int32_t>(center.x) + maxOffsetX;
-	auto basicMinY = static_cast<int32_t>(center.y) + minOffsetY;
-	auto basicMaxY = static_cast<int32_t>(center.y) + maxOffsetY;
-
-	for (auto z = minZ; z <= maxZ; ++z) {
-		auto deltaZ = center.z - z;
-
-		auto minX = static_cast<uint16_t>(std::max(0, std::min(basicMinX + deltaZ, static_cast<int32_t>(Map::maxX))));
-		auto maxX = static_cast<uint16_t>(std::max(0, std::min(basicMaxX + deltaZ, static_cast<int32_t>(Map::maxX))));
-		auto minY = static_cast<uint16_t>(std::max(0, std::min(basicMinY + deltaZ, static_cast<int32_t>(Map::maxY))));
-		auto maxY = static_cast<uint16_t>(std::max(0, std::min(basicMaxY + deltaZ, static_cast<int32_t>(Map::maxY))));
+void Map::getSpectators(SpectatorList& spectators, const Position& center, bool checkForDuplicates /*= false*/, bool multiFloor /*= false*/, int32_t westRange /*= 0*/, int32_t eastRange /*= 0*/, int32_t northRange /*= 0*/, int32_t southRange /*= 0*/) {
+	_spectators.getSpectators(spectators, center, checkForDuplicates, multiFloor, westRange, eastRange, northRange, southRange);
+}
 
-		if (maxX < minX || maxY < minY) {
-			continue;
-		}
 
-		auto minIndexX = indexStepX * (minX / Map::creaturesBlockSize);
-		auto maxIndexX = indexStepX * (maxX / Map::creaturesBlockSize);
-		auto minIndexY = indexStepY * (minY / Map::creaturesBlockSize);
-		auto maxIndexY = indexStepY * (maxY / Map::creaturesBlockSize);
+const SpectatorList& Map::getSpectators(const Position& center) {
+	return _spectators.getSpectators(center);
+}
 
-		for (auto indexX = minIndexX; indexX <= maxIndexX; indexX += indexStepX) {
-			for (auto indexY = minIndexY; indexY <= maxIndexY; indexY += indexStepY) {
-				auto index = indexX + indexY + z;
 
-				const auto& creatures = _creatures[index];
-				for (const auto& creature : creatures) {
-					const auto& position = creature->getPosition();
-					if (position.x < minX || position.x > maxX || position.y < minY || position.y > maxY) {
-						continue;
-					}
+const TileTemplate& Map::getTileTemplate(uint32_t flags, const std::vector<uint16_t>& itemIds) {
+	auto& tileTemplate = _tileTemplates[std::make_pair(flags, itemIds)];
+	if (tileTemplate == nullptr) {
+		tileTemplate.reset(new TileTemplate);
+		tileTemplate->flags = flags;
+		tileTemplate->itemIds = itemIds;
+		tileTemplate->tileStates = 0;
 
-					if (!checkForDuplicates || std::find(spectators.begin(), spectators.end(), creature) == spectators.end()) {
-						spectators.push_back(creature);
-					}
-				}
+		// the flags which items add to a tile are easiest to learn from the shared tile
+		tileTemplate->tile.reset(tileTemplate->createTile(0, 0, 0));
+		for (uint32_t state = 0; state < MapLayer::numTileStates; ++state) {
+			if (tileTemplate->tile->hasFlag(tileStateFlags[state])) {
+				tileTemplate->tileStates |= (1 << state);
 			}
 		}
 	}
-}
-
-
-void Map::getSpectators(SpectatorList& spectators, const Position& center, bool checkForDuplicates /*= false*/, bool multiFloor /*= false*/, int32_t westRange /*= 0*/, int32_t eastRange /*= 0*/, int32_t northRange /*= 0*/, int32_t southRange /*= 0*/) {
-	if (center.z > Map::maxZ) {
-		return;
-	}
 
-	int32_t minOffsetX = (westRange == 0 ? -Map::maxViewportX : -westRange);
-	int32_t maxOffsetX = (eastRange == 0 ? Map::maxViewportX : eastRange);
-	int32_t minOffsetY = (northRange == 0 ? -Map::maxViewportY : -northRange);
-	int32_t maxOffsetY = (southRange == 0 ? Map::maxViewportY : southRange);
-
-	bool cacheResult = false;
-	if (minOffsetX == -Map::maxViewportX && maxOffsetX == Map::maxViewportX && minOffsetY == -Map::maxViewportY && maxOffsetY == Map::maxViewportY && multiFloor && !checkForDuplicates) {
-		auto entry = _spectatorCache.find(center);
-		if (entry != _spectatorCache.end() && &entry->second != &spectators) {
-			// TODO allow caching with checkForDuplicates = true
-			spectators = entry->second;
-			return;
-		}
+	return *tileTemplate;
+}
 
-		cacheResult = true;
-	}
 
-	uint16_t minZ, maxZ;
-	if (multiFloor) {
-		if (isUnderground(center.z)) {
-			minZ = static_cast<uint16_t>(std::max(static_cast<int32_t>(center.z) - 2, 0));
-			maxZ = static_cast<uint16_t>(std::min(static_cast<uint32_t>(center.z) + 2, static_cast<uint32_t>(Map::maxZ)));
-		}
-		else {
-			minZ = 0;
-			maxZ = 7;
-		}
-	}
-	else {
-		minZ = center.z;
-		maxZ = center.z;
+bool Map::hasTileState(int32_t x, int32_t y, int32_t z, MapLayer::TileState state) const {
+	if (x < 0 || x > Map::maxX || y < 0 || y > Map::maxY || z < 0 || z > Map::maxZ) {
+		return false;
 	}
 
-	getSpectators(spectators, center, true, minOffsetX, maxOffsetX, minOffsetY, maxOffsetY, minZ, maxZ);
-
-	if (cacheResult) {
-		SpectatorList& cachedSpectators = _spectatorCache[center];
-		if (&cachedSpectators != &spectators) {
-			cachedSpectators = spectators;
-		}
-	}
+	return _layers[z].hasTileState(static_cast<uint16_t>(x), static_cast<uint16_t>(y), state);
 }
 
 
-const SpectatorList& Map::getSpectators(const Position& center) {
-	if (center.z > Map::maxZ) {
-		static SpectatorList empty;
-		return empty;
+Tile* Map::getTile(int32_t x, int32_t y, int32_t z) const {
+	if (x < 0 || x > Map::maxX || y < 0 || y > Map::maxY || z < 0 || z > Map::maxZ) {
+		return nullptr;
 	}
 
-	bool cached = (_spectatorCache.find(center) != _spectatorCache.end());
+	return _layers[z].getTile(static_cast<uint16_t>(x), static_cast<uint16_t>(y));
+}
 
-	SpectatorList& spectators = _spectatorCache[center];
-	if (!cached) {
-		getSpectators(spectators, center, false, true, 0, 0, 0, 0);
-	}
 
-	return spectators;
+Tile* Map::getTile(const Position& position) const {
+	return getTile(position.x, position.y, position.z);
 }
 
 
-Tile* Map::getTile(int32_t x, int32_t y, int32_t z) const {
+// Unlike getTile() this doesn't create tiles from their template but returns the shared tile of the template, so the
+// returned tile must not be changed and its position is not the one asked for.
+const Tile* Map::getTileForReading(int32_t x, int32_t y, int32_t z) const {
 	if (x < 0 || x > Map::maxX || y < 0 || y > Map::maxY || z < 0 || z > Map::maxZ) {
 		return nullptr;
 	}
 
-	return _layers[z].getTile(static_cast<uint16_t>(x), static_cast<uint16_t>(y));
+	return _layers[z].getTileForReading(static_cast<uint16_t>(x), static_cast<uint16_t>(y));
 }
 
 
-Tile* Map::getTile(const Position& position) const {
-	return getTile(position.x, position.y, position.z);
+const Tile* Map::getTileForReading(const Position& position) const {
+	return getTileForReading(position.x, position.y, position.z);
 }
 
 
@@ -879,6 +856,39 @@ uint16_t Map::getWidth() const {
 }
 
 
+bool Map::isFlowFieldWalkable(int32_t x, int32_t y, int32_t z) const {
+	// most blocked tiles are told by the bitmaps, without touching them or creating them from their template
+	if (hasTileState(x, y, z, MapLayer::TileState::BLOCK_SOLID) || hasTileState(x, y, z, MapLayer::TileState::BLOCK_PATH)
+		|| hasTileState(x, y, z, MapLayer::TileState::PROTECTION_ZONE)) {
+		return false;
+	}
+
+	const Tile* tile = getTileForReading(x, y, z);
+	if (tile == nullptr || tile->ground == nullptr) {
+		return false;
+	}
+
+	// flags which stop hostile monsters in general, either always or when searching a path
+	static const tileflags_t blockingFlags[] = {
+		TILESTATE_BLOCKSOLID,
+		TILESTATE_FLOORCHANGE,
+		TILESTATE_IMMOVABLENOFIELDBLOCKPATH,
+		TILESTATE_MAGICFIELD,
+		TILESTATE_NOFIELDBLOCKPATH,
+		TILESTATE_PROTECTIONZONE,
+		TILESTATE_TELEPORTER,
+	};
+
+	for (auto flag : blockingFlags) {
+		if (tile->hasFlag(flag)) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+
 bool Map::isSightClear(const Position& origin, const Position& destination, bool requireSameFloor) const {
 	if (requireSameFloor && origin.z != destination.z) {
 		return false;
@@ -895,20 +905,46 @@ bool Map::isUnderground(uint32_t z) {
 
 
 bool Map::load(const std::string& identifier) {
-	delete[] _creatures;
-	_creatures = nullptr;
+	_spectators.clear();
 
 	IOMap loader;
 
+	int64_t startTime = OTSYS_TIME();
 	if (!loader.loadMap(this, identifier)) {
 		LOGe("OTBM Loader - " << loader.getLastErrorString());
 		return false;
 	}
 
+	LOGi("Loaded map " << identifier << " in " << (static_cast<double>(OTSYS_TIME() - startTime) / 1000.0) << " seconds.");
+
+	size_t chunkCount = 0, denseStorageSize = 0, storageSize = 0;
 	for (uint32_t z = 0; z < Map::numZ; ++z) {
 		_layers[z].complete();
+
+		size_t layerChunkCount = 0;
+		storageSize += _layers[z].getStorageSize(layerChunkCount);
+		denseStorageSize += _layers[z].getDenseStorageSize();
+		chunkCount += layerChunkCount;
 	}
 
+	LOGi("Map tiles are stored in " << chunkCount << " chunks using " << (storageSize / 1024) << " KB (" << (denseStorageSize / 1024) << " KB for a dense tile array).");
+
+	size_t tileCount = 0, templateTileCount = 0, templateTilesSize = 0;
+	for (uint32_t z = 0; z < Map::numZ; ++z) {
+		size_t layerTileCount = 0, layerTemplateTileCount = 0;
+		templateTilesSize += _layers[z].getTemplateTilesSize(layerTileCount, layerTemplateTileCount);
+		tileCount += layerTileCount;
+		templateTileCount += layerTemplateTileCount;
+	}
+
+	size_t templatesSize = 0;
+	for (const auto& entry : _tileTemplates) {
+		templatesSize += sizeof(TileTemplate) + entry.second->itemIds.capacity() * sizeof(uint16_t) + entry.second->getTileSize();
+	}
+
+	LOGi(templateTileCount << " out of " << (tileCount + templateTileCount) << " map tiles share " << _tileTemplates.size() << " templates using "
+		<< (templatesSize / 1024) << " KB instead of " << (templateTilesSize / 1024) << " KB for creating them at once.");
+
 	IOMapSerialize& serializer = *IOMapSerialize::getInstance();
 
 	LOGi("Loading spawns...");
@@ -927,32 +963,34 @@ bool Map::load(const std::string& identifier) {
 	serializer.loadHouses();
 	serializer.loadMap(this);
 
+	size_t itemCount = 0, attributedItemCount = 0, attributesSize = 0;
+	for (uint32_t z = 0; z < Map::numZ; ++z) {
+		size_t layerItemCount = 0, layerAttributedItemCount = 0;
+		attributesSize += _layers[z].getItemAttributesSize(layerItemCount, layerAttributedItemCount);
+		itemCount += layerItemCount;
+		attributedItemCount += layerAttributedItemCount;
+	}
+
+	LOGi("Attributes of " << attributedItemCount << " out of " << itemCount << " map items use " << (attributesSize / 1024) << " KB ("
+		<< (attributedItemCount != 0 ? attributesSize / attributedItemCount : 0) << " bytes per item with attributes).");
+
 	return true;
 }
 
 
 void Map::onCreatureMoved(Creature* creature, const Tile* fromTile, const Tile* toTile) {
-	int32_t fromIndex = (fromTile != nullptr ? creaturesIndexForPosition(fromTile->getPosition()) : -1);
-	int32_t toIndex = (toTile != nullptr ? creaturesIndexForPosition(toTile->getPosition()) : -1);
+	CreatureP creatureP(creature);
 
-	if (fromIndex == toIndex) {
-		return;
-	}
+	Position from = (fromTile != nullptr ? fromTile->getPosition() : Position());
+	Position to = (toTile != nullptr ? toTile->getPosition() : Position());
 
-	if (fromIndex >= 0 && _creatures != nullptr) {
-		CreatureList& creaturesBlock = _creatures[fromIndex];
-		CreatureList::iterator it = std::find(creaturesBlock.begin(), creaturesBlock.end(), creature);
-		assert(it != creaturesBlock.end());
-		creaturesBlock.erase(it);
-	}
+	const Position* fromPosition = (fromTile != nullptr ? &from : nullptr);
+	const Position* toPosition = (toTile != nullptr ? &to : nullptr);
 
-	if (toIndex >= 0) {
-		if (_creatures == nullptr) {
-			_creatures = new CreatureList[_creatureBlockCountX * _creatureBlockCountY * _creatureBlockCountZ];
-		}
+	_spectators.onCreatureMoved(creatureP, fromPosition, toPosition);
 
-		CreatureList& creaturesBlock = _creatures[toIndex];
-		creaturesBlock.push_back(creature);
+	if (toPosition == nullptr) {
+		_flowFields.erase(creature->getId());
 	}
 }
 
@@ -1002,15 +1040,7 @@ void Map::setSize(uint16_t width, uint16_t height) {
 	_height = height;
 	_width = width;
 
-	if (_creatures != nullptr) {
-		assert(_creatures == nullptr);
-		delete[] _creatures;
-		_creatures = nullptr;
-	}
-
-	_creatureBlockCountX = static_cast<uint16_t>(width / Map::creaturesBlockSize + 1u);
-	_creatureBlockCountY = static_cast<uint16_t>(height / Map::creaturesBlockSize + 1u);
-	_creatureBlockCountZ = Map::numZ;
+	_spectators.setSize(width, height);
 
 	for (uint32_t z = 0; z < Map::numZ; ++z) {
 		_layers[z].prepareWithSize(width, height);
@@ -1024,7 +1054,7 @@ bool Map::setTile(uint16_t x, uint16_t y, uint16_t z, Tile* tile) {
 		return false;
 	}
 
-	if (_layers[z].getTile(x, y) != nullptr) {
+	if (_layers[z].hasTile(x, y)) {
 		LOGe("Another tile already exists at map coordinate " << x << "/" << y << "/" << z);
 		return false;
 	}
@@ -1054,22 +1084,194 @@ bool Map::setTile(const Position& position, Tile* tile) {
 }
 
 
+bool Map::setTileTemplate(uint16_t x, uint16_t y, uint16_t z, const TileTemplate& tileTemplate) {
+	if (x >= _width || y >= _height || z > Map::maxZ) {
+		LOGe("Cannot set tile at invalid map coordinate " << x << "/" << y << "/" << z);
+		return false;
+	}
+
+	if (_layers[z].hasTile(x, y)) {
+		LOGe("Another tile already exists at map coordinate " << x << "/" << y << "/" << z);
+		return false;
+	}
+
+	return _layers[z].setTileTemplate(x, y, tileTemplate);
+}
+
+
+void Map::trimSpectatorCache() {
+	// the cache is only dropped when it grows too large, so a low hit rate means that moves invalidate too many lists
+	auto now = Clock::now();
+	if (now - _spectatorCacheReportTime >= spectatorCacheReportInterval) {
+		auto lookups = _spectators.getCacheHits() + _spectators.getCacheMisses();
+		if (lookups > 0) {
+			LOGd("Spectator cache holds " << _spectators.getCacheSize() << " lists and answered " << (_spectators.getCacheHits() * 100 / lookups) << "% of " << lookups << " lookups from the cache.");
+		}
+
+		_spectators.resetCacheStatistics();
+		_spectatorCacheReportTime = now;
+	}
+
+	if (_spectators.getCacheSize() <= Map::maxSpectatorCacheSize) {
+		return;
+	}
+
+	LOGt("Dropping " << _spectators.getCacheSize() << " cached spectator lists.");
+
+	_spectators.clearCache();
+}
+
+
+void Map::updateFlowField(FlowField& field, const Position& origin) const {
+	field.costs.assign(FlowField::size * FlowField::size, FlowField::unreachedCost);
+	field.origin = origin;
+	field.stale = false;
+
+	typedef std::pair<uint16_t,int32_t> OpenCell;
+
+	// plain Dijkstra from the target outwards, cells are checked for walkability when they are reached the first time
+	std::priority_queue<OpenCell,std::vector<OpenCell>,std::greater<OpenCell>> openCells;
+
+	int32_t originIndex = field.indexForPosition(origin.x, origin.y);
+	field.costs[originIndex] = 0;
+	openCells.emplace(0, originIndex);
+
+	while (!openCells.empty()) {
+		OpenCell cell = openCells.top();
+		openCells.pop();
+
+		if (cell.first != field.costs[cell.second]) {
+			// reached again at a lower cost in the meantime
+			continue;
+		}
+
+		int32_t x = origin.x - FlowField::radius + (cell.second % FlowField::size);
+		int32_t y = origin.y - FlowField::radius + (cell.second / FlowField::size);
+
+		for (const auto& step : flowFieldSteps) {
+			int32_t stepIndex = field.indexForPosition(x + step.x, y + step.y);
+			if (stepIndex < 0) {
+				continue;
+			}
+
+			uint16_t& stepCost = field.costs[stepIndex];
+			if (stepCost == FlowField::blockedCost) {
+				continue;
+			}
+
+			uint16_t cost = cell.first + ((step.x != 0 && step.y != 0) ? MAP_DIAGONALWALKCOST : MAP_NORMALWALKCOST);
+			if (cost >= stepCost) {
+				continue;
+			}
+
+			if (stepCost == FlowField::unreachedCost && !isFlowFieldWalkable(x + step.x, y + step.y, origin.z)) {
+				stepCost = FlowField::blockedCost;
+				continue;
+			}
+
+			stepCost = cost;
+			openCells.emplace(cost, stepIndex);
+		}
+	}
+}
+
+
+void Map::updateTileStates(const Tile* tile) {
+	const Position& position = tile->getPosition();
+	if (position.z > Map::maxZ) {
+		return;
+	}
+
+	// tiles which are just being created from a template are already described by it
+	if (!_layers[position.z].updateTileStates(position.x, position.y, tile)) {
+		return;
+	}
+
+	// fields are updated lazily once a tile within them changed whether it can be walked on
+	for (auto& entry : _flowFields) {
+		FlowField& field = entry.second;
+		if (field.stale || field.origin.z != position.z) {
+			continue;
+		}
+
+		int32_t index = field.indexForPosition(position.x, position.y);
+		if (index < 0) {
+			continue;
+		}
+
+		bool walkable = (field.costs[index] < FlowField::unreachedCost);
+		if (walkable != isFlowFieldWalkable(position.x, position.y, position.z)) {
+			field.stale = true;
+		}
+	}
+}
+
+
+Tile* TileTemplate::createTile(uint16_t x, uint16_t y, uint16_t z) const {
+	Tile* tile = nullptr;
+	ItemP ground;
+
+	for (auto itemId : itemIds) {
+		ItemP item = Item::CreateItem(itemId, 0);
+		item->setLoadedFromMap(true);
+
+		if (tile != nullptr) {
+			tile->__internalAddThing(item.get());
+		}
+		else if (item->isGroundTile()) {
+			ground = item;
+		}
+		else {
+			tile = IOMap::createTile(ground.get(), item.get(), x, y, z);
+			tile->__internalAddThing(item.get());
+
+			ground = nullptr;
+		}
+	}
+
+	if (tile == nullptr) {
+		tile = IOMap::createTile(ground.get(), nullptr, x, y, z);
+	}
+
+	tile->setFlag(static_cast<tileflags_t>(flags));
+	return tile;
+}
+
+
+// An estimate of the heap size of a tile created from the template, not counting the encoded items sent to clients.
+size_t TileTemplate::getTileSize() const {
+	size_t size = (tile->hasFlag(TILESTATE_DYNAMIC_TILE) ? sizeof(DynamicTile) : sizeof(StaticTile)) + itemIds.size() * sizeof(Item);
+
+	if (const TileItemVector* items = tile->getItemList()) {
+		if (!tile->hasFlag(TILESTATE_DYNAMIC_TILE)) {
+			size += sizeof(TileItemVector);
+		}
+
+		size += items->size() * sizeof(ItemP);
+	}
+
+	return size;
+}
+
+
 
 LOGGER_DEFINITION(MapLayer);
 
 
 MapLayer::MapLayer(uint8_t z)
 	: _completed(false),
-	  _endX(0),
-	  _endY(0),
-	  _maxLoadedX(0),
-	  _maxLoadedY(0),
-	  _minLoadedX(std::numeric_limits<uint16_t>::max()),
-	  _minLoadedY(std::numeric_limits<uint16_t>::max()),
-	  _startX(0),
-	  _startY(0),
+	  _chunkCountX(0),
+	  _chunkCountY(0),
+	  _firstChunkX(0),
+	  _firstChunkY(0),
+	  _height(0),
+	  _maxLoadedChunkX(0),
+	  _maxLoadedChunkY(0),
+	  _minLoadedChunkX(std::numeric_limits<uint32_t>::max()),
+	  _minLoadedChunkY(std::numeric_limits<uint32_t>::max()),
+	  _width(0),
 	  _z(z),
-	  _tiles(nullptr)
+	  _chunks(nullptr)
 {}
 
 
@@ -1078,19 +1280,46 @@ MapLayer::~MapLayer() {
 }
 
 
+void MapLayer::buildTileStates() {
+	uint32_t chunkCount = _chunkCountX * _chunkCountY;
+	for (uint32_t chunkIndex = 0; chunkIndex < chunkCount; ++chunkIndex) {
+		Chunk* chunk = _chunks[chunkIndex];
+		if (chunk == nullptr) {
+			continue;
+		}
+
+		for (uint32_t index = 0; index < chunkSize * chunkSize; ++index) {
+			const Tile* tile = chunk->tiles[index];
+			const TileTemplate* tileTemplate = (chunk->templates != nullptr ? chunk->templates[index] : nullptr);
+			if (tile == nullptr && tileTemplate == nullptr) {
+				continue;
+			}
+
+			for (uint32_t state = 0; state < MapLayer::numTileStates; ++state) {
+				bool hasState = (tile != nullptr ? tile->hasFlag(tileStateFlags[state]) : ((tileTemplate->tileStates >> state) & 1));
+				if (hasState) {
+					chunk->tileStates[state][index / 64] |= (UINT64_C(1) << (index % 64));
+				}
+			}
+		}
+	}
+}
+
+
 void MapLayer::clear() {
-	if (_tiles != nullptr) {
-		uint32_t count = (_endX - _startX) * (_endY - _startY);
-		for (uint32_t i = 0; i < count; ++i) {
-			delete _tiles[i];
+	if (_chunks != nullptr) {
+		uint32_t chunkCount = _chunkCountX * _chunkCountY;
+		for (uint32_t i = 0; i < chunkCount; ++i) {
+			delete _chunks[i];
 		}
 
-		delete[] _tiles;
-		_tiles = nullptr;
+		delete[] _chunks;
+		_chunks = nullptr;
 	}
 
-	_startX = _endX = _startY = _endY = _maxLoadedX = _maxLoadedY = 0;
-	_minLoadedX = _minLoadedY = std::numeric_limits<uint16_t>::max();
+	_chunkCountX = _chunkCountY = _firstChunkX = _firstChunkY = _height = _width = 0;
+	_maxLoadedChunkX = _maxLoadedChunkY = 0;
+	_minLoadedChunkX = _minLoadedChunkY = std::numeric_limits<uint32_t>::max();
 	_completed = false;
 }
 
@@ -1101,7 +1330,7 @@ void MapLayer::complete() {
 		return;
 	}
 
-	if (_minLoadedX > _maxLoadedX || _minLoadedY > _maxLoadedY || _tiles == nullptr) {
+	if (_minLoadedChunkX > _maxLoadedChunkX || _minLoadedChunkY > _maxLoadedChunkY || _chunks == nullptr) {
 		clear();
 
 		_completed = true;
@@ -1110,93 +1339,371 @@ void MapLayer::complete() {
 
 	_completed = true;
 
-	uint32_t width = (_endX - _startX);
+	uint32_t optimizedCountX = (_maxLoadedChunkX - _minLoadedChunkX + 1);
+	uint32_t optimizedCountY = (_maxLoadedChunkY - _minLoadedChunkY + 1);
 
-	if (_minLoadedX == _startX && _minLoadedY == _startY && _maxLoadedX == _endX - 1 && _maxLoadedY == _endY - 1) {
-		return;
+	if (optimizedCountX != _chunkCountX || optimizedCountY != _chunkCountY) {
+		// chunks outside of the loaded area are all empty so only the chunk directory needs to shrink
+		Chunk** optimizedChunks = new Chunk*[optimizedCountX * optimizedCountY];
+		for (uint32_t chunkY = _minLoadedChunkY; chunkY <= _maxLoadedChunkY; ++chunkY) {
+			uint32_t startIndex = (_chunkCountX * (chunkY - _firstChunkY)) + (_minLoadedChunkX - _firstChunkX);
+			uint32_t optimizedStartIndex = (optimizedCountX * (chunkY - _minLoadedChunkY));
+
+			memcpy(&optimizedChunks[optimizedStartIndex], &_chunks[startIndex], optimizedCountX * sizeof(Chunk*));
+		}
+
+		_chunkCountX = optimizedCountX;
+		_chunkCountY = optimizedCountY;
+		_firstChunkX = _minLoadedChunkX;
+		_firstChunkY = _minLoadedChunkY;
+
+		delete[] _chunks;
+		_chunks = optimizedChunks;
 	}
 
-	uint32_t optimizedWidth = (_maxLoadedX - _minLoadedX + 1);
-	uint32_t optimizedHeight = (_maxLoadedY - _minLoadedY + 1);
+	buildTileStates();
+}
+
+
+Tile* MapLayer::createTileFromTemplate(Chunk& chunk, uint32_t index, uint16_t x, uint16_t y) const {
+	// the state bits already describe the tile since they were taken from the template
+	Tile* tile = chunk.templates[index]->createTile(x, y, _z);
+	chunk.templates[index] = nullptr;
+	chunk.tiles[index] = tile;
+
+	return tile;
+}
+
+
+MapLayer::Chunk* MapLayer::getChunk(uint16_t x, uint16_t y) const {
+	// coordinates in front of the first chunk wrap around and fail the range check as well
+	uint32_t chunkX = (x >> chunkBits) - _firstChunkX;
+	uint32_t chunkY = (y >> chunkBits) - _firstChunkY;
+	if (chunkX >= _chunkCountX || chunkY >= _chunkCountY) {
+		return nullptr;
+	}
+
+	return _chunks[(chunkY * _chunkCountX) + chunkX];
+}
+
+
+// The size of a single tile pointer array covering the loaded area, as used before the tiles were stored in chunks.
+size_t MapLayer::getDenseStorageSize() const {
+	return static_cast<size_t>(_chunkCountX * chunkSize) * (_chunkCountY * chunkSize) * sizeof(Tile*);
+}
 
-	Tile** optimizedTiles = new Tile*[optimizedWidth * optimizedHeight];
-	for (uint32_t y = _minLoadedY; y <= _maxLoadedY; ++y) {
-		uint32_t startIndex = (width * (y - _startY)) + _minLoadedX;
-		uint32_t optimizedStartIndex = (optimizedWidth * (y - _minLoadedY));
 
-		Tile* const* startPointer = &_tiles[startIndex];
-		Tile** optimizedStartPointer = &optimizedTiles[optimizedStartIndex];
+// The heap size of the attributes of all items on tiles which have been created, including the contents of containers. Tile
+// templates only consist of item types and have no attributes.
+size_t MapLayer::getItemAttributesSize(size_t& itemCount, size_t& attributedItemCount) const {
+	itemCount = 0;
+	attributedItemCount = 0;
 
-		memcpy(optimizedStartPointer, startPointer, optimizedWidth * sizeof(Tile*));
+	if (_chunks == nullptr) {
+		return 0;
 	}
 
-	_startX = _minLoadedX;
-	_startY = _minLoadedY;
-	_endX = _maxLoadedX + 1;
-	_endY = _maxLoadedY + 1;
+	size_t size = 0;
 
-	delete[] _tiles;
-	_tiles = optimizedTiles;
+	size_t directorySize = static_cast<size_t>(_chunkCountX) * _chunkCountY;
+	for (size_t index = 0; index < directorySize; ++index) {
+		const Chunk* chunk = _chunks[index];
+		if (chunk == nullptr) {
+			continue;
+		}
+
+		for (const Tile* tile : chunk->tiles) {
+			if (tile == nullptr) {
+				continue;
+			}
+
+			if (tile->ground != nullptr) {
+				addItemAttributesSize(*tile->ground, itemCount, attributedItemCount, size);
+			}
+
+			if (const TileItemVector* items = tile->getItemList()) {
+				for (const auto& item : *items) {
+					addItemAttributesSize(*item, itemCount, attributedItemCount, size);
+				}
+			}
+		}
+	}
+
+	return size;
+}
+
+
+// The size of the chunk directory and the allocated chunks, not including the tiles themselves.
+size_t MapLayer::getStorageSize(size_t& chunkCount) const {
+	chunkCount = 0;
+
+	if (_chunks == nullptr) {
+		return 0;
+	}
+
+	size_t directorySize = static_cast<size_t>(_chunkCountX) * _chunkCountY;
+	size_t size = directorySize * sizeof(Chunk*);
+
+	for (size_t index = 0; index < directorySize; ++index) {
+		const Chunk* chunk = _chunks[index];
+		if (chunk == nullptr) {
+			continue;
+		}
+
+		++chunkCount;
+		size += sizeof(Chunk);
+
+		if (chunk->templates != nullptr) {
+			size += chunkSize * chunkSize * sizeof(const TileTemplate*);
+		}
+	}
+
+	return size;
+}
+
+
+// The estimated size which the tiles still using their template would take when created, and the number of tiles.
+size_t MapLayer::getTemplateTilesSize(size_t& tileCount, size_t& templateTileCount) const {
+	tileCount = 0;
+	templateTileCount = 0;
+
+	if (_chunks == nullptr) {
+		return 0;
+	}
+
+	size_t size = 0;
+
+	size_t directorySize = static_cast<size_t>(_chunkCountX) * _chunkCountY;
+	for (size_t index = 0; index < directorySize; ++index) {
+		const Chunk* chunk = _chunks[index];
+		if (chunk == nullptr) {
+			continue;
+		}
+
+		for (uint32_t tileIndex = 0; tileIndex < chunkSize * chunkSize; ++tileIndex) {
+			if (chunk->tiles[tileIndex] != nullptr) {
+				++tileCount;
+			}
+			else if (chunk->templates != nullptr && chunk->templates[tileIndex] != nullptr) {
+				++templateTileCount;
+				size += chunk->templates[tileIndex]->getTileSize();
+			}
+		}
+	}
+
+	return size;
 }
 
 
 Tile* MapLayer::getTile(uint16_t x, uint16_t y) const {
-	int32_t index = indexForPosition(x, y);
-	if (index < 0) {
+	Chunk* chunk = getChunk(x, y);
+	if (chunk == nullptr) {
 		return nullptr;
 	}
 
-	return _tiles[index];
+	uint32_t index = indexInChunk(x, y);
+
+	Tile* tile = chunk->tiles[index];
+	if (tile == nullptr && chunk->templates != nullptr && chunk->templates[index] != nullptr) {
+		tile = createTileFromTemplate(*chunk, index, x, y);
+	}
+
+	return tile;
 }
 
 
-int32_t MapLayer::indexForPosition(uint16_t x, uint16_t y) const {
-	if (x < _startX || y < _startY || x >= _endX || y >= _endY) {
-		return -1;
+const Tile* MapLayer::getTileForReading(uint16_t x, uint16_t y) const {
+	Chunk* chunk = getChunk(x, y);
+	if (chunk == nullptr) {
+		return nullptr;
 	}
 
-	uint32_t indexX = x - _startX;
-	uint32_t indexY = (_endX - _startX) * (y - _startY);
+	uint32_t index = indexInChunk(x, y);
+
+	const Tile* tile = chunk->tiles[index];
+	if (tile == nullptr && chunk->templates != nullptr && chunk->templates[index] != nullptr) {
+		tile = chunk->templates[index]->tile.get();
+	}
 
-	return (indexX + indexY);
+	return tile;
 }
 
 
-void MapLayer::prepareWithSize(uint16_t width, uint16_t height) {
-	clear();
+bool MapLayer::hasTile(uint16_t x, uint16_t y) const {
+	Chunk* chunk = getChunk(x, y);
+	if (chunk == nullptr) {
+		return false;
+	}
 
-	_endX = width;
-	_endY = height;
+	uint32_t index = indexInChunk(x, y);
+	return (chunk->tiles[index] != nullptr || (chunk->templates != nullptr && chunk->templates[index] != nullptr));
+}
 
-	_tiles = new Tile*[width * height];
-	memset(_tiles, 0, width * height * sizeof(Tile*));
+
+bool MapLayer::hasTileState(uint16_t x, uint16_t y, TileState state) const {
+	// the bits of all chunks stay cleared until the layer is completed
+	Chunk* chunk = getChunk(x, y);
+	if (chunk == nullptr) {
+		return false;
+	}
+
+	uint32_t index = indexInChunk(x, y);
+	return ((chunk->tileStates[static_cast<uint32_t>(state)][index / 64] >> (index % 64)) & 1);
 }
 
 
-bool MapLayer::setTile(uint16_t x, uint16_t y, Tile* tile) {
-	int32_t index = indexForPosition(x, y);
-	if (index < 0) {
+uint32_t MapLayer::indexInChunk(uint16_t x, uint16_t y) {
+	return (((y & chunkMask) << chunkBits) | (x & chunkMask));
+}
+
+
+MapLayer::Chunk* MapLayer::prepareChunk(uint16_t x, uint16_t y) {
+	if (x >= _width || y >= _height) {
 		LOGe("Cannot set tile at invalid map coordinate " << x << "/" << y << "/" << _z);
-		return false;
+		return nullptr;
+	}
+
+	if (_chunks == nullptr) {
+		// the chunk directory covers the whole layer until it is completed
+		_chunkCountX = (_width + chunkMask) >> chunkBits;
+		_chunkCountY = (_height + chunkMask) >> chunkBits;
+
+		_chunks = new Chunk*[_chunkCountX * _chunkCountY];
+		memset(_chunks, 0, _chunkCountX * _chunkCountY * sizeof(Chunk*));
+	}
+
+	uint32_t chunkX = (x >> chunkBits) - _firstChunkX;
+	uint32_t chunkY = (y >> chunkBits) - _firstChunkY;
+	if (chunkX >= _chunkCountX || chunkY >= _chunkCountY) {
+		LOGe("Cannot set tile at invalid map coordinate " << x << "/" << y << "/" << _z);
+		return nullptr;
+	}
+
+	Chunk*& chunk = _chunks[(chunkY * _chunkCountX) + chunkX];
+	if (chunk == nullptr) {
+		chunk = new Chunk;
 	}
 
 	if (!_completed) {
-		if (x < _minLoadedX) {
-			_minLoadedX = x;
+		chunkX += _firstChunkX;
+		chunkY += _firstChunkY;
+
+		if (chunkX < _minLoadedChunkX) {
+			_minLoadedChunkX = chunkX;
 		}
-		if (x > _maxLoadedX) {
-			_maxLoadedX = x;
+		if (chunkX > _maxLoadedChunkX) {
+			_maxLoadedChunkX = chunkX;
 		}
-		if (y < _minLoadedY) {
-			_minLoadedY = y;
+		if (chunkY < _minLoadedChunkY) {
+			_minLoadedChunkY = chunkY;
 		}
-		if (y > _maxLoadedY) {
-			_maxLoadedY = y;
+		if (chunkY > _maxLoadedChunkY) {
+			_maxLoadedChunkY = chunkY;
 		}
 	}
 
-	delete _tiles[index];
-	_tiles[index] = tile;
+	return chunk;
+}
+
+
+void MapLayer::prepareWithSize(uint16_t width, uint16_t height) {
+	clear();
+
+	_width = width;
+	_height = height;
+}
+
+
+bool MapLayer::setTile(uint16_t x, uint16_t y, Tile* tile) {
+	Chunk* chunk = prepareChunk(x, y);
+	if (chunk == nullptr) {
+		return false;
+	}
+
+	uint32_t index = indexInChunk(x, y);
+	if (chunk->templates != nullptr) {
+		chunk->templates[index] = nullptr;
+	}
+
+	Tile*& slot = chunk->tiles[index];
+	delete slot;
+	slot = tile;
+
+	if (_completed) {
+		updateTileStates(x, y, tile);
+	}
+
+	return true;
+}
+
+
+bool MapLayer::setTileTemplate(uint16_t x, uint16_t y, const TileTemplate& tileTemplate) {
+	if (_completed) {
+		// the state bits are only taken from templates when the layer is completed
+		LOGe("Cannot set tile template at map coordinate " << x << "/" << y << "/" << _z << " of a completed layer");
+		return false;
+	}
+
+	Chunk* chunk = prepareChunk(x, y);
+	if (chunk == nullptr) {
+		return false;
+	}
+
+	if (chunk->templates == nullptr) {
+		chunk->templates.reset(new const TileTemplate*[chunkSize * chunkSize]());
+	}
+
+	uint32_t index = indexInChunk(x, y);
+
+	Tile*& slot = chunk->tiles[index];
+	delete slot;
+	slot = nullptr;
+
+	chunk->templates[index] = &tileTemplate;
+	return true;
+}
+
+
+bool MapLayer::updateTileStates(uint16_t x, uint16_t y, const Tile* tile) {
+	if (!_completed) {
+		// the bitmaps are built at once when the layer is completed
+		return false;
+	}
+
+	Chunk* chunk = getChunk(x, y);
+	if (chunk == nullptr) {
+		return false;
+	}
+
+	uint32_t index = indexInChunk(x, y);
+	if (chunk->tiles[index] != tile) {
+		return false;
+	}
+
+	uint64_t mask = (UINT64_C(1) << (index % 64));
+	for (uint32_t state = 0; state < MapLayer::numTileStates; ++state) {
+		uint64_t& bits = chunk->tileStates[state][index / 64];
+		if (tile != nullptr && tile->hasFlag(tileStateFlags[state])) {
+			bits |= mask;
+		}
+		else {
+			bits &= ~mask;
+		}
+	}
 
 	return true;
 }
+
+
+
+MapLayer::Chunk::Chunk()
+	: tiles(),
+	  tileStates()
+{}
+
+
+MapLayer::Chunk::~Chunk() {
+	for (Tile* tile : tiles) {
+		delete tile;
+	}
+}
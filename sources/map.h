@@ -18,14 +18,10 @@
 #ifndef _MAP_H
 #define _MAP_H
 
+#include "astarnodes.h"
+#include "spectatorindex.h"
 #include "waypoints.h"
 
-#define MAX_NODES  512
-#define GET_NODE_INDEX(a) (a - &nodes[0])
-
-#define MAP_NORMALWALKCOST 10
-#define MAP_DIAGONALWALKCOST 25
-
 #define FLOOR_BITS 3
 #define FLOOR_SIZE (1 << FLOOR_BITS)
 #define FLOOR_MASK (FLOOR_SIZE - 1)
@@ -42,84 +38,102 @@ using CreatureP = boost::intrusive_ptr<Creature>;
 
 typedef std::list<boost::intrusive_ptr<Creature>>  CreatureList;
 typedef std::list<CreatureP>                       SpectatorList;
-typedef std::unordered_map<Position,SpectatorList> SpectatorCache;
 
 
-struct AStarNode {
-	uint16_t x, y;
-	AStarNode* parent;
-	int32_t f, g, h;
-};
-
+// The content of a tile which only consists of plain items without any attributes, shared by all tiles of the map
+// looking the same. Such tiles are only created once something is about to change them. Until then readers like path
+// searches and map descriptions are given the shared tile of the template, so that the large parts of a map which are
+// only ever looked at cost no more than a pointer per tile.
+struct TileTemplate {
 
+	Tile*  createTile  (uint16_t x, uint16_t y, uint16_t z) const;
+	size_t getTileSize () const;
 
-class AStarNodes {
-
-public:
-
-	AStarNodes();
 
-	void openNode(AStarNode* node);
-	void closeNode(AStarNode* node);
+	uint32_t              flags;      // tile flags read from the map file
+	std::vector<uint16_t> itemIds;    // ground first
+	Unique<Tile>          tile;       // shared by all positions using the template, at 0/0/0 and never changed
+	uint8_t               tileStates; // one bit per MapLayer::TileState of the created tiles
 
-	uint32_t countOpenNodes();
-	uint32_t countClosedNodes();
+};
 
-	AStarNode* getBestNode();
-	AStarNode* createOpenNode();
-	AStarNode* getNodeInList(uint16_t x, uint16_t y);
 
-	bool isInList(uint16_t x, uint16_t y);
-	int32_t getEstimatedDistance(uint16_t x, uint16_t y, uint16_t xGoal, uint16_t yGoal);
 
-	int32_t getMapWalkCost(const Creature* creature, AStarNode* node,
-		const Tile* neighbourTile, const Position& neighbourPos);
-	static int32_t getTileWalkCost(const Creature* creature, const Tile* tile);
+// The tiles of one floor, stored in chunks of 32x32 tiles which are only allocated where the map actually has tiles. Tiles
+// loaded from a shared template are created when they are first asked for. Some tile flags are mirrored into a bitmap per flag with one bit per tile, so that hot loops like sight line checks and path
+// searches can test them without touching the tiles. The bitmaps are built when the layer is completed and kept up to date
+// by the tiles afterwards.
+class MapLayer {
 
 private:
 
+	enum class TileState : uint8_t {
+		BLOCK_PROJECTILE,
+		BLOCK_SOLID,
+		BLOCK_PATH,
+		PROTECTION_ZONE,
+	};
 
-	LOGGER_DECLARATION;
-
-	AStarNode nodes[MAX_NODES];
+	static const uint32_t chunkBits     = 5;
+	static const uint32_t chunkSize     = 1 << chunkBits;
+	static const uint32_t chunkMask     = chunkSize - 1;
+	static const uint32_t numTileStates = 4;
 
-	std::bitset<MAX_NODES> openNodes;
-	uint32_t curNode;
 
-};
+	struct Chunk {
 
+		Chunk();
+		~Chunk();
 
+		std::unique_ptr<const TileTemplate*[]> templates;
+		Tile*                                  tiles[chunkSize * chunkSize];
+		uint64_t                               tileStates[numTileStates][chunkSize * chunkSize / 64];
 
-class MapLayer {
+	};
 
-private:
 
 	MapLayer(uint8_t z);
 	~MapLayer();
 
-	void    clear            ();
-	void    complete         ();
-	Tile*   getTile          (uint16_t x, uint16_t y) const;
-	int32_t indexForPosition (uint16_t x, uint16_t y) const;
-	void    prepareWithSize  (uint16_t width, uint16_t height);
-	bool    setTile          (uint16_t x, uint16_t y, Tile* tile);
+	void        buildTileStates        ();
+	void        clear                  ();
+	void        complete               ();
+	Tile*       createTileFromTemplate (Chunk& chunk, uint32_t index, uint16_t x, uint16_t y) const;
+	Chunk*      getChunk               (uint16_t x, uint16_t y) const;
+	size_t      getDenseStorageSize    () const;
+	size_t      getItemAttributesSize  (size_t& itemCount, size_t& attributedItemCount) const;
+	size_t      getStorageSize         (size_t& chunkCount) const;
+	size_t      getTemplateTilesSize   (size_t& tileCount, size_t& templateTileCount) const;
+	Tile*       getTile                (uint16_t x, uint16_t y) const;
+	const Tile* getTileForReading      (uint16_t x, uint16_t y) const;
+	bool        hasTile                (uint16_t x, uint16_t y) const;
+	bool        hasTileState           (uint16_t x, uint16_t y, TileState state) const;
+	Chunk*      prepareChunk           (uint16_t x, uint16_t y);
+	void        prepareWithSize        (uint16_t width, uint16_t height);
+	bool        setTile                (uint16_t x, uint16_t y, Tile* tile);
+	bool        setTileTemplate        (uint16_t x, uint16_t y, const TileTemplate& tileTemplate);
+	bool        updateTileStates       (uint16_t x, uint16_t y, const Tile* tile);
+
+	static uint32_t indexInChunk (uint16_t x, uint16_t y);
 
 
 	LOGGER_DECLARATION;
 
 	bool _completed;
 
-	uint32_t _endX;
-	uint32_t _endY;
-	uint32_t _maxLoadedX;
-	uint32_t _maxLoadedY;
-	uint32_t _minLoadedX;
-	uint32_t _minLoadedY;
-	uint32_t _startX;
-	uint32_t _startY;
+	uint32_t _chunkCountX;
+	uint32_t _chunkCountY;
+	uint32_t _firstChunkX;
+	uint32_t _firstChunkY;
+	uint32_t _height;
+	uint32_t _maxLoadedChunkX;
+	uint32_t _maxLoadedChunkY;
+	uint32_t _minLoadedChunkX;
+	uint32_t _minLoadedChunkY;
+	uint32_t _width;
 	uint32_t _z;
 
-	Tile** _tiles;
+	Chunk** _chunks;
 
 	friend class Map;
 
@@ -127,6 +141,35 @@ private:
 
 
 
+// Walking costs to one creature within a fixed radius, shared by all hostile monsters chasing it. Each of them finds its
+// way by stepping to cheaper neighbor tiles instead of searching a path of its own. The costs only depend on the tiles,
+// not on the walking creature, so the monsters still check every step themselves. Protection zones count as blocked,
+// so other monsters and hostile ones already standing in a protection zone search their paths as before. Fields are
+// rebuilt after maxAge in case a change was missed and dropped once nobody asked for them for that long.
+struct FlowField {
+
+	static const uint16_t radius = 16;
+	static const uint16_t size = 2 * radius + 1;
+	static const uint16_t blockedCost = std::numeric_limits<uint16_t>::max();
+	static const uint16_t unreachedCost = blockedCost - 1;
+	static const uint32_t maxAge = 5000; // milliseconds
+
+
+	FlowField();
+
+	int32_t indexForPosition (int32_t x, int32_t y) const;
+
+
+	std::vector<uint16_t> costs;
+	Position              origin;
+	bool                  stale;
+	Time                  updateTime;
+	Time                  useTime;
+
+};
+
+
+
 class Map {
 
 public:
@@ -134,15 +177,16 @@ public:
 	typedef std::deque<Direction>  Route;
 
 
-	static const uint16_t creaturesBlockSize = 100;
 	static const uint16_t maxX = 60000;
 	static const uint16_t maxY = 60000;
 	static const uint16_t maxZ = 15;
-	static const uint16_t maxViewportX = 11;
-	static const uint16_t maxViewportY = 11;
+	static const uint16_t maxViewportX = SpectatorIndex<Creature>::maxViewportX;
+	static const uint16_t maxViewportY = SpectatorIndex<Creature>::maxViewportY;
 	static const uint16_t maxClientViewportX = 8;
 	static const uint16_t maxClientViewportY = 6;
 	static const uint32_t numZ = maxZ + 1;
+	static const size_t   maxSpectatorCacheSize = 50000;
+	static const Duration spectatorCacheReportInterval;
 
 
 	Map();
@@ -150,14 +194,16 @@ public:
 
 	bool                 canThrowObjectTo    (const Position& origin, const Position& destination, bool checkLineOfSight = true, int32_t rangeX = Map::maxClientViewportX, int32_t rangeY = Map::maxClientViewportY) const;
 	bool                 checkSightLine      (const Position& origin, const Position& destination) const;
-	void                 clearSpectatorCache ();
 	uint16_t             getHeight           () const;
 	bool                 getPathMatching     (const Creature* creature, Route& route, const FrozenPathingConditionCall& pathCondition, const FindPathParams& findParameters) const;
 	bool                 getPathTo           (const Creature* creature, const Position& destination, Route& route, int32_t maxDistance = -1) const;
+	bool                 getPathToCreature   (const Creature* creature, const Creature& target, Route& route, const FindPathParams& findParameters);
 	const SpectatorList& getSpectators       (const Position& center);
 	void                 getSpectators       (SpectatorList& spectators, const Position& center, bool checkForDuplicates = false, bool multiFloor = false, int32_t westRange = 0, int32_t eastRange = 0, int32_t northRange = 0, int32_t southRange = 0);
 	Tile*                getTile             (int32_t x, int32_t y, int32_t z) const;
 	Tile*                getTile             (const Position& position) const;
+	const Tile*          getTileForReading   (int32_t x, int32_t y, int32_t z) const;
+	const Tile*          getTileForReading   (const Position& position) const;
 	Waypoints&           getWaypoints        ();
 	const Waypoints&     getWaypoints        () const;
 	uint16_t             getWidth            () const;
@@ -167,6 +213,8 @@ public:
 	bool                 save                () const;
 	bool                 setTile             (uint16_t x, uint16_t y, uint16_t z, Tile* tile);
 	bool                 setTile             (const Position& position, Tile* tile);
+	void                 trimSpectatorCache  ();
+	void                 updateTileStates    (const Tile* tile);
 
 	static bool isUnderground (uint32_t z);
 
@@ -174,32 +222,37 @@ public:
 private:
 
 	void               addDescription            (const std::string& description);
-	bool               canWalkTo                 (const Creature* creature, const Position& destination) const;
-	uint32_t           creaturesIndexForPosition (const Position& position) const;
+	bool               canWalkTo                 (const Creature* creature, const Position& destination, bool ignoreCreatures = false) const;
+	FlowField&         getFlowField              (const Creature& target);
 	const std::string& getHousesFileName         () const;
+	bool               getPathFromFlowField      (const Creature* creature, const Creature& target, Route& route, const FindPathParams& findParameters);
 	const std::string& getSpawnsFileName         () const;
+	const TileTemplate& getTileTemplate         (uint32_t flags, const std::vector<uint16_t>& itemIds);
+	bool               hasTileState              (int32_t x, int32_t y, int32_t z, MapLayer::TileState state) const;
+	bool               isFlowFieldWalkable       (int32_t x, int32_t y, int32_t z) const;
 	void               setHousesFileName         (const std::string& housesFileName);
-	void               getSpectators             (SpectatorList& spectators, const Position& center, bool checkForDuplicates, int32_t minOffsetX, int32_t maxOffsetX, int32_t minOffsetY, int32_t maxOffsetY, uint16_t minZ, uint16_t maxZ) const;
 	void               setSize                   (uint16_t width, uint16_t height);
 	void               setSpawnsFileName         (const std::string& spawnsFileName);
+	bool               setTileTemplate           (uint16_t x, uint16_t y, uint16_t z, const TileTemplate& tileTemplate);
+	void               updateFlowField           (FlowField& field, const Position& origin) const;
 
 
 	LOGGER_DECLARATION;
 
-	uint16_t _creatureBlockCountX;
-	uint16_t _creatureBlockCountY;
-	uint16_t _creatureBlockCountZ;
 	uint16_t _height;
 	uint16_t _width;
 
-	CreatureList* _creatures;
-
-	std::vector<std::string> _descriptions;
-	std::string              _housesFileName;
-	MapLayer                 _layers[numZ];
-	std::string              _spawnsFileName;
-	SpectatorCache           _spectatorCache;
-	Waypoints                _waypoints;
+	std::vector<std::string>               _descriptions;
+	std::unordered_map<uint32_t,FlowField> _flowFields;
+	Time                                   _flowFieldsSweepTime;
+	std::string                            _housesFileName;
+	MapLayer                               _layers[numZ];
+	std::string                            _spawnsFileName;
+	Time                                   _spectatorCacheReportTime;
+	SpectatorIndex<Creature>               _spectators;
+	Waypoints                              _waypoints;
+
+	std::map<std::pair<uint32_t,std::vector<uint16_t>>,Unique<TileTemplate>> _tileTemplates;
 
 
 	friend class IOMap;
@@ -877,7 +877,7 @@ void Monster::updateTarget() {
 				getPathSearchParams(attackedCreature.get(), parameters);
 
 				DirectionRoute route;
-				if (!server.game().getPathToEx(this, attackedCreature->getPosition(), route, parameters)) {
+				if (!server.game().getPathToCreature(this, *attackedCreature, route, parameters)) {
 					retarget();
 				}
 			}
@@ -29,6 +29,7 @@
 
 #include "condition.h"
 #include "configmanager.h"
+#include "fileloader.h"
 #include "game.h"
 #include "items.h"
 #include "party.h"
@@ -37,6 +38,318 @@
 #include "world.h"
 
 
+namespace {
+
+	#define MONSTER_TYPE_CACHE_FIELDS(FIELD) \
+		FIELD(isSummonable) FIELD(isIllusionable) FIELD(isConvinceable) FIELD(isAttackable) FIELD(isHostile) \
+		FIELD(isLureable) FIELD(isWalkable) FIELD(canPushItems) FIELD(canPushCreatures) FIELD(pushable) FIELD(hideName) \
+		FIELD(hideHealth) FIELD(outfit.lookType) FIELD(outfit.lookTypeEx) FIELD(outfit.lookHead) FIELD(outfit.lookBody) \
+		FIELD(outfit.lookLegs) FIELD(outfit.lookFeet) FIELD(outfit.lookAddons) FIELD(race) FIELD(skull) FIELD(partyShield) \
+		FIELD(lootMessage) FIELD(defense) FIELD(armor) FIELD(health) FIELD(healthMax) FIELD(baseSpeed) FIELD(lookCorpse) \
+		FIELD(corpseUnique) FIELD(corpseAction) FIELD(maxSummons) FIELD(runAwayHealth) FIELD(conditionImmunities) \
+		FIELD(damageImmunities) FIELD(lightLevel) FIELD(lightColor) FIELD(staticAttackChance) FIELD(manaCost) \
+		FIELD(targetDistance) FIELD(babbleChance) FIELD(retargetChance)
+
+	const uint32_t monsterCacheVersion = 1;
+
+	enum MonsterCacheNode : uint8_t {
+		MONSTER_CACHE_ROOT,
+		MONSTER_CACHE_MONSTER,
+		MONSTER_CACHE_ATTACK,
+		MONSTER_CACHE_DEFENSE,
+	};
+
+
+	// An XML element as stored in the monster cache. Spells hold combat objects and scripts which can only be created by
+	// Monsters::deserializeSpell, so their nodes are kept instead of the spells.
+	struct CachedXmlNode {
+		std::string                                     name;
+		std::vector<std::pair<std::string,std::string>> attributes;
+		std::vector<CachedXmlNode>                      children;
+	};
+
+	struct CachedMonster {
+		std::string                name; // as registered in monsters.xml
+		Unique<MonsterType>        type;
+		std::vector<CachedXmlNode> attacks;
+		std::vector<CachedXmlNode> defenses;
+	};
+
+
+	xmlNodePtr createXmlNode(const CachedXmlNode& cachedNode) {
+		xmlNodePtr node = xmlNewNode(nullptr, reinterpret_cast<const xmlChar*>(cachedNode.name.c_str()));
+		for (const auto& attribute : cachedNode.attributes) {
+			xmlNewProp(node, reinterpret_cast<const xmlChar*>(attribute.first.c_str()), reinterpret_cast<const xmlChar*>(attribute.second.c_str()));
+		}
+
+		for (const auto& child : cachedNode.children) {
+			xmlAddChild(node, createXmlNode(child));
+		}
+
+		return node;
+	}
+
+
+	bool readLootBlock(PropStream& stream, LootBlock& lootBlock) {
+		uint32_t idCount, childCount;
+		if (!stream.GET_ULONG(idCount)) {
+			return false;
+		}
+
+		for (uint32_t i = 0; i < idCount; ++i) {
+			uint16_t id;
+			if (!stream.GET_USHORT(id)) {
+				return false;
+			}
+
+			lootBlock.ids.push_back(id);
+		}
+
+		if (!stream.GET_USHORT(lootBlock.count) || !stream.GET_VALUE(lootBlock.subType) || !stream.GET_VALUE(lootBlock.actionId)
+			|| !stream.GET_VALUE(lootBlock.uniqueId) || !stream.GET_ULONG(lootBlock.chance) || !stream.GET_STRING(lootBlock.text)
+			|| !stream.GET_ULONG(childCount)) {
+			return false;
+		}
+
+		for (uint32_t i = 0; i < childCount; ++i) {
+			lootBlock.childLoot.emplace_back();
+			if (!readLootBlock(stream, lootBlock.childLoot.back())) {
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+
+	bool readMonsterType(PropStream& stream, MonsterType& type) {
+		#define READ_FIELD(field) { \
+			int32_t value; \
+			if (!stream.GET_VALUE(value)) { \
+				return false; \
+			} \
+			type.field = static_cast<std::remove_reference<decltype(type.field)>::type>(value); \
+		}
+
+		MONSTER_TYPE_CACHE_FIELDS(READ_FIELD)
+		#undef READ_FIELD
+
+		int64_t babbleInterval, retargetInterval;
+		uint32_t count;
+		if (!stream.GET_VALUE(type.experience) || !stream.GET_VALUE(babbleInterval) || !stream.GET_VALUE(retargetInterval)
+			|| !stream.GET_STRING(type.name) || !stream.GET_STRING(type.nameDescription) || !stream.GET_ULONG(count)) {
+			return false;
+		}
+
+		type.babbleInterval = Milliseconds(babbleInterval);
+		type.retargetInterval = Milliseconds(retargetInterval);
+
+		for (uint32_t i = 0; i < count; ++i) {
+			voiceBlock_t voice;
+			if (!stream.GET_VALUE(voice.yellText) || !stream.GET_STRING(voice.text)) {
+				return false;
+			}
+
+			type.babbleEntries.push_back(voice);
+		}
+
+		if (!stream.GET_ULONG(count)) {
+			return false;
+		}
+
+		for (uint32_t i = 0; i < count; ++i) {
+			summonBlock_t summon;
+			if (!stream.GET_STRING(summon.name) || !stream.GET_ULONG(summon.chance) || !stream.GET_ULONG(summon.interval)
+				|| !stream.GET_ULONG(summon.amount)) {
+				return false;
+			}
+
+			type.summonList.push_back(summon);
+		}
+
+		if (!stream.GET_ULONG(count)) {
+			return false;
+		}
+
+		for (uint32_t i = 0; i < count; ++i) {
+			type.lootItems.emplace_back();
+			if (!readLootBlock(stream, type.lootItems.back())) {
+				return false;
+			}
+		}
+
+		if (!stream.GET_ULONG(count)) {
+			return false;
+		}
+
+		for (uint32_t i = 0; i < count; ++i) {
+			int32_t combatType, percent;
+			if (!stream.GET_VALUE(combatType) || !stream.GET_VALUE(percent)) {
+				return false;
+			}
+
+			type.elementMap[static_cast<CombatType_t>(combatType)] = percent;
+		}
+
+		if (!stream.GET_ULONG(count)) {
+			return false;
+		}
+
+		for (uint32_t i = 0; i < count; ++i) {
+			std::string script;
+			if (!stream.GET_STRING(script)) {
+				return false;
+			}
+
+			type.scriptList.push_back(script);
+		}
+
+		return true;
+	}
+
+
+	bool readXmlNode(PropStream& stream, CachedXmlNode& node) {
+		uint32_t attributeCount, childCount;
+		if (!stream.GET_STRING(node.name) || !stream.GET_ULONG(attributeCount)) {
+			return false;
+		}
+
+		for (uint32_t i = 0; i < attributeCount; ++i) {
+			std::string name, value;
+			if (!stream.GET_STRING(name) || !stream.GET_STRING(value)) {
+				return false;
+			}
+
+			node.attributes.emplace_back(name, value);
+		}
+
+		if (!stream.GET_ULONG(childCount)) {
+			return false;
+		}
+
+		for (uint32_t i = 0; i < childCount; ++i) {
+			node.children.emplace_back();
+			if (!readXmlNode(stream, node.children.back())) {
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+
+	void writeLootBlock(PropWriteStream& stream, const LootBlock& lootBlock) {
+		stream.ADD_ULONG(lootBlock.ids.size());
+		for (uint16_t id : lootBlock.ids) {
+			stream.ADD_USHORT(id);
+		}
+
+		stream.ADD_USHORT(lootBlock.count);
+		stream.ADD_VALUE(lootBlock.subType);
+		stream.ADD_VALUE(lootBlock.actionId);
+		stream.ADD_VALUE(lootBlock.uniqueId);
+		stream.ADD_ULONG(lootBlock.chance);
+		stream.ADD_STRING(lootBlock.text);
+
+		stream.ADD_ULONG(lootBlock.childLoot.size());
+		for (const LootBlock& child : lootBlock.childLoot) {
+			writeLootBlock(stream, child);
+		}
+	}
+
+
+	void writeMonsterType(PropWriteStream& stream, const MonsterType& type) {
+		#define WRITE_FIELD(field) stream.ADD_VALUE(static_cast<int32_t>(type.field));
+
+		MONSTER_TYPE_CACHE_FIELDS(WRITE_FIELD)
+		#undef WRITE_FIELD
+
+		stream.ADD_VALUE(type.experience);
+		stream.ADD_VALUE(static_cast<int64_t>(std::chrono::duration_cast<Milliseconds>(type.babbleInterval).count()));
+		stream.ADD_VALUE(static_cast<int64_t>(std::chrono::duration_cast<Milliseconds>(type.retargetInterval).count()));
+		stream.ADD_STRING(type.name);
+		stream.ADD_STRING(type.nameDescription);
+
+		stream.ADD_ULONG(type.babbleEntries.size());
+		for (const voiceBlock_t& voice : type.babbleEntries) {
+			stream.ADD_VALUE(voice.yellText);
+			stream.ADD_STRING(voice.text);
+		}
+
+		stream.ADD_ULONG(type.summonList.size());
+		for (const summonBlock_t& summon : type.summonList) {
+			stream.ADD_STRING(summon.name);
+			stream.ADD_ULONG(summon.chance);
+			stream.ADD_ULONG(summon.interval);
+			stream.ADD_ULONG(summon.amount);
+		}
+
+		stream.ADD_ULONG(type.lootItems.size());
+		for (const LootBlock& lootBlock : type.lootItems) {
+			writeLootBlock(stream, lootBlock);
+		}
+
+		stream.ADD_ULONG(type.elementMap.size());
+		for (const auto& element : type.elementMap) {
+			stream.ADD_VALUE(static_cast<int32_t>(element.first));
+			stream.ADD_VALUE(element.second);
+		}
+
+		stream.ADD_ULONG(type.scriptList.size());
+		for (const std::string& script : type.scriptList) {
+			stream.ADD_STRING(script);
+		}
+	}
+
+
+	void writeXmlNode(PropWriteStream& stream, xmlNodePtr node) {
+		stream.ADD_STRING(reinterpret_cast<const char*>(node->name));
+
+		uint32_t attributeCount = 0;
+		for (xmlAttrPtr attribute = node->properties; attribute != nullptr; attribute = attribute->next) {
+			++attributeCount;
+		}
+
+		stream.ADD_ULONG(attributeCount);
+		for (xmlAttrPtr attribute = node->properties; attribute != nullptr; attribute = attribute->next) {
+			xmlChar* value = xmlGetProp(node, attribute->name);
+			stream.ADD_STRING(reinterpret_cast<const char*>(attribute->name));
+			stream.ADD_STRING(value != nullptr ? reinterpret_cast<const char*>(value) : "");
+			xmlFree(value);
+		}
+
+		// only elements matter to spells, the text between them is left out
+		uint32_t childCount = 0;
+		for (xmlNodePtr child = node->children; child != nullptr; child = child->next) {
+			if (child->type == XML_ELEMENT_NODE) {
+				++childCount;
+			}
+		}
+
+		stream.ADD_ULONG(childCount);
+		for (xmlNodePtr child = node->children; child != nullptr; child = child->next) {
+			if (child->type == XML_ELEMENT_NODE) {
+				writeXmlNode(stream, child);
+			}
+		}
+	}
+
+
+	std::string serializeXmlNode(xmlNodePtr node) {
+		PropWriteStream stream;
+		writeXmlNode(stream, node);
+
+		uint32_t size;
+		const char* data = stream.getStream(size);
+		return std::string(data, size);
+	}
+
+	#undef MONSTER_TYPE_CACHE_FIELDS
+
+}
+
+
+
 void MonsterType::reset()
 {
 	canPushItems = canPushCreatures = isSummonable = isIllusionable = isConvinceable = isLureable = isWalkable = hideName = hideHealth = false;
@@ -201,6 +514,15 @@ bool MonsterType::createChildLoot(Container* parent, const LootBlock& lootBlock)
 }
 
 
+void Monsters::addMonsterType(const std::string& name, MonsterType* mType) {
+	static uint32_t id = 0;
+
+	++id;
+	monsterNames[asLowerCaseString(name)] = id;
+	monsters[id] = mType;
+}
+
+
 void Monsters::clear() {
 	loaded = false;
 
@@ -214,7 +536,8 @@ void Monsters::clear() {
 bool Monsters::loadFromXml(bool reloading /*= false*/)
 {
 	loaded = false;
-	xmlDocPtr doc = xmlParseFile(getFilePath(FileType::OTHER, "monster/monsters.xml").c_str());
+	std::string filePath = getFilePath(FileType::OTHER, "monster/monsters.xml");
+	xmlDocPtr doc = xmlParseFile(filePath.c_str());
 	if(!doc)
 	{
 		LOGe("[Monsters::loadFromXml] Cannot load monsters file: " << getLastXMLError());
@@ -229,6 +552,8 @@ bool Monsters::loadFromXml(bool reloading /*= false*/)
 		return false;
 	}
 
+	MonsterFileList monsterFiles;
+
 	p = root->children;
 	while(p)
 	{
@@ -247,19 +572,226 @@ bool Monsters::loadFromXml(bool reloading /*= false*/)
 
 		std::string file, name;
 		if(readXMLString(p, "file", file) && readXMLString(p, "name", name))
-		{
-			file = getFilePath(FileType::OTHER, "monster/" + file);
-			loadMonster(file, name, reloading);
-		}
+			monsterFiles.emplace_back(getFilePath(FileType::OTHER, "monster/" + file), name);
 
 		p = p->next;
 	}
 
 	xmlFreeDoc(doc);
+
+	// the cache holds the monsters as loaded from their files, which are only read again once one of them changes; loot
+	// refers to item kinds, so the item files are part of the hash as well
+	StringVector sourceFilePaths = Items::getSourceFilePaths();
+	sourceFilePaths.push_back(filePath);
+	for(const auto& monsterFile : monsterFiles)
+		sourceFilePaths.push_back(monsterFile.first);
+
+	std::string sourceHash = hashFiles(sourceFilePaths);
+	if(sourceHash.empty() || !loadFromCache(sourceHash, reloading))
+	{
+		_recordingSpellSources = !sourceHash.empty();
+
+		bool allLoaded = true;
+		for(const auto& monsterFile : monsterFiles)
+		{
+			if(!loadMonster(monsterFile.first, monsterFile.second, reloading))
+				allLoaded = false;
+		}
+
+		// monsters which failed to load are reported on every start until they are fixed
+		if(allLoaded && !sourceHash.empty())
+			saveToCache(sourceHash, monsterFiles);
+
+		_recordingSpellSources = false;
+		_spellSources.clear();
+	}
+
 	loaded = true;
 	return loaded;
 }
 
+
+bool Monsters::loadFromCache(const std::string& sourceHash, bool reloading) {
+	std::string filePath = getFilePath(FileType::OTHER, "monster/monsters.cache");
+
+	FileLoader loader;
+	if (!loader.mapFile(filePath.c_str())) {
+		return false;
+	}
+
+	uint32_t nodeType;
+	const NodeStruct* node = loader.getChildNode(NO_NODE, nodeType);
+
+	PropStream properties;
+	if (nodeType != MONSTER_CACHE_ROOT || !loader.getProps(node, properties)) {
+		return false;
+	}
+
+	uint32_t version, typeSize;
+	std::string hash;
+	if (!properties.GET_ULONG(version) || !properties.GET_ULONG(typeSize) || !properties.GET_STRING(hash)) {
+		return false;
+	}
+
+	if (version != monsterCacheVersion || typeSize != sizeof(MonsterType) || hash != sourceHash) {
+		LOGi("Monster cache " << filePath << " is outdated.");
+		return false;
+	}
+
+	// everything is read before the first monster is added, so that a corrupt cache leaves nothing behind
+	std::vector<CachedMonster> cachedMonsters;
+	for (node = loader.getChildNode(node, nodeType); node != NO_NODE; node = loader.getNextNode(node, nodeType)) {
+		cachedMonsters.emplace_back();
+
+		CachedMonster& cachedMonster = cachedMonsters.back();
+		cachedMonster.type.reset(new MonsterType);
+
+		if (nodeType != MONSTER_CACHE_MONSTER || !loader.getProps(node, properties) || !properties.GET_STRING(cachedMonster.name)
+			|| !readMonsterType(properties, *cachedMonster.type)) {
+			LOGe("Monster cache " << filePath << " is corrupt.");
+			return false;
+		}
+
+		uint32_t spellType;
+		for (const NodeStruct* spellNode = loader.getChildNode(node, spellType); spellNode != NO_NODE; spellNode = loader.getNextNode(spellNode, spellType)) {
+			auto& spells = (spellType == MONSTER_CACHE_ATTACK ? cachedMonster.attacks : cachedMonster.defenses);
+			spells.emplace_back();
+
+			if ((spellType != MONSTER_CACHE_ATTACK && spellType != MONSTER_CACHE_DEFENSE) || !loader.getProps(spellNode, properties)
+				|| !readXmlNode(properties, spells.back())) {
+				LOGe("Monster cache " << filePath << " is corrupt.");
+				return false;
+			}
+		}
+	}
+
+	for (CachedMonster& cachedMonster : cachedMonsters) {
+		MonsterType* mType = nullptr;
+
+		uint32_t id = getIdByName(cachedMonster.name);
+		if (id != 0) {
+			if (!reloading) {
+				LOGw("[Monsters::loadFromCache] Duplicate registered monster with name: " << cachedMonster.name);
+				continue;
+			}
+
+			mType = getMonsterType(id);
+		}
+
+		if (mType != nullptr) {
+			mType->reset();
+			*mType = *cachedMonster.type;
+		}
+		else {
+			mType = cachedMonster.type.release();
+			addMonsterType(cachedMonster.name, mType);
+		}
+
+		// spells are created just like from the monster file, so changed spell scripts are still picked up
+		for (int32_t defensive = 0; defensive < 2; ++defensive) {
+			auto& cachedSpells = (defensive ? cachedMonster.defenses : cachedMonster.attacks);
+			auto& spells = (defensive ? mType->spellDefenseList : mType->spellAttackList);
+
+			for (const CachedXmlNode& cachedSpell : cachedSpells) {
+				xmlNodePtr spellNode = createXmlNode(cachedSpell);
+
+				spellBlock_t sb;
+				if (deserializeSpell(spellNode, sb, cachedMonster.name)) {
+					spells.push_back(sb);
+				}
+				else {
+					LOGw("[Monsters::loadFromCache] Cannot load spell of monster " << cachedMonster.name);
+				}
+
+				xmlFreeNode(spellNode);
+			}
+		}
+	}
+
+	return true;
+}
+
+
+void Monsters::saveToCache(const std::string& sourceHash, const MonsterFileList& monsterFiles) const {
+	std::string filePath = getFilePath(FileType::OTHER, "monster/monsters.cache");
+	std::string temporaryFilePath = filePath + ".tmp";
+
+	{
+		FileLoader writer;
+		if (!writer.openFile(temporaryFilePath.c_str(), true)) {
+			LOGw("Cannot write monster cache " << temporaryFilePath << ".");
+			return;
+		}
+
+		PropWriteStream header;
+		header.ADD_ULONG(monsterCacheVersion);
+		header.ADD_ULONG(sizeof(MonsterType));
+		header.ADD_STRING(sourceHash);
+
+		uint32_t size;
+		const char* data = header.getStream(size);
+
+		writer.startNode(MONSTER_CACHE_ROOT);
+		writer.setProps(const_cast<char*>(data), size);
+
+		std::set<std::string> savedNames;
+		for (const auto& monsterFile : monsterFiles) {
+			// later duplicates of a name were skipped when loading
+			std::string key = asLowerCaseString(monsterFile.second);
+			if (!savedNames.insert(key).second) {
+				continue;
+			}
+
+			auto nameIt = monsterNames.find(key);
+			auto typeIt = (nameIt != monsterNames.end() ? monsters.find(nameIt->second) : monsters.end());
+			if (typeIt == monsters.end()) {
+				continue;
+			}
+
+			const MonsterType& type = *typeIt->second;
+
+			PropWriteStream stream;
+			stream.ADD_STRING(monsterFile.second);
+			writeMonsterType(stream, type);
+
+			data = stream.getStream(size);
+
+			writer.startNode(MONSTER_CACHE_MONSTER);
+			writer.setProps(const_cast<char*>(data), size);
+
+			auto spellsIt = _spellSources.find(&type);
+			if (spellsIt != _spellSources.end()) {
+				for (const std::string& spell : spellsIt->second.first) {
+					writer.startNode(MONSTER_CACHE_ATTACK);
+					writer.setProps(const_cast<char*>(spell.data()), spell.size());
+					writer.endNode();
+				}
+
+				for (const std::string& spell : spellsIt->second.second) {
+					writer.startNode(MONSTER_CACHE_DEFENSE);
+					writer.setProps(const_cast<char*>(spell.data()), spell.size());
+					writer.endNode();
+				}
+			}
+
+			writer.endNode();
+		}
+
+		writer.endNode();
+
+		if (writer.getError() != ERROR_NONE) {
+			LOGw("Cannot write monster cache " << temporaryFilePath << ".");
+			return;
+		}
+	}
+
+	// replaced at once so that an interrupted write never leaves a broken cache behind
+	if (rename(temporaryFilePath.c_str(), filePath.c_str()) != 0) {
+		LOGw("Cannot replace monster cache " << filePath << ".");
+	}
+}
+
+
 ConditionDamage* Monsters::getDamageCondition(ConditionType_t conditionType,
 	int32_t maxDamage, int32_t minDamage, int32_t startDamage, uint32_t tickInterval)
 {
@@ -923,6 +1455,9 @@ bool Monsters::loadMonster(const std::string& file, const std::string& monsterNa
 	if(new_mType)
 		mType = new MonsterType();
 
+	//a type which failed to load may have been deleted and its address reused
+	_spellSources.erase(mType);
+
 	int32_t intValue;
 	std::string strValue;
 	if(readXMLString(root, "name", strValue))
@@ -1148,7 +1683,11 @@ bool Monsters::loadMonster(const std::string& file, const std::string& monsterNa
 				{
 					spellBlock_t sb;
 					if(deserializeSpell(tmpNode, sb, monsterName))
+					{
 						mType->spellAttackList.push_back(sb);
+						if(_recordingSpellSources)
+							_spellSources[mType].first.push_back(serializeXmlNode(tmpNode));
+					}
 					else
 						SHOW_XML_WARNING("Cant load spell");
 				}
@@ -1171,7 +1710,11 @@ bool Monsters::loadMonster(const std::string& file, const std::string& monsterNa
 				{
 					spellBlock_t sb;
 					if(deserializeSpell(tmpNode, sb, monsterName))
+					{
 						mType->spellDefenseList.push_back(sb);
+						if(_recordingSpellSources)
+							_spellSources[mType].second.push_back(serializeXmlNode(tmpNode));
+					}
 					else
 						SHOW_XML_WARNING("Cant load spell");
 				}
@@ -1455,13 +1998,8 @@ bool Monsters::loadMonster(const std::string& file, const std::string& monsterNa
 	xmlFreeDoc(doc);
 	if(monsterLoad)
 	{
-		static uint32_t id = 0;
 		if(new_mType)
-		{
-			id++;
-			monsterNames[asLowerCaseString(monsterName)] = id;
-			monsters[id] = mType;
-		}
+			addMonsterType(monsterName, mType);
 
 		return true;
 	}
@@ -133,7 +133,7 @@ public:
 class Monsters
 {
 	public:
-		Monsters(): loaded(false) {}
+		Monsters(): loaded(false), _recordingSpellSources(false) {}
 		~Monsters();
 
 		void clear();
@@ -155,6 +155,17 @@ class Monsters
 
 		bool loaded;
 
+		typedef std::vector<std::pair<std::string, std::string>> MonsterFileList; // <file,name>
+		typedef std::map<const MonsterType*, std::pair<StringVector, StringVector>> SpellSourceMap; // <type,<attacks,defenses>>
+
+		void addMonsterType(const std::string& name, MonsterType* mType);
+		bool loadFromCache(const std::string& sourceHash, bool reloading);
+		void saveToCache(const std::string& sourceHash, const MonsterFileList& monsterFiles) const;
+
+		// the serialized spell nodes of the monsters being loaded from XML, which the cache needs to create their spells again
+		bool _recordingSpellSources;
+		SpellSourceMap _spellSources;
+
 		bool loadLoot(xmlNodePtr, LootBlock&);
 		bool loadChildLoot(xmlNodePtr, LootBlock&);
 
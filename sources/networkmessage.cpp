@@ -214,6 +214,30 @@ void NetworkMessage::AddItem(const Item* item)
 		AddByte(fluidMap[item->getSubType() % 8]);
 }
 
+void NetworkMessage::AppendItem(std::string& buffer, const Item* item)
+{
+	ItemKindPC kind = item->getKind();
+
+	uint16_t clientId = kind->clientId;
+	buffer.append(reinterpret_cast<const char*>(&clientId), sizeof(clientId));
+
+	if(kind->stackable || kind->isRune())
+		buffer.push_back(static_cast<char>(item->getSubType()));
+	else if(kind->isSplash() || kind->isFluidContainer())
+		buffer.push_back(static_cast<char>(fluidMap[item->getSubType() % 8]));
+}
+
+NetworkFragment_ptr NetworkMessage::createFragment(const std::function<void(NetworkMessage_ptr)>& encode)
+{
+	// reused for all fragments created on the same thread
+	static thread_local NetworkMessage_ptr msg = std::make_shared<NetworkMessage>();
+
+	msg->Reset();
+	encode(msg);
+
+	return std::make_shared<const NetworkFragment>(reinterpret_cast<const char*>(msg->m_MsgBuf + msg->m_ReadPos - msg->m_MsgSize), msg->m_MsgSize);
+}
+
 void NetworkMessage::AddItemId(const Item *item)
 {
 	AddU16(item->getKind()->clientId);
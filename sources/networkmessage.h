@@ -31,6 +31,10 @@ class RSA;
 
 typedef std::shared_ptr<NetworkMessage> NetworkMessage_ptr;
 
+// the bytes of a packet which was encoded once and is added to the messages of several recipients
+typedef std::string NetworkFragment;
+typedef std::shared_ptr<const NetworkFragment> NetworkFragment_ptr;
+
 
 class NetworkMessage
 {
@@ -114,6 +118,7 @@ class NetworkMessage
 		}
 
 		void AddBytes(const char* bytes, uint32_t size);
+		void AddFragment(const NetworkFragment& fragment) {AddBytes(fragment.data(), fragment.size());}
 		void AddPaddingBytes(uint32_t n);
 
 		void AddString(const std::string &value) {AddString(value.c_str());}
@@ -126,6 +131,12 @@ class NetworkMessage
 		void AddItemId(const Item *item);
 		void AddItemId(uint16_t itemId);
 
+		// encodes an item like AddItem but into a buffer which can be added to several messages later
+		static void AppendItem(std::string& buffer, const Item* item);
+
+		// encodes a packet through the given function and returns its bytes for use with AddFragment()
+		static NetworkFragment_ptr createFragment(const std::function<void(NetworkMessage_ptr)>& encode);
+
 		int32_t getMessageLength() const {return m_MsgSize;}
 		void setMessageLength(int32_t newSize) {m_MsgSize = newSize;}
 
@@ -22,6 +22,7 @@
 #define _OTPCH_H
 
 #include <algorithm>
+#include <atomic>
 #include <bitset>
 #include <chrono>
 #include <cmath>
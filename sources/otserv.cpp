@@ -55,6 +55,7 @@
 #include "server.h"
 
 RSA g_RSA;
+RSAWorkerPool g_RSAWorkerPool;
 
 IpList serverIps;
 
@@ -242,6 +243,8 @@ int main(int argc, char *argv[]) {
 		server.dispatcher().stop();
 	}
 
+	g_RSAWorkerPool.stop();
+
 	server.destroy();
 	xmlCleanupParser();
 
@@ -300,6 +303,7 @@ bool otserv(StringVector args, ServiceManager* services) {
 	const char* q("7630979195970404721891201847792002125535401292779123937207447574596692788513647179235335529307251350570728407373705564708871762033017096809910315212884101");
 	const char* d("46730330223584118622160180015036832148732986808519344675210555262940258739805766860224610646919605860206328024326703361630109888417839241959507572247284807035235569619173792292786907845791904955103601652822519121908367187885509270025388641700821735345222087940578381210879116823013776808975766851829020659073");
 	g_RSA.setKey(p, q, d);
+	g_RSAWorkerPool.start(g_RSA, std::max(configManager.getNumber(ConfigManager::RSA_WORKER_THREADS), 0));
 
 	LOGi("Connecting to database...");
 
@@ -17,28 +17,28 @@
 #include "otpch.h"
 #include "scheduler.h"
 
+#include "adler.h"
+
 #include "connection.h"
-#include "dispatcher.h"
 #include "outputmessage.h"
 #include "protocol.h"
 #include "server.h"
-#include "task.h"
 #include "tools.h"
 
 LOGGER_DEFINITION(OutputMessagePool);
 
 
-#ifdef __ENABLE_SERVER_DIAGNOSTIC__
-uint32_t OutputMessagePool::outputMessagePoolCount = OUTPUT_POOL_SIZE;
-#endif
-
 OutputMessagePool::OutputMessagePool()
-	: m_shutdown(false)
+	: m_availableMessageCount(OUTPUT_POOL_SIZE),
+	  m_destroyed(false),
+	  m_shutdown(false),
+	  m_totalMessageCount(OUTPUT_POOL_SIZE)
 {
+	m_freeMessages.reserve(OUTPUT_POOL_SIZE);
 	for(uint32_t i = 0; i < OUTPUT_POOL_SIZE; ++i)
 	{
 		OutputMessage* msg = new OutputMessage();
-		m_outputMessages.push_back(msg);
+		m_freeMessages.push_back(msg);
 #ifdef __TRACK_NETWORK__
 		m_allMessages.push_back(msg);
 #endif
@@ -51,28 +51,61 @@ void OutputMessagePool::startExecutionFrame()
 {
 	LOGt("OutputMessagePool::startExecutionFrame()");
 
-	//boost::recursive_mutex::scoped_lock lockClass(m_outputPoolLock);
 	m_frameTime = OTSYS_TIME();
 	m_shutdown = false;
 }
 
 OutputMessagePool::~OutputMessagePool()
 {
-	for(InternalList::iterator it = m_outputMessages.begin(); it != m_outputMessages.end(); ++it)
+	// messages still queued for sending are deleted by releaseMessage() from now on
+	m_destroyed = true;
+	m_autoSend.clear();
+	m_addQueue.clear();
+
+	for(FreeList::iterator it = m_freeMessages.begin(); it != m_freeMessages.end(); ++it)
 		delete (*it);
 
-	m_outputMessages.clear();
+	m_freeMessages.clear();
+}
+
+OutputMessagePool::LocalCache::~LocalCache()
+{
+	// hands the messages of a terminating thread back to the other threads
+	if(!messages.empty())
+		OutputMessagePool::getInstance()->spillLocalCache(messages, messages.size());
+}
+
+OutputMessage* OutputMessagePool::acquireMessage()
+{
+	FreeList& messages = localCache().messages;
+	if(messages.empty())
+		refillLocalCache(messages);
+
+	if(messages.empty())
+	{
+		++m_totalMessageCount;
+
+		OutputMessage* msg = new OutputMessage();
+#ifdef __TRACK_NETWORK__
+		std::lock_guard<std::mutex> lock(m_freeMessagesLock);
+		m_allMessages.push_back(msg);
+#endif
+
+		return msg;
+	}
+
+	--m_availableMessageCount;
+
+	OutputMessage* msg = messages.back();
+	messages.pop_back();
+	return msg;
 }
 
 void OutputMessagePool::send(OutputMessage_ptr msg)
 {
 	LOGt("OutputMessagePool::send()");
 
-	m_outputPoolLock.lock();
-	OutputMessage::OutputMessageState state = msg->getState();
-	m_outputPoolLock.unlock();
-
-	if(state == OutputMessage::STATE_ALLOCATED_NO_AUTOSEND)
+	if(msg->getState() == OutputMessage::STATE_ALLOCATED_NO_AUTOSEND)
 	{
 		if(msg->getConnection())
 		{
@@ -88,7 +121,6 @@ void OutputMessagePool::send(OutputMessage_ptr msg)
 
 void OutputMessagePool::sendAll()
 {
-	boost::recursive_mutex::scoped_lock lockClass(m_outputPoolLock);
 	OutputMessageList::iterator it;
 	for(it = m_addQueue.begin(); it != m_addQueue.end();)
 	{
@@ -138,36 +170,61 @@ void OutputMessagePool::sendAll()
 	}
 }
 
-void OutputMessagePool::releaseMessage(OutputMessage* msg)
+OutputMessagePool::LocalCache& OutputMessagePool::localCache()
 {
-	LOGt("OutputMessagePool::releaseMessage()");
+	static thread_local LocalCache cache;
+	return cache;
+}
 
-	server.dispatcher().addTask(Task::create(std::bind(
-		&OutputMessagePool::internalReleaseMessage, this, msg)), true);
+void OutputMessagePool::refillLocalCache(FreeList& messages)
+{
+	std::lock_guard<std::mutex> lock(m_freeMessagesLock);
+
+	size_t count = std::min(localCacheSize / 2, m_freeMessages.size());
+	messages.insert(messages.end(), m_freeMessages.end() - count, m_freeMessages.end());
+	m_freeMessages.resize(m_freeMessages.size() - count);
 }
 
-void OutputMessagePool::internalReleaseMessage(OutputMessage* msg)
+void OutputMessagePool::releaseMessage(OutputMessage* msg)
 {
-	LOGt("OutputMessagePool::internalReleaseMessage()");
+	LOGt("OutputMessagePool::releaseMessage()");
 
+	// runs on whichever thread dropped the last reference, usually the one which has written the message
 	if(msg->getProtocol())
 		msg->getProtocol()->unRef();
 	else
-		LOGe("[OutputMessagePool::internalReleaseMessage] protocol not found.");
+		LOGe("[OutputMessagePool::releaseMessage] protocol not found.");
 
 	if(msg->getConnection())
 		msg->getConnection()->unRef();
 	else
-		LOGe("[OutputMessagePool::internalReleaseMessage] connection not found.");
+		LOGe("[OutputMessagePool::releaseMessage] connection not found.");
 
 	msg->freeMessage();
 #ifdef __TRACK_NETWORK__
 	msg->clearTrack();
 #endif
 
-	m_outputPoolLock.lock();
-	m_outputMessages.push_back(msg);
-	m_outputPoolLock.unlock();
+	if(m_destroyed)
+	{
+		delete msg;
+		return;
+	}
+
+	FreeList& messages = localCache().messages;
+	messages.push_back(msg);
+	++m_availableMessageCount;
+
+	if(messages.size() >= localCacheSize)
+		spillLocalCache(messages, localCacheSize / 2);
+}
+
+void OutputMessagePool::spillLocalCache(FreeList& messages, size_t count)
+{
+	std::lock_guard<std::mutex> lock(m_freeMessagesLock);
+
+	m_freeMessages.insert(m_freeMessages.end(), messages.end() - count, messages.end());
+	messages.resize(messages.size() - count);
 }
 
 OutputMessage_ptr OutputMessagePool::getOutputMessage(Protocol* protocol, bool autoSend /*= true*/)
@@ -177,27 +234,13 @@ OutputMessage_ptr OutputMessagePool::getOutputMessage(Protocol* protocol, bool a
 	if(m_shutdown)
 		return OutputMessage_ptr();
 
-	boost::recursive_mutex::scoped_lock lockClass(m_outputPoolLock);
 	if(!protocol->getConnection())
 		return OutputMessage_ptr();
 
-	if(m_outputMessages.empty())
-	{
-#ifdef __ENABLE_SERVER_DIAGNOSTIC__
-		outputMessagePoolCount++;
-#endif
-		OutputMessage* msg = new OutputMessage();
-		m_outputMessages.push_back(msg);
-#ifdef __TRACK_NETWORK__
-		m_allMessages.push_back(msg);
-#endif
-	}
-
 	OutputMessage_ptr omsg;
-	omsg.reset(m_outputMessages.back(),
+	omsg.reset(acquireMessage(),
 		std::bind(&OutputMessagePool::releaseMessage, this, std::placeholders::_1));
 
-	m_outputMessages.pop_back();
 	configureOutputMessage(omsg, protocol, autoSend);
 	return omsg;
 }
@@ -231,9 +274,7 @@ void OutputMessagePool::autoSend(OutputMessage_ptr msg)
 {
 	LOGt("OutputMessagePool::autoSend()");
 
-	m_outputPoolLock.lock();
 	m_addQueue.push_back(msg);
-	m_outputPoolLock.unlock();
 }
 
 
@@ -139,9 +139,6 @@ class OutputMessagePool
 		OutputMessagePool();
 
 	public:
-#ifdef __ENABLE_SERVER_DIAGNOSTIC__
-		static uint32_t outputMessagePoolCount;
-#endif
 		~OutputMessagePool();
 		static OutputMessagePool* getInstance()
 		{
@@ -149,6 +146,7 @@ class OutputMessagePool
 			return &instance;
 		}
 
+		// messages sent automatically may only be requested by the dispatcher thread, which also sends them
 		OutputMessage_ptr getOutputMessage(Protocol* protocol, bool autoSend = true);
 
 		void send(OutputMessage_ptr msg);
@@ -158,35 +156,49 @@ class OutputMessagePool
 		void startExecutionFrame();
 		void autoSend(OutputMessage_ptr msg);
 
-#ifdef __ENABLE_SERVER_DIAGNOSTIC__
-		size_t getTotalMessageCount() const {return (size_t)outputMessagePoolCount;}
-#else
-		size_t getTotalMessageCount() const {return m_allMessages.size();}
-#endif
-		size_t getAvailableMessageCount() const {return m_outputMessages.size();}
+		size_t getTotalMessageCount() const {return m_totalMessageCount;}
+		size_t getAvailableMessageCount() const {return m_availableMessageCount;}
 		size_t getAutoMessageCount() const {return m_autoSend.size();}
 		size_t getQueuedMessageCount() const {return m_addQueue.size();}
 
 	protected:
-		void configureOutputMessage(OutputMessage_ptr msg, Protocol* protocol, bool autoSend);
+		typedef std::vector<OutputMessage*> FreeList;
+
+		// free messages owned by one thread, so that most allocations and releases don't need a lock
+		struct LocalCache
+		{
+			~LocalCache();
+
+			FreeList messages;
+		};
 
+		static const size_t localCacheSize = 64;
+
+		OutputMessage* acquireMessage();
+		void configureOutputMessage(OutputMessage_ptr msg, Protocol* protocol, bool autoSend);
+		LocalCache& localCache();
+		void refillLocalCache(FreeList& messages);
 		void releaseMessage(OutputMessage* msg);
-		void internalReleaseMessage(OutputMessage* msg);
+		void spillLocalCache(FreeList& messages, size_t count);
 
 
 		LOGGER_DECLARATION;
 
+		// only touched by the dispatcher thread
 		typedef std::list<OutputMessage_ptr> OutputMessageList;
 		OutputMessageList m_autoSend;
 		OutputMessageList m_addQueue;
 
 		typedef std::list<OutputMessage*> InternalList;
-		InternalList m_outputMessages;
 		InternalList m_allMessages;
 
-		boost::recursive_mutex m_outputPoolLock;
-		uint64_t m_frameTime;
-		bool m_shutdown;
+		std::atomic<size_t>     m_availableMessageCount;
+		std::atomic<bool>       m_destroyed;
+		FreeList                m_freeMessages;
+		std::mutex              m_freeMessagesLock;
+		std::atomic<uint64_t>   m_frameTime;
+		std::atomic<bool>       m_shutdown;
+		std::atomic<size_t>     m_totalMessageCount;
 };
 
 #ifdef __TRACK_NETWORK__
@@ -189,7 +189,7 @@ Player::Player(const AccountP& account, const std::string& _name, ProtocolGame*
 	if(client)
 		client->setPlayer(this);
 
-	pzLocked = isConnecting = addAttackSkillPoint = requestedOutfit = false;
+	pzLocked = isConnecting = addAttackSkillPoint = requestedOutfit = storageChanged = false;
 	saving = true;
 
 	lastAttackBlockType = BLOCK_NONE;
@@ -917,7 +917,10 @@ void Player::dropLoot(Container* corpse)
 bool Player::setStorage(const uint32_t key, const std::string& value)
 {
 	if(!IS_IN_KEYRANGE(key, RESERVED_RANGE))
+	{
+		storageChanged = true;
 		return Creature::setStorage(key, value);
+	}
 
 	if(IS_IN_KEYRANGE(key, OUTFITS_RANGE))
 	{
@@ -952,6 +955,7 @@ bool Player::setStorage(const uint32_t key, const std::string& value)
 void Player::eraseStorage(const uint32_t key)
 {
 	Creature::eraseStorage(key);
+	storageChanged = true;
 	if(IS_IN_KEYRANGE(key, RESERVED_RANGE))
 		LOGw("[Player::eraseStorage] Unknown reserved key: " << key << " for player: " << name);
 }
@@ -1563,21 +1567,23 @@ void Player::onCreatureDisappear(const Creature* creature)
 	}
 
 	server.chat().removeUserFromAllChannels(this);
-	if(!isGhost())
-		IOLoginData::getInstance()->updateOnlineStatus(guid, false);
-
 	if(server.configManager().getBool(ConfigManager::DISPLAY_LOGGING))
 		LOGi(name << " has logged out.");
 
+	// the player is marked offline by the same transaction which saves him
 	bool saved = false;
 	for(uint32_t tries = 0; !saved && tries < 3; ++tries)
 	{
-		if(IOLoginData::getInstance()->savePlayer(this))
+		if(IOLoginData::getInstance()->savePlayer(this, true, false, !isGhost()))
 			saved = true;
 	}
 
 	if(!saved)
+	{
 		LOGe("Player " << getName() << " couldn't be saved.");
+		if(!isGhost())
+			IOLoginData::getInstance()->updateOnlineStatus(guid, false);
+	}
 }
 
 void Player::openShopWindow()
@@ -3798,7 +3804,13 @@ void Player::generateReservedStorage()
 
 		std::stringstream ss;
 		ss << ((it->first << 16) | (it->second.addons & 0xFF));
-		storageMap[baseKey] = ss.str();
+
+		std::string& value = storageMap[baseKey];
+		if(value != ss.str())
+		{
+			value = ss.str();
+			storageChanged = true;
+		}
 
 		baseKey++;
 		if(baseKey <= PSTRG_OUTFITSID_RANGE_START + PSTRG_OUTFITSID_RANGE_SIZE)
@@ -4951,8 +4963,9 @@ void Player::sendCreatureMove(const CreatureP& creature, const Tile* newTile, co
 
 void Player::sendCreatureTurn(const CreatureP& creature)
 	{if(client) client->sendCreatureTurn(creature, StackPosition(creature->getPosition(), creature->getTile()->getClientIndexOfThing(this, creature.get())));}
-void Player::sendCreatureSay(const CreatureP& creature, SpeakClasses type, const std::string& text, Position* pos)
-	{if(client) client->sendCreatureSay(creature, type, text, pos);}
+void Player::sendCreatureSay(const CreatureP& creature, SpeakClasses type, const std::string& text, Position* pos,
+	const NetworkFragment_ptr& fragment)
+	{if(client) client->sendCreatureSay(creature, type, text, pos, fragment);}
 void Player::sendCreatureSquare(const CreatureP& creature, SquareColor_t color)
 	{if(client) client->sendCreatureSquare(creature, color);}
 void Player::sendCreatureChangeOutfit(const CreatureP& creature, const Outfit_t& outfit)
@@ -4974,8 +4987,8 @@ void Player::sendUpdateInventoryItem(slots_t slot, const Item* oldItem, const It
 void Player::sendRemoveInventoryItem(slots_t slot, const Item* item)
 	{if(client) client->sendRemoveInventoryItem(slot);}
 
-void Player::sendAnimatedText(const Position& pos, uint8_t color, std::string text) const
-	{if(client) client->sendAnimatedText(pos,color,text);}
+void Player::sendAnimatedText(const Position& pos, uint8_t color, std::string text, const NetworkFragment_ptr& fragment) const
+	{if(client) client->sendAnimatedText(pos, color, text, fragment);}
 void Player::sendCancel(const std::string& msg) const
 	{if(client) client->sendCancel(msg);}
 void Player::sendCancelTarget() const
@@ -4986,8 +4999,8 @@ void Player::sendChangeSpeed(const Creature* creature, uint32_t newSpeed) const
 	{if(client) client->sendChangeSpeed(creature, newSpeed);}
 void Player::sendCreatureHealth(const Creature* creature) const
 	{if(client) client->sendCreatureHealth(creature);}
-void Player::sendDistanceShoot(const Position& from, const Position& to, uint8_t type) const
-	{if(client) client->sendDistanceShoot(from, to, type);}
+void Player::sendDistanceShoot(const Position& from, const Position& to, uint8_t type, const NetworkFragment_ptr& fragment) const
+	{if(client) client->sendDistanceShoot(from, to, type, fragment);}
 void Player::sendOutfitWindow() const {if(client) client->sendOutfitWindow();}
 void Player::sendQuests() const {if(client) client->sendQuests();}
 void Player::sendQuestInfo(Quest* quest) const {if(client) client->sendQuestInfo(quest);}
@@ -4999,8 +5012,8 @@ void Player::sendCreatePrivateChannel(uint16_t channelId, const std::string& cha
 	{if(client) client->sendCreatePrivateChannel(channelId, channelName);}
 void Player::sendClosePrivate(uint16_t channelId) const
 	{if(client) client->sendClosePrivate(channelId);}
-void Player::sendMagicEffect(const Position& pos, uint8_t type) const
-	{if(client) client->sendMagicEffect(pos, type);}
+void Player::sendMagicEffect(const Position& pos, uint8_t type, const NetworkFragment_ptr& fragment) const
+	{if(client) client->sendMagicEffect(pos, type, fragment);}
 void Player::sendSkills() const
 	{if(client) client->sendSkills();}
 void Player::sendTextMessage(MessageClasses type, const std::string& message) const
@@ -5011,8 +5024,9 @@ void Player::sendTextWindow(Item* item, uint16_t maxLen, bool canWrite) const
 	{if(client) client->sendTextWindow(windowTextId, item, maxLen, canWrite);}
 void Player::sendTextWindow(uint32_t itemId, const std::string& text) const
 	{if(client) client->sendTextWindow(windowTextId, itemId, text);}
-void Player::sendToChannel(Creature* creature, SpeakClasses type, const std::string& text, uint16_t channelId, uint32_t time) const
-	{if(client) client->sendToChannel(creature, type, text, channelId, time);}
+void Player::sendToChannel(Creature* creature, SpeakClasses type, const std::string& text, uint16_t channelId, uint32_t time,
+	const NetworkFragment_ptr& fragment) const
+	{if(client) client->sendToChannel(creature, type, text, channelId, time, fragment);}
 void Player::sendShop() const
 	{if(client) client->sendShop(shopOffer);}
 void Player::sendGoods() const
@@ -20,6 +20,7 @@
 
 #include "container.h"
 #include "creature.h"
+#include "playerpersistence.h"
 
 class Account;
 class Depot;
@@ -35,6 +36,7 @@ class Vocation;
 class Weapon;
 
 typedef std::shared_ptr<Account>  AccountP;
+typedef std::shared_ptr<const std::string> NetworkFragment_ptr;
 typedef std::map<uint32_t,Outfit> OutfitMap;
 typedef std::set<uint32_t> VIPListSet;
 typedef std::vector<std::pair<uint32_t, Container*> > ContainerVector;
@@ -430,7 +432,8 @@ private:
 				const Tile* oldTile, const Position& oldPos, uint32_t oldStackpos, bool teleport, const char* callSource);
 
 		void sendCreatureTurn(const CreatureP& creature);
-		void sendCreatureSay(const CreatureP& creature, SpeakClasses type, const std::string& text, Position* pos = nullptr);
+		void sendCreatureSay(const CreatureP& creature, SpeakClasses type, const std::string& text, Position* pos = nullptr,
+			const NetworkFragment_ptr& fragment = NetworkFragment_ptr());
 		void sendCreatureSquare(const CreatureP& creature, SquareColor_t color);
 		void sendCreatureChangeOutfit(const CreatureP& creature, const Outfit_t& outfit);
 		void sendCreatureChangeVisible(const CreatureP& creature, Visible_t visible, const char* callSource);
@@ -488,14 +491,14 @@ private:
 			Item* newItem, const ItemKindPC& newType);
 		void onRemoveInventoryItem(slots_t slot, Item* item);
 
-		void sendAnimatedText(const Position& pos, uint8_t color, std::string text) const;
+		void sendAnimatedText(const Position& pos, uint8_t color, std::string text, const NetworkFragment_ptr& fragment = NetworkFragment_ptr()) const;
 		void sendCancel(const std::string& msg) const;
 		void sendCancelMessage(ReturnValue message) const;
 		void sendCancelTarget() const;
 		void sendCancelWalk() const;
 		void sendChangeSpeed(const Creature* creature, uint32_t newSpeed) const;
 		void sendCreatureHealth(const Creature* creature) const;
-		void sendDistanceShoot(const Position& from, const Position& to, uint8_t type) const;
+		void sendDistanceShoot(const Position& from, const Position& to, uint8_t type, const NetworkFragment_ptr& fragment = NetworkFragment_ptr()) const;
 		void sendHouseWindow(House* house, uint32_t listId) const;
 		void sendOutfitWindow() const;
 		void sendQuests() const;
@@ -505,14 +508,15 @@ private:
 		void sendCreatePrivateChannel(uint16_t channelId, const std::string& channelName);
 		void sendClosePrivate(uint16_t channelId) const;
 		void sendIcons() const;
-		void sendMagicEffect(const Position& pos, uint8_t type) const;
+		void sendMagicEffect(const Position& pos, uint8_t type, const NetworkFragment_ptr& fragment = NetworkFragment_ptr()) const;
 		void sendStats();
 		void sendSkills() const;
 		void sendTextMessage(MessageClasses type, const std::string& message) const;
 		void sendReLoginWindow() const;
 		void sendTextWindow(Item* item, uint16_t maxLen, bool canWrite) const;
 		void sendTextWindow(uint32_t itemId, const std::string& text) const;
-		void sendToChannel(Creature* creature, SpeakClasses type, const std::string& text, uint16_t channelId, uint32_t time = 0) const;
+		void sendToChannel(Creature* creature, SpeakClasses type, const std::string& text, uint16_t channelId, uint32_t time = 0,
+			const NetworkFragment_ptr& fragment = NetworkFragment_ptr()) const;
 		void sendShop() const;
 		void sendGoods() const;
 		void sendCloseShop() const;
@@ -650,6 +654,7 @@ private:
 		bool inventoryAbilities[11];
 		bool pzLocked;
 		bool saving;
+		bool storageChanged;
 		bool isConnecting;
 		bool requestedOutfit;
 		bool outfitAttributes;
@@ -751,6 +756,11 @@ private:
 		OutfitMap outfits;
 		LearnedInstantSpellList learnedInstantSpellList;
 
+		// rows of the last snapshot, used to only save what changed since then
+		PlayerSnapshot::ItemRowsP savedDepotItems;
+		PlayerSnapshot::ItemRowsP savedItems;
+		PlayerSnapshot::StorageRowsP savedStorage;
+
 	private:
 
 		friend class Game;
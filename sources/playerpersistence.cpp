@@ -0,0 +1,686 @@
+////////////////////////////////////////////////////////////////////////
+// OpenTibia - an opensource roleplaying game
+////////////////////////////////////////////////////////////////////////
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+////////////////////////////////////////////////////////////////////////
+
+
+#include "otpch.h"
+
+#include "playerpersistence.h"
+
+#include "configmanager.h"
+#include "database.h"
+#include "databasemanager.h"
+#include "server.h"
+
+
+LOGGER_DEFINITION(PlayerPersistence);
+
+
+
+namespace {
+
+void diffItems(const PlayerSnapshot::ItemRows& previousRows, const PlayerSnapshot::ItemRows& rows, std::vector<const PlayerSnapshot::ItemRow*>& changedRows, std::vector<int32_t>& removedSlotIds) {
+	std::unordered_map<int32_t,const PlayerSnapshot::ItemRow*> previousRowsBySlot;
+	for (const auto& previousRow : previousRows) {
+		previousRowsBySlot[previousRow.slotId] = &previousRow;
+	}
+
+	for (const auto& row : rows) {
+		auto previous = previousRowsBySlot.find(row.slotId);
+		if (previous == previousRowsBySlot.end()) {
+			changedRows.push_back(&row);
+			continue;
+		}
+
+		const auto& previousRow = *previous->second;
+		if (row.parentId != previousRow.parentId || row.itemType != previousRow.itemType || row.count != previousRow.count || row.attributes != previousRow.attributes) {
+			changedRows.push_back(&row);
+		}
+
+		previousRowsBySlot.erase(previous);
+	}
+
+	for (const auto& previous : previousRowsBySlot) {
+		removedSlotIds.push_back(previous.first);
+	}
+}
+
+
+void diffStorage(const PlayerSnapshot::StorageRows& previousRows, const PlayerSnapshot::StorageRows& rows, std::vector<const PlayerSnapshot::StorageRows::value_type*>& changedRows, std::vector<uint32_t>& removedKeys) {
+	std::unordered_map<uint32_t,const std::string*> previousValues;
+	for (const auto& previousRow : previousRows) {
+		previousValues[previousRow.first] = &previousRow.second;
+	}
+
+	for (const auto& row : rows) {
+		auto previous = previousValues.find(row.first);
+		if (previous == previousValues.end()) {
+			changedRows.push_back(&row);
+			continue;
+		}
+
+		if (row.second != *previous->second) {
+			changedRows.push_back(&row);
+		}
+
+		previousValues.erase(previous);
+	}
+
+	for (const auto& previous : previousValues) {
+		removedKeys.push_back(previous.first);
+	}
+}
+
+
+template<typename T>
+std::string join(const std::vector<T>& values) {
+	std::ostringstream joined;
+	for (auto it = values.cbegin(); it != values.cend(); ++it) {
+		if (it != values.cbegin()) {
+			joined << ", ";
+		}
+
+		joined << *it;
+	}
+
+	return joined.str();
+}
+
+
+std::string joinGuids(const std::vector<PlayerSnapshot*>& snapshots) {
+	std::ostringstream guids;
+	for (auto it = snapshots.cbegin(); it != snapshots.cend(); ++it) {
+		if (it != snapshots.cbegin()) {
+			guids << ", ";
+		}
+
+		guids << (*it)->guid;
+	}
+
+	return guids.str();
+}
+
+
+bool writeItems(Database& database, const std::string& table, const std::vector<PlayerSnapshot*>& snapshots, PlayerSnapshot::ItemRowsP PlayerSnapshot::*rowsMember, PlayerSnapshot::ItemRowsP PlayerSnapshot::*previousRowsMember) {
+	std::vector<PlayerSnapshot*> fullSnapshots;
+	for (auto snapshot : snapshots) {
+		if (snapshot->*previousRowsMember == nullptr) {
+			fullSnapshots.push_back(snapshot);
+		}
+	}
+
+	std::ostringstream query;
+	if (!fullSnapshots.empty()) {
+		query << "DELETE FROM `" << table << "` WHERE `player_id` IN (" << joinGuids(fullSnapshots) << ")";
+		if (!database.executeQuery(query.str())) {
+			return false;
+		}
+	}
+
+	DBInsert insert(database);
+	insert.setQuery("INSERT INTO `" + table + "` (`player_id`, `pid`, `sid`, `itemtype`, `count`, `attributes`) VALUES ");
+	insert.setSuffix(" ON DUPLICATE KEY UPDATE `pid` = VALUES(`pid`), `itemtype` = VALUES(`itemtype`), `count` = VALUES(`count`), `attributes` = VALUES(`attributes`)");
+
+	for (auto snapshot : snapshots) {
+		const auto& rows = snapshot->*rowsMember;
+		const auto& previousRows = snapshot->*previousRowsMember;
+		if (rows == previousRows) {
+			continue;
+		}
+
+		std::vector<const PlayerSnapshot::ItemRow*> changedRows;
+		std::vector<int32_t> removedSlotIds;
+
+		if (previousRows == nullptr) {
+			for (const auto& row : *rows) {
+				changedRows.push_back(&row);
+			}
+		}
+		else {
+			diffItems(*previousRows, *rows, changedRows, removedSlotIds);
+		}
+
+		if (!removedSlotIds.empty()) {
+			query.str("");
+			query << "DELETE FROM `" << table << "` WHERE `player_id` = " << snapshot->guid << " AND `sid` IN (" << join(removedSlotIds) << ")";
+			if (!database.executeQuery(query.str())) {
+				return false;
+			}
+		}
+
+		for (auto row : changedRows) {
+			std::stringstream values;
+			values << snapshot->guid << ", " << row->parentId << ", " << row->slotId << ", " << row->itemType << ", " << row->count << ", "
+				<< database.escapeBlob(row->attributes.data(), row->attributes.size());
+
+			if (!insert.addRow(values)) {
+				return false;
+			}
+		}
+	}
+
+	return insert.execute();
+}
+
+
+bool writeStorage(Database& database, const std::vector<PlayerSnapshot*>& snapshots) {
+	std::vector<PlayerSnapshot*> fullSnapshots;
+	for (auto snapshot : snapshots) {
+		if (snapshot->previousStorage == nullptr) {
+			fullSnapshots.push_back(snapshot);
+		}
+	}
+
+	std::ostringstream query;
+	if (!fullSnapshots.empty()) {
+		query << "DELETE FROM `player_storage` WHERE `player_id` IN (" << joinGuids(fullSnapshots) << ")";
+		if (!database.executeQuery(query.str())) {
+			return false;
+		}
+	}
+
+	DBInsert insert(database);
+	insert.setQuery("INSERT INTO `player_storage` (`player_id`, `key`, `value`) VALUES ");
+	insert.setSuffix(" ON DUPLICATE KEY UPDATE `value` = VALUES(`value`)");
+
+	for (auto snapshot : snapshots) {
+		// an unchanged storage is passed on from one snapshot to the next
+		if (snapshot->storage == snapshot->previousStorage) {
+			continue;
+		}
+
+		std::vector<const PlayerSnapshot::StorageRows::value_type*> changedRows;
+		std::vector<uint32_t> removedKeys;
+
+		if (snapshot->previousStorage == nullptr) {
+			for (const auto& row : *snapshot->storage) {
+				changedRows.push_back(&row);
+			}
+		}
+		else {
+			diffStorage(*snapshot->previousStorage, *snapshot->storage, changedRows, removedKeys);
+		}
+
+		if (!removedKeys.empty()) {
+			query.str("");
+			query << "DELETE FROM `player_storage` WHERE `player_id` = " << snapshot->guid << " AND `key` IN (" << join(removedKeys) << ")";
+			if (!database.executeQuery(query.str())) {
+				return false;
+			}
+		}
+
+		for (auto row : changedRows) {
+			std::stringstream values;
+			values << snapshot->guid << ", " << row->first << ", " << database.escapeString(row->second);
+
+			if (!insert.addRow(values)) {
+				return false;
+			}
+		}
+	}
+
+	return insert.execute();
+}
+
+} // namespace
+
+
+
+PlayerPersistence::PlayerPersistence()
+	: _state(State::STOPPED),
+	  _statisticsBatchCount(0),
+	  _statisticsMaximumBatchDuration(Duration::zero()),
+	  _statisticsSnapshotCount(0),
+	  _statisticsWriteDuration(Duration::zero())
+{
+}
+
+
+PlayerPersistence::~PlayerPersistence() {
+	if (_state != State::STOPPED) {
+		LOGe("Player persistence deleted but not yet stopped. Forgot to call waitUntilStopped()?");
+		assert(_state == State::STOPPED);
+
+		if (_state == State::STARTED) {
+			stop();
+		}
+
+		waitUntilStopped();
+	}
+}
+
+
+void PlayerPersistence::addSnapshot(PlayerSnapshotP snapshot) {
+	if (snapshot == nullptr) {
+		assert(snapshot != nullptr);
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	if (_state != State::STARTED) {
+		LOGe("Cannot save player " << snapshot->name << " because player persistence isn't running.");
+		return;
+	}
+
+	++_pendingGuids[snapshot->guid];
+	_snapshots.push_back(std::move(snapshot));
+
+	_signal.notify_one();
+}
+
+
+size_t PlayerPersistence::getQueueSize() {
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	return _snapshots.size();
+}
+
+
+PlayerPersistence::State PlayerPersistence::getState() {
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	return _state;
+}
+
+
+bool PlayerPersistence::isSaving(uint32_t guid) {
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	return _pendingGuids.count(guid) > 0;
+}
+
+
+void PlayerPersistence::recordBatch(size_t snapshotCount, Duration duration) {
+	++_statisticsBatchCount;
+	_statisticsSnapshotCount += snapshotCount;
+	_statisticsWriteDuration += duration;
+
+	if (duration > _statisticsMaximumBatchDuration) {
+		_statisticsMaximumBatchDuration = duration;
+	}
+
+	LOGd("Saved " << snapshotCount << " players in " << std::chrono::duration_cast<Milliseconds>(duration).count() << " ms. "
+		<< "Saved " << _statisticsSnapshotCount << " players in " << _statisticsBatchCount << " batches so far, "
+		<< "average batch latency " << std::chrono::duration_cast<Milliseconds>(_statisticsWriteDuration / _statisticsBatchCount).count() << " ms, "
+		<< "maximum batch latency " << std::chrono::duration_cast<Milliseconds>(_statisticsMaximumBatchDuration).count() << " ms.");
+}
+
+
+void PlayerPersistence::retryLogout(Database& database, PlayerSnapshot* snapshot) {
+	if (write(database, std::vector<PlayerSnapshot*>(1, snapshot))) {
+		return;
+	}
+
+	// like synchronous saving, the character is marked offline anyway so that it can log in again
+	LOGe("Player " << snapshot->name << " couldn't be saved on logout and loses the progress since the last save.");
+
+	std::ostringstream query;
+	query << "UPDATE `players` SET `online` = " << (snapshot->allowClones ? "IF(`online` > 0, `online` - 1, 0)" : "0")
+		<< " WHERE `id` = " << snapshot->guid << database.getUpdateLimiter();
+	if (!database.executeQuery(query.str())) {
+		LOGe("Player " << snapshot->name << " couldn't be marked offline.");
+	}
+}
+
+
+void PlayerPersistence::start() {
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	if (_state == State::STOPPED) {
+		_state = State::STARTED;
+		_thread = std::thread(&PlayerPersistence::thread, this);
+	}
+	else {
+		LOGe("Cannot start player persistence unless it is stopped.");
+		assert(_state == State::STOPPED);
+	}
+}
+
+
+void PlayerPersistence::stop() {
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	if (_state == State::STARTED) {
+		_state = State::STOPPING;
+		_signal.notify_one();
+	}
+	else {
+		LOGe("Cannot stop player persistence unless it is running.");
+		assert(_state == State::STARTED);
+	}
+}
+
+
+void PlayerPersistence::thread() {
+	auto database = server.databaseManager().createDatabase();
+	database->start();
+
+	std::unique_lock<std::mutex> uniqueLock(_mutex);
+
+	while (true) {
+		while (_snapshots.empty() && _state == State::STARTED) {
+			_signal.wait(uniqueLock);
+		}
+
+		if (_snapshots.empty()) {
+			break;
+		}
+
+		// a player must not appear twice in one batch so that the later snapshot is written after the earlier one
+		auto batchSize = static_cast<size_t>(std::max(server.configManager().getNumber(ConfigManager::PLAYER_SAVE_BATCH_SIZE), 1));
+		std::vector<PlayerSnapshotP> batch;
+		std::unordered_set<uint32_t> batchGuids;
+
+		while (!_snapshots.empty() && batch.size() < batchSize && batchGuids.insert(_snapshots.front()->guid).second) {
+			batch.push_back(std::move(_snapshots.front()));
+			_snapshots.pop_front();
+		}
+
+		uniqueLock.unlock();
+
+		std::vector<PlayerSnapshot*> snapshots;
+		for (auto& snapshot : batch) {
+			snapshots.push_back(snapshot.get());
+		}
+
+		auto startTime = Clock::now();
+
+		std::vector<PlayerSnapshot*> failedSnapshots;
+		write(*database, snapshots, &failedSnapshots);
+
+		recordBatch(snapshots.size(), Clock::now() - startTime);
+
+		// done before the player's pending saves drop so that logging in again waits for it
+		for (auto snapshot : failedSnapshots) {
+			if (snapshot->logout) {
+				retryLogout(*database, snapshot);
+			}
+		}
+
+		uniqueLock.lock();
+
+		for (auto snapshot : snapshots) {
+			auto pending = _pendingGuids.find(snapshot->guid);
+			if (pending != _pendingGuids.end() && --pending->second == 0) {
+				_pendingGuids.erase(pending);
+			}
+		}
+
+		_savedSignal.notify_all();
+	}
+
+	_state = State::STOPPED;
+	_savedSignal.notify_all();
+}
+
+
+void PlayerPersistence::waitUntilSaved(uint32_t guid) {
+	std::unique_lock<std::mutex> uniqueLock(_mutex);
+
+	while (_pendingGuids.count(guid) > 0 && _state != State::STOPPED) {
+		_savedSignal.wait(uniqueLock);
+	}
+}
+
+
+void PlayerPersistence::waitUntilStopped() {
+	_mutex.lock();
+
+	if (_state == State::STARTED) {
+		LOGe("Cannot wait for player persistence to stop because stopping wasn't requested.");
+		assert(_state != State::STARTED);
+
+		_mutex.unlock();
+		return;
+	}
+
+	_mutex.unlock();
+
+	if (_thread.joinable()) {
+		_thread.join();
+	}
+}
+
+
+bool PlayerPersistence::write(Database& database, const std::vector<PlayerSnapshot*>& snapshots, std::vector<PlayerSnapshot*>* failedSnapshots) {
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+
+		// the database doesn't contain the previous rows of a player whose last write failed
+		for (auto snapshot : snapshots) {
+			if (snapshot->items != nullptr && _fullWriteGuids.erase(snapshot->guid) > 0) {
+				snapshot->previousDepotItems = nullptr;
+				snapshot->previousItems = nullptr;
+				snapshot->previousStorage = nullptr;
+			}
+		}
+	}
+
+	std::vector<uint32_t> unwrittenGuids;
+
+	bool written = writeSnapshots(database, snapshots, unwrittenGuids);
+	if (!written) {
+		// retry one by one so that a single broken player doesn't prevent the others from being saved
+		unwrittenGuids.clear();
+
+		written = true;
+		for (auto snapshot : snapshots) {
+			if (!writeSnapshots(database, std::vector<PlayerSnapshot*>(1, snapshot), unwrittenGuids)) {
+				LOGe("Player " << snapshot->name << " couldn't be saved.");
+
+				unwrittenGuids.push_back(snapshot->guid);
+				written = false;
+
+				if (failedSnapshots != nullptr) {
+					failedSnapshots->push_back(snapshot);
+				}
+			}
+		}
+	}
+
+	if (!unwrittenGuids.empty()) {
+		std::lock_guard<std::mutex> lock(_mutex);
+		_fullWriteGuids.insert(unwrittenGuids.cbegin(), unwrittenGuids.cend());
+	}
+
+	return written;
+}
+
+
+bool PlayerPersistence::writeSnapshots(Database& database, const std::vector<PlayerSnapshot*>& snapshots, std::vector<uint32_t>& unwrittenGuids) {
+	if (snapshots.empty()) {
+		return true;
+	}
+
+	std::unordered_set<uint32_t> savablePlayers;
+	std::unordered_set<uint32_t> existingPlayers;
+
+	std::ostringstream query;
+	query << "SELECT `id`, `save` FROM `players` WHERE `id` IN (" << joinGuids(snapshots) << ")";
+
+	if (auto result = database.storeQuery(query.str())) {
+		do {
+			existingPlayers.insert(result->getDataInt("id"));
+			if (result->getDataInt("save")) {
+				savablePlayers.insert(result->getDataInt("id"));
+			}
+		} while (result->next());
+	}
+
+	DBTransaction transaction(database);
+	if (!transaction.begin()) {
+		return false;
+	}
+
+	std::vector<PlayerSnapshot*> rowSnapshots;
+
+	for (auto snapshot : snapshots) {
+		if (existingPlayers.count(snapshot->guid) == 0) {
+			LOGe("Cannot save player " << snapshot->name << " because the character no longer exists.");
+
+			unwrittenGuids.push_back(snapshot->guid);
+			continue;
+		}
+
+		bool saving = snapshot->saving && savablePlayers.count(snapshot->guid) > 0;
+
+		query.str("");
+		query << "UPDATE `players` SET `lastlogin` = " << snapshot->lastLogin << ", `lastip` = " << snapshot->lastIp;
+
+		if (saving) {
+			query << ", " << snapshot->columns;
+			query << ", `conditions` = " << database.escapeBlob(snapshot->conditions.data(), snapshot->conditions.size());
+
+			if (snapshot->hasDescription) {
+				query << ", `description` = " << database.escapeString(snapshot->description);
+			}
+
+			if (snapshot->ingameGuildManagement) {
+				query << ", `guildnick` = " << database.escapeString(snapshot->guildNick);
+				query << ", `rank_id` = COALESCE((SELECT `id` FROM `guild_ranks` WHERE `guild_id` = " << snapshot->guildId << " AND `level` = " << snapshot->guildLevel << " LIMIT 1), 0)";
+			}
+		}
+
+		// a player is only marked offline together with the last save so that nobody loads the character with stale data
+		if (snapshot->logout) {
+			query << ", `online` = " << (snapshot->allowClones ? "IF(`online` > 0, `online` - 1, 0)" : "0");
+		}
+
+		query << " WHERE `id` = " << snapshot->guid << database.getUpdateLimiter();
+		if (!database.executeQuery(query.str())) {
+			return false;
+		}
+
+		if (!saving) {
+			if (snapshot->items != nullptr) {
+				unwrittenGuids.push_back(snapshot->guid);
+			}
+
+			continue;
+		}
+
+		for (int32_t skill = SKILL_FIRST; skill <= SKILL_LAST; ++skill) {
+			query.str("");
+			query << "UPDATE `player_skills` SET `value` = " << snapshot->skills[skill][SKILL_LEVEL] << ", `count` = " << snapshot->skills[skill][SKILL_TRIES]
+				<< " WHERE `player_id` = " << snapshot->guid << " AND `skillid` = " << skill << database.getUpdateLimiter();
+			if (!database.executeQuery(query.str())) {
+				return false;
+			}
+		}
+
+		if (snapshot->items != nullptr) {
+			rowSnapshots.push_back(snapshot);
+		}
+	}
+
+	if (rowSnapshots.empty()) {
+		return transaction.commit();
+	}
+
+	DBInsert insert(database);
+
+	query.str("");
+	query << "DELETE FROM `player_spells` WHERE `player_id` IN (" << joinGuids(rowSnapshots) << ")";
+	if (!database.executeQuery(query.str())) {
+		return false;
+	}
+
+	insert.setQuery("INSERT INTO `player_spells` (`player_id`, `name`) VALUES ");
+	for (auto snapshot : rowSnapshots) {
+		for (const auto& spell : snapshot->spells) {
+			std::stringstream values;
+			values << snapshot->guid << ", " << database.escapeString(spell);
+
+			if (!insert.addRow(values)) {
+				return false;
+			}
+		}
+	}
+
+	if (!insert.execute()) {
+		return false;
+	}
+
+	if (!writeItems(database, "player_items", rowSnapshots, &PlayerSnapshot::items, &PlayerSnapshot::previousItems)) {
+		return false;
+	}
+
+	if (!writeItems(database, "player_depotitems", rowSnapshots, &PlayerSnapshot::depotItems, &PlayerSnapshot::previousDepotItems)) {
+		return false;
+	}
+
+	if (!writeStorage(database, rowSnapshots)) {
+		return false;
+	}
+
+	for (auto snapshot : rowSnapshots) {
+		if (snapshot->ingameGuildManagement) {
+			query.str("");
+			query << "DELETE FROM `guild_invites` WHERE `player_id` = " << snapshot->guid;
+			if (!database.executeQuery(query.str())) {
+				return false;
+			}
+
+			insert.setQuery("INSERT INTO `guild_invites` (`player_id`, `guild_id`) VALUES ");
+			for (auto guildId : snapshot->guildInvites) {
+				std::stringstream values;
+				values << snapshot->guid << ", " << guildId;
+
+				if (!insert.addRow(values)) {
+					return false;
+				}
+			}
+
+			if (!insert.execute()) {
+				return false;
+			}
+		}
+
+		query.str("");
+		if (snapshot->vipListPerPlayer) {
+			query << "DELETE FROM `player_viplist` WHERE `player_id` = " << snapshot->guid;
+		}
+		else {
+			query << "DELETE FROM `account_viplist` WHERE `account_id` = " << snapshot->accountId << " AND `world_id` = " << snapshot->worldId;
+		}
+
+		if (!database.executeQuery(query.str())) {
+			return false;
+		}
+
+		if (snapshot->vips.empty()) {
+			continue;
+		}
+
+		// only entries of players which still exist are kept
+		query.str("");
+		if (snapshot->vipListPerPlayer) {
+			query << "INSERT INTO `player_viplist` (`player_id`, `vip_id`) SELECT " << snapshot->guid << ", `id`";
+		}
+		else {
+			query << "INSERT INTO `account_viplist` (`account_id`, `world_id`, `player_id`) SELECT " << snapshot->accountId << ", " << snapshot->worldId << ", `id`";
+		}
+
+		query << " FROM `players` WHERE `id` IN (" << join(snapshot->vips) << ") AND `deleted` = 0 AND `world_id` = " << snapshot->worldId;
+
+		if (!database.executeQuery(query.str())) {
+			return false;
+		}
+	}
+
+	return transaction.commit();
+}
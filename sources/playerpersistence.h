@@ -0,0 +1,142 @@
+////////////////////////////////////////////////////////////////////////
+// OpenTibia - an opensource roleplaying game
+////////////////////////////////////////////////////////////////////////
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+////////////////////////////////////////////////////////////////////////
+
+
+#ifndef _PLAYERPERSISTENCE_H
+#define _PLAYERPERSISTENCE_H
+
+#include "const.h"
+
+class Database;
+
+
+// Everything needed to write a player to the database, copied on the dispatcher thread so that the player may change
+// or be deleted while the snapshot waits to be written.
+struct PlayerSnapshot {
+
+	struct ItemRow {
+		int32_t     parentId;
+		int32_t     slotId;
+		uint16_t    itemType;
+		int32_t     count;
+		std::string attributes;
+	};
+
+	typedef std::vector<ItemRow>                          ItemRows;
+	typedef Shared<const ItemRows>                        ItemRowsP;
+	typedef std::vector<std::pair<uint32_t, std::string>> StorageRows;
+	typedef Shared<const StorageRows>                     StorageRowsP;
+
+
+	uint32_t                 accountId;
+	bool                     allowClones;
+	std::string              columns;
+	std::string              conditions;
+	ItemRowsP                depotItems;
+	std::string              description;
+	uint32_t                 guid;
+	uint32_t                 guildId;
+	std::vector<uint32_t>    guildInvites;
+	uint32_t                 guildLevel;
+	std::string              guildNick;
+	bool                     hasDescription;
+	bool                     ingameGuildManagement;
+	ItemRowsP                items;
+	uint32_t                 lastIp;
+	time_t                   lastLogin;
+	bool                     logout;
+	std::string              name;
+	bool                     saving;
+	bool                     shallow;
+	int32_t                  skills[SKILL_LAST + 1][2];
+	std::vector<std::string> spells;
+	StorageRowsP             storage;
+	bool                     vipListPerPlayer;
+	std::vector<uint32_t>    vips;
+	int32_t                  worldId;
+
+	// rows which are already in the database so that only changed rows are written, or nullptr to rewrite all rows
+	ItemRowsP                previousDepotItems;
+	ItemRowsP                previousItems;
+	StorageRowsP             previousStorage;
+
+};
+
+typedef Unique<PlayerSnapshot>  PlayerSnapshotP;
+
+
+
+// Writes player snapshots on a separate thread with its own database connection. Snapshots are written in the order
+// they were queued and several of them share one transaction. Items and storage are written as a delta against the
+// previous snapshot of the same player unless writing one of that player's snapshots failed. A logout snapshot which
+// cannot be written is retried once more, after which the character is marked offline anyway.
+class PlayerPersistence {
+
+public:
+
+	enum class State {
+		STOPPED,
+		STARTED,
+		STOPPING,
+	};
+
+
+	PlayerPersistence();
+	~PlayerPersistence();
+
+	void   addSnapshot          (PlayerSnapshotP snapshot);
+	size_t getQueueSize         ();
+	State  getState             ();
+	bool   isSaving             (uint32_t guid);
+	void   start                ();
+	void   stop                 ();
+	void   waitUntilSaved       (uint32_t guid);
+	void   waitUntilStopped     ();
+	bool   write                (Database& database, const std::vector<PlayerSnapshot*>& snapshots, std::vector<PlayerSnapshot*>* failedSnapshots = nullptr);
+
+
+private:
+
+	typedef std::deque<PlayerSnapshotP>  SnapshotDeque;
+
+
+	void recordBatch           (size_t snapshotCount, Duration duration);
+	void retryLogout           (Database& database, PlayerSnapshot* snapshot);
+	void thread                ();
+
+	static bool writeSnapshots (Database& database, const std::vector<PlayerSnapshot*>& snapshots, std::vector<uint32_t>& unwrittenGuids);
+
+
+	LOGGER_DECLARATION;
+
+	std::unordered_set<uint32_t>          _fullWriteGuids;
+	std::mutex                            _mutex;
+	std::unordered_map<uint32_t,uint32_t> _pendingGuids;
+	std::condition_variable               _savedSignal;
+	std::condition_variable               _signal;
+	SnapshotDeque                         _snapshots;
+	volatile State                        _state;
+	std::thread                           _thread;
+
+	uint64_t                              _statisticsBatchCount;
+	Duration                              _statisticsMaximumBatchDuration;
+	uint64_t                              _statisticsSnapshotCount;
+	Duration                              _statisticsWriteDuration;
+
+};
+
+#endif // _PLAYERPERSISTENCE_H
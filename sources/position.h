@@ -220,7 +220,8 @@ namespace std {
 template<>
 struct hash<Position> : public function<size_t(const Position&)> {
 	result_type operator()(argument_type position) const {
-		return hash<typeof(position.x)>()(position.x) ^ hash<typeof(position.y)>()(position.y) ^ hash<typeof(position.z)>()(position.z);
+		// combining the coordinates with xor would map nearby positions to a few hashes, e.g. all positions with x == y to 0
+		return hash<uint64_t>()(static_cast<uint64_t>(position.x) | (static_cast<uint64_t>(position.y) << 16) | (static_cast<uint64_t>(position.z) << 32));
 	}
 };
 
@@ -26,12 +26,14 @@
 #include "server.h"
 #include "tools.h"
 #include "rsa.h"
+#include "xtea.h"
 
 
 LOGGER_DEFINITION(Protocol);
 
 
 extern RSA g_RSA;
+extern RSAWorkerPool g_RSAWorkerPool;
 
 void Protocol::onSendMessage(OutputMessage_ptr msg)
 {
@@ -104,10 +106,6 @@ void Protocol::deleteProtocolTask()
 
 void Protocol::XTEA_encrypt(OutputMessage& msg)
 {
-	uint32_t k[4];
-	for(uint8_t i = 0; i < 4; i++)
-		k[i] = m_key[i];
-
 	int32_t messageLength = msg.getMessageLength();
 	//add bytes until reach 8 multiple
 	uint32_t n;
@@ -118,22 +116,7 @@ void Protocol::XTEA_encrypt(OutputMessage& msg)
 		messageLength = messageLength + n;
 	}
 
-	int32_t readPos = 0;
-	uint32_t* buffer = (uint32_t*)msg.getOutputBuffer();
-	while(readPos < messageLength / 4)
-	{
-		uint32_t v0 = buffer[readPos], v1 = buffer[readPos + 1], delta = 0x61C88647, sum = 0;
-		for(int32_t i = 0; i < 32; i++)
-		{
-			v0 += ((v1 << 4 ^ v1 >> 5) + v1) ^ (sum + k[sum & 3]);
-			sum -= delta;
-			v1 += ((v0 << 4 ^ v0 >> 5) + v0) ^ (sum + k[sum>>11 & 3]);
-		}
-
-		buffer[readPos] = v0;
-		buffer[readPos + 1] = v1;
-		readPos += 2;
-	}
+	xteaEncrypt((uint32_t*)msg.getOutputBuffer(), messageLength / 8, m_key);
 }
 
 bool Protocol::XTEA_decrypt(NetworkMessage& msg)
@@ -144,26 +127,8 @@ bool Protocol::XTEA_decrypt(NetworkMessage& msg)
 		return false;
 	}
 
-	uint32_t k[4];
-	for(uint8_t i = 0; i < 4; i++)
-		k[i] = m_key[i];
-
-	int32_t messageLength = msg.getMessageLength() - 6, readPos = 0;
-	uint32_t* buffer = (uint32_t*)(msg.getBuffer() + msg.getReadPos());
-	while(readPos < messageLength / 4)
-	{
-		uint32_t v0 = buffer[readPos], v1 = buffer[readPos + 1], delta = 0x61C88647, sum = 0xC6EF3720;
-		for(int32_t i = 0; i < 32; i++)
-		{
-			v1 -= ((v0 << 4 ^ v0 >> 5) + v0) ^ (sum + k[sum>>11 & 3]);
-			sum += delta;
-			v0 -= ((v1 << 4 ^ v1 >> 5) + v1) ^ (sum + k[sum & 3]);
-		}
-
-		buffer[readPos] = v0;
-		buffer[readPos + 1] = v1;
-		readPos += 2;
-	}
+	int32_t messageLength = msg.getMessageLength() - 6;
+	xteaDecrypt((uint32_t*)(msg.getBuffer() + msg.getReadPos()), messageLength / 8, m_key);
 	//
 
 	int32_t tmp = msg.GetU16();
@@ -198,6 +163,49 @@ bool Protocol::RSA_decrypt(RSA* rsa, NetworkMessage& msg)
 	return false;
 }
 
+void Protocol::RSA_decryptAsync(NetworkMessage& msg, const DecryptedMessageHandler& handler)
+{
+	Connection_ptr connection = getConnection();
+	if(!connection)
+		return;
+
+	if(msg.getMessageLength() - msg.getReadPos() != 128)
+	{
+		LOGe("[Protocol::RSA_decryptAsync] Not valid packet size");
+		connection->close();
+		return;
+	}
+
+	// the connection reuses its message buffer for the next packet while the worker is busy
+	Shared<NetworkMessage> decryptedMsg = std::make_shared<NetworkMessage>(msg);
+
+	// the next packet is encrypted with the key which is part of this one
+	connection->pauseReading();
+
+	// keeps the protocol alive until the handler ran, see releaseProtocol(). The reference is also released if the
+	// handler is destroyed without running, e.g. when the io_service stops first.
+	addRef();
+	Shared<void> reference(nullptr, [this](void*) { unRef(); });
+
+	g_RSAWorkerPool.decrypt((decryptedMsg->getBuffer() + decryptedMsg->getReadPos()), [this, connection, decryptedMsg, handler, reference]() {
+		connection->getService().post([this, decryptedMsg, handler, reference]() {
+			Connection_ptr connection = getConnection();
+			if(!connection)
+				return;
+
+			if(decryptedMsg->GetByte())
+			{
+				LOGe("[Protocol::RSA_decryptAsync] First byte != 0");
+				connection->close();
+				return;
+			}
+
+			handler(*decryptedMsg);
+			connection->resumeReading();
+		});
+	});
+}
+
 uint32_t Protocol::getLocalIP() const
 {
 	if(getConnection())
@@ -75,6 +75,10 @@ class Protocol : boost::noncopyable
 		bool RSA_decrypt(NetworkMessage& msg);
 		bool RSA_decrypt(RSA* rsa, NetworkMessage& msg);
 
+		// decrypts the login block on an RSA worker and continues with handler on the network thread
+		typedef std::function<void(NetworkMessage& msg)> DecryptedMessageHandler;
+		void RSA_decryptAsync(NetworkMessage& msg, const DecryptedMessageHandler& handler);
+
 		virtual void releaseProtocol();
 		virtual void deleteProtocolTask();
 
@@ -86,7 +90,7 @@ class Protocol : boost::noncopyable
 
 		OutputMessage_ptr m_outputBuffer;
 		Connection_ptr m_connection;
-		uint32_t m_refCount;
+		std::atomic<int32_t> m_refCount;
 
 		bool m_rawMessages, m_encryptionEnabled, m_checksumEnabled;
 		uint32_t m_key[4];
@@ -147,7 +147,8 @@ bool ProtocolGame::login(const std::string& name, uint32_t id, const std::string
 		ban.param = PLAYERBAN_BANISHMENT;
 
 		ban.type = BAN_PLAYER;
-		if(IOBan::getInstance()->getData(ban) && !player->hasFlag(PlayerFlag_CannotBeBanned))
+		if(IOBan::getInstance()->isPlayerBanished(ban.value, PLAYERBAN_BANISHMENT) && IOBan::getInstance()->getData(ban)
+			&& !player->hasFlag(PlayerFlag_CannotBeBanned))
 		{
 			bool deletion = ban.expires < 0;
 			std::string name_ = "Automatic ";
@@ -404,6 +405,7 @@ bool ProtocolGame::connect(uint32_t playerId, OperatingSystem_t operatingSystem,
 	player->isConnecting = false;
 
 	player->client = this;
+	server.world().updatePlayerIp(player);
 	player->sendCreatureAppear(player, BOOST_CURRENT_FUNCTION);
 
 	player->setOperatingSystem(operatingSystem);
@@ -467,12 +469,12 @@ bool ProtocolGame::parseFirstPacket(NetworkMessage& msg)
 
 	OperatingSystem_t operatingSystem = (OperatingSystem_t)msg.GetU16();
 	uint16_t version = msg.GetU16();
-	if(!RSA_decrypt(msg))
-	{
-		getConnection()->close();
-		return false;
-	}
+	RSA_decryptAsync(msg, std::bind(&ProtocolGame::parseDecryptedFirstPacket, this, std::placeholders::_1, operatingSystem, version));
+	return true;
+}
 
+bool ProtocolGame::parseDecryptedFirstPacket(NetworkMessage& msg, OperatingSystem_t operatingSystem, uint16_t version)
+{
 	uint32_t key[4] = {msg.GetU32(), msg.GetU32(), msg.GetU32(), msg.GetU32()};
 	enableXTEAEncryption();
 	setXTEAKey(key);
@@ -545,7 +547,8 @@ bool ProtocolGame::parseFirstPacket(NetworkMessage& msg)
 	ban.value = id;
 
 	ban.type = BAN_ACCOUNT;
-	if(IOBan::getInstance()->getData(ban) && !IOLoginData::getInstance()->hasFlag(id, PlayerFlag_CannotBeBanned))
+	if(IOBan::getInstance()->isAccountBanished(id) && IOBan::getInstance()->getData(ban)
+		&& !IOLoginData::getInstance()->hasFlag(id, PlayerFlag_CannotBeBanned))
 	{
 		bool deletion = ban.expires < 0;
 		std::string name_ = "Automatic ";
@@ -906,35 +909,24 @@ void ProtocolGame::parsePacket(NetworkMessage &msg)
 	}
 }
 
-void ProtocolGame::GetTileDescription(const Tile* tile, NetworkMessage_ptr msg)
+void ProtocolGame::GetTileDescription(const Tile* tile, const Position& position, NetworkMessage_ptr msg)
 {
 	if(!tile)
 		return;
 
-	LOGt("ProtocolGame(" << player->getName() << ")::GetTileDescription(tile.position = " << tile->getPosition() << ")");
+	LOGt("ProtocolGame(" << player->getName() << ")::GetTileDescription(position = " << position << ")");
 
 
-	int32_t count = 0;
-	if(tile->ground)
-	{
-		msg->AddItem(tile->ground.get());
-		count++;
-	}
+	// items are the same for every client, so their bytes are encoded once until the tile changes
+	const Tile::EncodedItems& encodedItems = tile->getEncodedItems();
+	msg->AddBytes(encodedItems.bytes.data(), encodedItems.downItemsOffset);
 
-	invalidateCreaturesAtPosition(tile->getPosition());
+	int32_t count = encodedItems.topThingCount;
+	assert(count <= 10);
 
-	const TileItemVector* items = tile->getItemList();
-	const CreatureVector* creatures = tile->getCreatures();
-
-	ItemVector::const_iterator it;
-	if(items)
-	{
-		for(it = items->getBeginTopItem(); (it != items->getEndTopItem()); ++it, ++count) {
-			assert(count < 10);
-			msg->AddItem((*it).get());
-		}
-	}
+	invalidateCreaturesAtPosition(position);
 
+	const CreatureVector* creatures = tile->getCreatures();
 	if(creatures)
 	{
 		for(CreatureVector::const_iterator cit = creatures->begin(); cit != creatures->end(); ++cit)
@@ -951,13 +943,7 @@ void ProtocolGame::GetTileDescription(const Tile* tile, NetworkMessage_ptr msg)
 		}
 	}
 
-	if(items)
-	{
-		for(it = items->getBeginDownItem(); it != items->getEndDownItem(); ++it, ++count) {
-			assert(count < 10);
-			msg->AddItem((*it).get());
-		}
-	}
+	msg->AddBytes(encodedItems.bytes.data() + encodedItems.downItemsOffset, encodedItems.bytes.size() - encodedItems.downItemsOffset);
 }
 
 void ProtocolGame::GetMapDescription(int32_t x, int32_t y, int32_t z,
@@ -995,7 +981,7 @@ void ProtocolGame::GetFloorDescription(NetworkMessage_ptr msg, int32_t x, int32_
 {
 	LOGt("ProtocolGame(" << player->getName() << ")::GetFloorDescription(position = " << Position(x,y,z) << ", width = " << width << ", height = " << height << ", offset = " << offset << ")");
 
-	Tile* tile = nullptr;
+	const Tile* tile = nullptr;
 	for(int32_t nx = 0; nx < width; nx++)
 	{
 		for(int32_t ny = 0; ny < height; ny++)
@@ -1003,7 +989,7 @@ void ProtocolGame::GetFloorDescription(NetworkMessage_ptr msg, int32_t x, int32_
 			int_fast32_t finalX = x + nx + offset;
 			int_fast32_t finalY = y + ny + offset;
 
-			if(Position::isValid(finalX, finalY, z) && (tile = server.game().getTile(Position(finalX, finalY, z))))
+			if(Position::isValid(finalX, finalY, z) && (tile = server.game().getTileForReading(Position(finalX, finalY, z))))
 			{
 				if(skip >= 0)
 				{
@@ -1012,7 +998,7 @@ void ProtocolGame::GetFloorDescription(NetworkMessage_ptr msg, int32_t x, int32_
 				}
 
 				skip = 0;
-				GetTileDescription(tile, msg);
+				GetTileDescription(tile, Position(finalX, finalY, z), msg);
 			}
 			else
 			{
@@ -2252,7 +2238,8 @@ void ProtocolGame::sendCreatureTurn(const CreatureP& creature, const StackPositi
 	}
 }
 
-void ProtocolGame::sendCreatureSay(const CreatureP& creature, SpeakClasses type, const std::string& text, Position* pos/* = nullptr*/)
+void ProtocolGame::sendCreatureSay(const CreatureP& creature, SpeakClasses type, const std::string& text, Position* pos/* = nullptr*/,
+	const NetworkFragment_ptr& fragment/* = NetworkFragment_ptr()*/)
 {
 	LOGt("ProtocolGame(" << player->getName() << ")::sendCreatureSay(" << creature << "");
 
@@ -2260,11 +2247,15 @@ void ProtocolGame::sendCreatureSay(const CreatureP& creature, SpeakClasses type,
 	if(msg)
 	{
 		TRACK_MESSAGE(msg);
-		AddCreatureSpeak(msg, creature.get(), type, text, 0, 0, pos);
+		if(fragment)
+			msg->AddFragment(*fragment);
+		else
+			AddCreatureSpeak(msg, creature.get(), type, text, 0, 0, pos);
 	}
 }
 
-void ProtocolGame::sendToChannel(const Creature* creature, SpeakClasses type, const std::string& text, uint16_t channelId, uint32_t time /*= 0*/)
+void ProtocolGame::sendToChannel(const Creature* creature, SpeakClasses type, const std::string& text, uint16_t channelId, uint32_t time /*= 0*/,
+	const NetworkFragment_ptr& fragment/* = NetworkFragment_ptr()*/)
 {
 	LOGt("ProtocolGame(" << player->getName() << ")::sendToChannel(" << creature << ")");
 
@@ -2272,7 +2263,10 @@ void ProtocolGame::sendToChannel(const Creature* creature, SpeakClasses type, co
 	if(msg)
 	{
 		TRACK_MESSAGE(msg);
-		AddCreatureSpeak(msg, creature, type, text, channelId, time);
+		if(fragment)
+			msg->AddFragment(*fragment);
+		else
+			AddCreatureSpeak(msg, creature, type, text, channelId, time);
 	}
 }
 
@@ -2355,7 +2349,8 @@ void ProtocolGame::sendPing()
 	}
 }
 
-void ProtocolGame::sendDistanceShoot(const Position& from, const Position& to, uint8_t type)
+void ProtocolGame::sendDistanceShoot(const Position& from, const Position& to, uint8_t type,
+	const NetworkFragment_ptr& fragment/* = NetworkFragment_ptr()*/)
 {
 	LOGt("ProtocolGame(" << player->getName() << ")::sendDistanceShoot(from = " << from << ", to = " << to << ", type = " << static_cast<uint32_t>(type) << ") - canSee(from) = " << (canSee(from) ? "true" : "false") << ", canSee(from) = " << (canSee(to) ? "true" : "false"));
 
@@ -2366,11 +2361,14 @@ void ProtocolGame::sendDistanceShoot(const Position& from, const Position& to, u
 	if(msg)
 	{
 		TRACK_MESSAGE(msg);
-		AddDistanceShoot(msg, from, to, type);
+		if(fragment)
+			msg->AddFragment(*fragment);
+		else
+			AddDistanceShoot(msg, from, to, type);
 	}
 }
 
-void ProtocolGame::sendMagicEffect(const Position& pos, uint8_t type)
+void ProtocolGame::sendMagicEffect(const Position& pos, uint8_t type, const NetworkFragment_ptr& fragment/* = NetworkFragment_ptr()*/)
 {
 //	LOGt("ProtocolGame(" << player->getName() << ")::sendMagicEffect(pos = " << pos << ", type = " << static_cast<uint32_t>(type) << ") - canSee = " << (canSee(pos) ? "true" : "false"));
 
@@ -2381,11 +2379,15 @@ void ProtocolGame::sendMagicEffect(const Position& pos, uint8_t type)
 	if(msg)
 	{
 		TRACK_MESSAGE(msg);
-		AddMagicEffect(msg, pos, type);
+		if(fragment)
+			msg->AddFragment(*fragment);
+		else
+			AddMagicEffect(msg, pos, type);
 	}
 }
 
-void ProtocolGame::sendAnimatedText(const Position& pos, uint8_t color, std::string text)
+void ProtocolGame::sendAnimatedText(const Position& pos, uint8_t color, std::string text,
+	const NetworkFragment_ptr& fragment/* = NetworkFragment_ptr()*/)
 {
 //	LOGt("ProtocolGame(" << player->getName() << ")::sendAnimatedText(pos = " << pos << ") - canSee = " << (canSee(pos) ? "true" : "false"));
 
@@ -2396,7 +2398,10 @@ void ProtocolGame::sendAnimatedText(const Position& pos, uint8_t color, std::str
 	if(msg)
 	{
 		TRACK_MESSAGE(msg);
-		AddAnimatedText(msg, pos, color, text);
+		if(fragment)
+			msg->AddFragment(*fragment);
+		else
+			AddAnimatedText(msg, pos, color, text);
 	}
 }
 
@@ -2546,7 +2551,7 @@ void ProtocolGame::sendUpdateTile(const Tile* tile, const Position& pos)
 		msg->AddPosition(pos);
 		if(tile)
 		{
-			GetTileDescription(tile, msg);
+			GetTileDescription(tile, pos, msg);
 			msg->AddByte(0x00);
 			msg->AddByte(0xFF);
 		}
@@ -3087,6 +3092,28 @@ void ProtocolGame::AddTextMessage(NetworkMessage_ptr msg, MessageClasses mclass,
 	msg->AddString(message);
 }
 
+NetworkFragment_ptr ProtocolGame::createAnimatedText(const Position& pos, uint8_t color, const std::string& text)
+{
+	return NetworkMessage::createFragment(std::bind(&ProtocolGame::AddAnimatedText, std::placeholders::_1, std::cref(pos), color, std::cref(text)));
+}
+
+NetworkFragment_ptr ProtocolGame::createCreatureSpeak(const Creature* creature, SpeakClasses type, const std::string& text,
+	uint16_t channelId, uint32_t time/* = 0*/, Position* pos/* = nullptr*/)
+{
+	// players report statements by the id encoded here, so all recipients share one entry of the chat's statement map
+	return NetworkMessage::createFragment(std::bind(&ProtocolGame::AddCreatureSpeak, std::placeholders::_1, creature, type, text, channelId, time, pos));
+}
+
+NetworkFragment_ptr ProtocolGame::createDistanceShoot(const Position& from, const Position& to, uint8_t type)
+{
+	return NetworkMessage::createFragment(std::bind(&ProtocolGame::AddDistanceShoot, std::placeholders::_1, std::cref(from), std::cref(to), type));
+}
+
+NetworkFragment_ptr ProtocolGame::createMagicEffect(const Position& pos, uint8_t type)
+{
+	return NetworkMessage::createFragment(std::bind(&ProtocolGame::AddMagicEffect, std::placeholders::_1, std::cref(pos), type));
+}
+
 void ProtocolGame::AddAnimatedText(NetworkMessage_ptr msg, const Position& pos,
 	uint8_t color, const std::string& text)
 {
@@ -34,6 +34,7 @@ class Quest;
 class Tile;
 
 typedef std::shared_ptr<NetworkMessage> NetworkMessage_ptr;
+typedef std::shared_ptr<const std::string> NetworkFragment_ptr;
 
 
 class ProtocolGame : public Protocol
@@ -57,6 +58,13 @@ class ProtocolGame : public Protocol
 
 		void setPlayer(Player* p);
 
+		// packets encoded once for all of their recipients, to be passed to the send methods of Player
+		static NetworkFragment_ptr createAnimatedText(const Position& pos, uint8_t color, const std::string& text);
+		static NetworkFragment_ptr createCreatureSpeak(const Creature* creature, SpeakClasses type, const std::string& text,
+			uint16_t channelId, uint32_t time = 0, Position* pos = nullptr);
+		static NetworkFragment_ptr createDistanceShoot(const Position& from, const Position& to, uint8_t type);
+		static NetworkFragment_ptr createMagicEffect(const Position& pos, uint8_t type);
+
 	private:
 
 		struct CreatureValidationResult {
@@ -92,6 +100,7 @@ class ProtocolGame : public Protocol
 		virtual void onRecvFirstMessage(NetworkMessage& msg);
 
 		bool parseFirstPacket(NetworkMessage& msg);
+		bool parseDecryptedFirstPacket(NetworkMessage& msg, OperatingSystem_t operatingSystem, uint16_t version);
 		virtual void parsePacket(NetworkMessage& msg);
 
 		//Parse methods
@@ -173,21 +182,23 @@ class ProtocolGame : public Protocol
 		void sendChannel(uint16_t channelId, const std::string& channelName);
 		void sendRuleViolationsChannel(uint16_t channelId);
 		void sendOpenPrivateChannel(const std::string& receiver);
-		void sendToChannel(const Creature* creature, SpeakClasses type, const std::string& text, uint16_t channelId, uint32_t time = 0);
+		void sendToChannel(const Creature* creature, SpeakClasses type, const std::string& text, uint16_t channelId, uint32_t time = 0,
+			const NetworkFragment_ptr& fragment = NetworkFragment_ptr());
 		void sendRemoveReport(const std::string& name);
 		void sendLockRuleViolation();
 		void sendRuleViolationCancel(const std::string& name);
 		void sendIcons(int32_t icons);
 		void sendFYIBox(const std::string& message);
 
-		void sendDistanceShoot(const Position& from, const Position& to, uint8_t type);
-		void sendMagicEffect(const Position& pos, uint8_t type);
-		void sendAnimatedText(const Position& pos, uint8_t color, std::string text);
+		void sendDistanceShoot(const Position& from, const Position& to, uint8_t type, const NetworkFragment_ptr& fragment = NetworkFragment_ptr());
+		void sendMagicEffect(const Position& pos, uint8_t type, const NetworkFragment_ptr& fragment = NetworkFragment_ptr());
+		void sendAnimatedText(const Position& pos, uint8_t color, std::string text, const NetworkFragment_ptr& fragment = NetworkFragment_ptr());
 		void sendCreatureHealth(const CreatureP& creature);
 		void sendSkills();
 		void sendPing();
 		void sendCreatureTurn(const CreatureP& creature, const StackPosition& position);
-		void sendCreatureSay(const CreatureP& creature, SpeakClasses type, const std::string& text, Position* pos = nullptr);
+		void sendCreatureSay(const CreatureP& creature, SpeakClasses type, const std::string& text, Position* pos = nullptr,
+			const NetworkFragment_ptr& fragment = NetworkFragment_ptr());
 
 		void sendCancel(const std::string& message);
 		void sendCancelWalk();
@@ -252,8 +263,8 @@ class ProtocolGame : public Protocol
 
 		//Help functions
 
-		// translate a tile to clientreadable format
-		void GetTileDescription(const Tile* tile, NetworkMessage_ptr msg);
+		// translate a tile to clientreadable format, the position is passed since shared template tiles don't know it
+		void GetTileDescription(const Tile* tile, const Position& position, NetworkMessage_ptr msg);
 
 		// translate a floor to clientreadable format
 		void GetFloorDescription(NetworkMessage_ptr msg, int32_t x, int32_t y, int32_t z,
@@ -265,12 +276,12 @@ class ProtocolGame : public Protocol
 
 		void AddMapDescription(NetworkMessage_ptr msg, const Position& pos);
 		void AddTextMessage(NetworkMessage_ptr msg, MessageClasses mclass, const std::string& message);
-		void AddAnimatedText(NetworkMessage_ptr msg, const Position& pos, uint8_t color, const std::string& text);
-		void AddMagicEffect(NetworkMessage_ptr msg, const Position& pos, uint8_t type);
-		void AddDistanceShoot(NetworkMessage_ptr msg, const Position& from, const Position& to, uint8_t type);
+		static void AddAnimatedText(NetworkMessage_ptr msg, const Position& pos, uint8_t color, const std::string& text);
+		static void AddMagicEffect(NetworkMessage_ptr msg, const Position& pos, uint8_t type);
+		static void AddDistanceShoot(NetworkMessage_ptr msg, const Position& from, const Position& to, uint8_t type);
 		void AddCreature(NetworkMessage_ptr msg, const CreatureP& creature, const StackPosition& position);
 		void AddPlayerStats(NetworkMessage_ptr msg);
-		void AddCreatureSpeak(NetworkMessage_ptr msg, const Creature* creature, SpeakClasses type,
+		static void AddCreatureSpeak(NetworkMessage_ptr msg, const Creature* creature, SpeakClasses type,
 			std::string text, uint16_t channelId, uint32_t time = 0, Position* pos = nullptr);
 		void AddCreatureHealth(NetworkMessage_ptr msg, const Creature* creature);
 		void AddCreatureOutfit(NetworkMessage_ptr msg, const Creature* creature, const Outfit_t& outfit, bool outfitWindow = false);
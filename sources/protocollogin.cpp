@@ -70,17 +70,17 @@ bool ProtocolLogin::parseFirstPacket(NetworkMessage& msg)
 		return false;
 	}
 
-	uint32_t clientIp = getConnection()->getIP();
 	/*uint16_t operatingSystem = msg.GetU16();*/msg.SkipBytes(2);
 	uint16_t version = msg.GetU16();
 
 	msg.SkipBytes(12);
-	if(!RSA_decrypt(msg))
-	{
-		getConnection()->close();
-		return false;
-	}
+	RSA_decryptAsync(msg, std::bind(&ProtocolLogin::parseDecryptedFirstPacket, this, std::placeholders::_1, version));
+	return true;
+}
 
+bool ProtocolLogin::parseDecryptedFirstPacket(NetworkMessage& msg, uint16_t version)
+{
+	uint32_t clientIp = getConnection()->getIP();
 	uint32_t key[4] = {msg.GetU32(), msg.GetU32(), msg.GetU32(), msg.GetU32()};
 	enableXTEAEncryption();
 	setXTEAKey(key);
@@ -153,7 +153,8 @@ bool ProtocolLogin::parseFirstPacket(NetworkMessage& msg)
 	ban.value = account->getId();
 
 	ban.type = BAN_ACCOUNT;
-	if(IOBan::getInstance()->getData(ban) && !IOLoginData::getInstance()->hasFlag(account->getId(), PlayerFlag_CannotBeBanned))
+	if(IOBan::getInstance()->isAccountBanished(ban.value) && IOBan::getInstance()->getData(ban)
+		&& !IOLoginData::getInstance()->hasFlag(account->getId(), PlayerFlag_CannotBeBanned))
 	{
 		bool deletion = ban.expires < 0;
 		std::string name_ = "Automatic ";
@@ -56,6 +56,7 @@ class ProtocolLogin : public Protocol
 
 		void disconnectClient(uint8_t error, const char* message);
 		bool parseFirstPacket(NetworkMessage& msg);
+		bool parseDecryptedFirstPacket(NetworkMessage& msg, uint16_t version);
 
 
 		LOGGER_DECLARATION;
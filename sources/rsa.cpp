@@ -17,6 +17,8 @@
 #include "otpch.h"
 #include "rsa.h"
 
+LOGGER_DEFINITION(RSAWorkerPool);
+
 RSA::RSA()
 {
 	m_keySet = false;
@@ -130,3 +132,152 @@ void RSA::getPublicKey(char* buffer)
 	memset(buffer, 0, 128 - count);
 	mpz_export(&buffer[128 - count], nullptr, 1, 1, 0, 0, m_mod);
 }
+
+
+class RSAWorkerPool::Worker
+{
+	public:
+		Worker(RSA& key)
+		{
+			boost::recursive_mutex::scoped_lock lockClass(key.rsaLock);
+
+			mpz_init_set(m_p, key.m_p);
+			mpz_init_set(m_q, key.m_q);
+			mpz_init_set(m_u, key.m_u);
+			mpz_init_set(m_dp, key.m_dp);
+			mpz_init_set(m_dq, key.m_dq);
+
+			mpz_init2(m_c, 1024);
+			mpz_init2(m_v1, 1024);
+			mpz_init2(m_v2, 1024);
+			mpz_init2(m_u2, 1024);
+			mpz_init2(m_tmp, 1024);
+		}
+
+		~Worker()
+		{
+			mpz_clear(m_p);
+			mpz_clear(m_q);
+			mpz_clear(m_u);
+			mpz_clear(m_dp);
+			mpz_clear(m_dq);
+
+			mpz_clear(m_c);
+			mpz_clear(m_v1);
+			mpz_clear(m_v2);
+			mpz_clear(m_u2);
+			mpz_clear(m_tmp);
+		}
+
+		// same computation as RSA::decrypt() but without locking and allocating
+		void decrypt(char* msg)
+		{
+			mpz_import(m_c, 128, 1, 1, 0, 0, msg);
+
+			mpz_mod(m_tmp, m_c, m_p);
+			mpz_powm(m_v1, m_tmp, m_dp, m_p);
+			mpz_mod(m_tmp, m_c, m_q);
+			mpz_powm(m_v2, m_tmp, m_dq, m_q);
+			mpz_sub(m_u2, m_v2, m_v1);
+			mpz_mul(m_tmp, m_u2, m_u);
+			mpz_mod(m_u2, m_tmp, m_q);
+			if(mpz_cmp_si(m_u2, 0) < 0)
+			{
+				mpz_add(m_tmp, m_u2, m_q);
+				mpz_set(m_u2, m_tmp);
+			}
+			mpz_mul(m_tmp, m_u2, m_p);
+			mpz_add(m_c, m_v1, m_tmp);
+
+			size_t count = (mpz_sizeinbase(m_c, 2) + 7)/8;
+			memset(msg, 0, 128 - count);
+			mpz_export(&msg[128 - count], nullptr, 1, 1, 0, 0, m_c);
+		}
+
+	private:
+		mpz_t m_p, m_q, m_u, m_dp, m_dq;
+		mpz_t m_c, m_v1, m_v2, m_u2, m_tmp;
+};
+
+RSAWorkerPool::RSAWorkerPool()
+	: m_queueDepth(0), m_stopping(false)
+{
+}
+
+RSAWorkerPool::~RSAWorkerPool()
+{
+	stop();
+}
+
+void RSAWorkerPool::decrypt(char* msg, const Callback& callback)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	Job job;
+	job.msg = msg;
+	job.callback = callback;
+
+	m_jobs.push_back(std::move(job));
+	++m_queueDepth;
+
+	m_signal.notify_one();
+}
+
+void RSAWorkerPool::run(Worker* worker)
+{
+	std::unique_ptr<Worker> ownedWorker(worker);
+	std::unique_lock<std::mutex> lock(m_mutex);
+
+	while(true)
+	{
+		while(m_jobs.empty() && !m_stopping)
+			m_signal.wait(lock);
+
+		if(m_jobs.empty())
+			break;
+
+		Job job = std::move(m_jobs.front());
+		m_jobs.pop_front();
+		--m_queueDepth;
+
+		lock.unlock();
+
+		worker->decrypt(job.msg);
+		job.callback();
+
+		lock.lock();
+	}
+}
+
+void RSAWorkerPool::start(RSA& key, uint32_t workerCount)
+{
+	if(!m_threads.empty())
+	{
+		LOGe("Cannot start the RSA worker pool twice.");
+		return;
+	}
+
+	if(workerCount == 0)
+		workerCount = std::max(std::thread::hardware_concurrency(), 1u);
+
+	m_stopping = false;
+	for(uint32_t i = 0; i < workerCount; ++i)
+		m_threads.push_back(std::thread(&RSAWorkerPool::run, this, new Worker(key)));
+
+	LOGd("Started " << workerCount << " RSA worker threads.");
+}
+
+void RSAWorkerPool::stop()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		m_stopping = true;
+		m_signal.notify_all();
+	}
+
+	for(std::thread& thread : m_threads)
+		thread.join();
+
+	m_threads.clear();
+}
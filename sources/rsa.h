@@ -38,6 +38,48 @@ class RSA
 		bool m_keySet;
 		//use only GMP
 		mpz_t m_p, m_q, m_u, m_d, m_dp, m_dq, m_mod;
+
+		friend class RSAWorkerPool;
+};
+
+// Decrypts login blocks on a fixed number of worker threads. Every worker has its own copy of the key's CRT components
+// and its own GMP temporaries, so decryptions don't block each other.
+class RSAWorkerPool
+{
+	public:
+		// called on the worker thread once the block passed to decrypt() was decrypted in place
+		typedef std::function<void()> Callback;
+
+		RSAWorkerPool();
+		~RSAWorkerPool();
+
+		void decrypt(char* msg, const Callback& callback);
+
+		size_t getQueueDepth() const {return m_queueDepth;}
+		size_t getWorkerCount() const {return m_threads.size();}
+
+		void start(RSA& key, uint32_t workerCount);
+		void stop();
+
+	protected:
+		class Worker;
+
+		struct Job
+		{
+			char* msg;
+			Callback callback;
+		};
+
+		void run(Worker* worker);
+
+		LOGGER_DECLARATION;
+
+		std::mutex m_mutex;
+		std::condition_variable m_signal;
+		std::deque<Job> m_jobs;
+		std::atomic<size_t> m_queueDepth;
+		std::vector<std::thread> m_threads;
+		bool m_stopping;
 };
 
 #endif // _RSA_H
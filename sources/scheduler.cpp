@@ -29,7 +29,9 @@ LOGGER_DEFINITION(Scheduler);
 
 Scheduler::Scheduler()
 	: _lastUsedTaskId(0),
-	  _state(State::STOPPED)
+	  _nextWakeTime(Time::max().time_since_epoch().count()),
+	  _state(State::STOPPED),
+	  _submissions(nullptr)
 {}
 
 
@@ -59,6 +61,8 @@ Scheduler::~Scheduler() {
 	}
 
 	_mutex.unlock();
+
+	clear();
 }
 
 
@@ -68,29 +72,20 @@ auto Scheduler::addTask(const TaskP& task) -> TaskId {
 		return 0;
 	}
 
-	std::lock_guard<std::mutex> lock(_mutex);
-
-	switch (_state) {
+	switch (_state.load()) {
 	case State::STOPPED:
 	case State::STARTED: {
 		TaskId taskId = task->getId();
 		if (taskId == 0) {
-			if (_lastUsedTaskId == std::numeric_limits<TaskId>::max()) {
-				taskId = _lastUsedTaskId = 1;
-			}
-			else {
+			taskId = ++_lastUsedTaskId;
+			if (taskId == 0) {
 				taskId = ++_lastUsedTaskId;
 			}
 
 			task->setId(taskId);
 		}
 
-		_pendingTaskIds.insert(taskId);
-		_tasks.push(task);
-
-		if (_tasks.top()->getId() == taskId) {
-			_signal.notify_one();
-		}
+		submit(new Submission { taskId, task, nullptr }, task->getTime());
 
 		return taskId;
 	}
@@ -105,8 +100,6 @@ auto Scheduler::addTask(const TaskP& task) -> TaskId {
 
 
 bool Scheduler::cancelTask(TaskId taskId) {
-	std::lock_guard<std::mutex> lock(_mutex);
-
 	if (_state != State::STARTED) {
 		LOGt("Cannot cancel task in scheduler which is not started.");
 		return false;
@@ -116,13 +109,56 @@ bool Scheduler::cancelTask(TaskId taskId) {
 		return false;
 	}
 
-	auto i = _pendingTaskIds.find(taskId);
-	if (i == _pendingTaskIds.end()) {
-		return false;
+	// the scheduler thread is woken up right away so that the cancelled task and everything it holds is released now
+	// instead of when its slot comes up, which may be far in the future
+	submit(new Submission { taskId, nullptr, nullptr }, Time::min());
+	return true;
+}
+
+
+void Scheduler::clear() {
+	auto submission = _submissions.exchange(nullptr);
+	while (submission != nullptr) {
+		auto next = submission->next;
+		delete submission;
+		submission = next;
 	}
 
-	_pendingTaskIds.erase(i);
-	return true;
+	_lastUsedTaskId = 0;
+	_nextWakeTime = Time::max().time_since_epoch().count();
+	_wheel.clear();
+}
+
+
+void Scheduler::drainSubmissions() {
+	auto submission = _submissions.exchange(nullptr, std::memory_order_acquire);
+	if (submission == nullptr) {
+		return;
+	}
+
+	// the stack holds the latest submission first
+	Submission* previous = nullptr;
+	while (submission != nullptr) {
+		auto next = submission->next;
+		submission->next = previous;
+		previous = submission;
+		submission = next;
+	}
+
+	submission = previous;
+	while (submission != nullptr) {
+		if (submission->task != nullptr) {
+			auto tick = tickForTime(submission->task->getTime());
+			_wheel.insert(submission->taskId, tick, std::move(submission->task));
+		}
+		else {
+			_wheel.erase(submission->taskId);
+		}
+
+		auto next = submission->next;
+		delete submission;
+		submission = next;
+	}
 }
 
 
@@ -161,50 +197,85 @@ void Scheduler::stop() {
 }
 
 
+void Scheduler::submit(Submission* submission, Time time) {
+	auto head = _submissions.load(std::memory_order_relaxed);
+	do {
+		submission->next = head;
+	} while (!_submissions.compare_exchange_weak(head, submission));
+
+	if (time.time_since_epoch().count() < _nextWakeTime.load()) {
+		std::lock_guard<std::mutex> guard(_mutex);
+		_signal.notify_one();
+	}
+}
+
+
 void Scheduler::thread() {
 	std::unique_lock<std::mutex> uniqueLock(_mutex, std::defer_lock);
 
+	_epoch = Clock::now();
+	_wheel.clear();
+
+	auto& dispatcher = server.dispatcher();
+
 	while (_state == State::STARTED) {
-		uniqueLock.lock();
+		auto now = Clock::now();
+		auto nowTick = static_cast<uint64_t>(std::chrono::duration_cast<Milliseconds>(now - _epoch).count());
 
-		if (_tasks.empty()) {
-			_signal.wait(uniqueLock);
-		}
-		else {
-			_signal.wait_until(uniqueLock, _tasks.top()->getTime());
-		}
+		drainSubmissions();
+		_wheel.advanceTo(nowTick, [&dispatcher](TaskP& task) {
+			task->setExpiration(Time::max());
+			dispatcher.addTask(task);
+		});
 
-		if (_state != State::STARTED || _tasks.empty() || _tasks.top()->getTime() > Clock::now()) {
-			uniqueLock.unlock();
-			continue;
-		}
+		uniqueLock.lock();
 
-		auto task = std::move(_tasks.top());
-		_tasks.pop();
+		auto wakeTime = (_wheel.empty() ? Time::max() : timeForTick(_wheel.nextEventTick()));
+		_nextWakeTime = wakeTime.time_since_epoch().count();
 
-		auto i = _pendingTaskIds.find(task->getId());
-		if (i == _pendingTaskIds.end()) {
-			// task was cancelled
-			uniqueLock.unlock();
-			continue;
+		// a submission which arrives after this check will see the new wake time and notify us if needed
+		if (_state == State::STARTED && _submissions.load() == nullptr) {
+			if (wakeTime == Time::max()) {
+				_signal.wait(uniqueLock);
+			}
+			else {
+				_signal.wait_until(uniqueLock, wakeTime);
+			}
 		}
 
-		_pendingTaskIds.erase(i);
-		uniqueLock.unlock();
+		_nextWakeTime = Time::min().time_since_epoch().count();
 
-		task->setExpiration(Time::max());
-		server.dispatcher().addTask(task);
+		uniqueLock.unlock();
 	}
 
 	_mutex.lock();
-	_lastUsedTaskId = 0;
-	_pendingTaskIds.clear();
-	_tasks = TaskQueue();
+	clear();
 	_state = State::STOPPED;
 	_mutex.unlock();
 }
 
 
+uint64_t Scheduler::tickForTime(Time time) const {
+	if (time <= _epoch) {
+		return 0;
+	}
+
+	auto duration = time - _epoch;
+
+	auto tick = static_cast<uint64_t>(std::chrono::duration_cast<Milliseconds>(duration).count());
+	if (Milliseconds(tick) < duration) {
+		++tick;
+	}
+
+	return tick;
+}
+
+
+Time Scheduler::timeForTick(uint64_t tick) const {
+	return _epoch + Milliseconds(tick);
+}
+
+
 void Scheduler::waitUntilStopped() {
 	_mutex.lock();
 
@@ -230,9 +301,3 @@ void Scheduler::waitUntilStopped() {
 		}
 	}
 }
-
-
-
-bool Scheduler::TaskQueueCompare::operator() (const TaskP& a, const TaskP& b) {
-	return (a->getTime() > b->getTime());
-}
@@ -18,6 +18,8 @@
 #ifndef _SCHEDULER_H
 #define _SCHEDULER_H
 
+#include "timingwheel.h"
+
 class SchedulerTask;
 
 
@@ -48,28 +50,36 @@ public:
 
 private:
 
-	class TaskQueueCompare : public std::binary_function<const TaskP&, const TaskP&, bool> {
-	public:
-		inline bool operator() (const TaskP& a, const TaskP& b);
-	};
+	// Tasks are kept in a hierarchical timing wheel with one tick per millisecond. The wheel is only ever touched by the
+	// scheduler thread. Other threads submit tasks and cancellations through a lock-free stack and only lock the mutex
+	// to wake up the scheduler thread when a new task is due before it would wake up anyway or a task is cancelled.
 
-	typedef std::unordered_set<TaskId>                              TaskIdSet;
-	typedef std::vector<TaskP>                                      TaskVector;
-	typedef std::priority_queue<TaskP,TaskVector,TaskQueueCompare>  TaskQueue;
+	struct Submission {
+		TaskId      taskId;
+		TaskP       task; // nullptr for cancellations
+		Submission* next;
+	};
 
 
-	void thread();
+	void     clear            ();
+	void     drainSubmissions ();
+	void     submit           (Submission* submission, Time time);
+	void     thread           ();
+	uint64_t tickForTime      (Time time) const;
+	Time     timeForTick      (uint64_t tick) const;
 
 
 	LOGGER_DECLARATION;
 
-	TaskId                  _lastUsedTaskId;
-	std::mutex              _mutex;
-	TaskIdSet               _pendingTaskIds;
-	std::condition_variable _signal;
-	volatile State          _state;
-	TaskQueue               _tasks;
-	std::thread             _thread;
+	Time                        _epoch;
+	std::atomic<TaskId>         _lastUsedTaskId;
+	std::mutex                  _mutex;
+	std::atomic<Time::rep>      _nextWakeTime;
+	std::condition_variable     _signal;
+	std::atomic<State>          _state;
+	std::atomic<Submission*>    _submissions;
+	std::thread                 _thread;
+	TimingWheel<TaskP>          _wheel;
 
 };
 
@@ -31,6 +31,7 @@
 #include "monsters.h"
 #include "movement.h"
 #include "npc.h"
+#include "playerpersistence.h"
 #include "scheduler.h"
 #include "spells.h"
 #include "talkaction.h"
@@ -102,6 +103,12 @@ void Server::destroy() {
 	_scheduler->waitUntilStopped();
 	_dispatcher->waitUntilStopped();
 
+	// players saved during shutdown are still being written
+	if (_playerPersistence->getState() == PlayerPersistence::State::STARTED) {
+		_playerPersistence->stop();
+	}
+	_playerPersistence->waitUntilStopped();
+
 	_ready = false;
 
 	LOGi("Bye!\n");
@@ -119,6 +126,7 @@ void Server::destroy() {
 	_monsters.reset();
 	_moveEvents.reset();
 	_npcs.reset();
+	_playerPersistence.reset();
 	_scheduler.reset();
 	_spells.reset();
 	_talkActions.reset();
@@ -175,6 +183,12 @@ bool Server::isReady() const {
 }
 
 
+PlayerPersistence& Server::playerPersistence() const {
+	assert(_ready);
+	return *_playerPersistence;
+}
+
+
 void Server::run() {
 	if (!_ready) {
 		return;
@@ -182,6 +196,7 @@ void Server::run() {
 
 	_dispatcher->start();
 	_scheduler->start();
+	_playerPersistence->start();
 }
 
 
@@ -217,6 +232,7 @@ void Server::setupComponents() {
 	_monsters.reset(new Monsters);
 	_moveEvents.reset(new MoveEvents);
 	_npcs.reset(new Npcs);
+	_playerPersistence.reset(new PlayerPersistence);
 	_scheduler.reset(new Scheduler);
 	_spells.reset(new Spells);
 	_talkActions.reset(new TalkActions);
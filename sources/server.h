@@ -32,6 +32,7 @@ class Items;
 class Monsters;
 class MoveEvents;
 class Npcs;
+class PlayerPersistence;
 class Scheduler;
 class Server;
 class Spells;
@@ -49,30 +50,31 @@ public:
 
 	Server(); // static class
 
-	Actions&         actions() const;
-	Admin&           admin() const;
-	Chat&            chat() const;
-	ConfigManager&   configManager() const;
-	CreatureEvents&  creatureEvents() const;
-	Database&        database() const;
-	DatabaseManager& databaseManager() const;
-	void             destroy();
-	Dispatcher&      dispatcher() const;
-	Game&            game() const;
-	GlobalEvents&    globalEvents() const;
-	Items&           items() const;
-	Monsters&        monsters() const;
-	MoveEvents&      moveEvents() const;
-	Npcs&            npcs() const;
-	bool             isReady() const;
-	void             run();
-	Scheduler&       scheduler() const;
-	void             setup();
-	Spells&          spells() const;
-	TalkActions&     talkActions() const;
-	Towns&           towns() const;
-	Weapons&         weapons() const;
-	World&           world() const;
+	Actions&           actions() const;
+	Admin&             admin() const;
+	Chat&              chat() const;
+	ConfigManager&     configManager() const;
+	CreatureEvents&    creatureEvents() const;
+	Database&          database() const;
+	DatabaseManager&   databaseManager() const;
+	void               destroy();
+	Dispatcher&        dispatcher() const;
+	Game&              game() const;
+	GlobalEvents&      globalEvents() const;
+	Items&             items() const;
+	Monsters&          monsters() const;
+	MoveEvents&        moveEvents() const;
+	Npcs&              npcs() const;
+	bool               isReady() const;
+	PlayerPersistence& playerPersistence() const;
+	void               run();
+	Scheduler&         scheduler() const;
+	void               setup();
+	Spells&            spells() const;
+	TalkActions&       talkActions() const;
+	Towns&             towns() const;
+	Weapons&           weapons() const;
+	World&             world() const;
 
 
 private:
@@ -85,25 +87,26 @@ private:
 
 	bool _ready;
 
-	Unique<Actions>         _actions;
-	Unique<Admin>           _admin;
-	Unique<Chat>            _chat;
-	Unique<ConfigManager>   _configManager;
-	Unique<CreatureEvents>  _creatureEvents;
-	Unique<DatabaseManager> _databaseManager;
-	Unique<Dispatcher>      _dispatcher;
-	Unique<Game>            _game;
-	Unique<GlobalEvents>    _globalEvents;
-	Unique<Items>           _items;
-	Unique<Monsters>        _monsters;
-	Unique<MoveEvents>      _moveEvents;
-	Unique<Npcs>            _npcs;
-	Unique<Scheduler>       _scheduler;
-	Unique<Spells>          _spells;
-	Unique<TalkActions>     _talkActions;
-	Unique<Towns>           _towns;
-	Unique<Weapons>         _weapons;
-	Unique<World>           _world;
+	Unique<Actions>           _actions;
+	Unique<Admin>             _admin;
+	Unique<Chat>              _chat;
+	Unique<ConfigManager>     _configManager;
+	Unique<CreatureEvents>    _creatureEvents;
+	Unique<DatabaseManager>   _databaseManager;
+	Unique<Dispatcher>        _dispatcher;
+	Unique<Game>              _game;
+	Unique<GlobalEvents>      _globalEvents;
+	Unique<Items>             _items;
+	Unique<Monsters>          _monsters;
+	Unique<MoveEvents>        _moveEvents;
+	Unique<Npcs>              _npcs;
+	Unique<PlayerPersistence> _playerPersistence;
+	Unique<Scheduler>         _scheduler;
+	Unique<Spells>            _spells;
+	Unique<TalkActions>       _talkActions;
+	Unique<Towns>             _towns;
+	Unique<Weapons>           _weapons;
+	Unique<World>             _world;
 
 };
 
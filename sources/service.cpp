@@ -111,10 +111,13 @@ void ServicePort::accept()
 
 	try
 	{
+		// the acceptor hands the socket over to the event loop which serves the connection from now on
+		boost::asio::io_service& connectionService = m_serviceManager.getConnectionService();
+
 		// FIXME leak!
-		boost::asio::ip::tcp::socket* socket = new boost::asio::ip::tcp::socket(m_io_service);
+		boost::asio::ip::tcp::socket* socket = new boost::asio::ip::tcp::socket(connectionService);
 		m_acceptor->async_accept(*socket, boost::bind(
-			&ServicePort::handle, this, socket, boost::asio::placeholders::error));
+			&ServicePort::handle, this, socket, boost::ref(connectionService), boost::asio::placeholders::error));
 	}
 	catch(boost::system::system_error& e)
 	{
@@ -122,7 +125,8 @@ void ServicePort::accept()
 	}
 }
 
-void ServicePort::handle(boost::asio::ip::tcp::socket* socket, const boost::system::error_code& error)
+void ServicePort::handle(boost::asio::ip::tcp::socket* socket, boost::asio::io_service& connectionService,
+	const boost::system::error_code& error)
 {
 	if(!error)
 	{
@@ -141,7 +145,7 @@ void ServicePort::handle(boost::asio::ip::tcp::socket* socket, const boost::syst
 		Connection_ptr connection;
 		if(remoteIp && ConnectionManager::getInstance()->acceptConnection(remoteIp) &&
 			(connection = ConnectionManager::getInstance()->createConnection(
-			socket, m_io_service, shared_from_this())))
+			socket, connectionService, shared_from_this())))
 		{
 			if(m_services.front()->isSingleSocket())
 				connection->handle(m_services.front()->makeProtocol(connection));
@@ -203,6 +207,30 @@ Protocol* ServicePort::makeProtocol(bool checksum, NetworkMessage& msg) const
 LOGGER_DEFINITION(ServiceManager);
 
 
+ServiceManager::~ServiceManager()
+{
+	stop();
+	joinConnectionThreads();
+}
+
+boost::asio::io_service& ServiceManager::getConnectionService()
+{
+	assert(!m_connectionServices.empty());
+	return *m_connectionServices[m_nextConnectionService++ % m_connectionServices.size()];
+}
+
+void ServiceManager::joinConnectionThreads()
+{
+	m_connectionServiceWork.clear();
+	for(auto& service : m_connectionServices)
+		service->stop();
+
+	for(std::thread& thread : m_connectionThreads)
+		thread.join();
+
+	m_connectionThreads.clear();
+}
+
 void ServiceManager::run()
 {
 	assert(!running);
@@ -216,6 +244,38 @@ void ServiceManager::run()
 		running = false;
 		LOGe("ServiceManager::run() - " << e.what());
 	}
+
+	joinConnectionThreads();
+}
+
+void ServiceManager::startConnectionThreads()
+{
+	uint32_t threadCount = std::max(server.configManager().getNumber(ConfigManager::NETWORK_THREADS), 0);
+	if(threadCount == 0)
+		threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+
+	for(uint32_t i = 0; i < threadCount; ++i)
+	{
+		m_connectionServices.emplace_back(new boost::asio::io_service(1));
+		m_connectionServiceWork.emplace_back(new boost::asio::io_service::work(*m_connectionServices.back()));
+	}
+
+	for(auto& service : m_connectionServices)
+	{
+		boost::asio::io_service* connectionService = service.get();
+		m_connectionThreads.push_back(std::thread([this, connectionService]() {
+			try
+			{
+				connectionService->run();
+			}
+			catch(boost::system::system_error& e)
+			{
+				LOGe("ServiceManager::startConnectionThreads() - " << e.what());
+			}
+		}));
+	}
+
+	LOGd("Started " << threadCount << " network threads.");
 }
 
 void ServiceManager::stop()
@@ -239,6 +299,10 @@ void ServiceManager::stop()
 	m_acceptors.clear();
 	OutputMessagePool::getInstance()->stop();
 
+	// the threads themselves are joined by run() once the acceptors' loop returned
+	for(auto& service : m_connectionServices)
+		service->stop();
+
 	deathTimer.expires_from_now(boost::posix_time::seconds(3));
 	deathTimer.async_wait(std::bind(&ServiceManager::die, this));
 
@@ -21,6 +21,7 @@
 class Connection;
 class Protocol;
 class ServiceBase;
+class ServiceManager;
 class ServicePort;
 
 typedef std::shared_ptr<Connection>  Connection_ptr;
@@ -56,8 +57,8 @@ class NetworkMessage;
 class ServicePort : boost::noncopyable, public std::enable_shared_from_this<ServicePort>
 {
 	public:
-		ServicePort(boost::asio::io_service& io_service): m_io_service(io_service),
-			m_acceptor(nullptr), m_serverPort(0), m_pendingStart(false) {}
+		ServicePort(ServiceManager& serviceManager, boost::asio::io_service& io_service): m_serviceManager(serviceManager),
+			m_io_service(io_service), m_acceptor(nullptr), m_serverPort(0), m_pendingStart(false) {}
 		~ServicePort() {close();}
 
 		bool add(Service_ptr);
@@ -66,7 +67,8 @@ class ServicePort : boost::noncopyable, public std::enable_shared_from_this<Serv
 		bool open(uint16_t port);
 		void close();
 
-		void handle(boost::asio::ip::tcp::socket* socket, const boost::system::error_code& error);
+		void handle(boost::asio::ip::tcp::socket* socket, boost::asio::io_service& connectionService,
+			const boost::system::error_code& error);
 
 		bool isSingleSocket() const {return m_services.size() && m_services.front()->isSingleSocket();}
 		std::string getProtocolNames() const;
@@ -83,6 +85,7 @@ class ServicePort : boost::noncopyable, public std::enable_shared_from_this<Serv
 		typedef std::vector<Service_ptr> ServiceVec;
 		ServiceVec m_services;
 
+		ServiceManager& m_serviceManager;
 		boost::asio::io_service& m_io_service;
 		boost::asio::ip::tcp::acceptor* m_acceptor;
 
@@ -96,8 +99,8 @@ class ServiceManager : boost::noncopyable
 {
 	ServiceManager(const ServiceManager&);
 	public:
-		ServiceManager(): m_io_service(), deathTimer(m_io_service), running(false) {}
-		~ServiceManager() {stop();}
+		ServiceManager(): m_io_service(), deathTimer(m_io_service), running(false), m_nextConnectionService(0) {}
+		~ServiceManager();
 
 		template <typename ProtocolType>
 		bool add(uint16_t port);
@@ -108,8 +111,13 @@ class ServiceManager : boost::noncopyable
 		bool isRunning() const {return !m_acceptors.empty();}
 		std::list<uint16_t> getPorts() const;
 
+		// returns the event loop for a new connection, which handles all of its reads, writes and timers
+		boost::asio::io_service& getConnectionService();
+
 	private:
 		void die() {m_io_service.stop();}
+		void joinConnectionThreads();
+		void startConnectionThreads();
 
 
 		LOGGER_DECLARATION;
@@ -118,6 +126,12 @@ class ServiceManager : boost::noncopyable
 		boost::asio::deadline_timer deathTimer;
 		bool running;
 
+		// one event loop per network thread, connections are spread over them round-robin
+		std::vector<Unique<boost::asio::io_service>> m_connectionServices;
+		std::vector<Unique<boost::asio::io_service::work>> m_connectionServiceWork;
+		std::vector<std::thread> m_connectionThreads;
+		std::atomic<size_t> m_nextConnectionService;
+
 		typedef std::map<uint16_t, ServicePort_ptr> AcceptorsMap;
 		AcceptorsMap m_acceptors;
 };
@@ -131,11 +145,14 @@ bool ServiceManager::add(uint16_t port)
 		return false;
 	}
 
+	if(m_connectionThreads.empty())
+		startConnectionThreads();
+
 	ServicePort_ptr servicePort;
 	AcceptorsMap::iterator it = m_acceptors.find(port);
 	if(it == m_acceptors.end())
 	{
-		servicePort.reset(new ServicePort(m_io_service));
+		servicePort.reset(new ServicePort(*this, m_io_service));
 		if (!servicePort->open(port)) {
 			return false;
 		}
@@ -0,0 +1,66 @@
+////////////////////////////////////////////////////////////////////////
+// OpenTibia - an opensource roleplaying game
+////////////////////////////////////////////////////////////////////////
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+////////////////////////////////////////////////////////////////////////
+
+
+#ifndef _SIMD_H
+#define _SIMD_H
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+	#define SIMD_X86
+	#include <immintrin.h>
+#endif
+
+
+// Instruction sets the vectorized kernels are written for. The scalar kernels run everywhere.
+enum class SimdKernel {
+	SCALAR,
+	SSE2,
+	AVX2,
+};
+
+
+inline bool isSimdKernelSupported(SimdKernel kernel) {
+	switch (kernel) {
+	case SimdKernel::SCALAR:
+		return true;
+
+#ifdef SIMD_X86
+	case SimdKernel::SSE2:
+		return __builtin_cpu_supports("sse2");
+
+	case SimdKernel::AVX2:
+		return __builtin_cpu_supports("avx2");
+#endif
+
+	default:
+		return false;
+	}
+}
+
+
+inline SimdKernel getFastestSimdKernel() {
+	if (isSimdKernelSupported(SimdKernel::AVX2)) {
+		return SimdKernel::AVX2;
+	}
+	if (isSimdKernelSupported(SimdKernel::SSE2)) {
+		return SimdKernel::SSE2;
+	}
+
+	return SimdKernel::SCALAR;
+}
+
+#endif // _SIMD_H
@@ -0,0 +1,423 @@
+////////////////////////////////////////////////////////////////////////
+// OpenTibia - an opensource roleplaying game
+////////////////////////////////////////////////////////////////////////
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+////////////////////////////////////////////////////////////////////////
+
+
+#ifndef _SPECTATORINDEX_H
+#define _SPECTATORINDEX_H
+
+#include "position.h"
+
+
+// Creatures indexed by the cell of the map they stand in, and the cached spectator lists of the positions asked for.
+// Every floor is divided into cells of cellSize x cellSize tiles, each holding its creatures in a vector, and a bitmap
+// tells which cells hold creatures at all. Each cell also remembers when a creature last entered, left or moved within
+// it. A cached list is only searched again once one of the cells within its view changed after the list was built, so
+// moves cost the same no matter how many lists are cached. The index only asks creatures for their position and can be
+// used on its own, e.g. by the tests.
+template<typename Creature>
+class SpectatorIndex {
+
+public:
+
+	typedef boost::intrusive_ptr<Creature>  CreatureP;
+	typedef std::list<CreatureP>            List;
+
+
+	static const uint16_t cellSize     = 16;
+	static const uint16_t maxViewportX = 11;
+	static const uint16_t maxViewportY = 11;
+	static const uint16_t maxZ         = 15;
+	static const uint32_t numZ         = maxZ + 1;
+
+
+	SpectatorIndex()
+		: _cacheHits(0),
+		  _cacheMisses(0),
+		  _cellCountX(0),
+		  _cellCountY(0),
+		  _changeStamp(0)
+	{}
+
+
+	// Removes all creatures and cached lists.
+	void clear() {
+		for (uint32_t z = 0; z < numZ; ++z) {
+			_cells[z].clear();
+			_changeStamps[z].clear();
+			_occupancy[z].clear();
+		}
+
+		_cache.clear();
+	}
+
+
+	void clearCache() {
+		_cache.clear();
+	}
+
+
+	uint64_t getCacheHits() const {
+		return _cacheHits;
+	}
+
+
+	uint64_t getCacheMisses() const {
+		return _cacheMisses;
+	}
+
+
+	size_t getCacheSize() const {
+		return _cache.size();
+	}
+
+
+	// The creatures which can see the center or be seen from it, on all floors visible from there.
+	const List& getSpectators(const Position& center) {
+		if (center.z > maxZ) {
+			static List empty;
+			return empty;
+		}
+
+		auto iterator = _cache.find(center);
+		if (iterator != _cache.end() && isCurrent(center, iterator->second.stamp)) {
+			++_cacheHits;
+			return iterator->second.spectators;
+		}
+
+		++_cacheMisses;
+
+		CacheEntry& entry = (iterator != _cache.end() ? iterator->second : _cache[center]);
+		entry.spectators.clear();
+		entry.stamp = _changeStamp;
+
+		uint16_t minZ, maxZ;
+		getSpectatorFloors(center.z, minZ, maxZ);
+		collectSpectators(entry.spectators, center, false, -maxViewportX, maxViewportX, -maxViewportY, maxViewportY, minZ, maxZ);
+
+		return entry.spectators;
+	}
+
+
+	// Adds the creatures within the given range around the center to the list. A range of 0 stands for the viewport.
+	void getSpectators(List& spectators, const Position& center, bool checkForDuplicates, bool multiFloor, int32_t westRange, int32_t eastRange, int32_t northRange, int32_t southRange) {
+		if (center.z > SpectatorIndex::maxZ) {
+			return;
+		}
+
+		int32_t minOffsetX = (westRange == 0 ? -maxViewportX : -westRange);
+		int32_t maxOffsetX = (eastRange == 0 ? maxViewportX : eastRange);
+		int32_t minOffsetY = (northRange == 0 ? -maxViewportY : -northRange);
+		int32_t maxOffsetY = (southRange == 0 ? maxViewportY : southRange);
+
+		bool cacheResult = false;
+		if (minOffsetX == -maxViewportX && maxOffsetX == maxViewportX && minOffsetY == -maxViewportY && maxOffsetY == maxViewportY && multiFloor && !checkForDuplicates) {
+			auto entry = _cache.find(center);
+			if (entry != _cache.end() && &entry->second.spectators != &spectators && isCurrent(center, entry->second.stamp)) {
+				// TODO allow caching with checkForDuplicates = true
+				++_cacheHits;
+
+				spectators = entry->second.spectators;
+				return;
+			}
+
+			cacheResult = true;
+		}
+
+		uint16_t minZ, maxZ;
+		if (multiFloor) {
+			getSpectatorFloors(center.z, minZ, maxZ);
+		}
+		else {
+			minZ = center.z;
+			maxZ = center.z;
+		}
+
+		collectSpectators(spectators, center, true, minOffsetX, maxOffsetX, minOffsetY, maxOffsetY, minZ, maxZ);
+
+		if (cacheResult) {
+			++_cacheMisses;
+
+			CacheEntry& entry = _cache[center];
+			entry.stamp = _changeStamp;
+
+			if (&entry.spectators != &spectators) {
+				entry.spectators = spectators;
+			}
+		}
+	}
+
+
+	// Moves the creature between cells and marks both cells as changed. A missing position stands for a creature which
+	// is added to or removed from the map.
+	void onCreatureMoved(const CreatureP& creature, const Position* fromPosition, const Position* toPosition) {
+		bool sameCell = (fromPosition != nullptr && toPosition != nullptr && fromPosition->z == toPosition->z
+			&& cellIndex(fromPosition->x, fromPosition->y) == cellIndex(toPosition->x, toPosition->y));
+
+		uint64_t stamp = ++_changeStamp;
+
+		if (fromPosition != nullptr) {
+			auto index = cellIndex(fromPosition->x, fromPosition->y);
+			auto& creatures = getCell(*fromPosition).creatures;
+
+			if (!sameCell) {
+				auto iterator = std::find(creatures.begin(), creatures.end(), creature);
+				assert(iterator != creatures.end());
+
+				*iterator = std::move(creatures.back());
+				creatures.pop_back();
+
+				if (creatures.empty()) {
+					_occupancy[fromPosition->z][index / 64] &= ~(UINT64_C(1) << (index % 64));
+				}
+			}
+
+			_changeStamps[fromPosition->z][index] = stamp;
+		}
+
+		if (toPosition != nullptr && !sameCell) {
+			auto index = cellIndex(toPosition->x, toPosition->y);
+			getCell(*toPosition).creatures.push_back(creature);
+
+			_changeStamps[toPosition->z][index] = stamp;
+			_occupancy[toPosition->z][index / 64] |= (UINT64_C(1) << (index % 64));
+		}
+	}
+
+
+	void resetCacheStatistics() {
+		_cacheHits = 0;
+		_cacheMisses = 0;
+	}
+
+
+	// Prepares the cells for a map of the given size, removing all creatures.
+	void setSize(uint16_t width, uint16_t height) {
+		clear();
+
+		_cellCountX = static_cast<uint16_t>(width / cellSize + 1u);
+		_cellCountY = static_cast<uint16_t>(height / cellSize + 1u);
+	}
+
+
+	static void getSpectatorFloors(uint16_t centerZ, uint16_t& minZ, uint16_t& maxZ) {
+		// underground floors only see two floors up and down, floors above ground see all floors above ground
+		if (centerZ >= 8) {
+			minZ = static_cast<uint16_t>(std::max(static_cast<int32_t>(centerZ) - 2, 0));
+			maxZ = static_cast<uint16_t>(std::min(static_cast<uint32_t>(centerZ) + 2, static_cast<uint32_t>(SpectatorIndex::maxZ)));
+		}
+		else {
+			minZ = 0;
+			maxZ = 7;
+		}
+	}
+
+
+	static bool isInSpectatorRange(const Position& center, const Position& position) {
+		uint16_t minZ, maxZ;
+		getSpectatorFloors(center.z, minZ, maxZ);
+
+		if (position.z < minZ || position.z > maxZ) {
+			return false;
+		}
+
+		int32_t deltaZ = center.z - position.z;
+		int32_t offsetX = position.x - center.x - deltaZ;
+		int32_t offsetY = position.y - center.y - deltaZ;
+
+		return (std::abs(offsetX) <= maxViewportX && std::abs(offsetY) <= maxViewportY);
+	}
+
+
+private:
+
+	struct Area {
+		uint16_t minX;
+		uint16_t maxX;
+		uint16_t minY;
+		uint16_t maxY;
+		uint32_t minCellX;
+		uint32_t maxCellX;
+		uint32_t minCellY;
+		uint32_t maxCellY;
+	};
+
+	struct CacheEntry {
+		List     spectators;
+		uint64_t stamp;
+	};
+
+	struct Cell {
+		std::vector<CreatureP> creatures;
+	};
+
+	typedef std::unordered_map<Position,CacheEntry>  Cache;
+
+
+	uint32_t cellIndex(uint16_t x, uint16_t y) const {
+		// positions outside of the map are clamped to the edge cells
+		uint32_t cellX = std::min<uint32_t>(x / cellSize, _cellCountX - 1u);
+		uint32_t cellY = std::min<uint32_t>(y / cellSize, _cellCountY - 1u);
+
+		return (cellY * _cellCountX + cellX);
+	}
+
+
+	void collectSpectators(List& spectators, const Position& center, bool checkForDuplicates, int32_t minOffsetX, int32_t maxOffsetX, int32_t minOffsetY, int32_t maxOffsetY, uint16_t minZ, uint16_t maxZ) const {
+		// every creature is indexed in exactly one cell so we only have to look out for creatures which were in the list before
+		std::unordered_set<const Creature*> previousSpectators;
+		if (checkForDuplicates) {
+			for (const auto& spectator : spectators) {
+				previousSpectators.insert(spectator.get());
+			}
+		}
+
+		for (auto z = minZ; z <= maxZ; ++z) {
+			const auto& cells = _cells[z];
+			if (cells.empty()) {
+				continue;
+			}
+
+			Area area;
+			if (!getArea(center, z, minOffsetX, maxOffsetX, minOffsetY, maxOffsetY, area)) {
+				continue;
+			}
+
+			const auto& occupancy = _occupancy[z];
+
+			for (auto cellY = area.minCellY; cellY <= area.maxCellY; ++cellY) {
+				uint32_t rowIndex = cellY * _cellCountX;
+				uint32_t lastIndex = rowIndex + area.maxCellX;
+
+				// skip empty cells 64 at a time using the occupancy bitmap
+				for (uint32_t index = rowIndex + area.minCellX; index <= lastIndex;) {
+					uint64_t word = occupancy[index / 64] >> (index % 64);
+					if (word == 0) {
+						index = (index / 64 + 1) * 64;
+						continue;
+					}
+
+					index += __builtin_ctzll(word);
+					if (index > lastIndex) {
+						break;
+					}
+
+					for (const auto& creature : cells[index].creatures) {
+						const auto& position = creature->getPosition();
+						if (position.x < area.minX || position.x > area.maxX || position.y < area.minY || position.y > area.maxY) {
+							continue;
+						}
+
+						if (previousSpectators.empty() || previousSpectators.find(creature.get()) == previousSpectators.end()) {
+							spectators.push_back(creature);
+						}
+					}
+
+					++index;
+				}
+			}
+		}
+	}
+
+
+	// The tiles and cells of floor z within the given offsets from the center, shifted by one tile per floor like the view.
+	bool getArea(const Position& center, uint16_t z, int32_t minOffsetX, int32_t maxOffsetX, int32_t minOffsetY, int32_t maxOffsetY, Area& area) const {
+		static const int32_t maxCoordinate = std::numeric_limits<uint16_t>::max();
+
+		int32_t deltaZ = center.z - z;
+
+		area.minX = static_cast<uint16_t>(std::max(0, std::min(center.x + minOffsetX + deltaZ, maxCoordinate)));
+		area.maxX = static_cast<uint16_t>(std::max(0, std::min(center.x + maxOffsetX + deltaZ, maxCoordinate)));
+		area.minY = static_cast<uint16_t>(std::max(0, std::min(center.y + minOffsetY + deltaZ, maxCoordinate)));
+		area.maxY = static_cast<uint16_t>(std::max(0, std::min(center.y + maxOffsetY + deltaZ, maxCoordinate)));
+
+		if (area.maxX < area.minX || area.maxY < area.minY) {
+			return false;
+		}
+
+		area.minCellX = area.minX / cellSize;
+		area.maxCellX = std::min<uint32_t>(area.maxX / cellSize, _cellCountX - 1u);
+		area.minCellY = area.minY / cellSize;
+		area.maxCellY = std::min<uint32_t>(area.maxY / cellSize, _cellCountY - 1u);
+
+		return (area.minCellX <= area.maxCellX && area.minCellY <= area.maxCellY);
+	}
+
+
+	Cell& getCell(const Position& position) {
+		auto& cells = _cells[position.z];
+		if (cells.empty()) {
+			uint32_t cellCount = static_cast<uint32_t>(_cellCountX) * _cellCountY;
+
+			cells.resize(cellCount);
+			_changeStamps[position.z].assign(cellCount, 0);
+			_occupancy[position.z].assign((cellCount + 63) / 64, 0);
+		}
+
+		return cells[cellIndex(position.x, position.y)];
+	}
+
+
+	// Whether no cell within the view of the center changed since the given stamp.
+	bool isCurrent(const Position& center, uint64_t stamp) const {
+		uint16_t minZ, maxZ;
+		getSpectatorFloors(center.z, minZ, maxZ);
+
+		for (auto z = minZ; z <= maxZ; ++z) {
+			const auto& changeStamps = _changeStamps[z];
+			if (changeStamps.empty()) {
+				continue;
+			}
+
+			Area area;
+			if (!getArea(center, z, -maxViewportX, maxViewportX, -maxViewportY, maxViewportY, area)) {
+				continue;
+			}
+
+			for (auto cellY = area.minCellY; cellY <= area.maxCellY; ++cellY) {
+				uint32_t rowIndex = cellY * _cellCountX;
+				for (auto cellX = area.minCellX; cellX <= area.maxCellX; ++cellX) {
+					if (changeStamps[rowIndex + cellX] > stamp) {
+						return false;
+					}
+				}
+			}
+		}
+
+		return true;
+	}
+
+
+	Cache                 _cache;
+	uint64_t              _cacheHits;
+	uint64_t              _cacheMisses;
+	uint16_t              _cellCountX;
+	uint16_t              _cellCountY;
+	std::vector<Cell>     _cells[numZ];
+	uint64_t              _changeStamp;
+	std::vector<uint64_t> _changeStamps[numZ];
+	std::vector<uint64_t> _occupancy[numZ];
+
+};
+
+
+template<typename Creature> const uint16_t SpectatorIndex<Creature>::cellSize;
+template<typename Creature> const uint16_t SpectatorIndex<Creature>::maxViewportX;
+template<typename Creature> const uint16_t SpectatorIndex<Creature>::maxViewportY;
+template<typename Creature> const uint16_t SpectatorIndex<Creature>::maxZ;
+template<typename Creature> const uint32_t SpectatorIndex<Creature>::numZ;
+
+#endif // _SPECTATORINDEX_H
@@ -37,6 +37,7 @@ LOGGER_DEFINITION(ProtocolStatus);
 uint32_t ProtocolStatus::protocolStatusCount = 0;
 #endif
 IpConnectMap ProtocolStatus::ipConnectMap;
+std::mutex ProtocolStatus::ipConnectMapLock;
 
 void ProtocolStatus::onRecvFirstMessage(NetworkMessage& msg) {
 	auto ip = getIP();
@@ -52,9 +53,14 @@ void ProtocolStatus::onRecvFirstMessage(NetworkMessage& msg) {
 			}
 		}
 
+		// status requests are handled by all network threads
+		std::unique_lock<std::mutex> lock(ipConnectMapLock);
+
 		IpConnectMap::const_iterator it = ipConnectMap.find(ip);
 		if(it != ipConnectMap.end() && OTSYS_TIME() < it->second + server.configManager().getNumber(ConfigManager::STATUSQUERY_TIMEOUT))
 		{
+			lock.unlock();
+
 			getConnection()->close();
 			return;
 		}
@@ -63,6 +63,7 @@ class ProtocolStatus : public Protocol
 	private:
 
 		static IpConnectMap ipConnectMap;
+		static std::mutex ipConnectMapLock;
 
 		virtual void deleteProtocolTask();
 
@@ -42,6 +42,9 @@
 #include "protocolgame.h"
 #include "protocollogin.h"
 #include "protocolold.h"
+#include "rsa.h"
+
+extern RSAWorkerPool g_RSAWorkerPool;
 #endif
 
 #include "condition.h"
@@ -1042,7 +1045,8 @@ bool TalkAction::diagnostics(Creature* creature, const std::string& cmd, const s
 	text << "Total message pool: " << OutputMessagePool::getInstance()->getTotalMessageCount() << std::endl;
 	text << "Auto message pool: " << OutputMessagePool::getInstance()->getAutoMessageCount() << std::endl;
 	text << "Queued message pool: " << OutputMessagePool::getInstance()->getQueuedMessageCount() << std::endl;
-	text << "Free message pool: " << OutputMessagePool::getInstance()->getAvailableMessageCount() << std::endl << std::endl;
+	text << "Free message pool: " << OutputMessagePool::getInstance()->getAvailableMessageCount() << std::endl;
+	text << "RSA queue depth: " << g_RSAWorkerPool.getQueueDepth() << " (" << g_RSAWorkerPool.getWorkerCount() << " workers)" << std::endl << std::endl;
 	player->sendTextMessage(MSG_STATUS_CONSOLE_BLUE, text.str().c_str());
 
 	text.str("");
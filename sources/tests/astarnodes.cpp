@@ -0,0 +1,311 @@
+////////////////////////////////////////////////////////////////////////
+// OpenTibia - an opensource roleplaying game
+////////////////////////////////////////////////////////////////////////
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+////////////////////////////////////////////////////////////////////////
+
+
+#include "otpch.h"
+
+#include <random>
+
+#include "astarnodes.h"
+
+
+static int failures = 0;
+
+#define CHECK(condition) \
+	do { \
+		if (!(condition)) { \
+			std::cerr << __FILE__ << ":" << __LINE__ << ": check failed: " #condition << std::endl; \
+			++failures; \
+		} \
+	} while (false)
+
+
+// The node list used before AStarNodes kept its open nodes on a heap. Every lookup scans all nodes, but the search
+// results are the reference the heap has to reproduce, including which of several equally cheap nodes comes first.
+class LinearNodes {
+
+public:
+
+	LinearNodes(uint32_t capacity)
+		: nodes(capacity),
+		  openNodes(capacity),
+		  nodeCount(0)
+	{}
+
+
+	void openNode(AStarNode* node) {
+		openNodes[node - nodes.data()] = true;
+	}
+
+
+	void closeNode(AStarNode* node) {
+		openNodes[node - nodes.data()] = false;
+	}
+
+
+	uint32_t countClosedNodes() {
+		return std::count(openNodes.begin(), openNodes.begin() + nodeCount, false);
+	}
+
+
+	AStarNode* getBestNode() {
+		AStarNode* bestNode = nullptr;
+		for (uint32_t index = 0; index < nodeCount; ++index) {
+			if (openNodes[index] && (bestNode == nullptr || nodes[index].f < bestNode->f)) {
+				bestNode = &nodes[index];
+			}
+		}
+
+		return bestNode;
+	}
+
+
+	AStarNode* createNode(uint16_t x, uint16_t y) {
+		if (nodeCount >= nodes.size()) {
+			return nullptr;
+		}
+
+		AStarNode& node = nodes[nodeCount++];
+		node.x = x;
+		node.y = y;
+		node.parent = nullptr;
+		node.f = node.g = node.h = 0;
+
+		return &node;
+	}
+
+
+	AStarNode* getNodeInList(uint16_t x, uint16_t y) {
+		for (uint32_t index = 0; index < nodeCount; ++index) {
+			if (nodes[index].x == x && nodes[index].y == y) {
+				return &nodes[index];
+			}
+		}
+
+		return nullptr;
+	}
+
+
+private:
+
+	std::vector<AStarNode> nodes;
+	std::vector<bool>      openNodes;
+	uint32_t               nodeCount;
+
+};
+
+
+
+// A square map where each tile is either blocked or has an extra walking cost, like a creature standing on it.
+struct Grid {
+
+	static const int32_t size = 256;
+
+
+	Grid(uint32_t seed) {
+		std::mt19937 random(seed);
+		for (auto& cost : costs) {
+			auto roll = random() % 100;
+			cost = (roll < 25 ? -1 : (roll < 30 ? MAP_NORMALWALKCOST * 3 : 0));
+		}
+	}
+
+
+	int32_t getExtraCost(int32_t x, int32_t y) const {
+		if (x < 0 || y < 0 || x >= size || y >= size) {
+			return -1;
+		}
+
+		return costs[y * size + x];
+	}
+
+
+	int32_t costs[size * size];
+
+};
+
+
+static int32_t getEstimatedDistance(int32_t x, int32_t y, int32_t xGoal, int32_t yGoal) {
+	int32_t diagonal = std::min(std::abs(x - xGoal), std::abs(y - yGoal));
+	return (MAP_DIAGONALWALKCOST * diagonal) + (MAP_NORMALWALKCOST * ((std::abs(x - xGoal) + std::abs(y - yGoal)) - (2 * diagonal)));
+}
+
+
+// The search loop of Map::getPathTo on a grid. Returns the visited positions from the start to the goal.
+template<typename Nodes>
+static bool findPath(const Grid& grid, int32_t startX, int32_t startY, int32_t goalX, int32_t goalY, int32_t maxDistance, uint32_t capacity, std::vector<std::pair<int32_t,int32_t>>& path) {
+	static const int16_t neighbourOrderList[8][2] = {
+		{-1, 0}, {0, 1}, {1, 0}, {0, -1},
+		{-1, -1}, {1, -1}, {1, 1}, {-1, 1},
+	};
+
+	path.clear();
+
+	Nodes nodes(capacity);
+	AStarNode* startNode = nodes.createNode(startX, startY);
+	startNode->g = 0;
+	startNode->h = getEstimatedDistance(startX, startY, goalX, goalY);
+	startNode->f = startNode->g + startNode->h;
+	nodes.openNode(startNode);
+
+	AStarNode* found = nullptr;
+	while (maxDistance != -1 || nodes.countClosedNodes() < 100) {
+		AStarNode* node = nodes.getBestNode();
+		if (node == nullptr) {
+			return false;
+		}
+
+		if (node->x == goalX && node->y == goalY) {
+			found = node;
+			break;
+		}
+
+		for (auto& offset : neighbourOrderList) {
+			int32_t x = node->x + offset[0];
+			int32_t y = node->y + offset[1];
+
+			if (maxDistance != -1 && (std::abs(goalX - x) > maxDistance || std::abs(goalY - y) > maxDistance)) {
+				continue;
+			}
+
+			int32_t extraCost = grid.getExtraCost(x, y);
+			if (extraCost < 0) {
+				continue;
+			}
+
+			int32_t cost = (std::abs(offset[0]) == std::abs(offset[1]) ? MAP_DIAGONALWALKCOST : MAP_NORMALWALKCOST);
+			int32_t g = node->g + cost + extraCost;
+
+			AStarNode* neighbourNode = nodes.getNodeInList(x, y);
+			if (neighbourNode != nullptr) {
+				if (neighbourNode->g <= g) {
+					continue;
+				}
+			}
+			else {
+				neighbourNode = nodes.createNode(x, y);
+				if (neighbourNode == nullptr) {
+					return false;
+				}
+			}
+
+			neighbourNode->g = g;
+			neighbourNode->h = getEstimatedDistance(x, y, goalX, goalY);
+			neighbourNode->f = neighbourNode->g + neighbourNode->h;
+			neighbourNode->parent = node;
+
+			nodes.openNode(neighbourNode);
+		}
+
+		nodes.closeNode(node);
+	}
+
+	for (; found != nullptr; found = found->parent) {
+		path.emplace_back(found->x, found->y);
+	}
+
+	return !path.empty();
+}
+
+
+struct Search {
+	int32_t startX, startY, goalX, goalY, maxDistance;
+};
+
+
+static std::vector<Search> createSearches(size_t count) {
+	std::mt19937 random(1);
+	std::uniform_int_distribution<int32_t> coordinate(20, Grid::size - 21);
+	std::uniform_int_distribution<int32_t> offset(-12, 12);
+
+	std::vector<Search> searches;
+	for (size_t index = 0; index < count; ++index) {
+		Search search;
+		search.startX = coordinate(random);
+		search.startY = coordinate(random);
+		search.goalX = search.startX + offset(random);
+		search.goalY = search.startY + offset(random);
+
+		// monsters chasing a target search within a distance, everything else with the closed node limit
+		search.maxDistance = (index % 2 == 0 ? -1 : 12);
+
+		searches.push_back(search);
+	}
+
+	return searches;
+}
+
+
+static void testEquivalence() {
+	Grid grid(0);
+	size_t foundCount = 0;
+
+	for (uint32_t capacity : { 16, 100, 512, 2048 }) {
+		for (auto& search : createSearches(2000)) {
+			std::vector<std::pair<int32_t,int32_t>> path, referencePath;
+			bool found = findPath<AStarNodes>(grid, search.startX, search.startY, search.goalX, search.goalY, search.maxDistance, capacity, path);
+			bool referenceFound = findPath<LinearNodes>(grid, search.startX, search.startY, search.goalX, search.goalY, search.maxDistance, capacity, referencePath);
+
+			CHECK(found == referenceFound);
+			CHECK(path == referencePath);
+
+			if (found) {
+				++foundCount;
+			}
+		}
+	}
+
+	// make sure the searches are not trivially failing
+	CHECK(foundCount > 1000);
+}
+
+
+// Not a check but a measurement: prints how long both node lists take for the same searches.
+static void benchmarkSearches() {
+	Grid grid(0);
+	auto searches = createSearches(5000);
+	std::vector<std::pair<int32_t,int32_t>> path;
+
+	for (auto linearNodes : { true, false }) {
+		auto startTime = Clock::now();
+
+		for (auto& search : searches) {
+			if (linearNodes) {
+				findPath<LinearNodes>(grid, search.startX, search.startY, search.goalX, search.goalY, search.maxDistance, 512, path);
+			}
+			else {
+				findPath<AStarNodes>(grid, search.startX, search.startY, search.goalX, search.goalY, search.maxDistance, 512, path);
+			}
+		}
+
+		auto duration = std::chrono::duration_cast<Milliseconds>(Clock::now() - startTime);
+		std::cout << searches.size() << " searches with " << (linearNodes ? "linear" : "heap") << " nodes took " << duration.count() << " ms" << std::endl;
+	}
+}
+
+
+int main() {
+	testEquivalence();
+	benchmarkSearches();
+
+	if (failures != 0) {
+		std::cerr << failures << " check(s) failed." << std::endl;
+		return 1;
+	}
+
+	return 0;
+}
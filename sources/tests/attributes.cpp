@@ -0,0 +1,360 @@
+////////////////////////////////////////////////////////////////////////
+// OpenTibia - an opensource roleplaying game
+////////////////////////////////////////////////////////////////////////
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+////////////////////////////////////////////////////////////////////////
+
+
+#include "otpch.h"
+
+#include <boost/any.hpp>
+
+#include "attributes/Attribute.hpp"
+#include "attributes/Name.hpp"
+#include "attributes/Scheme.hpp"
+#include "attributes/Values.hpp"
+
+
+static int failures = 0;
+
+#define CHECK(condition) \
+	do { \
+		if (!(condition)) { \
+			std::cerr << __FILE__ << ":" << __LINE__ << ": check failed: " #condition << std::endl; \
+			++failures; \
+		} \
+	} while (false)
+
+
+// Counts the allocations of the whole program so the checks can tell whether values leak or allocate when they shouldn't.
+static size_t allocatedBytes = 0;
+static size_t liveAllocations = 0;
+
+
+void* operator new(size_t size) {
+	void* pointer = std::malloc(size != 0 ? size : 1);
+	if (pointer == nullptr) {
+		throw std::bad_alloc();
+	}
+
+	allocatedBytes += size;
+	++liveAllocations;
+
+	return pointer;
+}
+
+
+void* operator new[](size_t size) {
+	return operator new(size);
+}
+
+
+// not inlined, as the compiler would otherwise see memory from operator new being passed to free
+__attribute__((noinline)) void operator delete(void* pointer) noexcept {
+	if (pointer == nullptr) {
+		return;
+	}
+
+	--liveAllocations;
+	std::free(pointer);
+}
+
+
+void operator delete[](void* pointer) noexcept {
+	operator delete(pointer);
+}
+
+
+using attributes::Name;
+using attributes::Type;
+using attributes::Values;
+
+static const Name ATTRIBUTE_COUNT("count");
+static const Name ATTRIBUTE_FLAG("flag");
+static const Name ATTRIBUTE_TEXT("text");
+static const Name ATTRIBUTE_WEIGHT("weight");
+static const Name ATTRIBUTE_WRITER("writer");
+
+static const std::string longText = "A text which is too long to be stored within the string object itself.";
+
+
+static attributes::SchemeP createScheme() {
+	attributes::Scheme::AttributesP attributes(new attributes::Scheme::Attributes);
+	attributes->emplace(ATTRIBUTE_COUNT, Type::INTEGER);
+	attributes->emplace(ATTRIBUTE_FLAG, Type::BOOLEAN);
+	attributes->emplace(ATTRIBUTE_TEXT, Type::STRING);
+	attributes->emplace(ATTRIBUTE_WEIGHT, Type::FLOAT);
+	attributes->emplace(ATTRIBUTE_WRITER, Type::STRING);
+
+	return std::make_shared<attributes::Scheme>(std::move(attributes));
+}
+
+
+static void testSetAndGet(const attributes::SchemeP& scheme) {
+	Values values(scheme);
+	CHECK(values.isEmpty());
+	CHECK(values.size() == 0);
+	CHECK(values.begin() == values.end());
+	CHECK(values.getInteger(ATTRIBUTE_COUNT) == nullptr);
+
+	values.set(ATTRIBUTE_COUNT, 5);
+	values.set(ATTRIBUTE_FLAG, true);
+	values.set(ATTRIBUTE_TEXT, longText);
+	values.set(ATTRIBUTE_WEIGHT, 1.5f);
+
+	CHECK(values.size() == 4);
+	CHECK(values.contains(ATTRIBUTE_COUNT));
+	CHECK(values.contains("text"));
+	CHECK(!values.contains(ATTRIBUTE_WRITER));
+	CHECK(*values.getInteger(ATTRIBUTE_COUNT) == 5);
+	CHECK(*values.getBoolean("flag") == true);
+	CHECK(*values.getString(ATTRIBUTE_TEXT) == longText);
+	CHECK(*values.getFloat(ATTRIBUTE_WEIGHT) == 1.5f);
+
+	// existing values are updated in place
+	size_t allocations = liveAllocations;
+	values.set(ATTRIBUTE_COUNT, 6);
+	values.set(ATTRIBUTE_TEXT, std::string("short"));
+	CHECK(liveAllocations == allocations);
+	CHECK(values.size() == 4);
+	CHECK(*values.getInteger(ATTRIBUTE_COUNT) == 6);
+	CHECK(*values.getString(ATTRIBUTE_TEXT) == "short");
+}
+
+
+static void testCopyAndMove(const attributes::SchemeP& scheme) {
+	Values values(scheme);
+	values.set(ATTRIBUTE_COUNT, 1);
+	values.set(ATTRIBUTE_TEXT, longText);
+
+	Values copy(scheme);
+	copy = values;
+	CHECK(copy.size() == 2);
+	CHECK(*copy.getInteger(ATTRIBUTE_COUNT) == 1);
+	CHECK(*copy.getString(ATTRIBUTE_TEXT) == longText);
+
+	// the copy owns its own string
+	CHECK(copy.getString(ATTRIBUTE_TEXT) != values.getString(ATTRIBUTE_TEXT));
+	values.set(ATTRIBUTE_TEXT, std::string("changed"));
+	CHECK(*copy.getString(ATTRIBUTE_TEXT) == longText);
+
+	Values moved(scheme);
+	moved = std::move(values);
+	CHECK(values.isEmpty());
+	CHECK(moved.size() == 2);
+	CHECK(*moved.getString(ATTRIBUTE_TEXT) == "changed");
+
+	// copying empty values releases the previous ones
+	Values empty(scheme);
+	copy = empty;
+	CHECK(copy.isEmpty());
+
+	Values::Entry entry(*moved.getEntry(ATTRIBUTE_TEXT));
+	CHECK(entry.getString() == "changed");
+
+	Values::Entry movedEntry(std::move(entry));
+	CHECK(movedEntry.getString() == "changed");
+}
+
+
+// A string entry is overwritten by an integer entry and the other way round, which must release or allocate the string.
+static void testOverwriteType(const attributes::SchemeP& scheme) {
+	Values strings(scheme);
+	strings.set(ATTRIBUTE_TEXT, longText);
+
+	Values integers(scheme);
+	integers.set(ATTRIBUTE_COUNT, 42);
+
+	Values::Entry entry(*strings.getEntry(ATTRIBUTE_TEXT));
+	entry = *integers.getEntry(ATTRIBUTE_COUNT);
+	CHECK(entry.getAttribute().getType() == Type::INTEGER);
+	CHECK(entry.getInteger() == 42);
+
+	entry = *strings.getEntry(ATTRIBUTE_TEXT);
+	CHECK(entry.getAttribute().getType() == Type::STRING);
+	CHECK(entry.getString() == longText);
+
+	entry = Values::Entry(*integers.getEntry(ATTRIBUTE_COUNT));
+	CHECK(entry.getInteger() == 42);
+
+	entry = Values::Entry(*strings.getEntry(ATTRIBUTE_TEXT));
+	CHECK(entry.getString() == longText);
+
+	Values values(scheme);
+	values = strings;
+	values = integers;
+	CHECK(!values.contains(ATTRIBUTE_TEXT));
+	CHECK(*values.getInteger(ATTRIBUTE_COUNT) == 42);
+
+	values = strings;
+	CHECK(!values.contains(ATTRIBUTE_COUNT));
+	CHECK(*values.getString(ATTRIBUTE_TEXT) == longText);
+}
+
+
+static void testRemove(const attributes::SchemeP& scheme) {
+	Values values(scheme);
+	values.set(ATTRIBUTE_COUNT, 1);
+	values.set(ATTRIBUTE_TEXT, longText);
+	values.set(ATTRIBUTE_WRITER, std::string("writer"));
+
+	values.remove(ATTRIBUTE_TEXT);
+	CHECK(values.size() == 2);
+	CHECK(!values.contains(ATTRIBUTE_TEXT));
+	CHECK(*values.getInteger(ATTRIBUTE_COUNT) == 1);
+	CHECK(*values.getString(ATTRIBUTE_WRITER) == "writer");
+
+	// removing a value which isn't set changes nothing
+	values.remove(ATTRIBUTE_TEXT);
+	CHECK(values.size() == 2);
+
+	values.remove("count");
+	values.remove(ATTRIBUTE_WRITER);
+	CHECK(values.isEmpty());
+	CHECK(values.begin() == values.end());
+
+	values.set(ATTRIBUTE_TEXT, longText);
+	CHECK(*values.getString(ATTRIBUTE_TEXT) == longText);
+}
+
+
+static void testSelfAssignment(const attributes::SchemeP& scheme) {
+	Values values(scheme);
+	values.set(ATTRIBUTE_COUNT, 1);
+	values.set(ATTRIBUTE_TEXT, longText);
+
+	// assigned through a reference so the compiler doesn't warn about it
+	Values& same = values;
+	values = same;
+	CHECK(values.size() == 2);
+	CHECK(*values.getString(ATTRIBUTE_TEXT) == longText);
+
+	values = std::move(same);
+	CHECK(values.size() == 2);
+	CHECK(*values.getString(ATTRIBUTE_TEXT) == longText);
+
+	Values::Entry entry(*values.getEntry(ATTRIBUTE_TEXT));
+	Values::Entry& sameEntry = entry;
+	entry = sameEntry;
+	CHECK(entry.getString() == longText);
+
+	entry = std::move(sameEntry);
+	CHECK(entry.getString() == longText);
+}
+
+
+// The previous layout kept one map per object, allocating the map, its buckets and a node and a holder per value. The
+// values are copied before they are measured, so memory released while they were set up isn't counted.
+static size_t measureMapLayout(void (*setValues)(std::unordered_map<const void*,boost::any>&, const void* const*)) {
+	static const int keys[5] = {};
+	static const void* const keyPointers[] = { &keys[0], &keys[1], &keys[2], &keys[3], &keys[4] };
+
+	std::unordered_map<const void*,boost::any> map;
+	setValues(map, keyPointers);
+
+	size_t bytes = allocatedBytes;
+	size_t allocations = liveAllocations;
+
+	auto copy = new std::unordered_map<const void*,boost::any>(map);
+	size_t size = allocatedBytes - bytes;
+
+	delete copy;
+	CHECK(liveAllocations == allocations);
+
+	return size;
+}
+
+
+// Not a check but a measurement: prints the heap bytes of typical item attributes in the previous and the current layout.
+static void measureItemSizes(const attributes::SchemeP& scheme) {
+	struct Case {
+		const char* description;
+		void        (*setMap)(std::unordered_map<const void*,boost::any>&, const void* const*);
+		void        (*setValues)(Values&);
+	};
+
+	static const Case cases[] = {
+		{
+			"decaying item (2 integers)",
+			[](std::unordered_map<const void*,boost::any>& map, const void* const* keys) {
+				map[keys[0]] = int32_t(60);
+				map[keys[1]] = int32_t(1);
+			},
+			[](Values& values) {
+				values.set(ATTRIBUTE_COUNT, 60);
+				values.set(ATTRIBUTE_WEIGHT, 1.0f);
+			}
+		},
+		{
+			"written item (2 strings, 1 integer)",
+			[](std::unordered_map<const void*,boost::any>& map, const void* const* keys) {
+				map[keys[0]] = longText;
+				map[keys[1]] = std::string("writer");
+				map[keys[2]] = int32_t(1234567890);
+			},
+			[](Values& values) {
+				values.set(ATTRIBUTE_TEXT, longText);
+				values.set(ATTRIBUTE_WRITER, std::string("writer"));
+				values.set(ATTRIBUTE_COUNT, 1234567890);
+			}
+		},
+	};
+
+	for (const auto& testCase : cases) {
+		size_t mapSize = measureMapLayout(testCase.setMap);
+
+		Values values(scheme);
+		testCase.setValues(values);
+
+		size_t bytes = allocatedBytes;
+		size_t allocations = liveAllocations;
+		{
+			Values copy(scheme);
+			copy = values;
+
+			size_t valuesSize = allocatedBytes - bytes;
+
+			// the reported size only leaves out the array length which new[] stores in front of the entries
+			CHECK(copy.getHeapSize() <= valuesSize && valuesSize <= copy.getHeapSize() + sizeof(size_t));
+
+			std::cout << testCase.description << ": " << mapSize << " bytes in a map, " << valuesSize << " bytes allocated by values ("
+				<< copy.getHeapSize() << " bytes reported)." << std::endl;
+		}
+		CHECK(liveAllocations == allocations);
+	}
+}
+
+
+int main() {
+	auto scheme = createScheme();
+
+	size_t allocations = liveAllocations;
+
+	testSetAndGet(scheme);
+	testCopyAndMove(scheme);
+	testOverwriteType(scheme);
+	testRemove(scheme);
+	testSelfAssignment(scheme);
+	measureItemSizes(scheme);
+
+	// every test released all of its values
+	CHECK(liveAllocations == allocations);
+
+	if (failures != 0) {
+		std::cerr << failures << " check(s) failed." << std::endl;
+		return 1;
+	}
+
+	return 0;
+}
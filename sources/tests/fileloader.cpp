@@ -0,0 +1,220 @@
+////////////////////////////////////////////////////////////////////////
+// OpenTibia - an opensource roleplaying game
+////////////////////////////////////////////////////////////////////////
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+////////////////////////////////////////////////////////////////////////
+
+#include "otpch.h"
+
+#include <random>
+
+#include "fileloader.h"
+
+
+static int failures = 0;
+
+#define CHECK(condition) \
+	do { \
+		if (!(condition)) { \
+			std::cerr << __FILE__ << ":" << __LINE__ << ": check failed: " #condition << std::endl; \
+			++failures; \
+		} \
+	} while (false)
+
+
+// Writes a random node tree. Node types are written raw as both loaders read them, including the special bytes.
+class TreeWriter {
+
+public:
+
+	TreeWriter(uint64_t seed)
+		: _random(seed)
+	{}
+
+
+	std::vector<uint8_t> write(uint32_t nodeCount) {
+		_data.assign(4, 0);
+		_remainingNodes = nodeCount;
+
+		writeNode(0);
+
+		return std::move(_data);
+	}
+
+
+private:
+
+	void writeByte(uint8_t byte, bool escape) {
+		if (escape && byte >= 0xFD) {
+			_data.push_back(0xFD);
+		}
+
+		_data.push_back(byte);
+	}
+
+
+	void writeNode(uint32_t depth) {
+		--_remainingNodes;
+
+		writeByte(0xFE, false);
+		writeByte(std::uniform_int_distribution<uint32_t>(0, 9)(_random) == 0 ? 0xFD + _random() % 3 : _random() % 0xFD, false);
+
+		auto propsSize = std::uniform_int_distribution<uint32_t>(0, 40)(_random);
+		for (uint32_t i = 0; i < propsSize; ++i) {
+			// special bytes are a lot more likely than in real maps
+			writeByte(_random() % 4 == 0 ? 0xFD + _random() % 3 : _random() % 256, true);
+		}
+
+		// the root takes up all remaining nodes so that the tree reaches the requested size
+		while (_remainingNodes > 0 && (depth == 0 || (depth < 8 && std::uniform_int_distribution<uint32_t>(0, depth)(_random) == 0))) {
+			writeNode(depth + 1);
+		}
+
+		writeByte(0xFF, false);
+	}
+
+
+	std::vector<uint8_t>  _data;
+	std::mt19937_64       _random;
+	uint32_t              _remainingNodes;
+
+};
+
+
+static std::string writeFile(const std::vector<uint8_t>& data) {
+	char path[] = "/tmp/fileloader-test-XXXXXX";
+	auto fd = mkstemp(path);
+	if (fd == -1) {
+		return "";
+	}
+
+	auto written = ::write(fd, data.data(), data.size());
+	close(fd);
+
+	if (written != static_cast<ssize_t>(data.size())) {
+		unlink(path);
+		return "";
+	}
+
+	return path;
+}
+
+
+static uint32_t compareNodes(FileLoader& streamed, const NodeStruct* streamedNode, FileLoader& mapped, const NodeStruct* mappedNode) {
+	uint32_t count = 0;
+	while (streamedNode != nullptr && mappedNode != nullptr) {
+		++count;
+
+		uint32_t streamedType, mappedType;
+		auto streamedChild = streamed.getChildNode(streamedNode, streamedType);
+		auto mappedChild = mapped.getChildNode(mappedNode, mappedType);
+
+		CHECK(streamedNode->type == mappedNode->type);
+
+		uint32_t streamedSize, mappedSize;
+		auto streamedProps = streamed.getProps(streamedNode, streamedSize);
+		std::vector<uint8_t> streamedCopy(streamedProps, streamedProps + (streamedProps != nullptr ? streamedSize : 0));
+		auto mappedProps = mapped.getProps(mappedNode, mappedSize);
+		CHECK(mappedProps != nullptr);
+		CHECK(std::vector<uint8_t>(mappedProps, mappedProps + mappedSize) == streamedCopy);
+
+		CHECK((streamedChild == nullptr) == (mappedChild == nullptr));
+		count += compareNodes(streamed, streamedChild, mapped, mappedChild);
+
+		streamedNode = streamed.getNextNode(streamedNode, streamedType);
+		mappedNode = mapped.getNextNode(mappedNode, mappedType);
+	}
+
+	CHECK(streamedNode == nullptr && mappedNode == nullptr);
+	return count;
+}
+
+
+// Both loaders must produce the same tree, including for node types which equal one of the special bytes.
+static void testEquivalence() {
+	for (uint64_t seed = 1; seed <= 200; ++seed) {
+		auto path = writeFile(TreeWriter(seed).write(seed * 5));
+		CHECK(!path.empty());
+
+		FileLoader streamed;
+		FileLoader mapped;
+		CHECK(streamed.openFile(path.c_str(), false, true));
+		CHECK(mapped.mapFile(path.c_str()));
+
+		uint32_t type;
+		CHECK(compareNodes(streamed, streamed.getChildNode(nullptr, type), mapped, mapped.getChildNode(nullptr, type)) > 0);
+
+		unlink(path.c_str());
+	}
+}
+
+
+// Node types equal to the escape byte directly followed by a child used to be miscounted, so the node array grew.
+static void testEscapeNodeTypes() {
+	std::vector<uint8_t> data { 0, 0, 0, 0, 0xFE, 0xFD };
+	for (int i = 0; i < 100; ++i) {
+		data.insert(data.end(), { 0xFE, 0xFD });
+	}
+	for (int i = 0; i < 100; ++i) {
+		data.push_back(0xFF);
+	}
+	data.push_back(0xFF);
+
+	auto path = writeFile(data);
+	CHECK(!path.empty());
+
+	FileLoader streamed;
+	FileLoader mapped;
+	CHECK(streamed.openFile(path.c_str(), false, true));
+	CHECK(mapped.mapFile(path.c_str()));
+
+	uint32_t type;
+	CHECK(compareNodes(streamed, streamed.getChildNode(nullptr, type), mapped, mapped.getChildNode(nullptr, type)) == 101);
+
+	unlink(path.c_str());
+}
+
+
+// Not a check but a measurement: prints how long both loaders take to build the node tree of a large file.
+static void benchmarkLoading() {
+	auto path = writeFile(TreeWriter(0).write(500000));
+	CHECK(!path.empty());
+
+	for (auto mappedLoading : { false, true }) {
+		auto startTime = Clock::now();
+
+		FileLoader loader;
+		auto loaded = (mappedLoading ? loader.mapFile(path.c_str()) : loader.openFile(path.c_str(), false, true));
+		CHECK(loaded);
+
+		auto duration = std::chrono::duration_cast<Milliseconds>(Clock::now() - startTime);
+		std::cout << (mappedLoading ? "mapped" : "streamed") << " loading took " << duration.count() << " ms" << std::endl;
+	}
+
+	unlink(path.c_str());
+}
+
+
+int main() {
+	testEquivalence();
+	testEscapeNodeTypes();
+	benchmarkLoading();
+
+	if (failures != 0) {
+		std::cerr << failures << " check(s) failed." << std::endl;
+		return 1;
+	}
+
+	return 0;
+}
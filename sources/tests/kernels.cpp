@@ -0,0 +1,198 @@
+////////////////////////////////////////////////////////////////////////
+// OpenTibia - an opensource roleplaying game
+////////////////////////////////////////////////////////////////////////
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+////////////////////////////////////////////////////////////////////////
+
+
+#include "otpch.h"
+
+#include <random>
+
+#include "adler.h"
+#include "const.h"
+#include "xtea.h"
+
+
+static int failures = 0;
+
+#define CHECK(condition) \
+	do { \
+		if (!(condition)) { \
+			std::cerr << __FILE__ << ":" << __LINE__ << ": check failed: " #condition << std::endl; \
+			++failures; \
+		} \
+	} while (false)
+
+
+// keeps the benchmarked checksums from being optimized away
+static volatile uint32_t benchmarkResult = 0;
+
+static const SimdKernel kernels[] = { SimdKernel::SCALAR, SimdKernel::SSE2, SimdKernel::AVX2 };
+
+
+static const char* getKernelName(SimdKernel kernel) {
+	switch (kernel) {
+	case SimdKernel::SSE2: return "sse2";
+	case SimdKernel::AVX2: return "avx2";
+	default:               return "scalar";
+	}
+}
+
+
+// The textbook implementations the kernels have to match byte for byte.
+static void encryptReference(uint32_t* buffer, size_t blockCount, const uint32_t* key) {
+	for (size_t block = 0; block < blockCount; ++block, buffer += 2) {
+		uint32_t v0 = buffer[0], v1 = buffer[1], delta = 0x61C88647, sum = 0;
+		for (int32_t i = 0; i < 32; ++i) {
+			v0 += ((v1 << 4 ^ v1 >> 5) + v1) ^ (sum + key[sum & 3]);
+			sum -= delta;
+			v1 += ((v0 << 4 ^ v0 >> 5) + v0) ^ (sum + key[sum >> 11 & 3]);
+		}
+
+		buffer[0] = v0;
+		buffer[1] = v1;
+	}
+}
+
+
+static uint32_t adlerReference(const uint8_t* data, size_t length) {
+	uint32_t a = 1, b = 0;
+	for (size_t index = 0; index < length; ++index) {
+		a = (a + data[index]) % 65521;
+		b = (b + a) % 65521;
+	}
+
+	return (b << 16) | a;
+}
+
+
+static void testXteaEquivalence() {
+	std::mt19937 random(0);
+
+	for (auto kernel : kernels) {
+		if (!isSimdKernelSupported(kernel)) {
+			continue;
+		}
+
+		for (size_t blockCount = 0; blockCount <= 300; ++blockCount) {
+			uint32_t key[4];
+			for (auto& word : key) {
+				word = random();
+			}
+
+			std::vector<uint32_t> plain(2 * blockCount + 1);
+			for (auto& word : plain) {
+				word = random();
+			}
+
+			// the word past the last block must not be touched
+			auto expected = plain;
+			encryptReference(expected.data(), blockCount, key);
+
+			auto encrypted = plain;
+			xteaEncrypt(encrypted.data(), blockCount, key, kernel);
+			CHECK(encrypted == expected);
+
+			auto decrypted = encrypted;
+			xteaDecrypt(decrypted.data(), blockCount, key, kernel);
+			CHECK(decrypted == plain);
+		}
+	}
+}
+
+
+static void testAdlerEquivalence() {
+	std::mt19937 random(0);
+
+	// all bytes set to 0xFF are the worst case for the sums which are only reduced once per run
+	std::vector<uint8_t> randomData(NETWORKMESSAGE_MAXSIZE + 1), saturatedData(NETWORKMESSAGE_MAXSIZE + 1, 0xFF);
+	for (auto& byte : randomData) {
+		byte = random();
+	}
+
+	for (auto kernel : kernels) {
+		if (!isSimdKernelSupported(kernel)) {
+			continue;
+		}
+
+		for (auto* data : { &randomData, &saturatedData }) {
+			for (size_t length = 0; length <= NETWORKMESSAGE_MAXSIZE; length += (length < 1024 ? 1 : 61)) {
+				CHECK(adlerChecksum(data->data(), length, kernel) == adlerReference(data->data(), length));
+			}
+
+			CHECK(adlerChecksum(data->data(), NETWORKMESSAGE_MAXSIZE, kernel) == adlerReference(data->data(), NETWORKMESSAGE_MAXSIZE));
+			CHECK(adlerChecksum(data->data(), NETWORKMESSAGE_MAXSIZE + 1, kernel) == 0);
+		}
+	}
+}
+
+
+// Not a check but a measurement: prints the throughput of every supported kernel at typical packet sizes. Checksums are
+// only computed for messages up to NETWORKMESSAGE_MAXSIZE, so larger packets are measured at that size for Adler-32.
+static void benchmarkKernels() {
+	static const size_t packetSizes[] = { 64, 256, 1024, 4096, 16384 };
+	static const size_t bytesPerMeasurement = 8 * 1024 * 1024;
+
+	std::vector<uint8_t> data(packetSizes[sizeof(packetSizes) / sizeof(packetSizes[0]) - 1], 0x5A);
+	uint32_t key[4] = { 1, 2, 3, 4 };
+
+	for (auto kernel : kernels) {
+		if (!isSimdKernelSupported(kernel)) {
+			continue;
+		}
+
+		for (auto packetSize : packetSizes) {
+			auto iterations = bytesPerMeasurement / packetSize;
+
+			auto startTime = Clock::now();
+			for (size_t iteration = 0; iteration < iterations; ++iteration) {
+				xteaEncrypt(reinterpret_cast<uint32_t*>(data.data()), packetSize / 8, key, kernel);
+			}
+			auto xteaDuration = std::chrono::duration_cast<std::chrono::duration<double>>(Clock::now() - startTime);
+
+			size_t adlerSize = std::min(packetSize, static_cast<size_t>(NETWORKMESSAGE_MAXSIZE));
+			size_t adlerIterations = bytesPerMeasurement / adlerSize;
+
+			startTime = Clock::now();
+			for (size_t iteration = 0; iteration < adlerIterations; ++iteration) {
+				benchmarkResult = adlerChecksum(data.data(), adlerSize, kernel);
+			}
+			auto adlerDuration = std::chrono::duration_cast<std::chrono::duration<double>>(Clock::now() - startTime);
+
+			double xteaMegabytes = iterations * packetSize / (1024.0 * 1024.0);
+			double adlerMegabytes = adlerIterations * adlerSize / (1024.0 * 1024.0);
+			std::cout << getKernelName(kernel) << " " << packetSize << " bytes: xtea " << static_cast<uint32_t>(xteaMegabytes / xteaDuration.count())
+				<< " MB/s, adler " << static_cast<uint32_t>(adlerMegabytes / adlerDuration.count()) << " MB/s";
+			if (adlerSize != packetSize) {
+				std::cout << " (at " << adlerSize << " bytes)";
+			}
+			std::cout << std::endl;
+		}
+	}
+}
+
+
+int main() {
+	testXteaEquivalence();
+	testAdlerEquivalence();
+	benchmarkKernels();
+
+	if (failures != 0) {
+		std::cerr << failures << " check(s) failed." << std::endl;
+		return 1;
+	}
+
+	return 0;
+}
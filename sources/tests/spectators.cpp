@@ -0,0 +1,358 @@
+////////////////////////////////////////////////////////////////////////
+// OpenTibia - an opensource roleplaying game
+////////////////////////////////////////////////////////////////////////
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+////////////////////////////////////////////////////////////////////////
+
+
+#include "otpch.h"
+
+#include <random>
+
+#include "spectatorindex.h"
+
+
+static int failures = 0;
+
+#define CHECK(condition) \
+	do { \
+		if (!(condition)) { \
+			std::cerr << __FILE__ << ":" << __LINE__ << ": check failed: " #condition << std::endl; \
+			++failures; \
+		} \
+	} while (false)
+
+
+// The index only needs a position and reference counting from the creatures.
+class TestCreature {
+
+public:
+
+	TestCreature(const Position& position)
+		: _position(position),
+		  _references(0)
+	{}
+
+
+	const Position& getPosition() const {
+		return _position;
+	}
+
+
+	void setPosition(const Position& position) {
+		_position = position;
+	}
+
+
+private:
+
+	Position _position;
+	uint32_t _references;
+
+
+	friend void intrusive_ptr_add_ref(TestCreature* creature);
+	friend void intrusive_ptr_release(TestCreature* creature);
+
+};
+
+
+void intrusive_ptr_add_ref(TestCreature* creature) {
+	++creature->_references;
+}
+
+
+void intrusive_ptr_release(TestCreature* creature) {
+	if (--creature->_references == 0) {
+		delete creature;
+	}
+}
+
+
+typedef SpectatorIndex<TestCreature>  Index;
+typedef Index::CreatureP              TestCreatureP;
+
+
+static const uint16_t mapSize    = 1024;
+static const uint16_t blockX     = 500;
+static const uint16_t blockY     = 500;
+static const uint16_t blockSize  = 64;
+
+
+// A position within the city block, mostly on the ground floor and otherwise one floor above or below.
+static Position randomPosition(std::mt19937& random) {
+	uint32_t roll = random() % 10;
+	uint8_t z = (roll < 8 ? 7 : (roll < 9 ? 6 : 8));
+
+	return Position(static_cast<uint16_t>(blockX + random() % blockSize), static_cast<uint16_t>(blockY + random() % blockSize), z);
+}
+
+
+static std::vector<TestCreatureP> addCreatures(Index& index, uint32_t count, std::mt19937& random) {
+	std::vector<TestCreatureP> creatures;
+	for (uint32_t i = 0; i < count; ++i) {
+		TestCreatureP creature(new TestCreature(randomPosition(random)));
+		index.onCreatureMoved(creature, nullptr, &creature->getPosition());
+
+		creatures.push_back(creature);
+	}
+
+	return creatures;
+}
+
+
+// Whether the creature can be seen from the center, written down independently of the index.
+static bool canSee(const Position& center, const Position& position) {
+	if (center.z <= 7 && position.z > 7) {
+		return false;
+	}
+
+	if (center.z > 7 && std::abs(static_cast<int32_t>(center.z) - position.z) > 2) {
+		return false;
+	}
+
+	int32_t offsetZ = center.z - position.z;
+	return (std::abs(position.x - center.x - offsetZ) <= Index::maxViewportX && std::abs(position.y - center.y - offsetZ) <= Index::maxViewportY);
+}
+
+
+static bool matchesAllCreatures(const Index::List& spectators, const Position& center, const std::vector<TestCreatureP>& creatures) {
+	std::set<TestCreature*> expected;
+	for (const auto& creature : creatures) {
+		if (canSee(center, creature->getPosition())) {
+			expected.insert(creature.get());
+		}
+	}
+
+	std::set<TestCreature*> actual;
+	for (const auto& spectator : spectators) {
+		if (!actual.insert(spectator.get()).second) {
+			return false;
+		}
+	}
+
+	return (actual == expected);
+}
+
+
+// Cached lists are only searched again once a creature within their view moved, so after many moves they must still match
+// a fresh search over all creatures.
+static void testCachedListsFollowMoves() {
+	std::mt19937 random(0);
+
+	Index index;
+	index.setSize(mapSize, mapSize);
+
+	auto creatures = addCreatures(index, 500, random);
+
+	std::vector<Position> centers;
+	for (uint32_t i = 0; i < 200; ++i) {
+		centers.push_back(randomPosition(random));
+		index.getSpectators(centers.back());
+	}
+
+	for (uint32_t round = 0; round < 20; ++round) {
+		for (uint32_t move = 0; move < 200; ++move) {
+			auto& creature = creatures[random() % creatures.size()];
+			Position from = creature->getPosition();
+
+			// most creatures take a step, some jump further or leave and come back, like teleports and logouts
+			Position to = from;
+			uint32_t roll = random() % 10;
+			if (roll < 7) {
+				to.x = static_cast<uint16_t>(std::min<int32_t>(blockX + blockSize - 1, std::max<int32_t>(blockX, to.x + static_cast<int32_t>(random() % 3) - 1)));
+				to.y = static_cast<uint16_t>(std::min<int32_t>(blockY + blockSize - 1, std::max<int32_t>(blockY, to.y + static_cast<int32_t>(random() % 3) - 1)));
+			}
+			else {
+				to = randomPosition(random);
+			}
+
+			if (roll == 9) {
+				index.onCreatureMoved(creature, &from, nullptr);
+				creature->setPosition(to);
+				index.onCreatureMoved(creature, nullptr, &to);
+			}
+			else {
+				creature->setPosition(to);
+				index.onCreatureMoved(creature, &from, &to);
+			}
+		}
+
+		for (const auto& center : centers) {
+			CHECK(matchesAllCreatures(index.getSpectators(center), center, creatures));
+
+			Index::List spectators;
+			index.getSpectators(spectators, center, true, true, 0, 0, 0, 0);
+			CHECK(matchesAllCreatures(spectators, center, creatures));
+		}
+	}
+
+	CHECK(index.getCacheHits() + index.getCacheMisses() == 21 * centers.size());
+
+	// without moves in between, lists are served from the cache
+	index.resetCacheStatistics();
+	for (const auto& center : centers) {
+		index.getSpectators(center);
+	}
+
+	CHECK(index.getCacheMisses() == 0);
+	CHECK(index.getCacheHits() == centers.size());
+
+	for (const auto& creature : creatures) {
+		index.onCreatureMoved(creature, &creature->getPosition(), nullptr);
+	}
+
+	for (const auto& center : centers) {
+		CHECK(index.getSpectators(center).empty());
+	}
+}
+
+
+static void testCustomRanges() {
+	std::mt19937 random(1);
+
+	Index index;
+	index.setSize(mapSize, mapSize);
+
+	auto creatures = addCreatures(index, 300, random);
+
+	Position center(blockX + 30, blockY + 30, 7);
+
+	Index::List spectators;
+	index.getSpectators(spectators, center, false, false, 3, 5, 2, 4);
+
+	size_t expected = 0;
+	for (const auto& creature : creatures) {
+		const auto& position = creature->getPosition();
+		if (position.z == 7 && position.x >= center.x - 3 && position.x <= center.x + 5 && position.y >= center.y - 2 && position.y <= center.y + 4) {
+			++expected;
+		}
+	}
+
+	CHECK(spectators.size() == expected);
+
+	// the same creatures are not added again
+	index.getSpectators(spectators, center, true, false, 3, 5, 2, 4);
+	CHECK(spectators.size() == expected);
+
+	// other ranges are neither served from nor added to the cache
+	CHECK(index.getCacheSize() == 0);
+}
+
+
+static void stepRandomly(Index& index, const TestCreatureP& creature, std::mt19937& random) {
+	Position from = creature->getPosition();
+	Position to = from;
+	to.x = static_cast<uint16_t>(std::min<int32_t>(blockX + blockSize - 1, std::max<int32_t>(blockX, to.x + static_cast<int32_t>(random() % 3) - 1)));
+	to.y = static_cast<uint16_t>(std::min<int32_t>(blockY + blockSize - 1, std::max<int32_t>(blockY, to.y + static_cast<int32_t>(random() % 3) - 1)));
+
+	creature->setPosition(to);
+	index.onCreatureMoved(creature, &from, &to);
+}
+
+
+static void printDuration(const char* description, size_t count, Time startTime) {
+	auto duration = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - startTime);
+	std::cout << count << " " << description << " took " << (duration.count() / 1000.0) << " ms (" << (duration.count() * 1000 / count) << " ns each)" << std::endl;
+}
+
+
+// Not a check but a measurement: prints how long spectator lookups take with 2,000 creatures packed into one city block.
+// Lookups are measured on their own, after each creature's step at both ends of it, and after a few steps within the
+// block. With the cache dropped after every move, as the dispatcher did after every task, each lookup searches the cells.
+static void benchmarkLookups() {
+	std::mt19937 random(2);
+
+	Index index;
+	index.setSize(mapSize, mapSize);
+
+	auto creatures = addCreatures(index, 2000, random);
+
+	static const uint32_t rounds = 10;
+
+	size_t spectatorCount = 0;
+
+	for (const auto& creature : creatures) {
+		index.getSpectators(creature->getPosition());
+	}
+
+	auto startTime = Clock::now();
+	for (uint32_t round = 0; round < rounds; ++round) {
+		for (const auto& creature : creatures) {
+			spectatorCount += index.getSpectators(creature->getPosition()).size();
+		}
+	}
+	printDuration("cached lookups", rounds * creatures.size(), startTime);
+
+	startTime = Clock::now();
+	for (uint32_t round = 0; round < rounds; ++round) {
+		for (const auto& creature : creatures) {
+			Index::List spectators;
+			index.getSpectators(spectators, creature->getPosition(), true, true, 0, 0, 0, 0);
+			spectatorCount += spectators.size();
+		}
+	}
+	printDuration("uncached lookups", rounds * creatures.size(), startTime);
+
+	for (auto keepCache : { true, false }) {
+		startTime = Clock::now();
+		for (uint32_t round = 0; round < rounds; ++round) {
+			for (const auto& creature : creatures) {
+				Position from = creature->getPosition();
+				stepRandomly(index, creature, random);
+
+				if (!keepCache) {
+					index.clearCache();
+				}
+
+				spectatorCount += index.getSpectators(from).size();
+				spectatorCount += index.getSpectators(creature->getPosition()).size();
+			}
+		}
+		printDuration(keepCache ? "steps with lookups at both ends using the cache" : "steps with lookups at both ends dropping the cache", rounds * creatures.size(), startTime);
+	}
+
+	for (auto keepCache : { true, false }) {
+		startTime = Clock::now();
+		for (uint32_t round = 0; round < rounds; ++round) {
+			for (uint32_t step = 0; step < 5; ++step) {
+				stepRandomly(index, creatures[random() % creatures.size()], random);
+
+				if (!keepCache) {
+					index.clearCache();
+				}
+			}
+
+			for (const auto& creature : creatures) {
+				spectatorCount += index.getSpectators(creature->getPosition()).size();
+			}
+		}
+		printDuration(keepCache ? "lookups after 5 steps each round using the cache" : "lookups after 5 steps each round dropping the cache", rounds * creatures.size(), startTime);
+	}
+
+	CHECK(spectatorCount > 0);
+}
+
+
+int main() {
+	testCachedListsFollowMoves();
+	testCustomRanges();
+	benchmarkLookups();
+
+	if (failures != 0) {
+		std::cerr << failures << " check(s) failed." << std::endl;
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,190 @@
+////////////////////////////////////////////////////////////////////////
+// OpenTibia - an opensource roleplaying game
+////////////////////////////////////////////////////////////////////////
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+////////////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include <iostream>
+#include <list>
+#include <memory>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+#include <stdint.h>
+
+#include "timingwheel.h"
+
+
+static int failures = 0;
+
+#define CHECK(condition) \
+	do { \
+		if (!(condition)) { \
+			std::cerr << __FILE__ << ":" << __LINE__ << ": check failed: " #condition << std::endl; \
+			++failures; \
+		} \
+	} while (false)
+
+
+typedef TimingWheel<uint64_t>  Wheel;
+
+
+// Every value is its own due tick and must be released exactly at that tick.
+static void advanceAndVerify(Wheel& wheel, uint64_t tick, size_t& released) {
+	wheel.advanceTo(tick, [&](uint64_t dueTick) {
+		CHECK(wheel.currentTick() == dueTick);
+		++released;
+	});
+
+	CHECK(wheel.currentTick() == tick);
+}
+
+
+static void testLevelBoundaries() {
+	static const uint64_t ticks[] = {
+		1, 2, 254, 255, 256, 257, 300, 510, 511, 512, 513,
+		65535, 65536, 65537, 65791, 65792, 100000,
+		(UINT64_C(1) << 24) - 1, UINT64_C(1) << 24, (UINT64_C(1) << 24) + 255,
+	};
+
+	// advance one tick at a time as well as in large jumps
+	for (auto step : { UINT64_C(1), UINT64_C(97), UINT64_C(4096), UINT64_C(1) << 25 }) {
+		auto endTick = (step == 1 ? UINT64_C(1) << 17 : UINT64_C(1) << 25);
+
+		Wheel wheel;
+		Wheel::Id id = 0;
+		size_t expected = 0;
+		for (auto tick : ticks) {
+			CHECK(wheel.insert(++id, tick, tick));
+			if (tick <= endTick) {
+				++expected;
+			}
+		}
+
+		size_t released = 0;
+		for (uint64_t tick = 0; tick < endTick; ) {
+			tick = std::min(tick + step, endTick);
+			advanceAndVerify(wheel, tick, released);
+		}
+
+		CHECK(released == expected);
+		CHECK(wheel.empty() == (expected == id));
+	}
+}
+
+
+static void testInsertionWhileTurning() {
+	// a task due 255+ ticks ahead used to be cascaded back into the slot being drained
+	Wheel wheel;
+	size_t released = 0;
+
+	advanceAndVerify(wheel, 255, released);
+	CHECK(wheel.insert(1, 511, 511));
+	CHECK(wheel.insert(2, 512, 512));
+	CHECK(wheel.insert(3, 255 + 65536, 255 + 65536));
+	advanceAndVerify(wheel, 70000, released);
+	CHECK(released == 3);
+
+	// values which are already due run with the next tick
+	wheel.insert(4, 0, 70001);
+	advanceAndVerify(wheel, 70001, released);
+	CHECK(released == 4);
+	CHECK(wheel.empty());
+}
+
+
+static void testRandomized() {
+	std::mt19937_64 random(42);
+	std::uniform_int_distribution<uint64_t> delays(0, 200000);
+
+	Wheel wheel;
+	size_t inserted = 0;
+	size_t released = 0;
+	Wheel::Id id = 0;
+
+	for (uint64_t tick = 0; tick < 400000; tick += 37) {
+		for (int i = 0; i < 3; ++i) {
+			auto dueTick = tick + 1 + delays(random);
+			CHECK(wheel.insert(++id, dueTick, dueTick));
+			++inserted;
+		}
+
+		if (id % 5 == 0 && wheel.erase(id - 1)) {
+			--inserted;
+		}
+
+		advanceAndVerify(wheel, tick + 37, released);
+	}
+
+	advanceAndVerify(wheel, 400000 + 200001, released);
+	CHECK(released == inserted);
+	CHECK(wheel.empty());
+}
+
+
+static void testErase() {
+	Wheel wheel;
+	CHECK(wheel.insert(1, 1000, 1000));
+	CHECK(!wheel.insert(1, 2000, 2000));
+	CHECK(wheel.erase(1));
+	CHECK(!wheel.erase(1));
+	CHECK(wheel.empty());
+
+	size_t released = 0;
+	advanceAndVerify(wheel, 5000, released);
+	CHECK(released == 0);
+}
+
+
+// Cancelled values, like scheduler tasks holding creatures, must be destroyed right away and not once their slot comes
+// up, no matter which level of the wheel they wait in.
+static void testEraseDestroysValue() {
+	static const uint64_t ticks[] = { 1, 255, 256, 65536, UINT64_C(1) << 24, UINT64_C(1) << 40 };
+
+	TimingWheel<std::shared_ptr<int>> wheel;
+	wheel.advanceTo(100, [](std::shared_ptr<int>&) {});
+
+	uint32_t id = 0;
+	for (auto delay : ticks) {
+		auto value = std::make_shared<int>(0);
+		std::weak_ptr<int> weakValue = value;
+
+		++id;
+		CHECK(wheel.insert(id, wheel.currentTick() + delay, std::move(value)));
+		CHECK(!weakValue.expired());
+
+		CHECK(wheel.erase(id));
+		CHECK(weakValue.expired());
+	}
+
+	CHECK(wheel.empty());
+}
+
+
+int main() {
+	testLevelBoundaries();
+	testInsertionWhileTurning();
+	testRandomized();
+	testErase();
+	testEraseDestroysValue();
+
+	if (failures != 0) {
+		std::cerr << failures << " check(s) failed." << std::endl;
+		return 1;
+	}
+
+	return 0;
+}
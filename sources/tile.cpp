@@ -33,6 +33,7 @@
 
 #include "game.h"
 #include "configmanager.h"
+#include "networkmessage.h"
 #include "server.h"
 #include "world.h"
 
@@ -184,7 +185,6 @@ ReturnValue Tile::addCreature(const CreatureP& creature, uint32_t flags, const C
 		creature->setLastPosition(pos);
 	}
 
-	game.clearSpectatorCache();
 	creature->setParent(this);
 
 	if (previousTile != nullptr) {
@@ -408,6 +408,44 @@ Tile* Tile::getCreatureForwardingTile(const Creature& creature) const {
 }
 
 
+const Tile::EncodedItems& Tile::getEncodedItems() const {
+	if (_encodedItems == nullptr) {
+		_encodedItems.reset(new EncodedItems);
+	}
+	else if (_encodedItems->version == _version) {
+		return *_encodedItems;
+	}
+
+	auto& encodedItems = *_encodedItems;
+	encodedItems.bytes.clear();
+	encodedItems.topThingCount = 0;
+	encodedItems.version = _version;
+
+	if (ground != nullptr) {
+		NetworkMessage::AppendItem(encodedItems.bytes, ground.get());
+		++encodedItems.topThingCount;
+	}
+
+	auto items = getItemList();
+	if (items != nullptr) {
+		for (auto it = items->getBeginTopItem(); it != items->getEndTopItem(); ++it) {
+			NetworkMessage::AppendItem(encodedItems.bytes, it->get());
+			++encodedItems.topThingCount;
+		}
+	}
+
+	encodedItems.downItemsOffset = encodedItems.bytes.size();
+
+	if (items != nullptr) {
+		for (auto it = items->getBeginDownItem(); it != items->getEndDownItem(); ++it) {
+			NetworkMessage::AppendItem(encodedItems.bytes, it->get());
+		}
+	}
+
+	return encodedItems;
+}
+
+
 Tile* Tile::getForwardingDestinationTile() const {
 	if (!isForwarder()) {
 		return nullptr;
@@ -544,7 +582,6 @@ ReturnValue Tile::removeCreature(const CreatureP& creature, const CreatureP& act
 
 	--thingCount;
 
-	game.clearSpectatorCache();
 	creature->setParent(nullptr);
 
 	LOGt(creature << " removed from " << position << ".");
@@ -1157,6 +1194,7 @@ void Tile::onAddTileItem(Item* item)
 
 void Tile::onUpdateTileItem(Item* oldItem, const ItemKindPC& oldType, Item* newItem, const ItemKindPC& newType)
 {
+	++_version;
 	const Position& cylinderMapPos = pos;
 
 	const SpectatorList& list = server.game().getSpectators(cylinderMapPos);
@@ -2177,6 +2215,9 @@ void Tile::__internalAddThing(uint32_t index, Item* item)
 
 void Tile::updateTileFlags(Item* item, bool removed)
 {
+	// every change of the items passes through here
+	++_version;
+
 	if(!removed)
 	{
 		if(!hasFlag(TILESTATE_FLOORCHANGE))
@@ -2254,6 +2295,9 @@ void Tile::updateTileFlags(Item* item, bool removed)
 		if(item->getContainer() && item->getContainer()->getDepot())
 			setFlag(TILESTATE_DEPOT);
 
+		if(item->hasProperty(BLOCKPROJECTILE))
+			setFlag(TILESTATE_BLOCKPROJECTILE);
+
 		if(item->hasProperty(BLOCKSOLID))
 			setFlag(TILESTATE_BLOCKSOLID);
 
@@ -2343,6 +2387,9 @@ void Tile::updateTileFlags(Item* item, bool removed)
 		if(item->getContainer() && item->getContainer()->getDepot())
 			resetFlag(TILESTATE_DEPOT);
 
+		if(item->hasProperty(BLOCKPROJECTILE) && !hasProperty(item, BLOCKPROJECTILE))
+			resetFlag(TILESTATE_BLOCKPROJECTILE);
+
 		if(item->hasProperty(BLOCKSOLID) && !hasProperty(item, BLOCKSOLID))
 			resetFlag(TILESTATE_BLOCKSOLID);
 
@@ -2361,6 +2408,9 @@ void Tile::updateTileFlags(Item* item, bool removed)
 		if(item->hasProperty(IMMOVABLENOFIELDBLOCKPATH) && !hasProperty(item, IMMOVABLENOFIELDBLOCKPATH))
 			resetFlag(TILESTATE_IMMOVABLENOFIELDBLOCKPATH);
 	}
+
+	if(Map* map = server.game().getMap())
+		map->updateTileStates(this);
 }
 
 
@@ -43,6 +43,7 @@ enum tileflags_t
 {
 	TILESTATE_NONE = 0,
 	TILESTATE_PROTECTIONZONE = 1 << 0,
+	TILESTATE_BLOCKPROJECTILE = 1 << 1,
 	TILESTATE_NOPVPZONE = 1 << 2,
 	TILESTATE_NOLOGOUT = 1 << 3,
 	TILESTATE_PVPZONE = 1 << 4,
@@ -134,9 +135,20 @@ class Tile : public Cylinder {
 
 public:
 
+	// The items of the tile as they are sent to clients. Ground and top items come first, then the creatures which are
+	// encoded for each client, then the down items.
+	struct EncodedItems {
+		std::string bytes;
+		uint32_t    downItemsOffset;
+		uint32_t    topThingCount;
+		uint32_t    version;
+	};
+
+
 	ReturnValue         addCreature                        (const CreatureP& creature, uint32_t flags = 0, const CreatureP& actor = nullptr);
 	Tile*               getAvailableItemForwardingTile     (const Item& item) const;
 	Tile*               getCreatureForwardingTile          (const Creature& creature) const;
+	const EncodedItems& getEncodedItems                    () const;
 	Position            getForwardingDestination           () const;
 	Tile*               getForwardingDestinationTile       () const;
 	ItemP               getGround                          () const;
@@ -166,7 +178,9 @@ private:
 	};
 
 
-	uint32_t _lockCount;
+	mutable Unique<EncodedItems> _encodedItems;
+	uint32_t                     _lockCount;
+	uint32_t                     _version;
 
 
 	public:
@@ -368,7 +382,7 @@ class StaticTile : public Tile
 		CreatureVector* makeCreatures() {return (creatures) ? (creatures) : (creatures = new CreatureVector);}
 };
 
-inline Tile::Tile(uint16_t x, uint16_t y, uint16_t z): _lockCount(0), ground(nullptr), pos(x, y, z), m_flags(0), thingCount(0) {}
+inline Tile::Tile(uint16_t x, uint16_t y, uint16_t z): _lockCount(0), _version(0), ground(nullptr), pos(x, y, z), m_flags(0), thingCount(0) {}
 
 inline CreatureVector* Tile::getCreatures()
 {
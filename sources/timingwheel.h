@@ -0,0 +1,198 @@
+////////////////////////////////////////////////////////////////////////
+// OpenTibia - an opensource roleplaying game
+////////////////////////////////////////////////////////////////////////
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+////////////////////////////////////////////////////////////////////////
+
+#ifndef _TIMINGWHEEL_H
+#define _TIMINGWHEEL_H
+
+
+// A hierarchical timing wheel. Each level has 256 slots and covers 256 times the range of the level below it. Values
+// are due at an absolute tick and released by advanceTo() once the wheel reaches that tick. Not thread-safe.
+template<typename Value>
+class TimingWheel {
+
+public:
+
+	typedef uint32_t  Id;
+
+
+	TimingWheel()
+		: _currentTick(0)
+	{}
+
+
+	// Calls callback(value) for every value which is due up to and including the given tick.
+	template<typename Callback>
+	void advanceTo(uint64_t tick, Callback callback) {
+		while (_currentTick < tick) {
+			auto eventTick = nextEventTick();
+			if (eventTick > tick) {
+				_currentTick = tick;
+				break;
+			}
+
+			_currentTick = eventTick;
+
+			if ((eventTick & wheelMask) == 0) {
+				cascade(eventTick);
+			}
+
+			Slot dueEntries;
+			dueEntries.splice(dueEntries.end(), _wheel[0][eventTick & wheelMask]);
+
+			for (auto& entry : dueEntries) {
+				_locations.erase(entry.id);
+				callback(entry.value);
+			}
+		}
+	}
+
+
+	void clear() {
+		for (auto& level : _wheel) {
+			for (auto& slot : level) {
+				slot.clear();
+			}
+		}
+
+		_currentTick = 0;
+		_locations.clear();
+	}
+
+
+	uint64_t currentTick() const {
+		return _currentTick;
+	}
+
+
+	bool empty() const {
+		return _locations.empty();
+	}
+
+
+	bool erase(Id id) {
+		auto location = _locations.find(id);
+		if (location == _locations.end()) {
+			return false;
+		}
+
+		location->second.slot->erase(location->second.iterator);
+		_locations.erase(location);
+
+		return true;
+	}
+
+
+	// Values which are already due are released with the next tick. Returns false if the id is already in use.
+	bool insert(Id id, uint64_t tick, Value value) {
+		if (_locations.find(id) != _locations.end()) {
+			return false;
+		}
+
+		Slot incomingEntries;
+		incomingEntries.push_back(Entry { id, tick, std::move(value) });
+		place(incomingEntries, incomingEntries.begin(), 1);
+
+		return true;
+	}
+
+
+	// Either the next occupied slot of the lowest level or the next time the higher levels cascade.
+	uint64_t nextEventTick() const {
+		auto boundaryTick = (_currentTick | wheelMask) + 1;
+		for (auto tick = _currentTick + 1; tick < boundaryTick; ++tick) {
+			if (!_wheel[0][tick & wheelMask].empty()) {
+				return tick;
+			}
+		}
+
+		return boundaryTick;
+	}
+
+
+
+private:
+
+	static const uint32_t wheelBits   = 8;
+	static const uint32_t wheelLevels = 4;
+	static const uint32_t wheelSize   = 1 << wheelBits;
+	static const uint32_t wheelMask   = wheelSize - 1;
+
+	struct Entry {
+		Id       id;
+		uint64_t tick;
+		Value    value;
+	};
+
+	typedef std::list<Entry>  Slot;
+
+	struct Location {
+		Slot*                    slot;
+		typename Slot::iterator  iterator;
+	};
+
+
+	// Must be called with _currentTick already set to the boundary tick. The cascading slot is moved aside first as
+	// entries may be placed into the very slot they came from otherwise.
+	void cascade(uint64_t tick) {
+		for (uint32_t level = 1; level < wheelLevels; ++level) {
+			auto index = (tick >> (level * wheelBits)) & wheelMask;
+
+			Slot cascadingEntries;
+			cascadingEntries.splice(cascadingEntries.end(), _wheel[level][index]);
+
+			// entries due at this very tick go to the lowest level slot which is about to be released
+			while (!cascadingEntries.empty()) {
+				place(cascadingEntries, cascadingEntries.begin(), 0);
+			}
+
+			if (index != 0) {
+				break;
+			}
+		}
+	}
+
+
+	void place(Slot& source, typename Slot::iterator iterator, uint64_t minimumDelta) {
+		auto tick = iterator->tick;
+
+		uint64_t delta = minimumDelta;
+		if (tick > _currentTick + minimumDelta) {
+			// entries too far in the future are parked in the farthest slot and placed again once it cascades
+			delta = std::min<uint64_t>(tick - _currentTick, (UINT64_C(1) << (wheelLevels * wheelBits)) - 1);
+		}
+
+		tick = _currentTick + delta;
+
+		uint32_t level = 0;
+		while (level < wheelLevels - 1 && delta >= (UINT64_C(1) << ((level + 1) * wheelBits))) {
+			++level;
+		}
+
+		auto& slot = _wheel[level][(tick >> (level * wheelBits)) & wheelMask];
+		slot.splice(slot.end(), source, iterator);
+
+		_locations[iterator->id] = Location { &slot, iterator };
+	}
+
+
+	uint64_t                          _currentTick;
+	std::unordered_map<Id,Location>   _locations;
+	Slot                              _wheel[wheelLevels][wheelSize];
+
+};
+
+#endif // _TIMINGWHEEL_H
@@ -95,6 +95,49 @@ std::string transformToSHA1(std::string plainText, bool upperCase)
 	return hexStr;
 }
 
+std::string hashFiles(const StringVector& filePaths)
+{
+	//FNV-1a over the size and content of every file, empty if one of them cannot be read; the content is taken eight
+	//bytes at a time since the multiplications can't run in parallel and a byte at a time is slower than reading the files
+	uint64_t hash = UINT64_C(14695981039346656037);
+	auto addWord = [&hash](uint64_t word)
+	{
+		hash ^= word;
+		hash *= UINT64_C(1099511628211);
+	};
+
+	for(const std::string& filePath : filePaths)
+	{
+		std::ifstream file(filePath, std::ios::binary | std::ios::ate);
+		if(!file)
+			return "";
+
+		uint64_t size = file.tellg();
+		file.seekg(0, std::ios::beg);
+
+		std::string content(size, '\0');
+		if(!file.read(&content[0], size))
+			return "";
+
+		addWord(size);
+
+		size_t offset = 0;
+		for(; offset + sizeof(uint64_t) <= content.size(); offset += sizeof(uint64_t))
+		{
+			uint64_t word;
+			memcpy(&word, content.data() + offset, sizeof(word));
+			addWord(word);
+		}
+
+		for(; offset < content.size(); ++offset)
+			addWord(static_cast<uint8_t>(content[offset]));
+	}
+
+	std::ostringstream stream;
+	stream << std::hex << std::setw(16) << std::setfill('0') << hash;
+	return stream.str();
+}
+
 std::string transformToMD5(std::string plainText, bool upperCase)
 {
 	MD5_CTX m_md5;
@@ -1488,31 +1531,6 @@ bool fileExists(const char* filename)
 	return true;
 }
 
-uint32_t adlerChecksum(uint8_t *data, size_t length)
-{
-	if(length > NETWORKMESSAGE_MAXSIZE)
-		return 0;
-
-	const uint16_t adler = 65521;
-	uint32_t a = 1, b = 0;
-	while(length > 0)
-	{
-		size_t tmp = length > 5552 ? 5552 : length;
-		length -= tmp;
-		do
-		{
-			a += *data++;
-			b += a;
-		}
-		while(--tmp);
-
-		a %= adler;
-		b %= adler;
-	}
-
-	return (b << 16) | a;
-}
-
 std::string getFilePath(FileType filetype, std::string filename)
 {
 	std::string path = server.configManager().getString(ConfigManager::DATA_DIRECTORY);
@@ -34,6 +34,7 @@ CombatTypeIndex combatTypeIndexFromCombatType(CombatType_t combatType);
 
 std::string transformToMD5(std::string plainText, bool upperCase);
 std::string transformToSHA1(std::string plainText, bool upperCase);
+std::string hashFiles(const StringVector& filePaths);
 
 void _encrypt(std::string& str, bool upperCase);
 bool encryptTest(std::string plain, std::string hash);
@@ -136,7 +137,6 @@ bool parseVocationNode(xmlNodePtr vocationNode, VocationMap& vocationMap, String
 bool parseIntegerVec(std::string str, IntegerVec& intVector);
 
 bool fileExists(const char* filename);
-uint32_t adlerChecksum(uint8_t *data, size_t length);
 
 std::string getFilePath(FileType filetype, std::string filename);
 
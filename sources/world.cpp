@@ -21,16 +21,39 @@
 #include "otpch.h"
 #include "world.h"
 
+#include "account.h"
 #include "game.h"
 #include "monster.h"
 #include "npc.h"
 #include "player.h"
 #include "server.h"
 #include "tile.h"
+#include "tools.h"
 
 
 LOGGER_DEFINITION(World);
 
+namespace {
+
+template<typename Index, typename Key>
+void removePlayerFromIndex(Index& index, const Key& key, const World::PlayerP& player) {
+	auto entry = index.find(key);
+	if (entry == index.end()) {
+		return;
+	}
+
+	auto& players = entry->second;
+	players.erase(std::remove(players.begin(), players.end(), player), players.end());
+
+	if (players.empty()) {
+		index.erase(entry);
+	}
+}
+
+}
+
+const World::Players World::NO_PLAYERS;
+
 const World::CreatureId World::MAXIMUM_MONSTER_ID = 0x4FFFFFFF;
 const World::CreatureId World::MINIMUM_MONSTER_ID = 0x40000000;
 const World::CreatureId World::MAXIMUM_NPC_ID     = 0x8FFFFFFF;
@@ -89,6 +112,10 @@ ReturnValue World::addCreature(const CreatureP& creature, const Position& positi
 	creature->setId(id);
 	creature->setInWorld(true);
 
+	if (auto player = creature->getPlayer()) {
+		indexPlayer(player);
+	}
+
 	auto result = findTileResult.getTile()->addCreature(creature, findTileResult.getFlags());
 	assert(result == RET_NOERROR);
 
@@ -275,16 +302,107 @@ auto World::getNpcs() const -> const Npcs& {
 }
 
 
+auto World::getPlayerByGuid(uint32_t guid) const -> PlayerP {
+	auto i = _playersByGuid.find(guid);
+	if (i == _playersByGuid.end()) {
+		return nullptr;
+	}
+
+	return i->second.front();
+}
+
+
 auto World::getPlayerById(CreatureId id) const -> PlayerP {
 	return _playersById.get(id);
 }
 
 
+auto World::getPlayerByName(const std::string& name) const -> PlayerP {
+	auto& players = getPlayersByName(name);
+	if (players.empty()) {
+		return nullptr;
+	}
+
+	return players.front();
+}
+
+
 auto World::getPlayers() const -> const Players& {
 	return _players;
 }
 
 
+auto World::getPlayersByAccount(uint32_t accountId) const -> const Players& {
+	auto i = _playersByAccount.find(accountId);
+	if (i == _playersByAccount.end()) {
+		return NO_PLAYERS;
+	}
+
+	return i->second;
+}
+
+
+auto World::getPlayersByIp(uint32_t ip) const -> const Players& {
+	auto i = _playersByIp.find(ip);
+	if (i == _playersByIp.end()) {
+		return NO_PLAYERS;
+	}
+
+	return i->second;
+}
+
+
+auto World::getPlayersByName(const std::string& name) const -> const Players& {
+	auto i = _playersByName.find(asLowerCaseString(name));
+	if (i == _playersByName.end()) {
+		return NO_PLAYERS;
+	}
+
+	return i->second;
+}
+
+
+auto World::getPlayersByNamePrefix(const std::string& prefix, size_t limit) const -> Players {
+	auto lowerCasePrefix = asLowerCaseString(prefix);
+
+	// names with the same prefix are next to each other in the sorted index
+	Players players;
+	for (auto i = _playersBySortedName.lower_bound(lowerCasePrefix); i != _playersBySortedName.end() && players.size() < limit; ++i) {
+		if (i->first.compare(0, lowerCasePrefix.length(), lowerCasePrefix) != 0) {
+			break;
+		}
+
+		for (auto& player : i->second) {
+			if (players.size() >= limit) {
+				break;
+			}
+
+			players.push_back(player);
+		}
+	}
+
+	return players;
+}
+
+
+void World::indexPlayer(const PlayerP& player) {
+	auto name = asLowerCaseString(player->getName());
+	_playersByName[name].push_back(player);
+	_playersBySortedName[name].push_back(player);
+
+	// the account manager characters of different clients share their guid
+	_playersByGuid[player->getGUID()].push_back(player);
+
+	if (player->getAccount() != nullptr) {
+		_playersByAccount[player->getAccount()->getId()].push_back(player);
+	}
+
+	auto ip = player->getIP();
+	_playersByIp[ip].push_back(player);
+	_playerIps[player->getId()] = ip;
+}
+
+
 ReturnValue World::removeCreature(const CreatureP& creature) {
 	assert(creature != nullptr);
 
@@ -317,6 +435,7 @@ ReturnValue World::removeCreature(const CreatureP& creature) {
 		}
 	}
 	else if (auto player = creature->getPlayer()) { // less likely
+		unindexPlayer(player);
 		_playersById.erase(creature->getId());
 
 		auto i = std::find(_players.begin(), _players.end(), player);
@@ -351,6 +470,42 @@ ReturnValue World::removeCreature(const CreatureP& creature) {
 }
 
 
+void World::unindexPlayer(const PlayerP& player) {
+	auto name = asLowerCaseString(player->getName());
+	removePlayerFromIndex(_playersByName, name, player);
+	removePlayerFromIndex(_playersBySortedName, name, player);
+
+	removePlayerFromIndex(_playersByGuid, player->getGUID(), player);
+
+	if (player->getAccount() != nullptr) {
+		removePlayerFromIndex(_playersByAccount, player->getAccount()->getId(), player);
+	}
+
+	auto ip = _playerIps.find(player->getId());
+	if (ip != _playerIps.end()) {
+		removePlayerFromIndex(_playersByIp, ip->second, player);
+		_playerIps.erase(ip);
+	}
+}
+
+
+void World::updatePlayerIp(const PlayerP& player) {
+	auto previousIp = _playerIps.find(player->getId());
+	if (previousIp == _playerIps.end()) {
+		return;
+	}
+
+	auto ip = player->getIP();
+	if (ip == previousIp->second) {
+		return;
+	}
+
+	removePlayerFromIndex(_playersByIp, previousIp->second, player);
+	_playersByIp[ip].push_back(player);
+	previousIp->second = ip;
+}
+
+
 
 
 World::FindTileResult::FindTileResult(Tile* tile, uint32_t flags)
@@ -62,15 +62,35 @@ public:
 	const Monsters&  getMonsters                  () const;
 	NpcP             getNpcById                   (CreatureId id) const;
 	const Npcs&      getNpcs                      () const;
+	PlayerP          getPlayerByGuid              (uint32_t guid) const;
 	PlayerP          getPlayerById                (CreatureId id) const;
+	PlayerP          getPlayerByName              (const std::string& name) const;
 	const Players&   getPlayers                   () const;
+	const Players&   getPlayersByAccount          (uint32_t accountId) const;
+	const Players&   getPlayersByIp               (uint32_t ip) const;
+	const Players&   getPlayersByName             (const std::string& name) const;
+	Players          getPlayersByNamePrefix       (const std::string& prefix, size_t limit) const;
 	ReturnValue      removeCreature               (const CreatureP& creature);
+	void             updatePlayerIp               (const PlayerP& player);
 
 
 private:
 
+	// indexes of the players in the world, names are stored in lower case
+	using PlayersByKey        = std::unordered_map<uint32_t,Players>;
+	using PlayersByName       = std::unordered_map<std::string,Players>;
+	using PlayersBySortedName = std::map<std::string,Players>;
+	using PlayerIps           = std::unordered_map<CreatureId,uint32_t>;
+
+
+	void indexPlayer   (const PlayerP& player);
+	void unindexPlayer (const PlayerP& player);
+
+
 	LOGGER_DECLARATION;
 
+	static const Players    NO_PLAYERS;
+
 	static const CreatureId MAXIMUM_MONSTER_ID;
 	static const CreatureId MINIMUM_MONSTER_ID;
 	static const CreatureId MAXIMUM_NPC_ID;
@@ -81,14 +101,20 @@ private:
 	World(const World&) = delete;
 	World(World&&) = delete;
 
-	Creatures     _creatures;
-	CreaturesById _creaturesById;
-	Monsters      _monsters;
-	MonstersById  _monstersById;
-	Npcs          _npcs;
-	NpcsById      _npcsById;
-	Players       _players;
-	PlayersById   _playersById;
+	Creatures           _creatures;
+	CreaturesById       _creaturesById;
+	Monsters            _monsters;
+	MonstersById        _monstersById;
+	Npcs                _npcs;
+	NpcsById            _npcsById;
+	Players             _players;
+	PlayersByKey        _playersByAccount;
+	PlayersByKey        _playersByGuid;
+	PlayersById         _playersById;
+	PlayersByKey        _playersByIp;
+	PlayersByName       _playersByName;
+	PlayersBySortedName _playersBySortedName;
+	PlayerIps           _playerIps;
 
 };
 
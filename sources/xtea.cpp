@@ -0,0 +1,243 @@
+////////////////////////////////////////////////////////////////////////
+// OpenTibia - an opensource roleplaying game
+////////////////////////////////////////////////////////////////////////
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+////////////////////////////////////////////////////////////////////////
+
+
+#include "otpch.h"
+
+#include "xtea.h"
+
+
+namespace {
+
+const uint32_t delta  = 0x61C88647;
+const uint32_t rounds = 32;
+
+typedef void (*XteaKernel)(uint32_t* buffer, size_t blockCount, const uint32_t* roundKeys);
+
+
+// The per-round key terms only depend on the key, so they are computed once per message instead of once per block.
+// roundKeys[2 * i] is used for v0 and roundKeys[2 * i + 1] for v1 in round i of the encryption.
+void computeRoundKeys(const uint32_t* key, uint32_t* roundKeys) {
+	uint32_t sum = 0;
+	for (uint32_t round = 0; round < rounds; ++round) {
+		roundKeys[2 * round] = sum + key[sum & 3];
+		sum -= delta;
+		roundKeys[2 * round + 1] = sum + key[sum >> 11 & 3];
+	}
+}
+
+
+void decryptScalar(uint32_t* buffer, size_t blockCount, const uint32_t* roundKeys) {
+	for (size_t block = 0; block < blockCount; ++block, buffer += 2) {
+		uint32_t v0 = buffer[0], v1 = buffer[1];
+		for (uint32_t round = rounds; round > 0; --round) {
+			v1 -= ((v0 << 4 ^ v0 >> 5) + v0) ^ roundKeys[2 * round - 1];
+			v0 -= ((v1 << 4 ^ v1 >> 5) + v1) ^ roundKeys[2 * round - 2];
+		}
+
+		buffer[0] = v0;
+		buffer[1] = v1;
+	}
+}
+
+
+void encryptScalar(uint32_t* buffer, size_t blockCount, const uint32_t* roundKeys) {
+	for (size_t block = 0; block < blockCount; ++block, buffer += 2) {
+		uint32_t v0 = buffer[0], v1 = buffer[1];
+		for (uint32_t round = 0; round < rounds; ++round) {
+			v0 += ((v1 << 4 ^ v1 >> 5) + v1) ^ roundKeys[2 * round];
+			v1 += ((v0 << 4 ^ v0 >> 5) + v0) ^ roundKeys[2 * round + 1];
+		}
+
+		buffer[0] = v0;
+		buffer[1] = v1;
+	}
+}
+
+
+#ifdef SIMD_X86
+
+// The vector kernels keep the first and the second word of several blocks in separate registers so that each lane runs
+// the scalar algorithm for one block. Remaining blocks which don't fill a whole register are left to the scalar kernel.
+
+__attribute__((target("avx2")))
+void decryptAvx2(uint32_t* buffer, size_t blockCount, const uint32_t* roundKeys) {
+	size_t vectorBlockCount = blockCount & ~size_t(7);
+
+	for (size_t block = 0; block < vectorBlockCount; block += 8, buffer += 16) {
+		__m256i x = _mm256_shuffle_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(buffer)), _MM_SHUFFLE(3, 1, 2, 0));
+		__m256i y = _mm256_shuffle_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(buffer + 8)), _MM_SHUFFLE(3, 1, 2, 0));
+		__m256i v0 = _mm256_unpacklo_epi64(x, y);
+		__m256i v1 = _mm256_unpackhi_epi64(x, y);
+
+		for (uint32_t round = rounds; round > 0; --round) {
+			__m256i t = _mm256_add_epi32(_mm256_xor_si256(_mm256_slli_epi32(v0, 4), _mm256_srli_epi32(v0, 5)), v0);
+			v1 = _mm256_sub_epi32(v1, _mm256_xor_si256(t, _mm256_set1_epi32(roundKeys[2 * round - 1])));
+
+			t = _mm256_add_epi32(_mm256_xor_si256(_mm256_slli_epi32(v1, 4), _mm256_srli_epi32(v1, 5)), v1);
+			v0 = _mm256_sub_epi32(v0, _mm256_xor_si256(t, _mm256_set1_epi32(roundKeys[2 * round - 2])));
+		}
+
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(buffer), _mm256_unpacklo_epi32(v0, v1));
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(buffer + 8), _mm256_unpackhi_epi32(v0, v1));
+	}
+
+	decryptScalar(buffer, blockCount - vectorBlockCount, roundKeys);
+}
+
+
+__attribute__((target("avx2")))
+void encryptAvx2(uint32_t* buffer, size_t blockCount, const uint32_t* roundKeys) {
+	size_t vectorBlockCount = blockCount & ~size_t(7);
+
+	for (size_t block = 0; block < vectorBlockCount; block += 8, buffer += 16) {
+		__m256i x = _mm256_shuffle_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(buffer)), _MM_SHUFFLE(3, 1, 2, 0));
+		__m256i y = _mm256_shuffle_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(buffer + 8)), _MM_SHUFFLE(3, 1, 2, 0));
+		__m256i v0 = _mm256_unpacklo_epi64(x, y);
+		__m256i v1 = _mm256_unpackhi_epi64(x, y);
+
+		for (uint32_t round = 0; round < rounds; ++round) {
+			__m256i t = _mm256_add_epi32(_mm256_xor_si256(_mm256_slli_epi32(v1, 4), _mm256_srli_epi32(v1, 5)), v1);
+			v0 = _mm256_add_epi32(v0, _mm256_xor_si256(t, _mm256_set1_epi32(roundKeys[2 * round])));
+
+			t = _mm256_add_epi32(_mm256_xor_si256(_mm256_slli_epi32(v0, 4), _mm256_srli_epi32(v0, 5)), v0);
+			v1 = _mm256_add_epi32(v1, _mm256_xor_si256(t, _mm256_set1_epi32(roundKeys[2 * round + 1])));
+		}
+
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(buffer), _mm256_unpacklo_epi32(v0, v1));
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(buffer + 8), _mm256_unpackhi_epi32(v0, v1));
+	}
+
+	encryptScalar(buffer, blockCount - vectorBlockCount, roundKeys);
+}
+
+
+__attribute__((target("sse2")))
+void decryptSse2(uint32_t* buffer, size_t blockCount, const uint32_t* roundKeys) {
+	size_t vectorBlockCount = blockCount & ~size_t(3);
+
+	for (size_t block = 0; block < vectorBlockCount; block += 4, buffer += 8) {
+		__m128i x = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(buffer)), _MM_SHUFFLE(3, 1, 2, 0));
+		__m128i y = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(buffer + 4)), _MM_SHUFFLE(3, 1, 2, 0));
+		__m128i v0 = _mm_unpacklo_epi64(x, y);
+		__m128i v1 = _mm_unpackhi_epi64(x, y);
+
+		for (uint32_t round = rounds; round > 0; --round) {
+			__m128i t = _mm_add_epi32(_mm_xor_si128(_mm_slli_epi32(v0, 4), _mm_srli_epi32(v0, 5)), v0);
+			v1 = _mm_sub_epi32(v1, _mm_xor_si128(t, _mm_set1_epi32(roundKeys[2 * round - 1])));
+
+			t = _mm_add_epi32(_mm_xor_si128(_mm_slli_epi32(v1, 4), _mm_srli_epi32(v1, 5)), v1);
+			v0 = _mm_sub_epi32(v0, _mm_xor_si128(t, _mm_set1_epi32(roundKeys[2 * round - 2])));
+		}
+
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(buffer), _mm_unpacklo_epi32(v0, v1));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(buffer + 4), _mm_unpackhi_epi32(v0, v1));
+	}
+
+	decryptScalar(buffer, blockCount - vectorBlockCount, roundKeys);
+}
+
+
+__attribute__((target("sse2")))
+void encryptSse2(uint32_t* buffer, size_t blockCount, const uint32_t* roundKeys) {
+	size_t vectorBlockCount = blockCount & ~size_t(3);
+
+	for (size_t block = 0; block < vectorBlockCount; block += 4, buffer += 8) {
+		__m128i x = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(buffer)), _MM_SHUFFLE(3, 1, 2, 0));
+		__m128i y = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(buffer + 4)), _MM_SHUFFLE(3, 1, 2, 0));
+		__m128i v0 = _mm_unpacklo_epi64(x, y);
+		__m128i v1 = _mm_unpackhi_epi64(x, y);
+
+		for (uint32_t round = 0; round < rounds; ++round) {
+			__m128i t = _mm_add_epi32(_mm_xor_si128(_mm_slli_epi32(v1, 4), _mm_srli_epi32(v1, 5)), v1);
+			v0 = _mm_add_epi32(v0, _mm_xor_si128(t, _mm_set1_epi32(roundKeys[2 * round])));
+
+			t = _mm_add_epi32(_mm_xor_si128(_mm_slli_epi32(v0, 4), _mm_srli_epi32(v0, 5)), v0);
+			v1 = _mm_add_epi32(v1, _mm_xor_si128(t, _mm_set1_epi32(roundKeys[2 * round + 1])));
+		}
+
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(buffer), _mm_unpacklo_epi32(v0, v1));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(buffer + 4), _mm_unpackhi_epi32(v0, v1));
+	}
+
+	encryptScalar(buffer, blockCount - vectorBlockCount, roundKeys);
+}
+
+#endif // SIMD_X86
+
+
+XteaKernel getDecryptKernel(SimdKernel kernel) {
+	switch (kernel) {
+#ifdef SIMD_X86
+	case SimdKernel::AVX2:
+		return decryptAvx2;
+
+	case SimdKernel::SSE2:
+		return decryptSse2;
+#endif
+
+	default:
+		return decryptScalar;
+	}
+}
+
+
+XteaKernel getEncryptKernel(SimdKernel kernel) {
+	switch (kernel) {
+#ifdef SIMD_X86
+	case SimdKernel::AVX2:
+		return encryptAvx2;
+
+	case SimdKernel::SSE2:
+		return encryptSse2;
+#endif
+
+	default:
+		return encryptScalar;
+	}
+}
+
+} // namespace
+
+
+
+void xteaDecrypt(uint32_t* buffer, size_t blockCount, const uint32_t* key) {
+	static const SimdKernel kernel = getFastestSimdKernel();
+	xteaDecrypt(buffer, blockCount, key, kernel);
+}
+
+
+void xteaDecrypt(uint32_t* buffer, size_t blockCount, const uint32_t* key, SimdKernel kernel) {
+	uint32_t roundKeys[2 * rounds];
+	computeRoundKeys(key, roundKeys);
+
+	getDecryptKernel(kernel)(buffer, blockCount, roundKeys);
+}
+
+
+void xteaEncrypt(uint32_t* buffer, size_t blockCount, const uint32_t* key) {
+	static const SimdKernel kernel = getFastestSimdKernel();
+	xteaEncrypt(buffer, blockCount, key, kernel);
+}
+
+
+void xteaEncrypt(uint32_t* buffer, size_t blockCount, const uint32_t* key, SimdKernel kernel) {
+	uint32_t roundKeys[2 * rounds];
+	computeRoundKeys(key, roundKeys);
+
+	getEncryptKernel(kernel)(buffer, blockCount, roundKeys);
+}
@@ -0,0 +1,31 @@
+////////////////////////////////////////////////////////////////////////
+// OpenTibia - an opensource roleplaying game
+////////////////////////////////////////////////////////////////////////
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+////////////////////////////////////////////////////////////////////////
+
+
+#ifndef _XTEA_H
+#define _XTEA_H
+
+#include "simd.h"
+
+// Encrypts or decrypts blockCount 8-byte blocks in place. The fastest kernel supported by the CPU
+// (AVX2, SSE2 or scalar) is picked on first use unless one is given; all of them produce the same bytes.
+void xteaDecrypt(uint32_t* buffer, size_t blockCount, const uint32_t* key);
+void xteaDecrypt(uint32_t* buffer, size_t blockCount, const uint32_t* key, SimdKernel kernel);
+void xteaEncrypt(uint32_t* buffer, size_t blockCount, const uint32_t* key);
+void xteaEncrypt(uint32_t* buffer, size_t blockCount, const uint32_t* key, SimdKernel kernel);
+
+#endif // _XTEA_H